@@ -54,11 +54,13 @@
 #include "../source/ff.application/dxgi/device_child_base.h"
 #include "../source/ff.application/dxgi/draw_base.h"
 #include "../source/ff.application/dxgi/draw_device_base.h"
+#include "../source/ff.application/dxgi/draw_recorder.h"
 #include "../source/ff.application/dxgi/draw_util.h"
 #include "../source/ff.application/dxgi/dxgi_globals.h"
 #include "../source/ff.application/dxgi/format_util.h"
 #include "../source/ff.application/dxgi/palette_base.h"
 #include "../source/ff.application/dxgi/palette_data_base.h"
+#include "../source/ff.application/dxgi/recording_draw_device.h"
 #include "../source/ff.application/dxgi/sprite_data.h"
 #include "../source/ff.application/dxgi/target_access_base.h"
 #include "../source/ff.application/dxgi/target_base.h"
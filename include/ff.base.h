@@ -50,6 +50,7 @@
 #include "../source/ff.base/resource/auto_resource.h"
 #include "../source/ff.base/resource/global_resources.h"
 #include "../source/ff.base/resource/resource.h"
+#include "../source/ff.base/resource/resource_build_cache.h"
 #include "../source/ff.base/resource/resource_file.h"
 #include "../source/ff.base/resource/resource_load.h"
 #include "../source/ff.base/resource/resource_load_context.h"
@@ -63,12 +64,18 @@
 #include "../source/ff.base/thread/co_awaiters.h"
 #include "../source/ff.base/thread/co_exceptions.h"
 #include "../source/ff.base/thread/co_task.h"
+#include "../source/ff.base/thread/job_system.h"
+#include "../source/ff.base/thread/mpsc_queue.h"
+#include "../source/ff.base/thread/parallel.h"
 #include "../source/ff.base/thread/thread_dispatch.h"
 #include "../source/ff.base/thread/thread_pool.h"
+#include "../source/ff.base/thread/work_stealing_queue.h"
 
+#include "../source/ff.base/types/atom.h"
 #include "../source/ff.base/types/fixed.h"
 #include "../source/ff.base/types/flags.h"
 #include "../source/ff.base/types/frame_allocator.h"
+#include "../source/ff.base/types/inline_function.h"
 #include "../source/ff.base/types/intrusive_ptr.h"
 #include "../source/ff.base/types/perf_timer.h"
 #include "../source/ff.base/types/point.h"
@@ -192,6 +192,9 @@ static void frame_render(ff::state::advance_t advance_type)
 
 static ff::state::advance_t frame_advance_and_render(ff::state::advance_t previous_advance_type)
 {
+    // Per-thread frame memory from the previous frame is reused from here on
+    ff::frame_allocator_next_frame();
+
     // Input is part of previous frame's perf measures. But it must be first, before the timer updates,
     // because user input can affect how time is computed (like stopping or single stepping through frames)
     ::frame_advance_input();
@@ -84,7 +84,7 @@ ff::dx12::buffer::buffer(
     , type_(type)
     , mem_start(mem_start)
     , data_size(data_size)
-    , data_hash(data_hash ? ff::stable_hash_bytes(data, static_cast<size_t>(data_size)) : data_hash)
+    , data_hash(data_hash ? static_cast<size_t>(ff::wide_hash_bytes(data, static_cast<size_t>(data_size))) : data_hash)
     , version_(version ? version : 1)
 {
     assert(mem_start == ff::math::align_up<uint64_t>(mem_start, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT));
@@ -194,7 +194,7 @@ bool ff::dx12::buffer::writable() const
 
 bool ff::dx12::buffer::update(ff::dxgi::command_context_base& context, const void* data, size_t data_size, size_t min_buffer_size)
 {
-    size_t new_hash = data_size ? ff::stable_hash_bytes(data, data_size) : 0;
+    size_t new_hash = data_size ? static_cast<size_t>(ff::wide_hash_bytes(data, data_size)) : 0;
     if (new_hash != this->data_hash)
     {
         *this = ff::dx12::buffer(
@@ -408,7 +408,7 @@ bool ff::dx12::buffer_cpu::writable() const
 
 bool ff::dx12::buffer_cpu::update(ff::dxgi::command_context_base& context, const void* data, size_t size, size_t min_buffer_size)
 {
-    size_t new_hash = size ? ff::stable_hash_bytes(data, size) : 0;
+    size_t new_hash = size ? static_cast<size_t>(ff::wide_hash_bytes(data, size)) : 0;
     if (new_hash != this->data_hash)
     {
         std::memcpy(this->map(context, size), data, size);
@@ -427,7 +427,7 @@ void* ff::dx12::buffer_cpu::map(ff::dxgi::command_context_base& context, size_t
 
 void ff::dx12::buffer_cpu::unmap()
 {
-    size_t new_hash = this->data_.size() ? ff::stable_hash_bytes(this->data_.data(), this->data_.size()) : 0;
+    size_t new_hash = this->data_.size() ? static_cast<size_t>(ff::wide_hash_bytes(this->data_.data(), this->data_.size())) : 0;
     if (new_hash != this->data_hash)
     {
         this->data_hash = new_hash;
@@ -20,7 +20,7 @@ void ff::dxgi::draw_base::draw_sprite(const ff::dxgi::sprite_data& sprite, const
 
 void ff::dxgi::draw_base::draw_line_strip(const ff::point_fixed* points, size_t count, const DirectX::XMFLOAT4& color, ff::fixed_int thickness)
 {
-    ff::stack_vector<ff::point_float, 64> point_floats;
+    ff::frame_vector<ff::point_float> point_floats;
     point_floats.resize(count);
 
     for (size_t i = 0; i < count; i++)
@@ -58,7 +58,7 @@ void ff::dxgi::draw_base::draw_outline_circle(const ff::point_fixed & center, ff
 
 void ff::dxgi::draw_base::draw_palette_line_strip(const ff::point_fixed * points, size_t count, int color, ff::fixed_int thickness)
 {
-    ff::stack_vector<ff::point_float, 64> point_floats;
+    ff::frame_vector<ff::point_float> point_floats;
     point_floats.resize(count);
 
     for (size_t i = 0; i < count; i++)
@@ -11,8 +11,11 @@ namespace ff::dxgi
 {
     class command_context_base;
     class palette_base;
+    class draw_base;
     class sprite_data;
 
+    using draw_ptr = typename std::unique_ptr<ff::dxgi::draw_base, void(*)(ff::dxgi::draw_base*)>;
+
     class draw_base
     {
     public:
@@ -22,8 +25,12 @@ namespace ff::dxgi
 
         virtual void end_draw() = 0;
 
+        // The recording can be used on any one thread, it gets drawn after everything else when this draw ends
+        virtual ff::dxgi::draw_ptr begin_recording() = 0;
+
         virtual void draw_sprite(const ff::dxgi::sprite_data& sprite, const ff::transform& transform) = 0;
         void draw_sprite(const ff::dxgi::sprite_data& sprite, const ff::pixel_transform& transform);
+        virtual void draw_sprites(const ff::dxgi::sprite_data* const* sprites, const ff::transform* transforms, size_t count) = 0;
 
         virtual void draw_line_strip(const ff::point_float* points, const DirectX::XMFLOAT4* colors, size_t count, float thickness, bool pixel_thickness = false) = 0;
         virtual void draw_line_strip(const ff::point_float* points, size_t count, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness = false) = 0;
@@ -80,6 +87,4 @@ namespace ff::dxgi
         virtual void push_sampler_linear_filter(bool linear_filter) = 0;
         virtual void pop_sampler_linear_filter() = 0;
     };
-
-    using draw_ptr = typename std::unique_ptr<ff::dxgi::draw_base, void(*)(ff::dxgi::draw_base*)>;
 }
@@ -13,6 +13,7 @@ namespace ff::dxgi
         none = 0x00,
         pre_multiplied_alpha = 0x01,
         ignore_rotation = 0x02,
+        sort_alpha = 0x04, // alpha geometry that doesn't overlap can be drawn out of order, for fewer draw calls
     };
 
     class draw_device_base
@@ -0,0 +1,524 @@
+#include "pch.h"
+#include "dxgi/draw_recorder.h"
+
+static void recorder_ptr_deleter(ff::dxgi::draw_base* draw)
+{
+    draw->end_draw();
+}
+
+ff::dxgi::draw_recorder::draw_recorder()
+    : world_matrix_stack_changing_connection(this->world_matrix_stack_.matrix_changing().connect(std::bind(&draw_recorder::matrix_changing, this, std::placeholders::_1)))
+{}
+
+ff::dxgi::draw_recorder::~draw_recorder()
+{
+    assert(!this->recording_);
+}
+
+void ff::dxgi::draw_recorder::begin()
+{
+    assert(!this->recording_);
+
+    this->commands.clear();
+    this->sprites.clear();
+    this->points.clear();
+    this->colors.clear();
+    this->palette_colors.clear();
+    this->matrixes.clear();
+    this->custom_context_funcs.clear();
+    this->world_matrix_stack_.reset();
+    this->world_matrix_changed = true;
+    this->recording_ = true;
+}
+
+bool ff::dxgi::draw_recorder::recording() const
+{
+    return this->recording_;
+}
+
+void ff::dxgi::draw_recorder::replay(ff::dxgi::draw_util::draw_device_base& draw)
+{
+    assert(!this->recording_);
+
+    ff::matrix_stack& matrix_stack = draw.world_matrix_stack();
+    matrix_stack.push();
+
+    for (const ff::dxgi::draw_recorder::command& command : this->commands)
+    {
+        switch (command.type)
+        {
+            case command_type::sprite:
+                draw.draw_recorded_sprites(this->sprites.data() + command.start, command.count);
+                break;
+
+            case command_type::line_strip:
+                if (command.per_point_colors)
+                {
+                    draw.draw_line_strip(this->points.data() + command.start, this->colors.data() + command.color_start, command.count, command.thickness, command.flag);
+                }
+                else
+                {
+                    draw.draw_line_strip(this->points.data() + command.start, command.count, this->colors[command.color_start], command.thickness, command.flag);
+                }
+                break;
+
+            case command_type::filled_rectangle:
+                draw.draw_filled_rectangle(command.rect, this->colors.data() + command.color_start);
+                break;
+
+            case command_type::filled_triangles:
+                draw.draw_filled_triangles(this->points.data() + command.start, this->colors.data() + command.color_start, command.count);
+                break;
+
+            case command_type::outline_rectangle:
+                draw.draw_outline_rectangle(command.rect, this->colors[command.color_start], command.thickness, command.flag);
+                break;
+
+            case command_type::outline_circle:
+                draw.draw_outline_circle(command.rect.top_left(), command.radius, this->colors[command.color_start], this->colors[command.color_start + 1], command.thickness, command.flag);
+                break;
+
+            case command_type::palette_line_strip:
+                if (command.per_point_colors)
+                {
+                    draw.draw_palette_line_strip(this->points.data() + command.start, this->palette_colors.data() + command.color_start, command.count, command.thickness, command.flag);
+                }
+                else
+                {
+                    draw.draw_palette_line_strip(this->points.data() + command.start, command.count, this->palette_colors[command.color_start], command.thickness, command.flag);
+                }
+                break;
+
+            case command_type::palette_filled_rectangle:
+                draw.draw_palette_filled_rectangle(command.rect, this->palette_colors.data() + command.color_start);
+                break;
+
+            case command_type::palette_filled_triangles:
+                draw.draw_palette_filled_triangles(this->points.data() + command.start, this->palette_colors.data() + command.color_start, command.count);
+                break;
+
+            case command_type::palette_outline_rectangle:
+                draw.draw_palette_outline_rectangle(command.rect, this->palette_colors[command.color_start], command.thickness, command.flag);
+                break;
+
+            case command_type::palette_outline_circle:
+                draw.draw_palette_outline_circle(command.rect.top_left(), command.radius, this->palette_colors[command.color_start], this->palette_colors[command.color_start + 1], command.thickness, command.flag);
+                break;
+
+            case command_type::world_matrix:
+                matrix_stack.set(this->matrixes[command.start]);
+                break;
+
+            case command_type::push_palette:
+                draw.push_palette(const_cast<ff::dxgi::palette_base*>(reinterpret_cast<const ff::dxgi::palette_base*>(command.data)));
+                break;
+
+            case command_type::pop_palette:
+                draw.pop_palette();
+                break;
+
+            case command_type::push_palette_remap:
+                draw.push_palette_remap(reinterpret_cast<const uint8_t*>(command.data), command.hash);
+                break;
+
+            case command_type::pop_palette_remap:
+                draw.pop_palette_remap();
+                break;
+
+            case command_type::push_no_overlap:
+                draw.push_no_overlap();
+                break;
+
+            case command_type::pop_no_overlap:
+                draw.pop_no_overlap();
+                break;
+
+            case command_type::push_opaque:
+                draw.push_opaque();
+                break;
+
+            case command_type::pop_opaque:
+                draw.pop_opaque();
+                break;
+
+            case command_type::push_pre_multiplied_alpha:
+                draw.push_pre_multiplied_alpha();
+                break;
+
+            case command_type::pop_pre_multiplied_alpha:
+                draw.pop_pre_multiplied_alpha();
+                break;
+
+            case command_type::push_custom_context:
+                draw.push_custom_context(std::move(this->custom_context_funcs[command.start]));
+                break;
+
+            case command_type::pop_custom_context:
+                draw.pop_custom_context();
+                break;
+
+            case command_type::push_sampler_linear_filter:
+                draw.push_sampler_linear_filter(command.flag);
+                break;
+
+            case command_type::pop_sampler_linear_filter:
+                draw.pop_sampler_linear_filter();
+                break;
+        }
+    }
+
+    matrix_stack.pop();
+}
+
+void ff::dxgi::draw_recorder::end_draw()
+{
+    this->recording_ = false;
+}
+
+ff::dxgi::draw_ptr ff::dxgi::draw_recorder::begin_recording()
+{
+    // Recorders only come from a real draw, which needs to be used on one thread
+    assert(false);
+    return { nullptr, ::recorder_ptr_deleter };
+}
+
+void ff::dxgi::draw_recorder::draw_sprite(const ff::dxgi::sprite_data& sprite, const ff::transform& transform)
+{
+    const ff::dxgi::sprite_data* sprites = &sprite;
+    this->draw_sprites(&sprites, &transform, 1);
+}
+
+void ff::dxgi::draw_recorder::draw_sprites(const ff::dxgi::sprite_data* const* sprites, const ff::transform* transforms, size_t count)
+{
+    if (!count)
+    {
+        return;
+    }
+
+    // Sprites in a row with the same world matrix are replayed with one call to draw_sprites
+    if (this->world_matrix_changed || this->commands.empty() || this->commands.back().type != command_type::sprite)
+    {
+        ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::sprite);
+        command.start = static_cast<uint32_t>(this->sprites.size());
+    }
+
+    const size_t old_size = this->sprites.size();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const ff::dxgi::sprite_data& sprite = *sprites[i];
+        const ff::transform& transform = transforms[i];
+
+        // These never get drawn, whatever the state is during replay
+        if (!sprite.view() || transform.color.w == 0)
+        {
+            continue;
+        }
+
+        ff::dxgi::draw_util::recorded_sprite& recorded = this->sprites.emplace_back();
+        recorded.view = sprite.view();
+        recorded.type = sprite.type();
+
+        ff::vertex::sprite_geometry& geometry = recorded.geometry;
+        geometry.rect = *reinterpret_cast<const DirectX::XMFLOAT4*>(&sprite.world());
+        geometry.uv_rect = *reinterpret_cast<const DirectX::XMFLOAT4*>(&sprite.texture_uv());
+        geometry.color = transform.color;
+        geometry.scale = *reinterpret_cast<const DirectX::XMFLOAT2*>(&transform.scale);
+        geometry.position = DirectX::XMFLOAT3(transform.position.x, transform.position.y, 0);
+        geometry.rotate = transform.rotation_radians();
+        geometry.texture_index = 0;
+        geometry.matrix_index = 0;
+    }
+
+    this->commands.back().count += static_cast<uint32_t>(this->sprites.size() - old_size);
+}
+
+void ff::dxgi::draw_recorder::draw_line_strip(const ff::point_float* points, const DirectX::XMFLOAT4* colors, size_t count, float thickness, bool pixel_thickness)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::line_strip);
+    command.start = static_cast<uint32_t>(this->points.size());
+    command.count = static_cast<uint32_t>(count);
+    command.color_start = static_cast<uint32_t>(this->colors.size());
+    command.thickness = thickness;
+    command.flag = pixel_thickness;
+    command.per_point_colors = true;
+
+    this->points.insert(this->points.end(), points, points + count);
+    this->colors.insert(this->colors.end(), colors, colors + count);
+}
+
+void ff::dxgi::draw_recorder::draw_line_strip(const ff::point_float* points, size_t count, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::line_strip);
+    command.start = static_cast<uint32_t>(this->points.size());
+    command.count = static_cast<uint32_t>(count);
+    command.color_start = static_cast<uint32_t>(this->colors.size());
+    command.thickness = thickness;
+    command.flag = pixel_thickness;
+
+    this->points.insert(this->points.end(), points, points + count);
+    this->colors.push_back(color);
+}
+
+void ff::dxgi::draw_recorder::draw_line(const ff::point_float& start, const ff::point_float& end, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness)
+{
+    const ff::point_float points[2] = { start, end };
+    this->draw_line_strip(points, 2, color, thickness, pixel_thickness);
+}
+
+void ff::dxgi::draw_recorder::draw_filled_rectangle(const ff::rect_float& rect, const DirectX::XMFLOAT4* colors)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::filled_rectangle);
+    command.rect = rect;
+    command.color_start = static_cast<uint32_t>(this->colors.size());
+    this->colors.insert(this->colors.end(), colors, colors + 4);
+}
+
+void ff::dxgi::draw_recorder::draw_filled_rectangle(const ff::rect_float& rect, const DirectX::XMFLOAT4& color)
+{
+    const DirectX::XMFLOAT4 colors[4] = { color, color, color, color };
+    this->draw_filled_rectangle(rect, colors);
+}
+
+void ff::dxgi::draw_recorder::draw_filled_triangles(const ff::point_float* points, const DirectX::XMFLOAT4* colors, size_t count)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::filled_triangles);
+    command.start = static_cast<uint32_t>(this->points.size());
+    command.count = static_cast<uint32_t>(count);
+    command.color_start = static_cast<uint32_t>(this->colors.size());
+    this->points.insert(this->points.end(), points, points + count * 3);
+    this->colors.insert(this->colors.end(), colors, colors + count * 3);
+}
+
+void ff::dxgi::draw_recorder::draw_filled_circle(const ff::point_float& center, float radius, const DirectX::XMFLOAT4& color)
+{
+    this->draw_outline_circle(center, radius, color, color, std::abs(radius), false);
+}
+
+void ff::dxgi::draw_recorder::draw_filled_circle(const ff::point_float& center, float radius, const DirectX::XMFLOAT4& inside_color, const DirectX::XMFLOAT4& outside_color)
+{
+    this->draw_outline_circle(center, radius, inside_color, outside_color, std::abs(radius), false);
+}
+
+void ff::dxgi::draw_recorder::draw_outline_rectangle(const ff::rect_float& rect, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::outline_rectangle);
+    command.rect = rect;
+    command.color_start = static_cast<uint32_t>(this->colors.size());
+    command.thickness = thickness;
+    command.flag = pixel_thickness;
+    this->colors.push_back(color);
+}
+
+void ff::dxgi::draw_recorder::draw_outline_circle(const ff::point_float& center, float radius, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness)
+{
+    this->draw_outline_circle(center, radius, color, color, thickness, pixel_thickness);
+}
+
+void ff::dxgi::draw_recorder::draw_outline_circle(const ff::point_float& center, float radius, const DirectX::XMFLOAT4& inside_color, const DirectX::XMFLOAT4& outside_color, float thickness, bool pixel_thickness)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::outline_circle);
+    command.rect = ff::rect_float(center, center);
+    command.radius = radius;
+    command.color_start = static_cast<uint32_t>(this->colors.size());
+    command.thickness = thickness;
+    command.flag = pixel_thickness;
+    this->colors.push_back(inside_color);
+    this->colors.push_back(outside_color);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_line_strip(const ff::point_float* points, const int* colors, size_t count, float thickness, bool pixel_thickness)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::palette_line_strip);
+    command.start = static_cast<uint32_t>(this->points.size());
+    command.count = static_cast<uint32_t>(count);
+    command.color_start = static_cast<uint32_t>(this->palette_colors.size());
+    command.thickness = thickness;
+    command.flag = pixel_thickness;
+    command.per_point_colors = true;
+
+    this->points.insert(this->points.end(), points, points + count);
+    this->palette_colors.insert(this->palette_colors.end(), colors, colors + count);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_line_strip(const ff::point_float* points, size_t count, int color, float thickness, bool pixel_thickness)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::palette_line_strip);
+    command.start = static_cast<uint32_t>(this->points.size());
+    command.count = static_cast<uint32_t>(count);
+    command.color_start = static_cast<uint32_t>(this->palette_colors.size());
+    command.thickness = thickness;
+    command.flag = pixel_thickness;
+
+    this->points.insert(this->points.end(), points, points + count);
+    this->palette_colors.push_back(color);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_line(const ff::point_float& start, const ff::point_float& end, int color, float thickness, bool pixel_thickness)
+{
+    const ff::point_float points[2] = { start, end };
+    this->draw_palette_line_strip(points, 2, color, thickness, pixel_thickness);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_filled_rectangle(const ff::rect_float& rect, const int* colors)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::palette_filled_rectangle);
+    command.rect = rect;
+    command.color_start = static_cast<uint32_t>(this->palette_colors.size());
+    this->palette_colors.insert(this->palette_colors.end(), colors, colors + 4);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_filled_rectangle(const ff::rect_float& rect, int color)
+{
+    const int colors[4] = { color, color, color, color };
+    this->draw_palette_filled_rectangle(rect, colors);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_filled_triangles(const ff::point_float* points, const int* colors, size_t count)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::palette_filled_triangles);
+    command.start = static_cast<uint32_t>(this->points.size());
+    command.count = static_cast<uint32_t>(count);
+    command.color_start = static_cast<uint32_t>(this->palette_colors.size());
+    this->points.insert(this->points.end(), points, points + count * 3);
+    this->palette_colors.insert(this->palette_colors.end(), colors, colors + count * 3);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_filled_circle(const ff::point_float& center, float radius, int color)
+{
+    this->draw_palette_outline_circle(center, radius, color, color, std::abs(radius), false);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_filled_circle(const ff::point_float& center, float radius, int inside_color, int outside_color)
+{
+    this->draw_palette_outline_circle(center, radius, inside_color, outside_color, std::abs(radius), false);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_outline_rectangle(const ff::rect_float& rect, int color, float thickness, bool pixel_thickness)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::palette_outline_rectangle);
+    command.rect = rect;
+    command.color_start = static_cast<uint32_t>(this->palette_colors.size());
+    command.thickness = thickness;
+    command.flag = pixel_thickness;
+    this->palette_colors.push_back(color);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_outline_circle(const ff::point_float& center, float radius, int color, float thickness, bool pixel_thickness)
+{
+    this->draw_palette_outline_circle(center, radius, color, color, thickness, pixel_thickness);
+}
+
+void ff::dxgi::draw_recorder::draw_palette_outline_circle(const ff::point_float& center, float radius, int inside_color, int outside_color, float thickness, bool pixel_thickness)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_draw_command(command_type::palette_outline_circle);
+    command.rect = ff::rect_float(center, center);
+    command.radius = radius;
+    command.color_start = static_cast<uint32_t>(this->palette_colors.size());
+    command.thickness = thickness;
+    command.flag = pixel_thickness;
+    this->palette_colors.push_back(inside_color);
+    this->palette_colors.push_back(outside_color);
+}
+
+ff::matrix_stack& ff::dxgi::draw_recorder::world_matrix_stack()
+{
+    return this->world_matrix_stack_;
+}
+
+void ff::dxgi::draw_recorder::push_palette(ff::dxgi::palette_base* palette)
+{
+    this->add_command(command_type::push_palette).data = palette;
+}
+
+void ff::dxgi::draw_recorder::pop_palette()
+{
+    this->add_command(command_type::pop_palette);
+}
+
+void ff::dxgi::draw_recorder::push_palette_remap(const uint8_t* remap, size_t hash)
+{
+    ff::dxgi::draw_recorder::command& command = this->add_command(command_type::push_palette_remap);
+    command.data = remap;
+    command.hash = hash;
+}
+
+void ff::dxgi::draw_recorder::pop_palette_remap()
+{
+    this->add_command(command_type::pop_palette_remap);
+}
+
+void ff::dxgi::draw_recorder::push_no_overlap()
+{
+    this->add_command(command_type::push_no_overlap);
+}
+
+void ff::dxgi::draw_recorder::pop_no_overlap()
+{
+    this->add_command(command_type::pop_no_overlap);
+}
+
+void ff::dxgi::draw_recorder::push_opaque()
+{
+    this->add_command(command_type::push_opaque);
+}
+
+void ff::dxgi::draw_recorder::pop_opaque()
+{
+    this->add_command(command_type::pop_opaque);
+}
+
+void ff::dxgi::draw_recorder::push_pre_multiplied_alpha()
+{
+    this->add_command(command_type::push_pre_multiplied_alpha);
+}
+
+void ff::dxgi::draw_recorder::pop_pre_multiplied_alpha()
+{
+    this->add_command(command_type::pop_pre_multiplied_alpha);
+}
+
+void ff::dxgi::draw_recorder::push_custom_context(ff::dxgi::draw_base::custom_context_func&& func)
+{
+    this->add_command(command_type::push_custom_context).start = static_cast<uint32_t>(this->custom_context_funcs.size());
+    this->custom_context_funcs.push_back(std::move(func));
+}
+
+void ff::dxgi::draw_recorder::pop_custom_context()
+{
+    this->add_command(command_type::pop_custom_context);
+}
+
+void ff::dxgi::draw_recorder::push_sampler_linear_filter(bool linear_filter)
+{
+    this->add_command(command_type::push_sampler_linear_filter).flag = linear_filter;
+}
+
+void ff::dxgi::draw_recorder::pop_sampler_linear_filter()
+{
+    this->add_command(command_type::pop_sampler_linear_filter);
+}
+
+ff::dxgi::draw_recorder::command& ff::dxgi::draw_recorder::add_command(ff::dxgi::draw_recorder::command_type type)
+{
+    assert(this->recording_);
+    return this->commands.emplace_back(ff::dxgi::draw_recorder::command{ type });
+}
+
+ff::dxgi::draw_recorder::command& ff::dxgi::draw_recorder::add_draw_command(ff::dxgi::draw_recorder::command_type type)
+{
+    // The matrix only needs to be saved when something is drawn with it
+    if (this->world_matrix_changed)
+    {
+        this->world_matrix_changed = false;
+        this->add_command(command_type::world_matrix).start = static_cast<uint32_t>(this->matrixes.size());
+        this->matrixes.push_back(this->world_matrix_stack_.matrix());
+    }
+
+    return this->add_command(type);
+}
+
+void ff::dxgi::draw_recorder::matrix_changing(const ff::matrix_stack& matrix_stack)
+{
+    this->world_matrix_changed = true;
+}
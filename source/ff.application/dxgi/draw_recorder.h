@@ -0,0 +1,147 @@
+#pragma once
+
+#include "../dxgi/draw_base.h"
+#include "../dxgi/draw_util.h"
+#include "../dxgi/sprite_data.h"
+#include "../types/matrix_stack.h"
+#include "../types/transform.h"
+
+namespace ff::dxgi
+{
+    /// <summary>
+    /// Saves draw calls from any one thread so that they can be replayed later onto a real draw
+    /// </summary>
+    /// <remarks>
+    /// Get one from draw_base::begin_recording. Everything drawn is added after the rest of that draw, when it ends,
+    /// in the order that the recorders were created. This is exactly the same as making all the draw calls on one thread.
+    /// Sprites are turned into geometry while recording, so replay only has to add depth and indexes.
+    /// Textures and palettes must stay alive until the draw that owns the recorder ends.
+    /// </remarks>
+    class draw_recorder : public ff::dxgi::draw_base
+    {
+    public:
+        draw_recorder();
+        draw_recorder(draw_recorder&& other) noexcept = delete;
+        draw_recorder(const draw_recorder& other) = delete;
+        virtual ~draw_recorder() override;
+
+        draw_recorder& operator=(draw_recorder&& other) noexcept = delete;
+        draw_recorder& operator=(const draw_recorder& other) = delete;
+
+        void begin();
+        bool recording() const;
+        void replay(ff::dxgi::draw_util::draw_device_base& draw);
+
+        // draw_base
+        virtual void end_draw() override;
+        virtual ff::dxgi::draw_ptr begin_recording() override;
+
+        virtual void draw_sprite(const ff::dxgi::sprite_data& sprite, const ff::transform& transform) override;
+        virtual void draw_sprites(const ff::dxgi::sprite_data* const* sprites, const ff::transform* transforms, size_t count) override;
+
+        virtual void draw_line_strip(const ff::point_float* points, const DirectX::XMFLOAT4* colors, size_t count, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_line_strip(const ff::point_float* points, size_t count, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_line(const ff::point_float& start, const ff::point_float& end, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_filled_rectangle(const ff::rect_float& rect, const DirectX::XMFLOAT4* colors) override;
+        virtual void draw_filled_rectangle(const ff::rect_float& rect, const DirectX::XMFLOAT4& color) override;
+        virtual void draw_filled_triangles(const ff::point_float* points, const DirectX::XMFLOAT4* colors, size_t count) override;
+        virtual void draw_filled_circle(const ff::point_float& center, float radius, const DirectX::XMFLOAT4& color) override;
+        virtual void draw_filled_circle(const ff::point_float& center, float radius, const DirectX::XMFLOAT4& inside_color, const DirectX::XMFLOAT4& outside_color) override;
+        virtual void draw_outline_rectangle(const ff::rect_float& rect, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_outline_circle(const ff::point_float& center, float radius, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_outline_circle(const ff::point_float& center, float radius, const DirectX::XMFLOAT4& inside_color, const DirectX::XMFLOAT4& outside_color, float thickness, bool pixel_thickness = false) override;
+
+        virtual void draw_palette_line_strip(const ff::point_float* points, const int* colors, size_t count, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_palette_line_strip(const ff::point_float* points, size_t count, int color, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_palette_line(const ff::point_float& start, const ff::point_float& end, int color, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_palette_filled_rectangle(const ff::rect_float& rect, const int* colors) override;
+        virtual void draw_palette_filled_rectangle(const ff::rect_float& rect, int color) override;
+        virtual void draw_palette_filled_triangles(const ff::point_float* points, const int* colors, size_t count) override;
+        virtual void draw_palette_filled_circle(const ff::point_float& center, float radius, int color) override;
+        virtual void draw_palette_filled_circle(const ff::point_float& center, float radius, int inside_color, int outside_color) override;
+        virtual void draw_palette_outline_rectangle(const ff::rect_float& rect, int color, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_palette_outline_circle(const ff::point_float& center, float radius, int color, float thickness, bool pixel_thickness = false) override;
+        virtual void draw_palette_outline_circle(const ff::point_float& center, float radius, int inside_color, int outside_color, float thickness, bool pixel_thickness = false) override;
+
+        virtual ff::matrix_stack& world_matrix_stack() override;
+
+        virtual void push_palette(ff::dxgi::palette_base* palette) override;
+        virtual void pop_palette() override;
+        virtual void push_palette_remap(const uint8_t* remap, size_t hash) override;
+        virtual void pop_palette_remap() override;
+        virtual void push_no_overlap() override;
+        virtual void pop_no_overlap() override;
+        virtual void push_opaque() override;
+        virtual void pop_opaque() override;
+        virtual void push_pre_multiplied_alpha() override;
+        virtual void pop_pre_multiplied_alpha() override;
+        virtual void push_custom_context(ff::dxgi::draw_base::custom_context_func&& func) override;
+        virtual void pop_custom_context() override;
+        virtual void push_sampler_linear_filter(bool linear_filter) override;
+        virtual void pop_sampler_linear_filter() override;
+
+    private:
+        enum class command_type : uint8_t
+        {
+            sprite,
+            line_strip,
+            filled_rectangle,
+            filled_triangles,
+            outline_rectangle,
+            outline_circle,
+            palette_line_strip,
+            palette_filled_rectangle,
+            palette_filled_triangles,
+            palette_outline_rectangle,
+            palette_outline_circle,
+            world_matrix,
+            push_palette,
+            pop_palette,
+            push_palette_remap,
+            pop_palette_remap,
+            push_no_overlap,
+            pop_no_overlap,
+            push_opaque,
+            pop_opaque,
+            push_pre_multiplied_alpha,
+            pop_pre_multiplied_alpha,
+            push_custom_context,
+            pop_custom_context,
+            push_sampler_linear_filter,
+            pop_sampler_linear_filter,
+        };
+
+        // Shapes use rect (or rect.top_left() as a center), the rest of the data is in the vectors below
+        struct command
+        {
+            command_type type;
+            bool flag; // pixel thickness, or linear filter
+            bool per_point_colors; // line strips have a color for each point instead of just one
+            uint32_t start; // first item in the vector for this type of command
+            uint32_t count; // sprites, points, triangles, or colors
+            uint32_t color_start;
+            float thickness;
+            float radius;
+            ff::rect_float rect;
+            const void* data; // palette or palette remap
+            size_t hash; // palette remap
+        };
+
+        ff::dxgi::draw_recorder::command& add_command(ff::dxgi::draw_recorder::command_type type);
+        ff::dxgi::draw_recorder::command& add_draw_command(ff::dxgi::draw_recorder::command_type type);
+        void matrix_changing(const ff::matrix_stack& matrix_stack);
+
+        std::vector<ff::dxgi::draw_recorder::command> commands;
+        std::vector<ff::dxgi::draw_util::recorded_sprite> sprites;
+        std::vector<ff::point_float> points;
+        std::vector<DirectX::XMFLOAT4> colors;
+        std::vector<int> palette_colors;
+        std::vector<DirectX::XMFLOAT4X4> matrixes;
+        std::vector<ff::dxgi::draw_base::custom_context_func> custom_context_funcs;
+
+        ff::matrix_stack world_matrix_stack_;
+        ff::signal_connection world_matrix_stack_changing_connection;
+        bool world_matrix_changed{};
+        bool recording_{};
+    };
+}
@@ -2,6 +2,7 @@
 #include "dxgi/buffer_base.h"
 #include "dxgi/depth_base.h"
 #include "dxgi/draw_device_base.h"
+#include "dxgi/draw_recorder.h"
 #include "dxgi/draw_util.h"
 #include "dxgi/format_util.h"
 #include "dxgi/palette_data_base.h"
@@ -14,6 +15,12 @@
 #include "types/transform.h"
 #include "types/vertex.h"
 
+static ff::perf_counter perf_alpha_sort("Alpha sort", ff::perf_color::green);
+static ff::perf_counter perf_alpha_entries("Alpha entries", ff::perf_color::green);
+static ff::perf_counter perf_alpha_draws("Alpha draws", ff::perf_color::green);
+static ff::perf_counter perf_matrix_probes("Matrix probes", ff::perf_color::green);
+static ff::perf_counter perf_upload_bytes("Upload bytes", ff::perf_color::green);
+
 namespace
 {
     enum class alpha_type
@@ -54,15 +61,15 @@ static ::alpha_type get_alpha_type(const DirectX::XMFLOAT4* colors, size_t count
     return type;
 }
 
-static ::alpha_type get_alpha_type(const ff::dxgi::sprite_data& data, const DirectX::XMFLOAT4& color, bool force_opaque)
+static ::alpha_type get_alpha_type(ff::dxgi::sprite_type type, const DirectX::XMFLOAT4& color, bool force_opaque)
 {
     switch (::get_alpha_type(color, force_opaque))
     {
         case ::alpha_type::transparent:
-            return ff::flags::has(data.type(), ff::dxgi::sprite_type::palette) ? alpha_type::opaque : alpha_type::transparent;
+            return ff::flags::has(type, ff::dxgi::sprite_type::palette) ? alpha_type::opaque : alpha_type::transparent;
 
         case ::alpha_type::opaque:
-            return (ff::flags::has(data.type(), ff::dxgi::sprite_type::transparent) && !force_opaque)
+            return (ff::flags::has(type, ff::dxgi::sprite_type::transparent) && !force_opaque)
                 ? ::alpha_type::transparent
                 : ::alpha_type::opaque;
 
@@ -71,6 +78,11 @@ static ::alpha_type get_alpha_type(const ff::dxgi::sprite_data& data, const Dire
     }
 }
 
+static ::alpha_type get_alpha_type(const ff::dxgi::sprite_data& data, const DirectX::XMFLOAT4& color, bool force_opaque)
+{
+    return ::get_alpha_type(data.type(), color, force_opaque);
+}
+
 static ::alpha_type get_alpha_type(const ff::dxgi::sprite_data** datas, const DirectX::XMFLOAT4* colors, size_t count, bool force_opaque)
 {
     ::alpha_type type = ::get_alpha_type(*datas[0], colors[0], force_opaque);
@@ -86,6 +98,79 @@ static ::alpha_type get_alpha_type(const ff::dxgi::sprite_data** datas, const Di
     return type;
 }
 
+// Same as calling get_alpha_type(sprite, color) and transform.rotation_radians() for up to four sprites, but does the math together
+static void get_sprite_alpha_types(const ff::dxgi::sprite_data* const* sprites, const ff::transform* transforms, size_t count, bool force_opaque, ::alpha_type* alpha_types, float* radians)
+{
+    assert(count && count <= 4);
+    alignas(16) float alphas[4]{ 1, 1, 1, 1 };
+    alignas(16) float degrees[4]{};
+
+    for (size_t i = 0; i < count; i++)
+    {
+        alphas[i] = transforms[i].color.w;
+        degrees[i] = transforms[i].rotation;
+    }
+
+    const DirectX::XMVECTOR alpha = DirectX::XMLoadFloat4A(reinterpret_cast<const DirectX::XMFLOAT4A*>(alphas));
+    const int invisible_mask = _mm_movemask_ps(DirectX::XMVectorEqual(alpha, DirectX::XMVectorZero()));
+    const int opaque_mask = force_opaque ? 0xF : _mm_movemask_ps(DirectX::XMVectorEqual(alpha, DirectX::XMVectorSplatOne()));
+
+    // Matches ff::math::degrees_to_radians exactly: degrees * pi / 180
+    const DirectX::XMVECTOR rotation = DirectX::XMVectorDivide(
+        DirectX::XMVectorMultiply(DirectX::XMLoadFloat4A(reinterpret_cast<const DirectX::XMFLOAT4A*>(degrees)), DirectX::XMVectorReplicate(std::numbers::pi_v<float>)),
+        DirectX::XMVectorReplicate(180.0f));
+
+    alignas(16) float rotation_values[4];
+    DirectX::XMStoreFloat4A(reinterpret_cast<DirectX::XMFLOAT4A*>(rotation_values), rotation);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const ff::dxgi::sprite_type type = sprites[i]->type();
+        radians[i] = rotation_values[i];
+
+        if (invisible_mask & (1 << i))
+        {
+            alpha_types[i] = ::alpha_type::invisible;
+        }
+        else if (opaque_mask & (1 << i))
+        {
+            alpha_types[i] = (ff::flags::has(type, ff::dxgi::sprite_type::transparent) && !force_opaque) ? ::alpha_type::transparent : ::alpha_type::opaque;
+        }
+        else
+        {
+            alpha_types[i] = ff::flags::has(type, ff::dxgi::sprite_type::palette) ? ::alpha_type::opaque : ::alpha_type::transparent;
+        }
+    }
+}
+
+static ff::dxgi::draw_util::geometry_bucket_type get_sprite_bucket_type(::alpha_type alpha_type, bool use_palette, bool target_requires_palette)
+{
+    return (alpha_type == ::alpha_type::transparent && !target_requires_palette)
+        ? (use_palette ? ff::dxgi::draw_util::geometry_bucket_type::palette_sprites : ff::dxgi::draw_util::geometry_bucket_type::sprites_alpha)
+        : (use_palette ? ff::dxgi::draw_util::geometry_bucket_type::palette_sprites : ff::dxgi::draw_util::geometry_bucket_type::sprites);
+}
+
+static void set_sprite_geometry(
+    ff::vertex::sprite_geometry& input,
+    const ff::dxgi::sprite_data& sprite,
+    const ff::transform& transform,
+    float depth,
+    float rotate,
+    unsigned int model_index,
+    unsigned int texture_index)
+{
+    input.rect = *reinterpret_cast<const DirectX::XMFLOAT4*>(&sprite.world());
+    input.uv_rect = *reinterpret_cast<const DirectX::XMFLOAT4*>(&sprite.texture_uv());
+    input.color = transform.color;
+    input.scale = *reinterpret_cast<const DirectX::XMFLOAT2*>(&transform.scale);
+    input.position.x = transform.position.x;
+    input.position.y = transform.position.y;
+    input.position.z = depth;
+    input.rotate = rotate;
+    input.texture_index = texture_index;
+    input.matrix_index = model_index;
+}
+
 const std::array<uint8_t, ff::dxgi::palette_size>& ff::dxgi::draw_util::default_palette_remap()
 {
     static std::array<uint8_t, ff::dxgi::palette_size> value
@@ -339,8 +424,20 @@ void ff::dxgi::draw_util::draw_device_base::end_draw()
 {
     if (this->state == state_t::drawing)
     {
+        for (size_t i = 0; i < this->recorder_count; i++)
+        {
+            ff::dxgi::draw_recorder& recorder = *this->recorders[i];
+            assert_msg(!recorder.recording(), "Recording must end before the draw that owns it");
+            recorder.replay(*this);
+        }
+
+        this->recorder_count = 0;
         this->flush(true);
 
+        // Matrixes can be used by the next few draws
+        this->world_matrix_index = ff::constants::invalid_unsigned<DWORD>();
+        this->evict_world_matrixes(this->draw_start_generations[this->begin_draw_count % this->draw_start_generations.size()]);
+
         this->state = draw_device_base::state_t::valid;
         this->command_context_ = nullptr;
         this->palette_stack.resize(1);
@@ -352,6 +449,7 @@ void ff::dxgi::draw_util::draw_device_base::end_draw()
         this->force_no_overlap = 0;
         this->force_opaque = 0;
         this->force_pre_multiplied_alpha = 0;
+        this->sort_alpha = false;
     }
 }
 
@@ -361,22 +459,93 @@ void ff::dxgi::draw_util::draw_device_base::draw_sprite(const ff::dxgi::sprite_d
     if (alpha_type != ::alpha_type::invisible && sprite.view())
     {
         bool use_palette = ff::flags::has(sprite.type(), ff::dxgi::sprite_type::palette);
-        ff::dxgi::draw_util::geometry_bucket_type bucket_type = (alpha_type == ::alpha_type::transparent && !this->target_requires_palette_)
-            ? (use_palette ? ff::dxgi::draw_util::geometry_bucket_type::palette_sprites : ff::dxgi::draw_util::geometry_bucket_type::sprites_alpha)
-            : (use_palette ? ff::dxgi::draw_util::geometry_bucket_type::palette_sprites : ff::dxgi::draw_util::geometry_bucket_type::sprites);
+        ff::dxgi::draw_util::geometry_bucket_type bucket_type = ::get_sprite_bucket_type(alpha_type, use_palette, this->target_requires_palette_);
+
+        // Indexes first, they might need to flush
+        unsigned int model_index, texture_index;
+        this->get_world_matrix_and_texture_index(*sprite.view(), use_palette, model_index, texture_index);
 
         float depth = this->nudge_depth(this->force_no_overlap ? ff::dxgi::draw_util::last_depth_type::sprite_no_overlap : ff::dxgi::draw_util::last_depth_type::sprite);
         ff::vertex::sprite_geometry& input = *reinterpret_cast<ff::vertex::sprite_geometry*>(this->add_geometry(nullptr, bucket_type, depth));
+        ::set_sprite_geometry(input, sprite, transform, depth, transform.rotation_radians(), model_index, texture_index);
+    }
+}
+
+void ff::dxgi::draw_util::draw_device_base::draw_sprites(const ff::dxgi::sprite_data* const* sprites, const ff::transform* transforms, size_t count)
+{
+    const bool force_opaque = this->force_opaque || this->target_requires_palette_;
+    const ff::dxgi::draw_util::last_depth_type depth_type = this->force_no_overlap ? ff::dxgi::draw_util::last_depth_type::sprite_no_overlap : ff::dxgi::draw_util::last_depth_type::sprite;
+    std::array<::alpha_type, 4> alpha_types;
+    std::array<float, 4> radians;
+
+    // Sprites in a row usually share a texture, the indexes stay valid until the next flush
+    const ff::dxgi::texture_view_base* last_view{};
+    bool last_use_palette{};
+    size_t last_flush_generation{};
+    unsigned int model_index{}, texture_index{};
+
+    for (size_t i = 0; i < count; i += alpha_types.size())
+    {
+        const size_t block_count = std::min(count - i, alpha_types.size());
+        ::get_sprite_alpha_types(sprites + i, transforms + i, block_count, force_opaque, alpha_types.data(), radians.data());
+
+        for (size_t j = 0; j < block_count; j++)
+        {
+            const ff::dxgi::sprite_data& sprite = *sprites[i + j];
+            ff::dxgi::texture_view_base* view = sprite.view();
+            if (alpha_types[j] == ::alpha_type::invisible || !view)
+            {
+                continue;
+            }
+
+            const bool use_palette = ff::flags::has(sprite.type(), ff::dxgi::sprite_type::palette);
+            if (view != last_view || use_palette != last_use_palette || this->flush_generation != last_flush_generation)
+            {
+                this->get_world_matrix_and_texture_index(*view, use_palette, model_index, texture_index);
+                last_view = view;
+                last_use_palette = use_palette;
+                last_flush_generation = this->flush_generation;
+            }
+
+            const float depth = this->nudge_depth(depth_type);
+            void* input = this->add_geometry(nullptr, ::get_sprite_bucket_type(alpha_types[j], use_palette, this->target_requires_palette_), depth);
+            ::set_sprite_geometry(*reinterpret_cast<ff::vertex::sprite_geometry*>(input), sprite, transforms[i + j], depth, radians[j], model_index, texture_index);
+        }
+    }
+}
+
+// Same as draw_sprites, but the recorder already did everything that doesn't depend on the state of this draw
+void ff::dxgi::draw_util::draw_device_base::draw_recorded_sprites(const ff::dxgi::draw_util::recorded_sprite* sprites, size_t count)
+{
+    const bool force_opaque = this->force_opaque || this->target_requires_palette_;
+    const ff::dxgi::draw_util::last_depth_type depth_type = this->force_no_overlap ? ff::dxgi::draw_util::last_depth_type::sprite_no_overlap : ff::dxgi::draw_util::last_depth_type::sprite;
+
+    const ff::dxgi::texture_view_base* last_view{};
+    bool last_use_palette{};
+    size_t last_flush_generation{};
+    unsigned int model_index{}, texture_index{};
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const ff::dxgi::draw_util::recorded_sprite& sprite = sprites[i];
+        const ::alpha_type alpha_type = ::get_alpha_type(sprite.type, sprite.geometry.color, force_opaque);
+        const bool use_palette = ff::flags::has(sprite.type, ff::dxgi::sprite_type::palette);
+
+        if (sprite.view != last_view || use_palette != last_use_palette || this->flush_generation != last_flush_generation)
+        {
+            this->get_world_matrix_and_texture_index(*sprite.view, use_palette, model_index, texture_index);
+            last_view = sprite.view;
+            last_use_palette = use_palette;
+            last_flush_generation = this->flush_generation;
+        }
+
+        const float depth = this->nudge_depth(depth_type);
+        ff::vertex::sprite_geometry& input = *reinterpret_cast<ff::vertex::sprite_geometry*>(
+            this->add_geometry(&sprite.geometry, ::get_sprite_bucket_type(alpha_type, use_palette, this->target_requires_palette_), depth));
 
-        this->get_world_matrix_and_texture_index(*sprite.view(), use_palette, input.matrix_index, input.texture_index);
-        input.position.x = transform.position.x;
-        input.position.y = transform.position.y;
         input.position.z = depth;
-        input.scale = *reinterpret_cast<const DirectX::XMFLOAT2*>(&transform.scale);
-        input.rotate = transform.rotation_radians();
-        input.color = transform.color;
-        input.uv_rect = *reinterpret_cast<const DirectX::XMFLOAT4*>(&sprite.texture_uv());
-        input.rect = *reinterpret_cast<const DirectX::XMFLOAT4*>(&sprite.world());
+        input.texture_index = texture_index;
+        input.matrix_index = model_index;
     }
 }
 
@@ -540,7 +709,7 @@ void ff::dxgi::draw_util::draw_device_base::draw_outline_circle(const ff::point_
 
 void ff::dxgi::draw_util::draw_device_base::draw_palette_line_strip(const ff::point_float* points, const int* colors, size_t count, float thickness, bool pixel_thickness)
 {
-    ff::stack_vector<DirectX::XMFLOAT4, 64> colors2;
+    ff::frame_vector<DirectX::XMFLOAT4> colors2;
     colors2.resize(count);
 
     for (size_t i = 0; i != colors2.size(); i++)
@@ -583,7 +752,7 @@ void ff::dxgi::draw_util::draw_device_base::draw_palette_filled_rectangle(const
 
 void ff::dxgi::draw_util::draw_device_base::draw_palette_filled_triangles(const ff::point_float* points, const int* colors, size_t count)
 {
-    ff::stack_vector<DirectX::XMFLOAT4, 64 * 3> colors2;
+    ff::frame_vector<DirectX::XMFLOAT4> colors2;
     colors2.resize(count * 3);
 
     for (size_t i = 0; i != colors2.size(); i++)
@@ -804,6 +973,8 @@ ff::dxgi::draw_ptr ff::dxgi::draw_util::draw_device_base::internal_begin_draw(
         this->init_geometry_constant_buffer_0(target, view_rect, world_rect);
         this->target_requires_palette_ = ff::dxgi::palette_format(target.format());
         this->force_pre_multiplied_alpha = ff::flags::has(options, ff::dxgi::draw_options::pre_multiplied_alpha) && ff::dxgi::supports_pre_multiplied_alpha(target.format()) ? 1 : 0;
+        this->sort_alpha = ff::flags::has(options, ff::dxgi::draw_options::sort_alpha);
+        this->draw_start_generations[this->begin_draw_count++ % this->draw_start_generations.size()] = this->flush_generation;
         this->state = draw_device_base::state_t::drawing;
 
         return {this, ::draw_ptr_deleter};
@@ -812,6 +983,21 @@ ff::dxgi::draw_ptr ff::dxgi::draw_util::draw_device_base::internal_begin_draw(
     return {nullptr, ::draw_ptr_deleter};
 }
 
+ff::dxgi::draw_ptr ff::dxgi::draw_util::draw_device_base::begin_recording()
+{
+    assert_ret_val(this->state == state_t::drawing, ff::dxgi::draw_ptr(nullptr, ::draw_ptr_deleter));
+
+    if (this->recorder_count == this->recorders.size())
+    {
+        this->recorders.push_back(std::make_unique<ff::dxgi::draw_recorder>());
+    }
+
+    ff::dxgi::draw_recorder* recorder = this->recorders[this->recorder_count++].get();
+    recorder->begin();
+
+    return {recorder, ::draw_ptr_deleter};
+}
+
 bool ff::dxgi::draw_util::draw_device_base::reset()
 {
     this->destroy();
@@ -850,11 +1036,16 @@ void ff::dxgi::draw_util::draw_device_base::destroy()
 
     this->sampler_stack.clear();
     this->custom_context_stack.clear();
+    this->recorder_count = 0;
 
     this->view_matrix = ff::matrix_identity_4x4();
     this->world_matrix_stack_.reset();
     this->world_matrix_to_index.clear();
+    this->world_matrix_generations.clear();
+    this->world_matrix_free_indexes.clear();
+    this->draw_start_generations.fill(0);
     this->world_matrix_index = ff::constants::invalid_unsigned<DWORD>();
+    this->world_matrixes_changed = false;
 
     std::memset(this->textures.data(), 0, ff::array_byte_size(this->textures));
     std::memset(this->textures_using_palette.data(), 0, ff::array_byte_size(this->textures_using_palette));
@@ -879,6 +1070,7 @@ void ff::dxgi::draw_util::draw_device_base::destroy()
     this->force_no_overlap = 0;
     this->force_opaque = 0;
     this->force_pre_multiplied_alpha = 0;
+    this->sort_alpha = false;
 
     for (auto& bucket : this->geometry_buckets)
     {
@@ -888,6 +1080,12 @@ void ff::dxgi::draw_util::draw_device_base::destroy()
 
 void ff::dxgi::draw_util::draw_device_base::flush(bool end_draw)
 {
+    if (this->sort_alpha && this->alpha_geometry.size() > 1)
+    {
+        // Must happen before the geometry buckets get copied and cleared
+        this->sort_alpha_geometry();
+    }
+
     if (this->last_depth_type != ff::dxgi::draw_util::last_depth_type::none && this->create_geometry_buffer())
     {
         this->internal_flush_begin(this->command_context_);
@@ -911,19 +1109,18 @@ void ff::dxgi::draw_util::draw_device_base::flush(bool end_draw)
         this->draw_alpha_geometry();
         this->internal_flush_end(this->command_context_);
 
-        // Reset draw data
+        // Reset draw data, world matrixes are kept but anything not used by a later flush can be replaced
 
-        this->world_matrix_to_index.clear();
+        this->flush_generation++;
         this->world_matrix_index = ff::constants::invalid_unsigned<DWORD>();
+        this->texture_count = 0;
+        this->textures_using_palette_count = 0;
 
         this->palette_to_index.clear();
         this->palette_index = ff::constants::invalid_unsigned<DWORD>();
         this->palette_remap_to_index.clear();
         this->palette_remap_index = ff::constants::invalid_unsigned<DWORD>();
 
-        this->texture_count = 0;
-        this->textures_using_palette_count = 0;
-
         this->alpha_geometry.clear();
         this->last_depth_type = ff::dxgi::draw_util::last_depth_type::none;
 
@@ -995,21 +1192,21 @@ void ff::dxgi::draw_util::draw_device_base::update_geometry_constant_buffer_0()
 {
     this->geometry_constants_0.projection = this->view_matrix;
     this->geometry_constants_buffer_0().update(*this->command_context_, &this->geometry_constants_0, sizeof(ff::dxgi::draw_util::geometry_shader_constants_0));
+    ff::perf_timer::hit(::perf_upload_bytes, sizeof(ff::dxgi::draw_util::geometry_shader_constants_0));
 }
 
 void ff::dxgi::draw_util::draw_device_base::update_geometry_constant_buffer_1()
 {
-    // Build up model matrix array
-    size_t world_matrix_count = this->world_matrix_to_index.size();
-    this->geometry_constants_1.model.resize(world_matrix_count);
-
-    for (const auto& iter : this->world_matrix_to_index)
+    // The model matrix array is kept up to date as matrixes are added, the buffer still has it when nothing was added
+    if (this->world_matrixes_changed)
     {
-        this->geometry_constants_1.model[iter.second] = iter.first;
-    }
+        this->world_matrixes_changed = false;
 
-    size_t buffer_size = sizeof(DirectX::XMFLOAT4X4) * (ff::constants::debug_build ? ff::dxgi::draw_util::MAX_TRANSFORM_MATRIXES : world_matrix_count);
-    this->geometry_constants_buffer_1().update(*this->command_context_, this->geometry_constants_1.model.data(), ff::vector_byte_size(this->geometry_constants_1.model), buffer_size);
+        const size_t byte_size = ff::vector_byte_size(this->geometry_constants_1.model);
+        const size_t buffer_size = ff::constants::debug_build ? sizeof(DirectX::XMFLOAT4X4) * ff::dxgi::draw_util::MAX_TRANSFORM_MATRIXES : byte_size;
+        this->geometry_constants_buffer_1().update(*this->command_context_, this->geometry_constants_1.model.data(), byte_size, buffer_size);
+        ff::perf_timer::hit(::perf_upload_bytes, byte_size);
+    }
 }
 
 void ff::dxgi::draw_util::draw_device_base::update_pixel_constant_buffer_0()
@@ -1025,6 +1222,7 @@ void ff::dxgi::draw_util::draw_device_base::update_pixel_constant_buffer_0()
         }
 
         this->pixel_constants_buffer_0().update(*this->command_context_, &this->pixel_constants_0, sizeof(ff::dxgi::draw_util::pixel_shader_constants_0));
+        ff::perf_timer::hit(::perf_upload_bytes, sizeof(ff::dxgi::draw_util::pixel_shader_constants_0));
     }
 }
 
@@ -1052,6 +1250,7 @@ bool ff::dxgi::draw_util::draw_device_base::create_geometry_buffer()
         }
 
         this->geometry_buffer().unmap();
+        ff::perf_timer::hit(::perf_upload_bytes, byte_size);
 
         return true;
     }
@@ -1091,17 +1290,20 @@ void ff::dxgi::draw_util::draw_device_base::draw_alpha_geometry()
         const size_t custom_size = this->custom_context_stack.size();
         const ff::dxgi::draw_base::custom_context_func* custom_func = custom_size ? &this->custom_context_stack[custom_size - 1] : nullptr;
         this->apply_alpha_state(*this->command_context_);
+        size_t draw_count = 0;
 
         for (size_t i = 0; i < alpha_geometry_size; )
         {
             const ff::dxgi::draw_util::alpha_geometry_entry& entry = this->alpha_geometry[i];
             size_t geometry_count = 1;
 
+            // After sorting, entries next to each other from the same bucket can always be drawn together,
+            // they were drawn one after the other and nothing is drawn between them.
             for (i++; i < alpha_geometry_size; i++, geometry_count++)
             {
                 const ff::dxgi::draw_util::alpha_geometry_entry& entry2 = this->alpha_geometry[i];
                 if (entry2.bucket != entry.bucket ||
-                    entry2.depth != entry.depth ||
+                    (entry2.depth != entry.depth && !this->sort_alpha) ||
                     entry2.index != entry.index + geometry_count)
                 {
                     break;
@@ -1113,9 +1315,272 @@ void ff::dxgi::draw_util::draw_device_base::draw_alpha_geometry()
                 if (!custom_func || (*custom_func)(*this->command_context_, entry.bucket->item_type(), false))
                 {
                     this->draw(*this->command_context_, geometry_count, entry.bucket->render_start() + entry.index);
+                    draw_count++;
+                }
+            }
+        }
+
+        ff::perf_timer::hit(::perf_alpha_entries, alpha_geometry_size);
+        ff::perf_timer::hit(::perf_alpha_draws, draw_count);
+    }
+}
+
+// Alpha geometry is sorted into layers using a coarse grid over the view, anything in the same cell might overlap
+static constexpr size_t alpha_sort_grid_size = 32;
+static constexpr size_t alpha_sort_bucket_count = static_cast<size_t>(ff::dxgi::draw_util::geometry_bucket_type::count) - static_cast<size_t>(ff::dxgi::draw_util::geometry_bucket_type::first_alpha);
+static constexpr int alpha_sort_bucket_bits = 2;
+static_assert(::alpha_sort_bucket_count <= (1 << ::alpha_sort_bucket_bits));
+
+static void add_to_bounds(DirectX::XMVECTOR point, DirectX::XMVECTOR& bounds_min, DirectX::XMVECTOR& bounds_max)
+{
+    bounds_min = DirectX::XMVectorMin(bounds_min, point);
+    bounds_max = DirectX::XMVectorMax(bounds_max, point);
+}
+
+static unsigned int get_bounds(const ff::vertex::line_geometry& input, const ff::point_float& view_scale, DirectX::XMVECTOR& bounds_min, DirectX::XMVECTOR& bounds_max)
+{
+    // Same as line_gs in shaders.hlsl, the miters can stick out far past the end points
+    float thickness_scale = 1;
+    DirectX::XMVECTOR aspect = DirectX::XMVectorSplatOne();
+
+    if (input.thickness[0] < 0)
+    {
+        thickness_scale = -view_scale.y;
+        aspect = DirectX::XMVectorSet(view_scale.y / view_scale.x, 1, 1, 1);
+    }
+
+    const DirectX::XMVECTOR pos0 = DirectX::XMVectorMultiply(DirectX::XMLoadFloat2(&input.position[0]), aspect);
+    const DirectX::XMVECTOR pos1 = DirectX::XMVectorMultiply(DirectX::XMLoadFloat2(&input.position[1]), aspect);
+    const DirectX::XMVECTOR pos2 = DirectX::XMVectorMultiply(DirectX::XMLoadFloat2(&input.position[2]), aspect);
+    const DirectX::XMVECTOR pos3 = DirectX::XMVectorMultiply(DirectX::XMLoadFloat2(&input.position[3]), aspect);
+
+    const DirectX::XMVECTOR dir_line = DirectX::XMVector2Normalize(DirectX::XMVector2Equal(pos1, pos2) ? DirectX::g_XMIdentityR0 : DirectX::XMVectorSubtract(pos2, pos1));
+    const DirectX::XMVECTOR dir_prev = DirectX::XMVector2Equal(pos0, pos1) ? dir_line : DirectX::XMVector2Normalize(DirectX::XMVectorSubtract(pos1, pos0));
+    const DirectX::XMVECTOR dir_next = DirectX::XMVector2Equal(pos2, pos3) ? dir_line : DirectX::XMVector2Normalize(DirectX::XMVectorSubtract(pos3, pos2));
+    const DirectX::XMVECTOR normal = DirectX::XMVector2Orthogonal(dir_line);
+
+    DirectX::XMVECTOR miter1 = DirectX::XMVector2Orthogonal(DirectX::XMVector2Normalize(DirectX::XMVectorAdd(dir_prev, dir_line)));
+    const float miter_dot1 = DirectX::XMVectorGetX(DirectX::XMVector2Dot(miter1, normal));
+    miter1 = DirectX::XMVectorScale(miter1, (input.thickness[0] * thickness_scale / 2) / (miter_dot1 + (miter_dot1 == 0)));
+
+    DirectX::XMVECTOR miter2 = DirectX::XMVector2Orthogonal(DirectX::XMVector2Normalize(DirectX::XMVectorAdd(dir_line, dir_next)));
+    const float miter_dot2 = DirectX::XMVectorGetX(DirectX::XMVector2Dot(miter2, normal));
+    miter2 = DirectX::XMVectorScale(miter2, (input.thickness[1] * thickness_scale / 2) / (miter_dot2 + (miter_dot2 == 0)));
+
+    bounds_min = bounds_max = DirectX::XMVectorDivide(DirectX::XMVectorAdd(pos1, miter1), aspect);
+    ::add_to_bounds(DirectX::XMVectorDivide(DirectX::XMVectorSubtract(pos1, miter1), aspect), bounds_min, bounds_max);
+    ::add_to_bounds(DirectX::XMVectorDivide(DirectX::XMVectorAdd(pos2, miter2), aspect), bounds_min, bounds_max);
+    ::add_to_bounds(DirectX::XMVectorDivide(DirectX::XMVectorSubtract(pos2, miter2), aspect), bounds_min, bounds_max);
+
+    return input.matrix_index;
+}
+
+static unsigned int get_bounds(const ff::vertex::circle_geometry& input, const ff::point_float& view_scale, DirectX::XMVECTOR& bounds_min, DirectX::XMVECTOR& bounds_max)
+{
+    // Thickness is inside the radius, but a thick enough outline can go past the center and out the other side
+    const DirectX::XMVECTOR thickness = (input.thickness < 0)
+        ? DirectX::XMVectorScale(DirectX::XMVectorSet(view_scale.x, view_scale.y, 0, 0), -input.thickness)
+        : DirectX::XMVectorReplicate(input.thickness);
+
+    const DirectX::XMVECTOR center = DirectX::XMLoadFloat2(reinterpret_cast<const DirectX::XMFLOAT2*>(&input.position));
+    const DirectX::XMVECTOR extent = DirectX::XMVectorAdd(DirectX::XMVectorReplicate(std::abs(input.radius)), DirectX::XMVectorAbs(thickness));
+
+    bounds_min = DirectX::XMVectorSubtract(center, extent);
+    bounds_max = DirectX::XMVectorAdd(center, extent);
+
+    return input.matrix_index;
+}
+
+static unsigned int get_bounds(const ff::vertex::triangle_geometry& input, const ff::point_float& view_scale, DirectX::XMVECTOR& bounds_min, DirectX::XMVECTOR& bounds_max)
+{
+    bounds_min = bounds_max = DirectX::XMLoadFloat2(&input.position[0]);
+    ::add_to_bounds(DirectX::XMLoadFloat2(&input.position[1]), bounds_min, bounds_max);
+    ::add_to_bounds(DirectX::XMLoadFloat2(&input.position[2]), bounds_min, bounds_max);
+
+    return input.matrix_index;
+}
+
+static unsigned int get_bounds(const ff::vertex::sprite_geometry& input, const ff::point_float& view_scale, DirectX::XMVECTOR& bounds_min, DirectX::XMVECTOR& bounds_max)
+{
+    // Bounding circle, so that the rotation doesn't matter
+    const DirectX::XMVECTOR rect = DirectX::XMVectorAbs(DirectX::XMVectorMultiply(DirectX::XMLoadFloat4(&input.rect),
+        DirectX::XMVectorSet(input.scale.x, input.scale.y, input.scale.x, input.scale.y)));
+    const DirectX::XMVECTOR corner = DirectX::XMVectorMax(rect, DirectX::XMVectorSwizzle<2, 3, 0, 1>(rect));
+    const DirectX::XMVECTOR radius = DirectX::XMVector2Length(corner);
+    const DirectX::XMVECTOR center = DirectX::XMLoadFloat2(reinterpret_cast<const DirectX::XMFLOAT2*>(&input.position));
+
+    bounds_min = DirectX::XMVectorSubtract(center, radius);
+    bounds_max = DirectX::XMVectorAdd(center, radius);
+
+    return input.matrix_index;
+}
+
+template<class T>
+static unsigned int get_bounds(const ff::dxgi::draw_util::alpha_geometry_entry& entry, const ff::point_float& view_scale, DirectX::XMVECTOR& bounds_min, DirectX::XMVECTOR& bounds_max)
+{
+    const T& input = *reinterpret_cast<const T*>(entry.bucket->data() + entry.index * entry.bucket->item_size());
+    return ::get_bounds(input, view_scale, bounds_min, bounds_max);
+}
+
+static unsigned int get_bounds(const ff::dxgi::draw_util::alpha_geometry_entry& entry, const ff::point_float& view_scale, DirectX::XMVECTOR& bounds_min, DirectX::XMVECTOR& bounds_max)
+{
+    switch (entry.bucket->bucket_type())
+    {
+        case ff::dxgi::draw_util::geometry_bucket_type::lines_alpha:
+            return ::get_bounds<ff::vertex::line_geometry>(entry, view_scale, bounds_min, bounds_max);
+
+        case ff::dxgi::draw_util::geometry_bucket_type::circles_alpha:
+            return ::get_bounds<ff::vertex::circle_geometry>(entry, view_scale, bounds_min, bounds_max);
+
+        case ff::dxgi::draw_util::geometry_bucket_type::triangles_alpha:
+            return ::get_bounds<ff::vertex::triangle_geometry>(entry, view_scale, bounds_min, bounds_max);
+
+        default:
+            assert(entry.bucket->bucket_type() == ff::dxgi::draw_util::geometry_bucket_type::sprites_alpha);
+            return ::get_bounds<ff::vertex::sprite_geometry>(entry, view_scale, bounds_min, bounds_max);
+    }
+}
+
+void ff::dxgi::draw_util::draw_device_base::sort_alpha_geometry()
+{
+    // Alpha entries from a single bucket are already in the best order
+    const size_t size = this->alpha_geometry.size();
+    bool mixed = false;
+    size_t max_index = 0;
+
+    for (const ff::dxgi::draw_util::alpha_geometry_entry& entry : this->alpha_geometry)
+    {
+        mixed |= (entry.bucket != this->alpha_geometry[0].bucket);
+        max_index = std::max(max_index, entry.index);
+    }
+
+    if (!mixed)
+    {
+        return;
+    }
+
+    ff::perf_timer timer(::perf_alpha_sort);
+
+    // Each world matrix combined with the view matrix, to get the bounds of each entry in view space (-1 to 1)
+    const DirectX::XMMATRIX view_matrix = DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&this->view_matrix));
+    this->alpha_sort_matrixes.resize(this->geometry_constants_1.model.size());
+
+    for (size_t i = 0; i < this->alpha_sort_matrixes.size(); i++)
+    {
+        if (this->world_matrix_generations[i] == this->flush_generation)
+        {
+            const DirectX::XMMATRIX world_matrix = DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&this->geometry_constants_1.model[i]));
+            DirectX::XMStoreFloat4x4(&this->alpha_sort_matrixes[i], world_matrix * view_matrix);
+        }
+    }
+
+    // Each entry goes into the lowest layer that is still drawn after everything it overlaps from other buckets.
+    // Overlapping entries from the same bucket can share a layer since they stay in index order within the layer.
+    // Each grid cell remembers the highest layer (plus one) used by each bucket.
+    this->alpha_sort_cells.assign(::alpha_sort_grid_size * ::alpha_sort_grid_size * ::alpha_sort_bucket_count, 0);
+    this->alpha_sort_keys.resize(size);
+
+    const int index_bits = std::bit_width(max_index);
+    const DirectX::XMVECTOR grid_scale = DirectX::XMVectorReplicate(::alpha_sort_grid_size / 2.0f);
+    const DirectX::XMVECTOR grid_margin = DirectX::XMVectorReplicate(1.0f / 64.0f);
+    const DirectX::XMVECTOR grid_max = DirectX::XMVectorReplicate(static_cast<float>(::alpha_sort_grid_size - 1));
+    uint32_t max_layer = 0;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        const ff::dxgi::draw_util::alpha_geometry_entry& entry = this->alpha_geometry[i];
+        const size_t bucket = static_cast<size_t>(entry.bucket->bucket_type()) - static_cast<size_t>(ff::dxgi::draw_util::geometry_bucket_type::first_alpha);
+
+        DirectX::XMVECTOR local_min, local_max;
+        const unsigned int matrix_index = ::get_bounds(entry, this->geometry_constants_0.view_scale, local_min, local_max);
+        const DirectX::XMMATRIX matrix = DirectX::XMLoadFloat4x4(&this->alpha_sort_matrixes[matrix_index]);
+
+        DirectX::XMVECTOR view_min, view_max;
+        view_min = view_max = DirectX::XMVector2Transform(local_min, matrix);
+        ::add_to_bounds(DirectX::XMVector2Transform(local_max, matrix), view_min, view_max);
+        ::add_to_bounds(DirectX::XMVector2Transform(DirectX::XMVectorSelect(local_min, local_max, DirectX::g_XMSelect1000), matrix), view_min, view_max);
+        ::add_to_bounds(DirectX::XMVector2Transform(DirectX::XMVectorSelect(local_min, local_max, DirectX::g_XMSelect0100), matrix), view_min, view_max);
+
+        size_t x0 = 0, y0 = 0, x1 = ::alpha_sort_grid_size - 1, y1 = ::alpha_sort_grid_size - 1;
+        if (!DirectX::XMVector2IsNaN(view_min) && !DirectX::XMVector2IsNaN(view_max))
+        {
+            // Offscreen geometry gets clamped to the edges, which is fine since it can't overlap anything
+            view_min = DirectX::XMVectorClamp(DirectX::XMVectorSubtract(DirectX::XMVectorMultiply(DirectX::XMVectorAdd(view_min, DirectX::g_XMOne), grid_scale), grid_margin), DirectX::g_XMZero, grid_max);
+            view_max = DirectX::XMVectorClamp(DirectX::XMVectorAdd(DirectX::XMVectorMultiply(DirectX::XMVectorAdd(view_max, DirectX::g_XMOne), grid_scale), grid_margin), DirectX::g_XMZero, grid_max);
+
+            x0 = static_cast<size_t>(DirectX::XMVectorGetX(view_min));
+            y0 = static_cast<size_t>(DirectX::XMVectorGetY(view_min));
+            x1 = static_cast<size_t>(DirectX::XMVectorGetX(view_max));
+            y1 = static_cast<size_t>(DirectX::XMVectorGetY(view_max));
+        }
+
+        uint32_t layer = 0;
+
+        for (size_t y = y0; y <= y1; y++)
+        {
+            const uint32_t* cell = &this->alpha_sort_cells[(y * ::alpha_sort_grid_size + x0) * ::alpha_sort_bucket_count];
+
+            for (size_t x = x0; x <= x1; x++, cell += ::alpha_sort_bucket_count)
+            {
+                for (size_t b = 0; b < ::alpha_sort_bucket_count; b++)
+                {
+                    layer = std::max(layer, cell[b] - (cell[b] && b == bucket));
                 }
             }
         }
+
+        for (size_t y = y0; y <= y1; y++)
+        {
+            uint32_t* cell = &this->alpha_sort_cells[(y * ::alpha_sort_grid_size + x0) * ::alpha_sort_bucket_count + bucket];
+
+            for (size_t x = x0; x <= x1; x++, cell += ::alpha_sort_bucket_count)
+            {
+                *cell = layer + 1;
+            }
+        }
+
+        max_layer = std::max(max_layer, layer);
+        this->alpha_sort_keys[i] = (static_cast<uint64_t>(layer) << (index_bits + ::alpha_sort_bucket_bits)) | (static_cast<uint64_t>(bucket) << index_bits) | entry.index;
+    }
+
+    // Radix sort by (layer, bucket, index), skipping digits that are the same for every key
+    const int key_bits = std::bit_width(max_layer) + ::alpha_sort_bucket_bits + index_bits;
+    assert(key_bits <= 64);
+
+    this->alpha_sort_keys_sorted.resize(size);
+    this->alpha_geometry_sorted.resize(size);
+
+    for (int shift = 0; shift < key_bits; shift += 8)
+    {
+        std::array<size_t, 256> offsets{};
+
+        for (uint64_t key : this->alpha_sort_keys)
+        {
+            offsets[(key >> shift) & 0xFF]++;
+        }
+
+        if (offsets[(this->alpha_sort_keys[0] >> shift) & 0xFF] == size)
+        {
+            continue;
+        }
+
+        for (size_t i = 0, offset = 0; i < offsets.size(); i++)
+        {
+            const size_t count = offsets[i];
+            offsets[i] = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < size; i++)
+        {
+            const uint64_t key = this->alpha_sort_keys[i];
+            const size_t dest = offsets[(key >> shift) & 0xFF]++;
+            this->alpha_sort_keys_sorted[dest] = key;
+            this->alpha_geometry_sorted[dest] = this->alpha_geometry[i];
+        }
+
+        std::swap(this->alpha_sort_keys, this->alpha_sort_keys_sorted);
+        std::swap(this->alpha_geometry, this->alpha_geometry_sorted);
     }
 }
 
@@ -1149,21 +1614,88 @@ unsigned int ff::dxgi::draw_util::draw_device_base::get_world_matrix_index_no_fl
         DirectX::XMFLOAT4X4 wm;
         DirectX::XMStoreFloat4x4(&wm, DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&this->world_matrix_stack_.matrix())));
         auto iter = this->world_matrix_to_index.find(wm);
+        ff::perf_timer::hit(::perf_matrix_probes, 1);
 
-        if (iter == this->world_matrix_to_index.cend() && this->world_matrix_to_index.size() != ::ff::dxgi::draw_util::MAX_TRANSFORM_MATRIXES)
+        if (iter == this->world_matrix_to_index.cend())
         {
-            iter = this->world_matrix_to_index.try_emplace(wm, static_cast<unsigned int>(this->world_matrix_to_index.size())).first;
+            unsigned int index = this->alloc_world_matrix_index();
+            if (index != ff::constants::invalid_unsigned<DWORD>())
+            {
+                iter = this->world_matrix_to_index.try_emplace(wm, index).first;
+                this->geometry_constants_1.model[index] = wm;
+                this->world_matrixes_changed = true;
+            }
         }
 
         if (iter != this->world_matrix_to_index.cend())
         {
             this->world_matrix_index = iter->second;
+            this->world_matrix_generations[iter->second] = this->flush_generation;
         }
     }
 
     return this->world_matrix_index;
 }
 
+unsigned int ff::dxgi::draw_util::draw_device_base::alloc_world_matrix_index()
+{
+    std::vector<DirectX::XMFLOAT4X4>& model = this->geometry_constants_1.model;
+
+    if (this->world_matrix_free_indexes.empty() && model.size() == ff::dxgi::draw_util::MAX_TRANSFORM_MATRIXES)
+    {
+        // Anything not used since the last flush can be replaced, those draws already have their own copy of the buffer
+        this->evict_world_matrixes(this->flush_generation);
+    }
+
+    if (!this->world_matrix_free_indexes.empty())
+    {
+        unsigned int index = this->world_matrix_free_indexes.back();
+        this->world_matrix_free_indexes.pop_back();
+        return index;
+    }
+
+    if (model.size() < ff::dxgi::draw_util::MAX_TRANSFORM_MATRIXES)
+    {
+        model.emplace_back();
+        this->world_matrix_generations.push_back(0);
+        return static_cast<unsigned int>(model.size() - 1);
+    }
+
+    return ff::constants::invalid_unsigned<DWORD>();
+}
+
+void ff::dxgi::draw_util::draw_device_base::evict_world_matrixes(size_t min_generation)
+{
+    std::vector<DirectX::XMFLOAT4X4>& model = this->geometry_constants_1.model;
+
+    for (size_t i = 0; i < model.size(); i++)
+    {
+        size_t& generation = this->world_matrix_generations[i];
+        if (generation && generation < min_generation)
+        {
+            this->world_matrix_to_index.erase(model[i]);
+            generation = 0;
+        }
+    }
+
+    // Free matrixes at the end don't need to be uploaded anymore
+    while (!model.empty() && !this->world_matrix_generations.back())
+    {
+        model.pop_back();
+        this->world_matrix_generations.pop_back();
+    }
+
+    this->world_matrix_free_indexes.clear();
+
+    for (size_t i = model.size(); i != 0; i--)
+    {
+        if (!this->world_matrix_generations[i - 1])
+        {
+            this->world_matrix_free_indexes.push_back(static_cast<unsigned int>(i - 1));
+        }
+    }
+}
+
 unsigned int ff::dxgi::draw_util::draw_device_base::get_texture_index_no_flush(ff::dxgi::texture_view_base& texture_view, bool use_palette)
 {
     if (use_palette)
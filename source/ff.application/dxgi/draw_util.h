@@ -5,18 +5,21 @@
 #include "../dxgi/palette_base.h"
 #include "../types/operators.h"
 #include "../types/matrix_stack.h"
+#include "../types/vertex.h"
 
 namespace ff::dxgi
 {
     class buffer_base;
     class command_context_base;
     class depth_base;
+    class draw_recorder;
     class sprite_data;
     class target_base;
     class texture_base;
     class texture_view_base;
 
     enum class draw_options;
+    enum class sprite_type;
 }
 
 namespace ff::dxgi::draw_util
@@ -26,6 +29,7 @@ namespace ff::dxgi::draw_util
     constexpr size_t MAX_PALETTES = 128; // 256 color palettes only
     constexpr size_t MAX_PALETTE_REMAPS = 128; // 256 entries only
     constexpr size_t MAX_TRANSFORM_MATRIXES = 1024;
+    constexpr size_t RETAIN_TRANSFORM_MATRIX_DRAWS = 4; // world matrixes not used by this many draws in a row are forgotten
     constexpr size_t MAX_RENDER_COUNT = 524288; // 0x00080000
     constexpr float MAX_RENDER_DEPTH = 1.0f;
     constexpr float RENDER_DEPTH_DELTA = MAX_RENDER_DEPTH / MAX_RENDER_COUNT;
@@ -116,6 +120,14 @@ namespace ff::dxgi::draw_util
         float depth;
     };
 
+    // A sprite that was turned into geometry while recording, replay only fills in the depth and indexes
+    struct recorded_sprite
+    {
+        ff::vertex::sprite_geometry geometry;
+        ff::dxgi::texture_view_base* view;
+        ff::dxgi::sprite_type type;
+    };
+
     struct geometry_shader_constants_0
     {
         static const size_t DWORD_COUNT = 18; // don't include padding
@@ -147,7 +159,9 @@ namespace ff::dxgi::draw_util
         draw_device_base& operator=(const draw_device_base& other) = delete;
 
         virtual void end_draw() override;
+        virtual ff::dxgi::draw_ptr begin_recording() override;
         virtual void draw_sprite(const ff::dxgi::sprite_data& sprite, const ff::transform& transform) override;
+        virtual void draw_sprites(const ff::dxgi::sprite_data* const* sprites, const ff::transform* transforms, size_t count) override;
         virtual void draw_line_strip(const ff::point_float* points, const DirectX::XMFLOAT4* colors, size_t count, float thickness, bool pixel_thickness) override;
         virtual void draw_line_strip(const ff::point_float* points, size_t count, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness) override;
         virtual void draw_line(const ff::point_float& start, const ff::point_float& end, const DirectX::XMFLOAT4& color, float thickness, bool pixel_thickness) override;
@@ -234,6 +248,8 @@ namespace ff::dxgi::draw_util
             ff::dxgi::draw_options options);
 
     private:
+        friend class ff::dxgi::draw_recorder;
+
         // device_child_base
         virtual bool reset() override;
 
@@ -241,6 +257,7 @@ namespace ff::dxgi::draw_util
         void flush(bool end_draw = false);
 
         void matrix_changing(const ff::matrix_stack& matrix_stack);
+        void draw_recorded_sprites(const ff::dxgi::draw_util::recorded_sprite* sprites, size_t count);
         void draw_line_strip(const ff::point_float* points, size_t point_count, const DirectX::XMFLOAT4* colors, size_t color_count, float thickness, bool pixel_thickness);
         void init_geometry_constant_buffer_0(ff::dxgi::target_base& target, const ff::rect_float& view_rect, const ff::rect_float& world_rect);
         void update_geometry_constant_buffer_0();
@@ -249,10 +266,13 @@ namespace ff::dxgi::draw_util
         bool create_geometry_buffer();
         void draw_opaque_geometry();
         void draw_alpha_geometry();
+        void sort_alpha_geometry();
+        void evict_world_matrixes(size_t min_generation);
         float nudge_depth(ff::dxgi::draw_util::last_depth_type depth_type);
 
         unsigned int get_world_matrix_index();
         unsigned int get_world_matrix_index_no_flush();
+        unsigned int alloc_world_matrix_index();
         unsigned int get_texture_index_no_flush(ff::dxgi::texture_view_base& texture_view, bool use_palette);
         unsigned int get_palette_index_no_flush();
         unsigned int get_palette_remap_index_no_flush();
@@ -272,6 +292,12 @@ namespace ff::dxgi::draw_util
         } state{};
 
         ff::dxgi::command_context_base* command_context_{};
+        size_t flush_generation{ 1 }; // zero is never a valid generation
+        size_t begin_draw_count{};
+
+        // Recordings from other threads, drawn in order at end_draw
+        std::vector<std::unique_ptr<ff::dxgi::draw_recorder>> recorders;
+        size_t recorder_count{};
 
         // Constant data for shaders
         ff::dxgi::draw_util::geometry_shader_constants_0 geometry_constants_0{};
@@ -286,8 +312,12 @@ namespace ff::dxgi::draw_util
         DirectX::XMFLOAT4X4 view_matrix{};
         ff::matrix_stack world_matrix_stack_;
         ff::signal_connection world_matrix_stack_changing_connection;
-        std::unordered_map<DirectX::XMFLOAT4X4, unsigned int, ff::stable_hash<DirectX::XMFLOAT4X4>> world_matrix_to_index;
+        std::unordered_map<DirectX::XMFLOAT4X4, unsigned int, ff::wide_hash<DirectX::XMFLOAT4X4>> world_matrix_to_index; // kept across flushes and draws
+        std::vector<size_t> world_matrix_generations; // last flush that used each index of geometry_constants_1.model, zero when free
+        std::vector<unsigned int> world_matrix_free_indexes;
+        std::array<size_t, ff::dxgi::draw_util::RETAIN_TRANSFORM_MATRIX_DRAWS> draw_start_generations{};
         unsigned int world_matrix_index{};
+        bool world_matrixes_changed{};
 
         // Textures
         std::array<ff::dxgi::texture_view_base*, ff::dxgi::draw_util::MAX_TEXTURES> textures{};
@@ -312,11 +342,17 @@ namespace ff::dxgi::draw_util
 
         // Render data
         std::vector<ff::dxgi::draw_util::alpha_geometry_entry> alpha_geometry;
+        std::vector<ff::dxgi::draw_util::alpha_geometry_entry> alpha_geometry_sorted;
+        std::vector<uint64_t> alpha_sort_keys;
+        std::vector<uint64_t> alpha_sort_keys_sorted;
+        std::vector<uint32_t> alpha_sort_cells;
+        std::vector<DirectX::XMFLOAT4X4> alpha_sort_matrixes;
         std::array<ff::dxgi::draw_util::geometry_bucket, static_cast<size_t>(ff::dxgi::draw_util::geometry_bucket_type::count)> geometry_buckets;
         ff::dxgi::draw_util::last_depth_type last_depth_type{};
         float draw_depth{};
         int force_no_overlap{};
         int force_opaque{};
         int force_pre_multiplied_alpha{};
+        bool sort_alpha{};
     };
 }
@@ -0,0 +1,439 @@
+#include "pch.h"
+#include "dxgi/palette_data_base.h"
+#include "dxgi/recording_draw_device.h"
+
+ff::dxgi::recording_buffer::recording_buffer(ff::dxgi::buffer_type type)
+    : type_(type)
+{}
+
+const std::vector<uint8_t>& ff::dxgi::recording_buffer::data() const
+{
+    return this->data_;
+}
+
+size_t ff::dxgi::recording_buffer::bytes_written() const
+{
+    return this->bytes_written_;
+}
+
+void ff::dxgi::recording_buffer::reset_bytes_written()
+{
+    this->bytes_written_ = 0;
+}
+
+ff::dxgi::buffer_type ff::dxgi::recording_buffer::type() const
+{
+    return this->type_;
+}
+
+size_t ff::dxgi::recording_buffer::size() const
+{
+    return this->data_.size();
+}
+
+bool ff::dxgi::recording_buffer::writable() const
+{
+    return true;
+}
+
+bool ff::dxgi::recording_buffer::update(ff::dxgi::command_context_base& context, const void* data, size_t size, size_t min_buffer_size)
+{
+    assert_ret_val(!this->mapped, false);
+
+    this->data_.resize(std::max(size, min_buffer_size));
+
+    if (size)
+    {
+        std::memcpy(this->data_.data(), data, size);
+    }
+
+    this->bytes_written_ += size;
+    return true;
+}
+
+void* ff::dxgi::recording_buffer::map(ff::dxgi::command_context_base& context, size_t size)
+{
+    assert_ret_val(!this->mapped, nullptr);
+
+    if (!size)
+    {
+        return nullptr;
+    }
+
+    this->data_.resize(size);
+    this->bytes_written_ += size;
+    this->mapped = true;
+
+    return this->data_.data();
+}
+
+void ff::dxgi::recording_buffer::unmap()
+{
+    assert(this->mapped);
+    this->mapped = false;
+}
+
+ff::dxgi::recording_texture::recording_texture(ff::point_size size, DXGI_FORMAT format, ff::dxgi::sprite_type sprite_type)
+    : size_(size)
+    , format_(format)
+    , sprite_type_(sprite_type)
+{}
+
+size_t ff::dxgi::recording_texture::update_count() const
+{
+    return this->update_count_;
+}
+
+ff::dxgi::sprite_type ff::dxgi::recording_texture::sprite_type() const
+{
+    return this->sprite_type_;
+}
+
+std::shared_ptr<DirectX::ScratchImage> ff::dxgi::recording_texture::data() const
+{
+    return {};
+}
+
+bool ff::dxgi::recording_texture::update(ff::dxgi::command_context_base& context, size_t array_index, size_t mip_index, const ff::point_size& pos, const DirectX::Image& data)
+{
+    this->update_count_++;
+    return true;
+}
+
+ff::point_size ff::dxgi::recording_texture::size() const
+{
+    return this->size_;
+}
+
+size_t ff::dxgi::recording_texture::mip_count() const
+{
+    return 1;
+}
+
+size_t ff::dxgi::recording_texture::array_size() const
+{
+    return 1;
+}
+
+size_t ff::dxgi::recording_texture::sample_count() const
+{
+    return 1;
+}
+
+DXGI_FORMAT ff::dxgi::recording_texture::format() const
+{
+    return this->format_;
+}
+
+ff::dxgi::texture_view_access_base& ff::dxgi::recording_texture::view_access()
+{
+    return *this;
+}
+
+ff::dxgi::texture_base* ff::dxgi::recording_texture::view_texture()
+{
+    return this;
+}
+
+size_t ff::dxgi::recording_texture::view_array_start() const
+{
+    return 0;
+}
+
+size_t ff::dxgi::recording_texture::view_array_size() const
+{
+    return 1;
+}
+
+size_t ff::dxgi::recording_texture::view_mip_start() const
+{
+    return 0;
+}
+
+size_t ff::dxgi::recording_texture::view_mip_size() const
+{
+    return 1;
+}
+
+ff::dxgi::recording_target::recording_target(ff::point_size size, DXGI_FORMAT format)
+    : size_{ size, 1.0, DMDO_DEFAULT }
+    , format_(format)
+{}
+
+void ff::dxgi::recording_target::clear(ff::dxgi::command_context_base& context, const DirectX::XMFLOAT4& clear_color)
+{}
+
+bool ff::dxgi::recording_target::begin_render(ff::dxgi::command_context_base& context, const DirectX::XMFLOAT4* clear_color)
+{
+    return true;
+}
+
+bool ff::dxgi::recording_target::end_render(ff::dxgi::command_context_base& context)
+{
+    return true;
+}
+
+ff::dxgi::target_access_base& ff::dxgi::recording_target::target_access()
+{
+    return *this;
+}
+
+size_t ff::dxgi::recording_target::target_array_start() const
+{
+    return 0;
+}
+
+size_t ff::dxgi::recording_target::target_array_size() const
+{
+    return 1;
+}
+
+size_t ff::dxgi::recording_target::target_mip_start() const
+{
+    return 0;
+}
+
+size_t ff::dxgi::recording_target::target_mip_size() const
+{
+    return 1;
+}
+
+size_t ff::dxgi::recording_target::target_sample_count() const
+{
+    return 1;
+}
+
+DXGI_FORMAT ff::dxgi::recording_target::format() const
+{
+    return this->format_;
+}
+
+ff::window_size ff::dxgi::recording_target::size() const
+{
+    return this->size_;
+}
+
+double ff::dxgi::recording_stats::draws_per_flush() const
+{
+    return this->flush_count ? static_cast<double>(this->draw_count) / static_cast<double>(this->flush_count) : 0.0;
+}
+
+ff::dxgi::recording_draw_device::recording_draw_device(bool record_commands)
+    : record_commands(record_commands)
+{
+    this->as_device_child()->reset();
+}
+
+ff::dxgi::recording_draw_device::~recording_draw_device()
+{}
+
+const std::vector<ff::dxgi::recorded_command>& ff::dxgi::recording_draw_device::commands() const
+{
+    return this->commands_;
+}
+
+const ff::dxgi::recording_stats& ff::dxgi::recording_draw_device::stats() const
+{
+    return this->stats_;
+}
+
+const ff::dxgi::recording_buffer& ff::dxgi::recording_draw_device::recorded_geometry_buffer() const
+{
+    return this->geometry_buffer_;
+}
+
+void ff::dxgi::recording_draw_device::clear_recording()
+{
+    this->commands_.clear();
+    this->stats_ = {};
+    this->geometry_buffer_.reset_bytes_written();
+    this->geometry_constants_buffer_0_.reset_bytes_written();
+    this->geometry_constants_buffer_1_.reset_bytes_written();
+    this->pixel_constants_buffer_0_.reset_bytes_written();
+}
+
+bool ff::dxgi::recording_draw_device::valid() const
+{
+    return this->internal_valid();
+}
+
+ff::dxgi::draw_ptr ff::dxgi::recording_draw_device::begin_draw(
+    ff::dxgi::command_context_base& context,
+    ff::dxgi::target_base& target,
+    ff::dxgi::depth_base* depth,
+    const ff::rect_float& view_rect,
+    const ff::rect_float& world_rect,
+    ff::dxgi::draw_options options)
+{
+    return this->internal_begin_draw(context, target, depth, view_rect, world_rect, options);
+}
+
+void ff::dxgi::recording_draw_device::internal_destroy()
+{
+    assert(!this->context);
+}
+
+void ff::dxgi::recording_draw_device::internal_reset()
+{}
+
+ff::dxgi::command_context_base* ff::dxgi::recording_draw_device::internal_flush(ff::dxgi::command_context_base* context, bool end_draw)
+{
+    if (end_draw)
+    {
+        this->record(ff::dxgi::recorded_command_type::end_draw);
+        this->context = nullptr;
+    }
+
+    return this->context;
+}
+
+ff::dxgi::command_context_base* ff::dxgi::recording_draw_device::internal_setup(ff::dxgi::command_context_base& context, ff::dxgi::target_base& target, ff::dxgi::depth_base* depth, const ff::rect_float& view_rect, bool ignore_rotation)
+{
+    this->context = &context;
+    this->last_bucket = nullptr;
+    this->stats_.begin_draw_count++;
+    this->record(ff::dxgi::recorded_command_type::setup);
+
+    return this->context;
+}
+
+void ff::dxgi::recording_draw_device::internal_flush_begin(ff::dxgi::command_context_base* context)
+{
+    this->stats_.flush_count++;
+    this->record(ff::dxgi::recorded_command_type::flush_begin);
+}
+
+void ff::dxgi::recording_draw_device::internal_flush_end(ff::dxgi::command_context_base* context)
+{
+    this->stats_.geometry_bytes = this->geometry_buffer_.bytes_written();
+    this->stats_.constant_bytes = this->constant_bytes_written();
+    this->record(ff::dxgi::recorded_command_type::flush_end);
+}
+
+ff::dxgi::buffer_base& ff::dxgi::recording_draw_device::geometry_buffer()
+{
+    return this->geometry_buffer_;
+}
+
+ff::dxgi::buffer_base& ff::dxgi::recording_draw_device::geometry_constants_buffer_0()
+{
+    return this->geometry_constants_buffer_0_;
+}
+
+ff::dxgi::buffer_base& ff::dxgi::recording_draw_device::geometry_constants_buffer_1()
+{
+    return this->geometry_constants_buffer_1_;
+}
+
+ff::dxgi::buffer_base& ff::dxgi::recording_draw_device::pixel_constants_buffer_0()
+{
+    return this->pixel_constants_buffer_0_;
+}
+
+bool ff::dxgi::recording_draw_device::flush_for_sampler_change() const
+{
+    return false;
+}
+
+void ff::dxgi::recording_draw_device::update_palette_texture(ff::dxgi::command_context_base& context,
+    size_t textures_using_palette_count,
+    ff::dxgi::texture_base& palette_texture, size_t* palette_texture_hashes, palette_to_index_t& palette_to_index,
+    ff::dxgi::texture_base& palette_remap_texture, size_t* palette_remap_texture_hashes, palette_remap_to_index_t& palette_remap_to_index)
+{
+    // Only rows that changed would be copied to the GPU, same as the DX12 draw device
+    size_t row_count = 0;
+
+    if (textures_using_palette_count)
+    {
+        for (const auto& iter : palette_to_index)
+        {
+            ff::dxgi::palette_base* palette = iter.second.first;
+            if (palette)
+            {
+                size_t row_hash = palette->data()->row_hash(palette->current_row());
+                if (palette_texture_hashes[iter.second.second] != row_hash)
+                {
+                    palette_texture_hashes[iter.second.second] = row_hash;
+                    this->stats_.texture_bytes += ff::dxgi::palette_row_bytes;
+                    row_count++;
+                }
+            }
+        }
+    }
+
+    if (textures_using_palette_count || this->target_requires_palette())
+    {
+        for (const auto& iter : palette_remap_to_index)
+        {
+            if (palette_remap_texture_hashes[iter.second.second] != iter.first)
+            {
+                palette_remap_texture_hashes[iter.second.second] = iter.first;
+                this->stats_.texture_bytes += ff::dxgi::palette_size;
+                row_count++;
+            }
+        }
+    }
+
+    this->stats_.palette_row_update_count += row_count;
+    this->record(ff::dxgi::recorded_command_type::update_palette, {}, row_count);
+}
+
+void ff::dxgi::recording_draw_device::apply_shader_input(ff::dxgi::command_context_base& context,
+    size_t texture_count, ff::dxgi::texture_view_base** textures,
+    size_t textures_using_palette_count, ff::dxgi::texture_view_base** textures_using_palette,
+    ff::dxgi::texture_base& palette_texture, ff::dxgi::texture_base& palette_remap_texture)
+{
+    this->stats_.texture_bind_count += texture_count + textures_using_palette_count;
+    this->record(ff::dxgi::recorded_command_type::shader_input, {}, texture_count, textures_using_palette_count);
+}
+
+void ff::dxgi::recording_draw_device::apply_opaque_state(ff::dxgi::command_context_base& context)
+{
+    this->stats_.state_change_count++;
+    this->record(ff::dxgi::recorded_command_type::opaque_state);
+}
+
+void ff::dxgi::recording_draw_device::apply_alpha_state(ff::dxgi::command_context_base& context)
+{
+    this->stats_.state_change_count++;
+    this->record(ff::dxgi::recorded_command_type::alpha_state);
+}
+
+bool ff::dxgi::recording_draw_device::apply_geometry_state(ff::dxgi::command_context_base& context, const ff::dxgi::draw_util::geometry_bucket& bucket)
+{
+    if (this->last_bucket != &bucket)
+    {
+        this->last_bucket = &bucket;
+        this->stats_.state_change_count++;
+    }
+
+    this->record(ff::dxgi::recorded_command_type::geometry_state, bucket.bucket_type());
+    return true;
+}
+
+std::shared_ptr<ff::dxgi::texture_base> ff::dxgi::recording_draw_device::create_texture(ff::point_size size, DXGI_FORMAT format)
+{
+    return std::make_shared<ff::dxgi::recording_texture>(size, format);
+}
+
+void ff::dxgi::recording_draw_device::draw(ff::dxgi::command_context_base& context, size_t count, size_t start)
+{
+    this->stats_.draw_count++;
+    this->stats_.drawn_item_count += count;
+    this->record(ff::dxgi::recorded_command_type::draw, this->last_bucket ? this->last_bucket->bucket_type() : ff::dxgi::draw_util::geometry_bucket_type{}, count, start);
+}
+
+void ff::dxgi::recording_draw_device::record(ff::dxgi::recorded_command_type type, ff::dxgi::draw_util::geometry_bucket_type bucket_type, size_t count, size_t start)
+{
+    if (this->record_commands)
+    {
+        this->commands_.push_back(ff::dxgi::recorded_command{ type, bucket_type, count, start });
+    }
+}
+
+size_t ff::dxgi::recording_draw_device::constant_bytes_written() const
+{
+    return this->geometry_constants_buffer_0_.bytes_written()
+        + this->geometry_constants_buffer_1_.bytes_written()
+        + this->pixel_constants_buffer_0_.bytes_written();
+}
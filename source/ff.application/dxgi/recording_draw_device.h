@@ -0,0 +1,242 @@
+#pragma once
+
+#include "../dxgi/buffer_base.h"
+#include "../dxgi/command_context_base.h"
+#include "../dxgi/draw_device_base.h"
+#include "../dxgi/draw_util.h"
+#include "../dxgi/sprite_data.h"
+#include "../dxgi/target_access_base.h"
+#include "../dxgi/target_base.h"
+#include "../dxgi/texture_base.h"
+#include "../dxgi/texture_view_access_base.h"
+
+namespace ff::dxgi
+{
+    /// <summary>
+    /// Command context for a recording_draw_device, there is nothing to record into
+    /// </summary>
+    class recording_command_context : public ff::dxgi::command_context_base
+    {};
+
+    /// <summary>
+    /// Buffer that only lives in memory, it keeps the bytes from the last map or update
+    /// </summary>
+    class recording_buffer : public ff::dxgi::buffer_base
+    {
+    public:
+        recording_buffer(ff::dxgi::buffer_type type);
+        recording_buffer(recording_buffer&& other) noexcept = delete;
+        recording_buffer(const recording_buffer& other) = delete;
+
+        recording_buffer& operator=(recording_buffer&& other) noexcept = delete;
+        recording_buffer& operator=(const recording_buffer& other) = delete;
+
+        const std::vector<uint8_t>& data() const;
+        size_t bytes_written() const;
+        void reset_bytes_written();
+
+        // buffer_base
+        virtual ff::dxgi::buffer_type type() const override;
+        virtual size_t size() const override;
+        virtual bool writable() const override;
+        virtual bool update(ff::dxgi::command_context_base& context, const void* data, size_t size, size_t min_buffer_size = 0) override;
+        virtual void* map(ff::dxgi::command_context_base& context, size_t size) override;
+        virtual void unmap() override;
+
+    private:
+        ff::dxgi::buffer_type type_;
+        std::vector<uint8_t> data_;
+        size_t bytes_written_{};
+        bool mapped{};
+    };
+
+    /// <summary>
+    /// Texture without any pixels, good enough to be used as a sprite view by a recording_draw_device
+    /// </summary>
+    class recording_texture : public ff::dxgi::texture_base, public ff::dxgi::texture_view_access_base
+    {
+    public:
+        recording_texture(ff::point_size size, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM, ff::dxgi::sprite_type sprite_type = ff::dxgi::sprite_type::unknown);
+        recording_texture(recording_texture&& other) noexcept = delete;
+        recording_texture(const recording_texture& other) = delete;
+
+        recording_texture& operator=(recording_texture&& other) noexcept = delete;
+        recording_texture& operator=(const recording_texture& other) = delete;
+
+        size_t update_count() const;
+
+        // texture_base
+        virtual ff::dxgi::sprite_type sprite_type() const override;
+        virtual std::shared_ptr<DirectX::ScratchImage> data() const override;
+        virtual bool update(ff::dxgi::command_context_base& context, size_t array_index, size_t mip_index, const ff::point_size& pos, const DirectX::Image& data) override;
+
+        // texture_metadata_base
+        virtual ff::point_size size() const override;
+        virtual size_t mip_count() const override;
+        virtual size_t array_size() const override;
+        virtual size_t sample_count() const override;
+        virtual DXGI_FORMAT format() const override;
+
+        // texture_view_base
+        virtual ff::dxgi::texture_view_access_base& view_access() override;
+        virtual ff::dxgi::texture_base* view_texture() override;
+        virtual size_t view_array_start() const override;
+        virtual size_t view_array_size() const override;
+        virtual size_t view_mip_start() const override;
+        virtual size_t view_mip_size() const override;
+
+    private:
+        ff::point_size size_;
+        DXGI_FORMAT format_;
+        ff::dxgi::sprite_type sprite_type_;
+        size_t update_count_{};
+    };
+
+    /// <summary>
+    /// Render target that only has a size and format
+    /// </summary>
+    class recording_target : public ff::dxgi::target_base, public ff::dxgi::target_access_base
+    {
+    public:
+        recording_target(ff::point_size size, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM);
+        recording_target(recording_target&& other) noexcept = delete;
+        recording_target(const recording_target& other) = delete;
+
+        recording_target& operator=(recording_target&& other) noexcept = delete;
+        recording_target& operator=(const recording_target& other) = delete;
+
+        // target_base
+        virtual void clear(ff::dxgi::command_context_base& context, const DirectX::XMFLOAT4& clear_color) override;
+        virtual bool begin_render(ff::dxgi::command_context_base& context, const DirectX::XMFLOAT4* clear_color = nullptr) override;
+        virtual bool end_render(ff::dxgi::command_context_base& context) override;
+        virtual ff::dxgi::target_access_base& target_access() override;
+        virtual size_t target_array_start() const override;
+        virtual size_t target_array_size() const override;
+        virtual size_t target_mip_start() const override;
+        virtual size_t target_mip_size() const override;
+        virtual size_t target_sample_count() const override;
+        virtual DXGI_FORMAT format() const override;
+        virtual ff::window_size size() const override;
+
+    private:
+        ff::window_size size_;
+        DXGI_FORMAT format_;
+    };
+
+    enum class recorded_command_type
+    {
+        setup,
+        flush_begin,
+        update_palette,
+        shader_input,
+        opaque_state,
+        alpha_state,
+        geometry_state,
+        draw,
+        flush_end,
+        end_draw,
+    };
+
+    struct recorded_command
+    {
+        bool operator==(const ff::dxgi::recorded_command& other) const = default;
+
+        ff::dxgi::recorded_command_type type;
+        ff::dxgi::draw_util::geometry_bucket_type bucket_type; // geometry_state and draw only
+        size_t count; // draw: item count, shader_input: texture count, update_palette: changed rows
+        size_t start; // draw: first item, shader_input: textures using palette count
+    };
+
+    struct recording_stats
+    {
+        double draws_per_flush() const;
+
+        size_t begin_draw_count;
+        size_t flush_count;
+        size_t draw_count;
+        size_t drawn_item_count;
+        size_t state_change_count; // pipeline changes between different bucket types, plus opaque/alpha switches
+        size_t texture_bind_count;
+        size_t palette_row_update_count;
+        size_t geometry_bytes;
+        size_t constant_bytes; // all constant buffers, including world matrixes
+        size_t texture_bytes; // palette and palette remap rows
+    };
+
+    /// <summary>
+    /// Draw device that does all of the normal CPU batching, but records what it would send to the GPU instead
+    /// </summary>
+    /// <remarks>
+    /// This makes the sprite submission path testable and measurable without any graphics device.
+    /// Use recording_target and recording_texture for targets and sprite views, any context can be passed in.
+    /// </remarks>
+    class recording_draw_device : public ff::dxgi::draw_util::draw_device_base, public ff::dxgi::draw_device_base
+    {
+    public:
+        recording_draw_device(bool record_commands = true);
+        virtual ~recording_draw_device() override;
+
+        recording_draw_device(recording_draw_device&& other) noexcept = delete;
+        recording_draw_device(const recording_draw_device& other) = delete;
+        recording_draw_device& operator=(recording_draw_device&& other) noexcept = delete;
+        recording_draw_device& operator=(const recording_draw_device& other) = delete;
+
+        const std::vector<ff::dxgi::recorded_command>& commands() const;
+        const ff::dxgi::recording_stats& stats() const;
+        const ff::dxgi::recording_buffer& recorded_geometry_buffer() const;
+        void clear_recording();
+
+        // ff::dxgi::draw_device_base
+        virtual bool valid() const override;
+        virtual ff::dxgi::draw_ptr begin_draw(
+            ff::dxgi::command_context_base& context,
+            ff::dxgi::target_base& target,
+            ff::dxgi::depth_base* depth,
+            const ff::rect_float& view_rect,
+            const ff::rect_float& world_rect,
+            ff::dxgi::draw_options options = ff::dxgi::draw_options::none) override;
+
+    protected:
+        virtual void internal_destroy() override;
+        virtual void internal_reset() override;
+        virtual ff::dxgi::command_context_base* internal_flush(ff::dxgi::command_context_base* context, bool end_draw) override;
+        virtual ff::dxgi::command_context_base* internal_setup(ff::dxgi::command_context_base& context, ff::dxgi::target_base& target, ff::dxgi::depth_base* depth, const ff::rect_float& view_rect, bool ignore_rotation) override;
+        virtual void internal_flush_begin(ff::dxgi::command_context_base* context) override;
+        virtual void internal_flush_end(ff::dxgi::command_context_base* context) override;
+
+        virtual ff::dxgi::buffer_base& geometry_buffer() override;
+        virtual ff::dxgi::buffer_base& geometry_constants_buffer_0() override;
+        virtual ff::dxgi::buffer_base& geometry_constants_buffer_1() override;
+        virtual ff::dxgi::buffer_base& pixel_constants_buffer_0() override;
+        virtual bool flush_for_sampler_change() const override;
+
+        virtual void update_palette_texture(ff::dxgi::command_context_base& context,
+            size_t textures_using_palette_count,
+            ff::dxgi::texture_base& palette_texture, size_t* palette_texture_hashes, palette_to_index_t& palette_to_index,
+            ff::dxgi::texture_base& palette_remap_texture, size_t* palette_remap_texture_hashes, palette_remap_to_index_t& palette_remap_to_index) override;
+        virtual void apply_shader_input(ff::dxgi::command_context_base& context,
+            size_t texture_count, ff::dxgi::texture_view_base** textures,
+            size_t textures_using_palette_count, ff::dxgi::texture_view_base** textures_using_palette,
+            ff::dxgi::texture_base& palette_texture, ff::dxgi::texture_base& palette_remap_texture) override;
+        virtual void apply_opaque_state(ff::dxgi::command_context_base& context) override;
+        virtual void apply_alpha_state(ff::dxgi::command_context_base& context) override;
+        virtual bool apply_geometry_state(ff::dxgi::command_context_base& context, const ff::dxgi::draw_util::geometry_bucket& bucket) override;
+        virtual std::shared_ptr<ff::dxgi::texture_base> create_texture(ff::point_size size, DXGI_FORMAT format) override;
+        virtual void draw(ff::dxgi::command_context_base& context, size_t count, size_t start) override;
+
+    private:
+        void record(ff::dxgi::recorded_command_type type, ff::dxgi::draw_util::geometry_bucket_type bucket_type = {}, size_t count = 0, size_t start = 0);
+        size_t constant_bytes_written() const;
+
+        ff::dxgi::recording_buffer geometry_buffer_{ ff::dxgi::buffer_type::vertex };
+        ff::dxgi::recording_buffer geometry_constants_buffer_0_{ ff::dxgi::buffer_type::constant };
+        ff::dxgi::recording_buffer geometry_constants_buffer_1_{ ff::dxgi::buffer_type::constant };
+        ff::dxgi::recording_buffer pixel_constants_buffer_0_{ ff::dxgi::buffer_type::constant };
+
+        ff::dxgi::command_context_base* context{};
+        const ff::dxgi::draw_util::geometry_bucket* last_bucket{};
+        bool record_commands;
+        std::vector<ff::dxgi::recorded_command> commands_;
+        ff::dxgi::recording_stats stats_{};
+    };
+}
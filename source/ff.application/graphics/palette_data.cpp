@@ -116,7 +116,8 @@ std::shared_ptr<ff::resource_object_base> ff::internal::palette_data_factory::lo
         return nullptr;
     }
 
-    for (auto& remap_pair : dict.get<ff::dict>("remaps"))
+    const ff::dict remaps_dict = dict.get<ff::dict>("remaps");
+    for (auto& remap_pair : remaps_dict)
     {
         std::vector<uint8_t> remap;
         remap.resize(ff::dxgi::palette_size);
@@ -160,7 +161,8 @@ std::shared_ptr<ff::resource_object_base> ff::internal::palette_data_factory::lo
         return nullptr;
     }
 
-    for (auto& i : dict.get<ff::dict>("remaps"))
+    const ff::dict remaps_dict = dict.get<ff::dict>("remaps");
+    for (auto& i : remaps_dict)
     {
         auto data = i.second->get<ff::data_base>();
         if (data && data->size() == ff::dxgi::palette_size)
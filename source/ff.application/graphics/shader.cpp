@@ -180,8 +180,9 @@ std::shared_ptr<ff::resource_object_base> ff::internal::shader_factory::load_fro
     std::string entry = dict.get<std::string>("entry", "main");
     std::string target = dict.get<std::string>("target");
 
+    const ff::dict defines_dict = dict.get<ff::dict>("defines");
     std::unordered_map<std::string_view, std::string_view> defines;
-    for (auto& i : dict.get<ff::dict>("defines"))
+    for (auto& i : defines_dict)
     {
         defines.try_emplace(i.first, i.second->get<std::string>());
     }
@@ -271,7 +271,7 @@ bool ff::sprite_font::init_sprites()
             continue;
         }
 
-        size_t glyph_bytes_hash = ff::stable_hash_bytes(glyph_bytes.data(), ff::vector_byte_size(glyph_bytes));
+        size_t glyph_bytes_hash = static_cast<size_t>(ff::wide_hash_bytes(glyph_bytes.data(), ff::vector_byte_size(glyph_bytes)));
         auto iter = hash_to_sprite.find(glyph_bytes_hash);
         if (iter == hash_to_sprite.cend())
         {
@@ -44,7 +44,7 @@ void ff::keyboard_device::advance()
 
 void ff::keyboard_device::kill_pending()
 {
-    std::vector<ff::input_device_event> device_events;
+    ff::frame_vector<ff::input_device_event> device_events;
     {
         std::scoped_lock lock(this->mutex);
 
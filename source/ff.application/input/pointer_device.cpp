@@ -116,7 +116,7 @@ void ff::pointer_device::advance()
 
 void ff::pointer_device::kill_pending()
 {
-    std::vector<ff::input_device_event> device_events;
+    ff::frame_vector<ff::input_device_event> device_events;
     {
         std::scoped_lock lock(this->mutex);
 
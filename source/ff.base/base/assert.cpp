@@ -37,6 +37,7 @@ bool ff::internal::assert_core(const char* exp, const char* text, const char* fi
     std::string_view dialog_text_view(dialog_text.data(), static_cast<size_t>(len));
     std::wstring message_text = ff::string::to_wstring(dialog_text_view) + L"\r\n\r\nBreak?";
     ff::log::write(ff::log::type::debug, dialog_text_view);
+    ff::log::flush();
 
     // Only the main thread should show dialog UI
     bool ignored = true;
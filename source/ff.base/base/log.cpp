@@ -1,54 +1,278 @@
 #include "pch.h"
 #include "base/assert.h"
 #include "base/log.h"
-#include "base/stable_hash.h"
 #include "base/string.h"
+#include "thread/thread_pool.h"
+#include "types/atom.h"
 #include "types/scope_exit.h"
 
 namespace
 {
     struct log_type
     {
-        std::string name;
+        ff::atom name;
         bool enabled;
     };
+
+    // Every record starts with this. Records are a multiple of its size, so the end of a ring always has room for padding.
+    struct alignas(32) record_header
+    {
+        ff::internal::log::format_func* format; // nullptr for padding at the end of the ring
+        uint64_t time; // FILETIME
+        ff::log::type type;
+        uint32_t size;
+    };
+
+    static_assert(sizeof(record_header) == 32);
+
+    /// <summary>
+    /// Lock-free ring of log records written by one thread and read by the writer thread
+    /// </summary>
+    class thread_buffer
+    {
+    public:
+        static constexpr size_t capacity = 64 * 1024;
+        static constexpr size_t max_record_size = capacity / 4;
+
+        thread_buffer()
+            : thread_id(::GetCurrentThreadId())
+            , records(std::make_unique<::record_header[]>(thread_buffer::capacity / sizeof(::record_header)))
+        {}
+
+        thread_buffer(thread_buffer&& other) noexcept = delete;
+        thread_buffer(const thread_buffer& other) = delete;
+        thread_buffer& operator=(thread_buffer&& other) noexcept = delete;
+        thread_buffer& operator=(const thread_buffer& other) = delete;
+
+        // Owning thread only, returns nullptr when the ring is full
+        ::record_header* begin_write(size_t size)
+        {
+            const size_t write_pos = this->write_pos.load(std::memory_order_relaxed);
+            const size_t contiguous = thread_buffer::capacity - write_pos % thread_buffer::capacity;
+            const size_t padding = (size > contiguous) ? contiguous : 0;
+
+            if (write_pos + padding + size - this->read_pos.load(std::memory_order_acquire) > thread_buffer::capacity)
+            {
+                return nullptr;
+            }
+
+            if (padding)
+            {
+                ::record_header* header = this->record(write_pos);
+                header->format = nullptr;
+                header->size = static_cast<uint32_t>(padding);
+            }
+
+            this->pending_pos = write_pos + padding + size;
+            return this->record(write_pos + padding);
+        }
+
+        void end_write()
+        {
+            // Sequentially consistent so that either the writer sees the record or this thread sees that the writer is sleeping
+            this->write_pos.store(this->pending_pos);
+        }
+
+        // Writer thread only
+        template<class Func>
+        bool read(Func&& func)
+        {
+            size_t read_pos = this->read_pos.load(std::memory_order_relaxed);
+            const size_t write_pos = this->write_pos.load();
+
+            if (read_pos == write_pos)
+            {
+                return false;
+            }
+
+            while (read_pos != write_pos)
+            {
+                const ::record_header* header = this->record(read_pos);
+                if (header->format)
+                {
+                    func(*header);
+                }
+
+                read_pos += header->size;
+            }
+
+            this->read_pos.store(read_pos, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const
+        {
+            return this->read_pos.load(std::memory_order_relaxed) == this->write_pos.load();
+        }
+
+        const DWORD thread_id;
+        std::atomic_size_t dropped{};
+        std::atomic_bool retired{};
+        size_t reported_dropped{}; // writer thread only
+
+    private:
+        ::record_header* record(size_t pos) const
+        {
+            return &this->records[pos % thread_buffer::capacity / sizeof(::record_header)];
+        }
+
+        alignas(std::hardware_destructive_interference_size) std::atomic_size_t write_pos{};
+        size_t pending_pos{};
+        alignas(std::hardware_destructive_interference_size) std::atomic_size_t read_pos{};
+        std::unique_ptr<::record_header[]> records;
+    };
+
+    enum class record_target
+    {
+        none,
+        ring, // formatted later by the writer thread
+        large, // too big for the ring, formatted now and the writer thread gets a pointer to the text
+        direct, // no writer thread, formatted and written now
+    };
+
+    class thread_state
+    {
+    public:
+        ~thread_state()
+        {
+            if (this->buffer)
+            {
+                // The writer thread frees the buffer once it's empty
+                this->buffer->retired.store(true, std::memory_order_release);
+            }
+        }
+
+        ::thread_buffer& get_buffer();
+
+        std::shared_ptr<::thread_buffer> buffer;
+        std::vector<::record_header> scratch; // records that don't go into the ring
+        ::record_target target{};
+    };
 }
 
+static std::shared_mutex types_mutex; // the writer thread reads types while other threads register them
 static std::unordered_map<ff::log::type, ::log_type> types
 {
-    { ff::log::type::none, { "ff", false } },
-    { ff::log::type::normal, { "ff/game", true } },
-    { ff::log::type::debug, { "ff/debug", ff::constants::profile_build } },
-
-    { ff::log::type::application, { "ff/app", true } },
-    { ff::log::type::audio, { "ff/audio", true } },
-    { ff::log::type::base_memory, { "ff/mem", true } },
-    { ff::log::type::data, { "ff/data", true } },
-    { ff::log::type::dx12, { "ff/dx12", true } },
-    { ff::log::type::dx12_fence, { "ff/dx12_fence", false } },
-    { ff::log::type::dx12_residency, { "ff/dx12_residency", ff::constants::debug_build } },
-    { ff::log::type::dx12_target, { "ff/dx12_target", ff::constants::debug_build } },
-    { ff::log::type::dxgi, { "ff/dxgi", true } },
-    { ff::log::type::graphics, { "ff/graph", true } },
-    { ff::log::type::input, { "ff/input", true } },
-    { ff::log::type::resource, { "ff/res", true } },
-    { ff::log::type::resource_load, { "ff/res_load", false } },
-    { ff::log::type::test, { "ff/test", true } },
-    { ff::log::type::ui, { "ff/ui", true } },
-    { ff::log::type::ui_focus, { "ff/ui_focus", ff::constants::debug_build } },
-    { ff::log::type::ui_mem, { "ff/ui_mem", false } },
+    { ff::log::type::none, { ff::atom("ff"), false } },
+    { ff::log::type::normal, { ff::atom("ff/game"), true } },
+    { ff::log::type::debug, { ff::atom("ff/debug"), ff::constants::profile_build } },
+
+    { ff::log::type::application, { ff::atom("ff/app"), true } },
+    { ff::log::type::audio, { ff::atom("ff/audio"), true } },
+    { ff::log::type::base_memory, { ff::atom("ff/mem"), true } },
+    { ff::log::type::data, { ff::atom("ff/data"), true } },
+    { ff::log::type::dx12, { ff::atom("ff/dx12"), true } },
+    { ff::log::type::dx12_fence, { ff::atom("ff/dx12_fence"), false } },
+    { ff::log::type::dx12_residency, { ff::atom("ff/dx12_residency"), ff::constants::debug_build } },
+    { ff::log::type::dx12_target, { ff::atom("ff/dx12_target"), ff::constants::debug_build } },
+    { ff::log::type::dxgi, { ff::atom("ff/dxgi"), true } },
+    { ff::log::type::graphics, { ff::atom("ff/graph"), true } },
+    { ff::log::type::input, { ff::atom("ff/input"), true } },
+    { ff::log::type::resource, { ff::atom("ff/res"), true } },
+    { ff::log::type::resource_load, { ff::atom("ff/res_load"), false } },
+    { ff::log::type::test, { ff::atom("ff/test"), true } },
+    { ff::log::type::ui, { ff::atom("ff/ui"), true } },
+    { ff::log::type::ui_focus, { ff::atom("ff/ui_focus"), ff::constants::debug_build } },
+    { ff::log::type::ui_mem, { ff::atom("ff/ui_mem"), false } },
 };
 
+static uint64_t type_bit(ff::log::type type)
+{
+    const size_t index = static_cast<size_t>(type);
+    return (index < 64) ? (uint64_t(1) << index) : 0;
+}
+
+static uint64_t get_enabled_types()
+{
+    std::shared_lock lock(::types_mutex);
+    uint64_t bits = 0;
+
+    for (const auto& [type, info] : ::types)
+    {
+        bits |= info.enabled ? ::type_bit(type) : 0;
+    }
+
+    return bits;
+}
+
+std::atomic_uint64_t ff::internal::log::enabled_types = ::get_enabled_types();
+
 static std::ostream* file_stream{};
+static std::mutex output_mutex; // guards the file stream while text is written
 static bool statics_destroyed{};
 static ff::scope_exit statics_invalidate([]()
     {
         assert_msg(!::file_stream, "ff::log::file(nullptr) must be called before exit.");
         ::statics_destroyed = true;
+        ff::internal::log::enabled_types.store(ff::constants::profile_build ? ::type_bit(ff::log::type::debug) : 0);
     });
 
-void ff::internal::log::write(std::string_view text)
+// Shared by threads that write records and the writer thread
+static std::atomic_bool writer_running;
+static std::atomic_uint32_t ring_writers; // threads between begin_record and end_record for a ring record
+static std::atomic_bool writer_sleeping;
+static std::atomic_uint32_t writer_wake;
+static std::atomic_uint64_t flush_requested;
+static std::atomic_uint64_t flush_done;
+static std::atomic_size_t dropped_total;
+static std::mutex buffers_mutex;
+static std::vector<std::shared_ptr<::thread_buffer>> buffers;
+static std::atomic_uint32_t buffers_version;
+static thread_local ::thread_state thread_log;
+static thread_local bool writer_thread;
+
+::thread_buffer& thread_state::get_buffer()
+{
+    if (!this->buffer)
+    {
+        this->buffer = std::make_shared<::thread_buffer>();
+
+        std::scoped_lock lock(::buffers_mutex);
+        ::buffers.push_back(this->buffer);
+        ::buffers_version.fetch_add(1);
+    }
+
+    return *this->buffer;
+}
+
+static size_t record_size(size_t data_size)
+{
+    const size_t align = sizeof(::record_header);
+    return (sizeof(::record_header) + data_size + align - 1) / align * align;
+}
+
+static uint64_t record_time()
 {
+    FILETIME time;
+    ::GetSystemTimeAsFileTime(&time);
+    return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+}
+
+static void write_time(std::ostream& output, uint64_t time)
+{
+    FILETIME file_time{ static_cast<DWORD>(time), static_cast<DWORD>(time >> 32) };
+    SYSTEMTIME system_time{}, local_time{};
+    ::FileTimeToSystemTime(&file_time, &system_time);
+    ::SystemTimeToTzSpecificLocalTime(nullptr, &system_time, &local_time);
+
+    const char fill = output.fill('0');
+    output << std::setw(2) << local_time.wHour << ':' << std::setw(2) << local_time.wMinute << ':' << std::setw(2) << local_time.wSecond;
+    output.fill(fill);
+}
+
+static void write_record_text(std::ostream& output, const ::record_header& header)
+{
+    output << "[" << ff::log::type_name(header.type) << ",";
+    ::write_time(output, header.time);
+    output << "] ";
+    header.format(output, reinterpret_cast<const uint8_t*>(&header + 1));
+    output << "\r\n";
+}
+
+static void write_text(std::string_view text)
+{
+    std::scoped_lock lock(::output_mutex);
+
     if (::file_stream)
     {
         *::file_stream << text;
@@ -57,28 +281,362 @@ void ff::internal::log::write(std::string_view text)
     if constexpr (ff::constants::profile_build)
     {
         std::cerr << text;
+        ::OutputDebugString(ff::string::to_wstring(text).c_str());
     }
 }
 
-void ff::internal::log::write_debug(std::string_view text)
+static void wake_writer()
 {
-    if constexpr (ff::constants::profile_build)
+    ::writer_wake.fetch_add(1);
+    ::writer_wake.notify_one();
+}
+
+static void format_large_record(std::ostream& output, const uint8_t* data)
+{
+    std::string* text;
+    std::memcpy(&text, data, sizeof(text));
+    output << *text;
+    delete text;
+}
+
+static uint8_t* begin_ring_record(::thread_state& state, ff::log::type type, uint64_t time, ff::internal::log::format_func* format, size_t size)
+{
+    ::thread_buffer& buffer = state.get_buffer();
+    ::record_header* header = buffer.begin_write(size);
+
+    if (!header)
     {
-        ::OutputDebugString(ff::string::to_wstring(text).c_str());
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        ::dropped_total.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    *header = ::record_header{ format, time, type, static_cast<uint32_t>(size) };
+    return reinterpret_cast<uint8_t*>(header + 1);
+}
+
+static void end_ring_record(::thread_state& state)
+{
+    state.buffer->end_write();
+
+    if (::writer_sleeping.load())
+    {
+        ::wake_writer();
+    }
+}
+
+static void end_ring_writer()
+{
+    if (::ring_writers.fetch_sub(1) == 1 && !::writer_running.load())
+    {
+        ::ring_writers.notify_all();
+    }
+}
+
+namespace
+{
+    /// <summary>
+    /// Formats records from every thread's buffer and writes them in batches
+    /// </summary>
+    class log_writer
+    {
+    public:
+        log_writer()
+            : thread([this](std::stop_token stop)
+                {
+                    this->run(stop);
+                })
+        {}
+
+        log_writer(log_writer&& other) noexcept = delete;
+        log_writer(const log_writer& other) = delete;
+        log_writer& operator=(log_writer&& other) noexcept = delete;
+        log_writer& operator=(const log_writer& other) = delete;
+
+        void stop()
+        {
+            this->thread.request_stop();
+            ::wake_writer();
+            this->thread.join();
+        }
+
+        // Returns true if any records were written
+        bool drain()
+        {
+            if (this->buffers_version != ::buffers_version.load(std::memory_order_acquire))
+            {
+                std::scoped_lock lock(::buffers_mutex);
+                this->buffers_version = ::buffers_version.load(std::memory_order_acquire);
+                this->buffers = ::buffers;
+            }
+
+            bool wrote = false;
+            bool retired = false;
+
+            for (const std::shared_ptr<::thread_buffer>& buffer : this->buffers)
+            {
+                // Check before reading, so that nothing written before the thread exited gets missed
+                retired = retired || buffer->retired.load(std::memory_order_acquire);
+
+                wrote = buffer->read([this](const ::record_header& header)
+                    {
+                        ::write_record_text(this->text, header);
+                    }) || wrote;
+
+                const size_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+                if (dropped != buffer->reported_dropped)
+                {
+                    this->text << "[" << ff::log::type_name(ff::log::type::none) << ",";
+                    ::write_time(this->text, ::record_time());
+                    this->text << "] Dropped " << dropped - buffer->reported_dropped << " log records from thread " << buffer->thread_id << "\r\n";
+                    buffer->reported_dropped = dropped;
+                    wrote = true;
+                }
+            }
+
+            if (wrote)
+            {
+                ::write_text(this->text.view());
+                this->text.str(std::string());
+            }
+
+            if (retired)
+            {
+                std::scoped_lock lock(::buffers_mutex);
+                std::erase_if(::buffers, [](const std::shared_ptr<::thread_buffer>& buffer)
+                    {
+                        return buffer->retired.load(std::memory_order_acquire) && buffer->empty();
+                    });
+
+                this->buffers_version = ::buffers_version.fetch_add(1, std::memory_order_acq_rel) + 1;
+                this->buffers = ::buffers;
+            }
+
+            return wrote;
+        }
+
+    private:
+        bool pending() const
+        {
+            for (const std::shared_ptr<::thread_buffer>& buffer : this->buffers)
+            {
+                if (!buffer->empty())
+                {
+                    return true;
+                }
+            }
+
+            return this->buffers_version != ::buffers_version.load();
+        }
+
+        void run(std::stop_token stop)
+        {
+            ff::set_thread_name("ff::log::writer");
+            ::writer_thread = true;
+
+            while (true)
+            {
+                const uint32_t wake = ::writer_wake.load();
+                const uint64_t flush_request = ::flush_requested.load();
+
+                if (this->drain())
+                {
+                    continue;
+                }
+
+                // Everything queued before the flush was requested is written now
+                if (::flush_done.load(std::memory_order_relaxed) != flush_request)
+                {
+                    ::flush_done.store(flush_request);
+                    ::flush_done.notify_all();
+                }
+
+                if (stop.stop_requested())
+                {
+                    break;
+                }
+
+                ::writer_sleeping.store(true);
+
+                if (!this->pending() && ::flush_requested.load() == flush_request)
+                {
+                    ::writer_wake.wait(wake);
+                }
+
+                ::writer_sleeping.store(false);
+            }
+        }
+
+        std::vector<std::shared_ptr<::thread_buffer>> buffers;
+        uint32_t buffers_version{};
+        std::ostringstream text;
+        std::jthread thread;
+    };
+}
+
+static std::unique_ptr<::log_writer> writer;
+
+void ff::internal::log::init()
+{
+    assert_ret(!::writer);
+    ::writer = std::make_unique<::log_writer>();
+    ::writer_running.store(true);
+}
+
+void ff::internal::log::destroy()
+{
+    assert_ret(::writer);
+
+    // New records get written directly by their thread, wait for records that are already going into a ring
+    ::writer_running.store(false);
+    for (uint32_t count = ::ring_writers.load(); count; count = ::ring_writers.load())
+    {
+        ::ring_writers.wait(count);
+    }
+
+    // The writer thread drains every ring before it stops
+    ::writer->stop();
+    ::writer.reset();
+
+    ::flush_done.store(::flush_requested.load());
+    ::flush_done.notify_all();
+}
+
+bool ff::internal::log::registered_type_enabled(ff::log::type type)
+{
+    if (::statics_destroyed)
+    {
+        return false;
+    }
+
+    bool found, enabled;
+    {
+        std::shared_lock lock(::types_mutex);
+        auto i = ::types.find(type);
+        found = (i != ::types.end());
+        enabled = found && i->second.enabled;
+    }
+
+    // Asserts can write to the log, so they're checked outside of the lock
+    assert_msg_ret_val(found, "Invalid log type", false);
+    return enabled;
+}
+
+uint8_t* ff::internal::log::begin_record(ff::log::type type, ff::internal::log::format_func* format, size_t size)
+{
+    ::thread_state& state = ::thread_log;
+    const size_t record_size = ::record_size(size);
+    const uint64_t time = ::record_time();
+    assert(state.target == ::record_target::none);
+
+    // Counted before checking writer_running, so destroy() can wait for the record to reach the ring
+    ::ring_writers.fetch_add(1);
+    const bool writer_running = ::writer_running.load();
+
+    if (writer_running && record_size <= ::thread_buffer::max_record_size)
+    {
+        uint8_t* data = ::begin_ring_record(state, type, time, format, record_size);
+        state.target = data ? ::record_target::ring : ::record_target::none;
+
+        if (!data)
+        {
+            ::end_ring_writer();
+        }
+
+        return data;
+    }
+
+    if (!writer_running)
+    {
+        ::end_ring_writer();
+    }
+
+    state.scratch.resize(record_size / sizeof(::record_header));
+    state.scratch[0] = ::record_header{ format, time, type, static_cast<uint32_t>(record_size) };
+    state.target = writer_running ? ::record_target::large : ::record_target::direct;
+    return reinterpret_cast<uint8_t*>(&state.scratch[1]);
+}
+
+void ff::internal::log::end_record()
+{
+    ::thread_state& state = ::thread_log;
+    const ::record_target target = std::exchange(state.target, ::record_target::none);
+
+    switch (target)
+    {
+        case ::record_target::ring:
+            ::end_ring_record(state);
+            ::end_ring_writer();
+            break;
+
+        case ::record_target::large:
+            {
+                const ::record_header& header = state.scratch[0];
+                std::ostringstream text;
+                header.format(text, reinterpret_cast<const uint8_t*>(&header + 1));
+
+                std::string* text_copy = new std::string(text.str());
+                uint8_t* data = ::begin_ring_record(state, header.type, header.time, &::format_large_record, ::record_size(sizeof(text_copy)));
+                if (data)
+                {
+                    std::memcpy(data, &text_copy, sizeof(text_copy));
+                    ::end_ring_record(state);
+                }
+                else
+                {
+                    delete text_copy;
+                }
+
+                ::end_ring_writer();
+            }
+            break;
+
+        case ::record_target::direct:
+            {
+                std::ostringstream text;
+                ::write_record_text(text, state.scratch[0]);
+                ::write_text(text.view());
+            }
+            break;
     }
 }
 
 void ff::log::file(std::ostream* file_stream)
 {
+    ff::log::flush();
+
+    std::scoped_lock lock(::output_mutex);
     ::file_stream = file_stream;
 }
 
+void ff::log::flush()
+{
+    if (!::writer_running.load(std::memory_order_acquire) || ::writer_thread)
+    {
+        return;
+    }
+
+    const uint64_t request = ::flush_requested.fetch_add(1) + 1;
+    ::wake_writer();
+
+    for (uint64_t done = ::flush_done.load(); done < request && ::writer_running.load(std::memory_order_acquire); done = ::flush_done.load())
+    {
+        ::flush_done.wait(done);
+    }
+}
+
+size_t ff::log::dropped_count()
+{
+    return ::dropped_total.load(std::memory_order_relaxed);
+}
+
 std::vector<ff::log::type> ff::log::types()
 {
     std::vector<ff::log::type> types;
 
     if (!::statics_destroyed)
     {
+        std::shared_lock lock(::types_mutex);
         types.reserve(::types.size());
 
         for (auto& i : ::types)
@@ -93,10 +651,20 @@ std::vector<ff::log::type> ff::log::types()
 ff::log::type ff::log::register_type(std::string_view name, bool enabled)
 {
     assert(!::statics_destroyed);
-    ff::log::type type = static_cast<ff::log::type>(ff::stable_hash_func(name));
-    auto i = ::types.try_emplace(type, ::log_type{ std::string(name), enabled });
-    assert_msg(i.second, "Log name already registered");
+    const ff::atom atom_name(name);
+    ff::log::type type = static_cast<ff::log::type>(atom_name.hash());
+    bool added;
+    {
+        std::scoped_lock lock(::types_mutex);
+        added = ::types.try_emplace(type, ::log_type{ atom_name, enabled }).second;
 
+        if (enabled && added)
+        {
+            ff::internal::log::enabled_types.fetch_or(::type_bit(type));
+        }
+    }
+
+    assert_msg(added, "Log name already registered");
     return type;
 }
 
@@ -104,11 +672,22 @@ ff::log::type ff::log::lookup_type(std::string_view name)
 {
     if (!::statics_destroyed)
     {
-        for (auto& i : ::types)
+        // Registered types use the name's hash as their value, built-in types need a search
+        const ff::atom atom_name(name);
         {
-            if (i.second.name == name)
+            std::shared_lock lock(::types_mutex);
+            auto i = ::types.find(static_cast<ff::log::type>(atom_name.hash()));
+            if (i != ::types.end() && i->second.name == atom_name)
+            {
+                return i->first;
+            }
+
+            for (auto& [type, info] : ::types)
             {
-                return i.first;
+                if (info.name == atom_name)
+                {
+                    return type;
+                }
             }
         }
 
@@ -125,27 +704,41 @@ std::string_view ff::log::type_name(ff::log::type type)
         return "ff/debug"; // only debug works after shut down
     }
 
-    auto i = ::types.find(type);
-    assert_msg_ret_val(i != ::types.end(), "Invalid log type", "");
-    return i->second.name;
-}
-
-bool ff::log::type_enabled(ff::log::type type)
-{
-    if (::statics_destroyed)
+    std::string_view name;
     {
-        return type == ff::log::type::debug && ff::constants::profile_build;
+        // Atom strings never move, so the name stays valid after unlocking
+        std::shared_lock lock(::types_mutex);
+        auto i = ::types.find(type);
+        name = (i != ::types.end()) ? i->second.name.str() : std::string_view();
     }
 
-    auto i = ::types.find(type);
-    assert_msg_ret_val(i != ::types.end(), "Invalid log type", false);
-    return i->second.enabled;
+    assert_msg_ret_val(name.size(), "Invalid log type", "");
+    return name;
 }
 
 void ff::log::type_enabled(ff::log::type type, bool value)
 {
     assert_ret(!::statics_destroyed);
-    auto i = ::types.find(type);
-    assert_msg_ret(i != ::types.end(), "Invalid log type");
-    i->second.enabled = value;
+    bool found;
+    {
+        std::scoped_lock lock(::types_mutex);
+        auto i = ::types.find(type);
+        found = (i != ::types.end());
+
+        if (found)
+        {
+            i->second.enabled = value;
+
+            if (value)
+            {
+                ff::internal::log::enabled_types.fetch_or(::type_bit(type));
+            }
+            else
+            {
+                ff::internal::log::enabled_types.fetch_and(~::type_bit(type));
+            }
+        }
+    }
+
+    assert_msg(found, "Invalid log type");
 }
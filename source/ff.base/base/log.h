@@ -3,16 +3,8 @@
 #include "../base/constants.h"
 #include "../base/string.h"
 
-namespace ff::internal::log
-{
-    void write(std::string_view text);
-    void write_debug(std::string_view text);
-}
-
 namespace ff::log
 {
-    void file(std::ostream* file_stream);
-
     enum class type : size_t
     {
         none, // not visible by default
@@ -38,27 +30,170 @@ namespace ff::log
         ui_focus,
         ui_mem,
     };
+}
+
+namespace ff::internal::log
+{
+    void init();
+    void destroy();
+
+    using format_func = void(std::ostream& output, const uint8_t* data);
+
+    // Bit per built-in log type, registered types have hashed values and are looked up instead
+    extern std::atomic_uint64_t enabled_types;
+    bool registered_type_enabled(ff::log::type type);
+
+    uint8_t* begin_record(ff::log::type type, ff::internal::log::format_func* format, size_t size);
+    void end_record();
+
+    /// <summary>
+    /// How one argument is copied into a log record, so that it can be formatted later on the writer thread
+    /// </summary>
+    /// <remarks>
+    /// Strings are copied as their bytes, numbers and enums are copied as they are, and anything else
+    /// (including pointers, which may not be valid later) is formatted to a string right away on the calling thread.
+    /// </remarks>
+    template<class T, class = void>
+    struct record_arg
+    {
+        static std::string capture(const T& value)
+        {
+            std::ostringstream str;
+            str << value;
+            return str.str();
+        }
+    };
+
+    template<class T>
+    struct record_arg<T, std::enable_if_t<std::is_convertible_v<const T&, std::string_view>>>
+    {
+        static std::string_view capture(const T& value)
+        {
+            return value;
+        }
+    };
+
+    template<class T>
+    struct record_arg<T, std::enable_if_t<!std::is_convertible_v<const T&, std::string_view> && (std::is_arithmetic_v<T> || std::is_enum_v<T>)>>
+    {
+        static const T& capture(const T& value)
+        {
+            return value;
+        }
+    };
+
+    template<class T>
+    struct stored_arg
+    {
+        static size_t size(const T& value)
+        {
+            return sizeof(T);
+        }
+
+        static uint8_t* save(uint8_t* data, const T& value)
+        {
+            std::memcpy(data, &value, sizeof(T));
+            return data + sizeof(T);
+        }
+
+        static T load(const uint8_t*& data)
+        {
+            T value;
+            std::memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+            return value;
+        }
+    };
+
+    template<>
+    struct stored_arg<std::string_view>
+    {
+        static size_t size(std::string_view value)
+        {
+            return sizeof(uint32_t) + value.size();
+        }
+
+        static uint8_t* save(uint8_t* data, std::string_view value)
+        {
+            const uint32_t size = static_cast<uint32_t>(value.size());
+            std::memcpy(data, &size, sizeof(size));
+
+            if (size)
+            {
+                std::memcpy(data + sizeof(size), value.data(), size);
+            }
+
+            return data + sizeof(size) + size;
+        }
+
+        static std::string_view load(const uint8_t*& data)
+        {
+            uint32_t size;
+            std::memcpy(&size, data, sizeof(size));
+            std::string_view value(reinterpret_cast<const char*>(data + sizeof(size)), size);
+            data += sizeof(size) + size;
+            return value;
+        }
+    };
+
+    template<>
+    struct stored_arg<std::string> : public ff::internal::log::stored_arg<std::string_view>
+    {};
+
+    template<class... Stored>
+    void format_record(std::ostream& output, const uint8_t* data)
+    {
+        (output << ... << ff::internal::log::stored_arg<Stored>::load(data));
+    }
+
+    template<class... Stored>
+    void write_record(ff::log::type type, const Stored&... values)
+    {
+        const size_t size = (static_cast<size_t>(0) + ... + ff::internal::log::stored_arg<Stored>::size(values));
+        uint8_t* data = ff::internal::log::begin_record(type, &ff::internal::log::format_record<Stored...>, size);
+
+        if (data)
+        {
+            ((data = ff::internal::log::stored_arg<Stored>::save(data, values)), ...);
+            ff::internal::log::end_record();
+        }
+    }
+}
+
+namespace ff::log
+{
+    void file(std::ostream* file_stream);
+    void flush();
+    size_t dropped_count();
 
     std::vector<ff::log::type> types();
     ff::log::type register_type(std::string_view name, bool enabled);
     ff::log::type lookup_type(std::string_view name);
     std::string_view type_name(ff::log::type type);
-    bool type_enabled(ff::log::type type);
     void type_enabled(ff::log::type type, bool value);
 
+    // Only a relaxed atomic load for built-in types, so disabled log calls are nearly free
+    inline bool type_enabled(ff::log::type type)
+    {
+        const size_t index = static_cast<size_t>(type);
+        return (index < 64)
+            ? ((ff::internal::log::enabled_types.load(std::memory_order_relaxed) >> index) & 1) != 0
+            : ff::internal::log::registered_type_enabled(type);
+    }
+
+    /// <summary>
+    /// Queues a log line, the calling thread never waits for the log file
+    /// </summary>
+    /// <remarks>
+    /// Arguments are copied into the thread's own lock-free buffer and a background thread formats
+    /// and writes them. When a buffer is full, the line is dropped and counted (see dropped_count).
+    /// </remarks>
     template<class... Args>
     void write(ff::log::type type, Args&&... args)
     {
         if (ff::log::type_enabled(type))
         {
-            std::ostringstream ostr;
-            ostr << "[" << ff::log::type_name(type) << "," << ff::string::time() << "] ";
-            (ostr << ... << args);
-            ostr << "\r\n";
-
-            std::string str = ostr.str();
-            ff::internal::log::write(str);
-            ff::internal::log::write_debug(str);
+            ff::internal::log::write_record(type, ff::internal::log::record_arg<std::decay_t<Args>>::capture(args)...);
         }
     }
 
@@ -69,6 +204,7 @@ namespace ff::log
 
         if constexpr (ff::constants::debug_build)
         {
+            ff::log::flush();
             __debugbreak();
         }
     }
@@ -6,54 +6,14 @@
 // See http://burtleburtle.net/bob/hash/evahash.html
 // See http://burtleburtle.net/bob/c/lookup3.c
 
-inline constexpr static size_t create_hash_result(uint32_t b, uint32_t c)
-{
-    static_assert(sizeof(size_t) == 4 || sizeof(size_t) == 8);
-
-    if constexpr (sizeof(size_t) == 8)
-    {
-        return (static_cast<uint64_t>(b) << 32) | static_cast<uint64_t>(c);
-    }
-    else
-    {
-        return c;
-    }
-}
-
-inline constexpr static uint32_t rotate_bits(uint32_t val, uint32_t count)
-{
-    return (val << count) | (val >> (32 - count));
-}
-
-inline constexpr static void hash_mix(uint32_t& a, uint32_t& b, uint32_t& c)
-{
-    a -= c; a ^= ::rotate_bits(c, 4); c += b;
-    b -= a; b ^= ::rotate_bits(a, 6); a += c;
-    c -= b; c ^= ::rotate_bits(b, 8); b += a;
-    a -= c; a ^= ::rotate_bits(c, 16); c += b;
-    b -= a; b ^= ::rotate_bits(a, 19); a += c;
-    c -= b; c ^= ::rotate_bits(b, 4); b += a;
-}
-
-inline constexpr static void final_hash_mix(uint32_t& a, uint32_t& b, uint32_t& c)
-{
-    c ^= b; c -= ::rotate_bits(b, 14);
-    a ^= c; a -= ::rotate_bits(c, 11);
-    b ^= a; b -= ::rotate_bits(a, 25);
-    c ^= b; c -= ::rotate_bits(b, 16);
-    a ^= c; a -= ::rotate_bits(c, 4);
-    b ^= a; b -= ::rotate_bits(a, 14);
-    c ^= b; c -= ::rotate_bits(b, 24);
-}
-
 ff::stable_hash_data_t::stable_hash_data_t()
-    : a(0x9e3779b9)
-    , b(0x9e3779b9)
-    , c(0x9e3779b9)
+    : a(ff::internal::lookup3::initial_value)
+    , b(ff::internal::lookup3::initial_value)
+    , c(ff::internal::lookup3::initial_value)
 {}
 
 ff::stable_hash_data_t::stable_hash_data_t(size_t data_size)
-    : a(0x9e3779b9 + static_cast<uint32_t>(data_size))
+    : a(ff::internal::lookup3::initial_value + static_cast<uint32_t>(data_size))
     , b(a)
     , c(a)
 {}
@@ -72,8 +32,8 @@ void ff::stable_hash_data_t::hash(const void* data, size_t size)
 size_t ff::stable_hash_data_t::hash() const
 {
     stable_hash_data_t other = *this;
-    ::final_hash_mix(other.a, other.b, other.c);
-    return ::create_hash_result(other.b, other.c);
+    ff::internal::lookup3::final_mix(other.a, other.b, other.c);
+    return ff::internal::lookup3::hash_result(other.b, other.c);
 }
 
 ff::stable_hash_data_t::operator size_t() const
@@ -97,7 +57,7 @@ ff::stable_hash_data_t ff::stable_hash_incremental(const void* data, size_t size
             b += key_data[1];
             c += key_data[2];
 
-            ::hash_mix(a, b, c);
+            ff::internal::lookup3::mix(a, b, c);
 
             size -= 12;
             key_data += 3;
@@ -129,7 +89,7 @@ ff::stable_hash_data_t ff::stable_hash_incremental(const void* data, size_t size
             b += key_data[2] + (static_cast<uint32_t>(key_data[3]) << 16);
             c += key_data[4] + (static_cast<uint32_t>(key_data[5]) << 16);
 
-            ::hash_mix(a, b, c);
+            ff::internal::lookup3::mix(a, b, c);
 
             size -= 12;
             key_data += 6;
@@ -215,7 +175,7 @@ ff::stable_hash_data_t ff::stable_hash_incremental(const void* data, size_t size
             c += static_cast<uint32_t>(key_data[10]) << 16;
             c += static_cast<uint32_t>(key_data[11]) << 24;
 
-            ::hash_mix(a, b, c);
+            ff::internal::lookup3::mix(a, b, c);
 
             size -= 12;
             key_data += 12;
@@ -246,3 +206,131 @@ size_t ff::stable_hash_bytes(const void* data, size_t size) noexcept
 {
     return ff::stable_hash_incremental(data, size, ff::stable_hash_data_t(size));
 }
+
+// XXH3 (xxHash v0.8) by Yann Collet, BSD 2-Clause License.
+// See https://github.com/Cyan4973/xxHash, only the 64-bit seeded variant is here.
+
+static constexpr size_t wide_stripe_size = 64;
+static constexpr size_t wide_stripes_per_block = (sizeof(ff::internal::wide_hash::secret) - ::wide_stripe_size) / 8;
+static constexpr size_t wide_block_size = ::wide_stripe_size * ::wide_stripes_per_block;
+
+static uint64_t wide_hash_129_to_240(const uint8_t* data, size_t size, uint64_t seed)
+{
+    const uint8_t* secret = ff::internal::wide_hash::secret;
+    const size_t rounds = size / 16;
+    uint64_t result = size * ff::internal::wide_hash::prime64_1;
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        result += ff::internal::wide_hash::mix16(data + 16 * i, secret + 16 * i, seed);
+    }
+
+    result = ff::internal::wide_hash::avalanche(result);
+    uint64_t result_end = ff::internal::wide_hash::mix16(data + size - 16, secret + 136 - 17, seed);
+
+    for (size_t i = 8; i < rounds; i++)
+    {
+        result_end += ff::internal::wide_hash::mix16(data + 16 * i, secret + 16 * (i - 8) + 3, seed);
+    }
+
+    return ff::internal::wide_hash::avalanche(result + result_end);
+}
+
+// Each 64 byte stripe is four 16 byte lanes of two 64-bit accumulators
+static void wide_accumulate_stripe(__m128i* acc, const uint8_t* data, const uint8_t* secret)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        const __m128i data_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i);
+        const __m128i key_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i);
+        const __m128i data_key = _mm_xor_si128(data_vec, key_vec);
+        const __m128i product = _mm_mul_epu32(data_key, _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)));
+        const __m128i sum = _mm_add_epi64(acc[i], _mm_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc[i] = _mm_add_epi64(product, sum);
+    }
+}
+
+static void wide_scramble(__m128i* acc, const uint8_t* secret)
+{
+    const __m128i prime = _mm_set1_epi32(static_cast<int>(ff::internal::wide_hash::prime32_1));
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        const __m128i key_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i);
+        const __m128i data_key = _mm_xor_si128(_mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47)), key_vec);
+        const __m128i product_low = _mm_mul_epu32(data_key, prime);
+        const __m128i product_high = _mm_mul_epu32(_mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        acc[i] = _mm_add_epi64(product_low, _mm_slli_epi64(product_high, 32));
+    }
+}
+
+static uint64_t wide_hash_long(const uint8_t* data, size_t size, const uint8_t* secret)
+{
+    alignas(16) uint64_t acc[8] =
+    {
+        ff::internal::wide_hash::prime32_3, ff::internal::wide_hash::prime64_1, ff::internal::wide_hash::prime64_2, ff::internal::wide_hash::prime64_3,
+        ff::internal::wide_hash::prime64_4, ff::internal::wide_hash::prime32_2, ff::internal::wide_hash::prime64_5, ff::internal::wide_hash::prime32_1,
+    };
+
+    __m128i* acc_vec = reinterpret_cast<__m128i*>(acc);
+    const size_t blocks = (size - 1) / ::wide_block_size;
+
+    for (size_t block = 0; block < blocks; block++)
+    {
+        const uint8_t* block_data = data + block * ::wide_block_size;
+
+        for (size_t i = 0; i < ::wide_stripes_per_block; i++)
+        {
+            ::wide_accumulate_stripe(acc_vec, block_data + i * ::wide_stripe_size, secret + i * 8);
+        }
+
+        ::wide_scramble(acc_vec, secret + sizeof(ff::internal::wide_hash::secret) - ::wide_stripe_size);
+    }
+
+    const uint8_t* block_data = data + blocks * ::wide_block_size;
+    const size_t stripes = ((size - 1) - blocks * ::wide_block_size) / ::wide_stripe_size;
+
+    for (size_t i = 0; i < stripes; i++)
+    {
+        ::wide_accumulate_stripe(acc_vec, block_data + i * ::wide_stripe_size, secret + i * 8);
+    }
+
+    // The last stripe always ends at the end of the data, so it may overlap the previous one
+    ::wide_accumulate_stripe(acc_vec, data + size - ::wide_stripe_size, secret + sizeof(ff::internal::wide_hash::secret) - ::wide_stripe_size - 7);
+
+    uint64_t result = size * ff::internal::wide_hash::prime64_1;
+    for (size_t i = 0; i < 4; i++)
+    {
+        const uint8_t* merge_secret = secret + 11 + 16 * i;
+        result += ff::internal::wide_hash::mul128_fold64(
+            acc[i * 2] ^ ff::internal::wide_hash::read64(merge_secret),
+            acc[i * 2 + 1] ^ ff::internal::wide_hash::read64(merge_secret + 8));
+    }
+
+    return ff::internal::wide_hash::avalanche(result);
+}
+
+uint64_t ff::internal::wide_hash::hash_large(const uint8_t* data, size_t size, uint64_t seed) noexcept
+{
+    if (size <= 240)
+    {
+        return ::wide_hash_129_to_240(data, size, seed);
+    }
+
+    if (!seed)
+    {
+        return ::wide_hash_long(data, size, ff::internal::wide_hash::secret);
+    }
+
+    // A seed changes the whole secret for long inputs
+    alignas(16) uint8_t seeded_secret[sizeof(ff::internal::wide_hash::secret)];
+    for (size_t i = 0; i < sizeof(seeded_secret); i += 16)
+    {
+        const uint64_t low = ff::internal::wide_hash::read64(ff::internal::wide_hash::secret + i) + seed;
+        const uint64_t high = ff::internal::wide_hash::read64(ff::internal::wide_hash::secret + i + 8) - seed;
+        std::memcpy(seeded_secret + i, &low, sizeof(low));
+        std::memcpy(seeded_secret + i + 8, &high, sizeof(high));
+    }
+
+    return ::wide_hash_long(data, size, seeded_secret);
+}
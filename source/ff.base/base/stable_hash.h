@@ -1,5 +1,88 @@
 #pragma once
 
+namespace ff::internal::lookup3
+{
+    // By Bob Jenkins, 2006. bob_jenkins@burtleburtle.net. You may use this
+    // code any way you wish, private, educational, or commercial. It's free.
+    // See http://burtleburtle.net/bob/hash/evahash.html
+    // See http://burtleburtle.net/bob/c/lookup3.c
+
+    constexpr uint32_t initial_value = 0x9e3779b9;
+
+    constexpr size_t hash_result(uint32_t b, uint32_t c)
+    {
+        static_assert(sizeof(size_t) == 4 || sizeof(size_t) == 8);
+
+        if constexpr (sizeof(size_t) == 8)
+        {
+            return (static_cast<uint64_t>(b) << 32) | static_cast<uint64_t>(c);
+        }
+        else
+        {
+            return c;
+        }
+    }
+
+    constexpr void mix(uint32_t& a, uint32_t& b, uint32_t& c)
+    {
+        a -= c; a ^= std::rotl(c, 4); c += b;
+        b -= a; b ^= std::rotl(a, 6); a += c;
+        c -= b; c ^= std::rotl(b, 8); b += a;
+        a -= c; a ^= std::rotl(c, 16); c += b;
+        b -= a; b ^= std::rotl(a, 19); a += c;
+        c -= b; c ^= std::rotl(b, 4); b += a;
+    }
+
+    constexpr void final_mix(uint32_t& a, uint32_t& b, uint32_t& c)
+    {
+        c ^= b; c -= std::rotl(b, 14);
+        a ^= c; a -= std::rotl(c, 11);
+        b ^= a; b -= std::rotl(a, 25);
+        c ^= b; c -= std::rotl(b, 16);
+        a ^= c; a -= std::rotl(c, 4);
+        b ^= a; b -= std::rotl(a, 14);
+        c ^= b; c -= std::rotl(b, 24);
+    }
+
+    /// <summary>
+    /// Same result as ff::stable_hash_bytes for the chars of a string, but it can run at compile time
+    /// </summary>
+    constexpr size_t hash_chars(std::string_view str)
+    {
+        uint32_t a = ff::internal::lookup3::initial_value + static_cast<uint32_t>(str.size());
+        uint32_t b = a;
+        uint32_t c = a;
+        uint32_t words[3]{};
+        size_t size = str.size();
+        const char* data = str.data();
+
+        for (; size; data += 12)
+        {
+            const size_t block_size = std::min<size_t>(size, 12);
+            words[0] = words[1] = words[2] = 0;
+
+            for (size_t i = 0; i < block_size; i++)
+            {
+                words[i / 4] += static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (i % 4 * 8);
+            }
+
+            a += words[0];
+            b += words[1];
+            c += words[2];
+            size -= block_size;
+
+            // The last block isn't mixed, only final_mix runs on it
+            if (size)
+            {
+                ff::internal::lookup3::mix(a, b, c);
+            }
+        }
+
+        ff::internal::lookup3::final_mix(a, b, c);
+        return ff::internal::lookup3::hash_result(b, c);
+    }
+}
+
 namespace ff
 {
     struct stable_hash_data_t
@@ -22,6 +105,231 @@ namespace ff
     ff::stable_hash_data_t stable_hash_incremental(const void* data, size_t size, const ff::stable_hash_data_t& prev_data = ff::stable_hash_data_t()) noexcept;
     size_t stable_hash_bytes(const void* data, size_t size) noexcept;
 
+    // Bump this if wide_hash_bytes ever changes, anything that persists wide hashes should save it too
+    constexpr uint32_t wide_hash_version = 1;
+}
+
+namespace ff::internal::wide_hash
+{
+    // Same secret and constants as XXH3 (xxHash v0.8), so results match XXH3_64bits_withSeed
+    alignas(64) inline constexpr uint8_t secret[192] =
+    {
+        0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+        0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+        0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+        0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+        0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+        0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+        0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+        0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+        0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+        0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+        0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+        0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+    };
+
+    constexpr uint64_t prime32_1 = 0x9E3779B1U;
+    constexpr uint64_t prime32_2 = 0x85EBCA77U;
+    constexpr uint64_t prime32_3 = 0xC2B2AE3DU;
+    constexpr uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t prime64_4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t prime64_5 = 0x27D4EB2F165667C5ULL;
+    constexpr uint64_t prime_mx1 = 0x165667919E3779F9ULL;
+    constexpr uint64_t prime_mx2 = 0x9FB21C651E98DF25ULL;
+
+    // Anything longer goes through the out of line mid size and bulk paths
+    uint64_t hash_large(const uint8_t* data, size_t size, uint64_t seed) noexcept;
+
+    inline uint32_t read32(const void* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t read64(const void* data)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t mul128_fold64(uint64_t a, uint64_t b)
+    {
+#if defined(_M_X64)
+        uint64_t high;
+        uint64_t low = ::_umul128(a, b, &high);
+        return low ^ high;
+#elif defined(_M_ARM64)
+        return (a * b) ^ ::__umulh(a, b);
+#else
+        const uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+        const uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+        const uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+        const uint64_t hi_hi = (a >> 32) * (b >> 32);
+        const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+        const uint64_t high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+        const uint64_t low = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+        return low ^ high;
+#endif
+    }
+
+    inline uint64_t avalanche(uint64_t hash)
+    {
+        hash ^= hash >> 37;
+        hash *= ff::internal::wide_hash::prime_mx1;
+        return hash ^ (hash >> 32);
+    }
+
+    inline uint64_t avalanche64(uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= ff::internal::wide_hash::prime64_2;
+        hash ^= hash >> 29;
+        hash *= ff::internal::wide_hash::prime64_3;
+        return hash ^ (hash >> 32);
+    }
+
+    inline uint64_t rrmxmx(uint64_t hash, uint64_t size)
+    {
+        hash ^= std::rotl(hash, 49) ^ std::rotl(hash, 24);
+        hash *= ff::internal::wide_hash::prime_mx2;
+        hash ^= (hash >> 35) + size;
+        hash *= ff::internal::wide_hash::prime_mx2;
+        return hash ^ (hash >> 28);
+    }
+
+    inline uint64_t mix16(const uint8_t* data, const uint8_t* secret, uint64_t seed)
+    {
+        const uint64_t low = ff::internal::wide_hash::read64(data) ^ (ff::internal::wide_hash::read64(secret) + seed);
+        const uint64_t high = ff::internal::wide_hash::read64(data + 8) ^ (ff::internal::wide_hash::read64(secret + 8) - seed);
+        return ff::internal::wide_hash::mul128_fold64(low, high);
+    }
+
+    inline uint64_t secret_pair64(size_t offset1, size_t offset2)
+    {
+        return ff::internal::wide_hash::read64(ff::internal::wide_hash::secret + offset1) ^ ff::internal::wide_hash::read64(ff::internal::wide_hash::secret + offset2);
+    }
+
+    inline uint64_t hash_0_to_16(const uint8_t* data, size_t size, uint64_t seed)
+    {
+        if (size > 8)
+        {
+            const uint64_t low = ff::internal::wide_hash::read64(data) ^ (ff::internal::wide_hash::secret_pair64(24, 32) + seed);
+            const uint64_t high = ff::internal::wide_hash::read64(data + size - 8) ^ (ff::internal::wide_hash::secret_pair64(40, 48) - seed);
+            return ff::internal::wide_hash::avalanche(size + ::_byteswap_uint64(low) + high + ff::internal::wide_hash::mul128_fold64(low, high));
+        }
+
+        if (size >= 4)
+        {
+            seed ^= static_cast<uint64_t>(::_byteswap_ulong(static_cast<uint32_t>(seed))) << 32;
+            const uint64_t input = ff::internal::wide_hash::read32(data + size - 4) + (static_cast<uint64_t>(ff::internal::wide_hash::read32(data)) << 32);
+            return ff::internal::wide_hash::rrmxmx(input ^ (ff::internal::wide_hash::secret_pair64(8, 16) - seed), size);
+        }
+
+        if (size)
+        {
+            const uint32_t combined =
+                (static_cast<uint32_t>(data[0]) << 16) |
+                (static_cast<uint32_t>(data[size >> 1]) << 24) |
+                static_cast<uint32_t>(data[size - 1]) |
+                (static_cast<uint32_t>(size) << 8);
+            const uint32_t flip = ff::internal::wide_hash::read32(ff::internal::wide_hash::secret) ^ ff::internal::wide_hash::read32(ff::internal::wide_hash::secret + 4);
+            return ff::internal::wide_hash::avalanche64(combined ^ (flip + seed));
+        }
+
+        return ff::internal::wide_hash::avalanche64(seed ^ ff::internal::wide_hash::secret_pair64(56, 64));
+    }
+
+    inline uint64_t hash_17_to_128(const uint8_t* data, size_t size, uint64_t seed)
+    {
+        const uint8_t* secret = ff::internal::wide_hash::secret;
+        uint64_t result = size * ff::internal::wide_hash::prime64_1;
+
+        if (size > 32)
+        {
+            if (size > 64)
+            {
+                if (size > 96)
+                {
+                    result += ff::internal::wide_hash::mix16(data + 48, secret + 96, seed);
+                    result += ff::internal::wide_hash::mix16(data + size - 64, secret + 112, seed);
+                }
+
+                result += ff::internal::wide_hash::mix16(data + 32, secret + 64, seed);
+                result += ff::internal::wide_hash::mix16(data + size - 48, secret + 80, seed);
+            }
+
+            result += ff::internal::wide_hash::mix16(data + 16, secret + 32, seed);
+            result += ff::internal::wide_hash::mix16(data + size - 32, secret + 48, seed);
+        }
+
+        result += ff::internal::wide_hash::mix16(data, secret, seed);
+        result += ff::internal::wide_hash::mix16(data + size - 16, secret + 16, seed);
+
+        return ff::internal::wide_hash::avalanche(result);
+    }
+}
+
+namespace ff
+{
+    /// <summary>
+    /// 64-bit XXH3 hash of bytes, it's stable and much faster than stable_hash_bytes for anything but tiny inputs.
+    /// </summary>
+    /// <remarks>
+    /// Small sizes are inline so that hashing a fixed size type compiles down to one short path.
+    /// Inputs over 240 bytes use 64 byte SIMD stripes. The result is not the same as stable_hash_bytes,
+    /// so existing persisted hashes and cookies must keep using that.
+    /// </remarks>
+    inline uint64_t wide_hash_bytes(const void* data, size_t size, uint64_t seed = 0) noexcept
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+        if (size <= 16)
+        {
+            return ff::internal::wide_hash::hash_0_to_16(bytes, size, seed);
+        }
+
+        if (size <= 128)
+        {
+            return ff::internal::wide_hash::hash_17_to_128(bytes, size, seed);
+        }
+
+        return ff::internal::wide_hash::hash_large(bytes, size, seed);
+    }
+
+    /// <summary>
+    /// Like stable_hash, but uses wide_hash_bytes
+    /// </summary>
+    template<class T>
+    struct wide_hash
+    {
+        size_t operator()(const T& value) const noexcept
+        {
+            return static_cast<size_t>(ff::wide_hash_bytes(&value, sizeof(T)));
+        }
+    };
+
+    template<class Elem, class Traits>
+    struct wide_hash<std::basic_string_view<Elem, Traits>>
+    {
+        size_t operator()(const std::basic_string_view<Elem, Traits>& value) const noexcept
+        {
+            return static_cast<size_t>(ff::wide_hash_bytes(value.data(), value.size() * sizeof(Elem)));
+        }
+    };
+
+    template<class Elem, class Traits, class Alloc>
+    struct wide_hash<std::basic_string<Elem, Traits, Alloc>>
+    {
+        size_t operator()(const std::basic_string<Elem, Traits, Alloc>& value) const noexcept
+        {
+            return static_cast<size_t>(ff::wide_hash_bytes(value.data(), value.size() * sizeof(Elem)));
+        }
+    };
+
     /// <summary>
     /// Replacement for std::hash that is always stable, the hashes could be persisted.
     /// </summary>
@@ -1,10 +1,18 @@
 #include "pch.h"
 #include "base/assert.h"
+#include "base/stable_hash.h"
 #include "data_persist/compression.h"
 #include "data_persist/data.h"
+#include "data_persist/saved_data.h"
 #include "data_persist/stream.h"
+#include "thread/job_system.h"
+#include "thread/thread_pool.h"
+#include "types/flags.h"
+#include "types/stack_vector.h"
 #include <zlib/zlib.h>
 
+using namespace std::string_view_literals;
+
 static size_t get_chunk_size_for_data_size(size_t data_size)
 {
     static const size_t max_chunk_size = 1024 * 256;
@@ -119,6 +127,514 @@ bool ff::compression::uncompress(reader_base& reader, size_t saved_size, writer_
     return status;
 }
 
+static const size_t CHUNKED_COOKIE = ff::stable_hash_func("ff::compression::chunked@0"sv);
+constexpr size_t DEFAULT_CHUNKED_SIZE = 1024 * 256;
+
+namespace
+{
+    // Followed by a uint64_t for where each chunk ends (relative to the end of the index), then the chunks
+    struct chunked_header_t
+    {
+        uint64_t cookie;
+        uint64_t loaded_size;
+        uint64_t chunk_size;
+        uint64_t chunk_count;
+    };
+}
+
+static const ::chunked_header_t* get_chunked_header(const ff::data_base& saved_data)
+{
+    const ::chunked_header_t* header = reinterpret_cast<const ::chunked_header_t*>(saved_data.data());
+    assert_ret_val(saved_data.size() >= sizeof(::chunked_header_t) && header->cookie == ::CHUNKED_COOKIE, nullptr);
+    assert_ret_val(header->chunk_size || !header->loaded_size, nullptr);
+    assert_ret_val(header->chunk_count == (header->loaded_size ? (header->loaded_size - 1) / header->chunk_size + 1 : 0), nullptr);
+    assert_ret_val((saved_data.size() - sizeof(::chunked_header_t)) / sizeof(uint64_t) >= header->chunk_count, nullptr);
+    return header;
+}
+
+// Runs func(i) for each chunk on the job system, waiting on a worker thread runs other jobs instead of blocking
+template<class Func>
+static bool for_each_chunk(size_t begin, size_t end, const Func& func)
+{
+    std::atomic_bool status = true;
+
+    if (end - begin <= 1)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            status = func(i) && status;
+        }
+    }
+    else
+    {
+        ff::job_handle root = ff::thread_pool::add_job([begin, end, &func, &status]()
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    ff::thread_pool::add_job([i, &func, &status]()
+                        {
+                            if (!func(i))
+                            {
+                                status = false;
+                            }
+                        }, ff::job_system::current_job());
+                }
+            });
+
+        root.wait();
+    }
+
+    return status;
+}
+
+bool ff::compression::compress_chunked(const data_base& data, writer_base& writer, size_t chunk_size)
+{
+    chunk_size = chunk_size ? chunk_size : ::DEFAULT_CHUNKED_SIZE;
+
+    const size_t full_size = data.size();
+    const size_t chunk_count = full_size ? (full_size - 1) / chunk_size + 1 : 0;
+    std::vector<std::vector<uint8_t>> chunks(chunk_count);
+
+    bool status = ::for_each_chunk(0, chunk_count, [&data, &chunks, chunk_size, full_size](size_t i)
+        {
+            const size_t pos = i * chunk_size;
+            const uLong read_size = static_cast<uLong>(std::min(full_size - pos, chunk_size));
+            uLongf write_size = ::compressBound(read_size);
+
+            std::vector<uint8_t>& chunk = chunks[i];
+            chunk.resize(write_size);
+            assert_ret_val(::compress2(chunk.data(), &write_size, data.data() + pos, read_size, Z_BEST_COMPRESSION) == Z_OK, false);
+            chunk.resize(write_size);
+            return true;
+        });
+
+    assert_ret_val(status, false);
+
+    const ::chunked_header_t header{ ::CHUNKED_COOKIE, full_size, chunk_size, chunk_count };
+    std::vector<uint64_t> chunk_ends;
+    chunk_ends.reserve(chunk_count);
+
+    for (const std::vector<uint8_t>& chunk : chunks)
+    {
+        chunk_ends.push_back((chunk_ends.empty() ? 0 : chunk_ends.back()) + chunk.size());
+    }
+
+    status = writer.write(&header, sizeof(header)) == sizeof(header) &&
+        writer.write(chunk_ends.data(), ff::vector_byte_size(chunk_ends)) == ff::vector_byte_size(chunk_ends);
+
+    for (size_t i = 0; status && i < chunk_count; i++)
+    {
+        status = writer.write(chunks[i].data(), chunks[i].size()) == chunks[i].size();
+    }
+
+    assert(status);
+    return status;
+}
+
+bool ff::compression::uncompress_chunked(const data_base& saved_data, size_t offset, void* buffer, size_t size)
+{
+    const ::chunked_header_t* header = ::get_chunked_header(saved_data);
+    assert_ret_val(header && offset <= header->loaded_size && size <= header->loaded_size - offset, false);
+
+    if (!size)
+    {
+        return true;
+    }
+
+    const uint64_t* chunk_ends = reinterpret_cast<const uint64_t*>(header + 1);
+    const uint8_t* chunks_data = reinterpret_cast<const uint8_t*>(chunk_ends + header->chunk_count);
+    const size_t chunks_size = saved_data.size() - (chunks_data - saved_data.data());
+    const size_t chunk_size = static_cast<size_t>(header->chunk_size);
+    const size_t loaded_size = static_cast<size_t>(header->loaded_size);
+
+    return ::for_each_chunk(offset / chunk_size, (offset + size - 1) / chunk_size + 1,
+        [=](size_t i)
+        {
+            const size_t saved_begin = i ? static_cast<size_t>(chunk_ends[i - 1]) : 0;
+            const size_t saved_end = static_cast<size_t>(chunk_ends[i]);
+            assert_ret_val(saved_begin <= saved_end && saved_end <= chunks_size, false);
+
+            // Only the part of this chunk that overlaps [offset, offset + size) gets copied out
+            const size_t chunk_pos = i * chunk_size;
+            const size_t chunk_loaded_size = std::min(loaded_size - chunk_pos, chunk_size);
+            const size_t copy_begin = std::max(offset, chunk_pos);
+            const size_t copy_end = std::min(offset + size, chunk_pos + chunk_loaded_size);
+            uint8_t* dest = static_cast<uint8_t*>(buffer) + (copy_begin - offset);
+
+            std::vector<uint8_t> partial_chunk;
+            const bool partial = copy_begin != chunk_pos || copy_end != chunk_pos + chunk_loaded_size;
+            if (partial)
+            {
+                partial_chunk.resize(chunk_loaded_size);
+            }
+
+            uLongf write_size = static_cast<uLongf>(chunk_loaded_size);
+            const int zlib_status = ::uncompress(partial ? partial_chunk.data() : dest, &write_size, chunks_data + saved_begin, static_cast<uLong>(saved_end - saved_begin));
+            assert_ret_val(zlib_status == Z_OK && write_size == chunk_loaded_size, false);
+
+            if (partial)
+            {
+                std::memcpy(dest, partial_chunk.data() + (copy_begin - chunk_pos), copy_end - copy_begin);
+            }
+
+            return true;
+        });
+}
+
+size_t ff::compression::chunked_loaded_size(const data_base& saved_data)
+{
+    const ::chunked_header_t* header = ::get_chunked_header(saved_data);
+    return header ? static_cast<size_t>(header->loaded_size) : 0;
+}
+
+static const size_t LZ4_COOKIE = ff::stable_hash_func("ff::compression::lz4@0"sv);
+constexpr size_t LZ4_MIN_MATCH = 4;
+constexpr size_t LZ4_LAST_LITERALS = 5; // the last bytes of a block are always literals
+constexpr size_t LZ4_MATCH_LIMIT = 12; // the last match has to start this far from the end
+constexpr size_t LZ4_MAX_OFFSET = 0xFFFF;
+constexpr size_t LZ4_HASH_BITS = 16;
+
+static uint32_t lz4_read32(const uint8_t* data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static size_t lz4_hash(uint32_t value)
+{
+    return static_cast<size_t>((value * 2654435761u) >> (32 - ::LZ4_HASH_BITS));
+}
+
+static uint8_t* lz4_write_length(uint8_t* output, size_t length)
+{
+    for (; length >= 0xFF; length -= 0xFF)
+    {
+        *output++ = 0xFF;
+    }
+
+    *output++ = static_cast<uint8_t>(length);
+    return output;
+}
+
+static bool lz4_read_length(const uint8_t*& input, const uint8_t* input_end, size_t& length)
+{
+    for (uint8_t value = 0xFF; value == 0xFF; length += value)
+    {
+        assert_ret_val(input < input_end, false);
+        value = *input++;
+    }
+
+    return true;
+}
+
+static uint8_t* lz4_write_sequence(uint8_t* output, const uint8_t* literals, size_t literal_size, size_t offset, size_t match_size)
+{
+    const size_t match_extra = match_size ? match_size - ::LZ4_MIN_MATCH : 0;
+    *output++ = static_cast<uint8_t>((std::min<size_t>(literal_size, 15) << 4) | std::min<size_t>(match_extra, 15));
+
+    if (literal_size >= 15)
+    {
+        output = ::lz4_write_length(output, literal_size - 15);
+    }
+
+    std::memcpy(output, literals, literal_size);
+    output += literal_size;
+
+    if (match_size)
+    {
+        *output++ = static_cast<uint8_t>(offset);
+        *output++ = static_cast<uint8_t>(offset >> 8);
+
+        if (match_extra >= 15)
+        {
+            output = ::lz4_write_length(output, match_extra - 15);
+        }
+    }
+
+    return output;
+}
+
+static size_t lz4_compress_bound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+// Greedy LZ4 block compression with a single hash table, it skips ahead faster through data that doesn't match.
+// The output must have room for lz4_compress_bound(size) bytes, returns the actual size.
+static size_t lz4_compress_block(const uint8_t* data, size_t size, uint8_t* output)
+{
+    uint8_t* const output_start = output;
+    std::vector<uint32_t> table(size_t(1) << ::LZ4_HASH_BITS);
+    size_t anchor = 0;
+
+    for (size_t i = 0; i + ::LZ4_MATCH_LIMIT <= size;)
+    {
+        const uint32_t value = ::lz4_read32(data + i);
+        uint32_t& table_entry = table[::lz4_hash(value)];
+        size_t match = table_entry;
+        table_entry = static_cast<uint32_t>(i);
+
+        if (match >= i || i - match > ::LZ4_MAX_OFFSET || ::lz4_read32(data + match) != value)
+        {
+            i += 1 + ((i - anchor) >> 6);
+            continue;
+        }
+
+        while (i > anchor && match > 0 && data[i - 1] == data[match - 1])
+        {
+            i--;
+            match--;
+        }
+
+        size_t match_size = ::LZ4_MIN_MATCH;
+        for (const size_t match_end = size - ::LZ4_LAST_LITERALS; i + match_size < match_end && data[i + match_size] == data[match + match_size]; match_size++);
+
+        output = ::lz4_write_sequence(output, data + anchor, i - anchor, i - match, match_size);
+        i += match_size;
+        anchor = i;
+
+        if (i + ::LZ4_MATCH_LIMIT <= size)
+        {
+            table[::lz4_hash(::lz4_read32(data + i - 2))] = static_cast<uint32_t>(i - 2);
+        }
+    }
+
+    output = ::lz4_write_sequence(output, data + anchor, size - anchor, 0, 0);
+    return output - output_start;
+}
+
+static bool lz4_uncompress_block(const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size)
+{
+    const uint8_t* const input_end = input + input_size;
+    uint8_t* const output_start = output;
+    uint8_t* const output_end = output + output_size;
+
+    while (true)
+    {
+        assert_ret_val(input < input_end, false);
+        const uint8_t token = *input++;
+        size_t literal_size = token >> 4;
+
+        if (literal_size == 15)
+        {
+            assert_ret_val(::lz4_read_length(input, input_end, literal_size), false);
+        }
+
+        assert_ret_val(literal_size <= static_cast<size_t>(input_end - input) && literal_size <= static_cast<size_t>(output_end - output), false);
+
+        if (literal_size + 16 <= static_cast<size_t>(input_end - input) && literal_size + 16 <= static_cast<size_t>(output_end - output))
+        {
+            for (size_t i = 0; i < literal_size; i += 16)
+            {
+                std::memcpy(output + i, input + i, 16);
+            }
+        }
+        else
+        {
+            std::memcpy(output, input, literal_size);
+        }
+
+        input += literal_size;
+        output += literal_size;
+
+        if (input == input_end)
+        {
+            // The last sequence is only literals
+            return output == output_end;
+        }
+
+        assert_ret_val(input_end - input >= 2, false);
+        const size_t offset = input[0] | (static_cast<size_t>(input[1]) << 8);
+        input += 2;
+        assert_ret_val(offset && offset <= static_cast<size_t>(output - output_start), false);
+
+        size_t match_size = token & 0x0F;
+        if (match_size == 15)
+        {
+            assert_ret_val(::lz4_read_length(input, input_end, match_size), false);
+        }
+
+        match_size += ::LZ4_MIN_MATCH;
+        assert_ret_val(match_size <= static_cast<size_t>(output_end - output), false);
+
+        // Matches can overlap the output, which repeats the last offset bytes
+        const uint8_t* match = output - offset;
+        if (offset >= 16 && match_size + 16 <= static_cast<size_t>(output_end - output))
+        {
+            for (size_t i = 0; i < match_size; i += 16)
+            {
+                std::memcpy(output + i, match + i, 16);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < match_size; i++)
+            {
+                output[i] = match[i];
+            }
+        }
+
+        output += match_size;
+    }
+}
+
+namespace
+{
+    struct lz4_header_t
+    {
+        uint64_t cookie;
+        uint64_t loaded_size;
+    };
+}
+
+bool ff::compression::compress_lz4(const data_base& data, writer_base& writer)
+{
+    std::vector<uint8_t> output(sizeof(::lz4_header_t) + ::lz4_compress_bound(data.size()));
+    const ::lz4_header_t header{ ::LZ4_COOKIE, data.size() };
+    std::memcpy(output.data(), &header, sizeof(header));
+
+    const size_t output_size = sizeof(header) + ::lz4_compress_block(data.data(), data.size(), output.data() + sizeof(header));
+    return writer.write(output.data(), output_size) == output_size;
+}
+
+bool ff::compression::uncompress_lz4(const data_base& saved_data, void* buffer, size_t size)
+{
+    assert_ret_val(saved_data.size() >= sizeof(::lz4_header_t), false);
+
+    ::lz4_header_t header;
+    std::memcpy(&header, saved_data.data(), sizeof(header));
+    assert_ret_val(header.cookie == ::LZ4_COOKIE && header.loaded_size == size, false);
+
+    return ::lz4_uncompress_block(saved_data.data() + sizeof(header), saved_data.size() - sizeof(header), static_cast<uint8_t*>(buffer), size);
+}
+
+namespace
+{
+    class zlib_codec : public ff::compression::codec_base
+    {
+    public:
+        virtual std::string_view name() const override
+        {
+            return "zlib";
+        }
+
+        virtual ff::saved_data_type type() const override
+        {
+            return ff::saved_data_type::zlib_compressed;
+        }
+
+        virtual bool compress(const ff::data_base& data, ff::writer_base& writer) const override
+        {
+            ff::data_reader reader(std::make_shared<ff::data_static>(data.data(), data.size()));
+            return ff::compression::compress(reader, data.size(), writer);
+        }
+
+        virtual bool uncompress(const ff::data_base& saved_data, void* buffer, size_t size) const override
+        {
+            if (!saved_data.size())
+            {
+                return !size;
+            }
+
+            // One inflate call right into the buffer, rather than going through the chunks of ff::compression::uncompress
+            assert_ret_val(saved_data.size() <= std::numeric_limits<uLong>::max() && size <= std::numeric_limits<uLong>::max(), false);
+            uLongf write_size = static_cast<uLongf>(size);
+            return ::uncompress(static_cast<uint8_t*>(buffer), &write_size, saved_data.data(), static_cast<uLong>(saved_data.size())) == Z_OK && write_size == size;
+        }
+    };
+
+    class zlib_chunked_codec : public ff::compression::codec_base
+    {
+    public:
+        virtual std::string_view name() const override
+        {
+            return "zlib_chunked";
+        }
+
+        virtual ff::saved_data_type type() const override
+        {
+            return ff::saved_data_type::zlib_chunked;
+        }
+
+        virtual bool compress(const ff::data_base& data, ff::writer_base& writer) const override
+        {
+            return ff::compression::compress_chunked(data, writer);
+        }
+
+        virtual bool uncompress(const ff::data_base& saved_data, void* buffer, size_t size) const override
+        {
+            return ff::compression::chunked_loaded_size(saved_data) == size && ff::compression::uncompress_chunked(saved_data, 0, buffer, size);
+        }
+    };
+
+    class lz4_codec : public ff::compression::codec_base
+    {
+    public:
+        virtual std::string_view name() const override
+        {
+            return "lz4";
+        }
+
+        virtual ff::saved_data_type type() const override
+        {
+            return ff::saved_data_type::lz4_compressed;
+        }
+
+        virtual bool compress(const ff::data_base& data, ff::writer_base& writer) const override
+        {
+            return ff::compression::compress_lz4(data, writer);
+        }
+
+        virtual bool uncompress(const ff::data_base& saved_data, void* buffer, size_t size) const override
+        {
+            return ff::compression::uncompress_lz4(saved_data, buffer, size);
+        }
+    };
+}
+
+static const ::zlib_codec zlib_codec_instance;
+static const ::zlib_chunked_codec zlib_chunked_codec_instance;
+static const ::lz4_codec lz4_codec_instance;
+static const std::array<const ff::compression::codec_base*, 3> codecs{ &::zlib_codec_instance, &::zlib_chunked_codec_instance, &::lz4_codec_instance };
+
+const ff::compression::codec_base* ff::compression::get_codec(ff::saved_data_type type)
+{
+    for (const ff::compression::codec_base* codec : ::codecs)
+    {
+        if (ff::flags::has(type, codec->type()))
+        {
+            return codec;
+        }
+    }
+
+    return nullptr;
+}
+
+const ff::compression::codec_base* ff::compression::get_codec(std::string_view name)
+{
+    for (const ff::compression::codec_base* codec : ::codecs)
+    {
+        if (codec->name() == name)
+        {
+            return codec;
+        }
+    }
+
+    return nullptr;
+}
+
+ff::saved_data_type ff::compression::codec_types()
+{
+    ff::saved_data_type types = ff::saved_data_type::none;
+    for (const ff::compression::codec_base* codec : ::codecs)
+    {
+        types = ff::flags::combine(types, codec->type());
+    }
+
+    return types;
+}
+
 static uint8_t CHAR_TO_BYTE[] =
 {
     62, // +
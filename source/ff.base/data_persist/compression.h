@@ -5,6 +5,7 @@ namespace ff
     class data_base;
     class reader_base;
     class writer_base;
+    enum class saved_data_type;
 }
 
 namespace ff::compression
@@ -12,5 +13,44 @@ namespace ff::compression
     bool compress(reader_base& reader, size_t full_size, writer_base& writer);
     bool uncompress(reader_base& reader, size_t saved_size, writer_base& writer);
 
+    /// <summary>
+    /// Compresses independent chunks on the job system, see saved_data_type::zlib_chunked
+    /// </summary>
+    /// <remarks>
+    /// The output starts with a header and an index of where each chunk ends, so any range of the
+    /// original data can be uncompressed without touching the chunks around it.
+    /// </remarks>
+    bool compress_chunked(const data_base& data, writer_base& writer, size_t chunk_size = 0);
+    bool uncompress_chunked(const data_base& saved_data, size_t offset, void* buffer, size_t size);
+    size_t chunked_loaded_size(const data_base& saved_data);
+
+    /// <summary>
+    /// LZ4 compression, much faster to uncompress than zlib but doesn't compress as well
+    /// </summary>
+    /// <remarks>
+    /// The output is a cookie and the uncompressed size followed by one raw LZ4 block. It isn't an LZ4 frame,
+    /// so other LZ4 tools can only read the block after skipping that header.
+    /// </remarks>
+    bool compress_lz4(const data_base& data, writer_base& writer);
+    bool uncompress_lz4(const data_base& saved_data, void* buffer, size_t size);
+
+    /// <summary>
+    /// One way to compress saved data, the saved_data_type bit records which codec was used
+    /// </summary>
+    class codec_base
+    {
+    public:
+        virtual ~codec_base() = default;
+
+        virtual std::string_view name() const = 0;
+        virtual ff::saved_data_type type() const = 0;
+        virtual bool compress(const data_base& data, writer_base& writer) const = 0;
+        virtual bool uncompress(const data_base& saved_data, void* buffer, size_t size) const = 0;
+    };
+
+    const ff::compression::codec_base* get_codec(ff::saved_data_type type);
+    const ff::compression::codec_base* get_codec(std::string_view name);
+    ff::saved_data_type codec_types();
+
     std::shared_ptr<data_base> decode_base64(std::string_view text);
 }
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "base/assert.h"
 #include "base/log.h"
+#include "base/math.h"
 #include "base/stable_hash.h"
 #include "data_persist/data.h"
 #include "data_persist/dict.h"
@@ -9,6 +10,7 @@
 #include "data_persist/stream.h"
 #include "data_value/data_v.h"
 #include "data_value/dict_v.h"
+#include "data_value/null_v.h"
 #include "data_value/value.h"
 #include "data_value/value_vector_v.h"
 #include "types/push_back.h"
@@ -16,29 +18,83 @@
 using namespace std::string_view_literals;
 
 static const size_t DICT_PERSIST_COOKIE = ff::stable_hash_func("ff::dict@0"sv);
+static const size_t DICT_INDEXED_COOKIE = ff::stable_hash_func("ff::dict@1"sv);
 
-static const std::string& get_cached_string(std::string_view str)
+namespace
 {
-    static std::forward_list<std::string> string_list;
-    static std::unordered_map<std::string_view, const std::string&> string_map;
-    static std::shared_mutex mutex;
+    // Offsets are from the start of the indexed dict data
+    struct indexed_entry_t
+    {
+        size_t name_offset;
+        size_t name_size;
+        size_t value_offset;
+        size_t value_size;
+    };
 
-    // Check if it's cached already
+    struct indexed_header_t
     {
-        std::shared_lock lock(mutex);
-        auto i = string_map.find(str);
-        if (i != string_map.cend())
-        {
-            return i->second;
-        }
-    }
+        size_t cookie;
+        size_t count;
+    };
+}
 
-    // Add to the cache
+struct ff::dict::lazy_values_t
+{
+    struct location_t
     {
-        std::unique_lock lock(mutex);
-        const std::string& new_str = string_list.emplace_front(str);
-        return string_map.try_emplace(new_str, new_str).first->second;
+        size_t offset;
+        size_t size;
+    };
+
+    std::shared_ptr<ff::data_base> data;
+    std::vector<location_t> locations;
+    std::unique_ptr<std::atomic_bool[]> loaded;
+    std::atomic_bool all_loaded;
+    std::mutex mutex;
+};
+
+ff::dict::const_iterator::const_iterator(map_type::const_iterator map_iter)
+    : map_iter(map_iter)
+{}
+
+ff::dict::const_iterator::const_iterator(const value_type* flat_iter)
+    : flat_iter(flat_iter)
+{}
+
+ff::dict::const_iterator::reference ff::dict::const_iterator::operator*() const
+{
+    return this->flat_iter ? *this->flat_iter : *this->map_iter;
+}
+
+ff::dict::const_iterator::pointer ff::dict::const_iterator::operator->() const
+{
+    return &**this;
+}
+
+ff::dict::const_iterator& ff::dict::const_iterator::operator++()
+{
+    if (this->flat_iter)
+    {
+        this->flat_iter++;
+    }
+    else
+    {
+        ++this->map_iter;
     }
+
+    return *this;
+}
+
+ff::dict::const_iterator ff::dict::const_iterator::operator++(int)
+{
+    const_iterator old = *this;
+    ++*this;
+    return old;
+}
+
+bool ff::dict::const_iterator::operator==(const const_iterator& other) const
+{
+    return this->flat_iter ? this->flat_iter == other.flat_iter : this->map_iter == other.map_iter;
 }
 
 bool ff::dict::operator==(const dict& other) const
@@ -68,21 +124,22 @@ std::ostream& ff::dict::operator<<(std::ostream& ostream) const
 
 bool ff::dict::empty() const
 {
-    return this->map.empty();
+    return !this->size();
 }
 
 size_t ff::dict::size() const
 {
-    return this->map.size();
+    return this->flat ? this->flat->entries.size() : this->map.size();
 }
 
 void ff::dict::reserve(size_t count)
 {
-    this->map.reserve(count);
+    this->mutable_map().reserve(count);
 }
 
 void ff::dict::clear()
 {
+    this->flat.reset();
     this->map.clear();
 }
 
@@ -111,11 +168,11 @@ void ff::dict::set(std::string_view name, const value* value)
 {
     if (!value)
     {
-        this->map.erase(name);
+        this->mutable_map().erase(name);
     }
     else
     {
-        this->map.insert_or_assign(::get_cached_string(name), value);
+        this->mutable_map().insert_or_assign(ff::atom(name).str(), value);
     }
 }
 
@@ -132,13 +189,21 @@ void ff::dict::set_bytes(std::string_view name, const void* data, size_t size)
     this->set<ff::data_base>(name, value, ff::saved_data_type::none);
 }
 
-ff::value_ptr ff::dict::get(std::string_view name) const
+ff::value_ptr ff::dict::get(ff::atom_key name) const
 {
-    value_ptr value = this->get_by_path(name);
+    value_ptr value = this->get_by_path(name.str);
     if (!value)
     {
-        auto i = this->map.find(name);
-        value = (i != this->map.cend()) ? i->second : nullptr;
+        if (this->flat)
+        {
+            const value_type* entry = this->find_flat(name.hash(), name.str);
+            value = entry ? entry->second : nullptr;
+        }
+        else
+        {
+            auto i = this->map.find(name.str);
+            value = (i != this->map.cend()) ? i->second : nullptr;
+        }
     }
 
     return value;
@@ -161,12 +226,24 @@ std::vector<std::string_view> ff::dict::child_names(bool sorted) const
     std::vector<std::string_view> names;
     names.reserve(this->size());
 
-    for (const auto& i : *this)
+    if (this->flat)
+    {
+        // Don't use begin(), it would load lazy values
+        for (const value_type& i : this->flat->entries)
+        {
+            names.push_back(i.first);
+        }
+    }
+    else
     {
-        names.push_back(i.first);
+        for (const auto& i : *this)
+        {
+            names.push_back(i.first);
+        }
     }
 
-    if (sorted)
+    // Flat dicts are already sorted
+    if (sorted && !this->flat)
     {
         std::sort(names.begin(), names.end());
     }
@@ -176,11 +253,8 @@ std::vector<std::string_view> ff::dict::child_names(bool sorted) const
 
 bool ff::dict::load_child_dicts()
 {
-    bool changed = false;
-
-    for (auto& i : *this)
+    auto load_child_value = [](const value_ptr& val) -> value_ptr
     {
-        value_ptr val = i.second;
         if (val->is_type<ff::value_vector>())
         {
             bool changed_vector = false;
@@ -197,11 +271,7 @@ bool ff::dict::load_child_dicts()
                 }
             }
 
-            if (changed_vector)
-            {
-                i.second = value::create<ff::value_vector>(std::move(values));
-                changed = true;
-            }
+            return changed_vector ? value::create<ff::value_vector>(std::move(values)) : nullptr;
         }
         else
         {
@@ -210,8 +280,50 @@ bool ff::dict::load_child_dicts()
             {
                 dict new_dict = dict_val->get<dict>();
                 new_dict.load_child_dicts();
+                return value::create<dict>(std::move(new_dict));
+            }
+        }
 
-                i.second = value::create<dict>(std::move(new_dict));
+        return nullptr;
+    };
+
+    bool changed = false;
+
+    if (this->flat)
+    {
+        // Keep the dict flat, the names and lookup table don't change
+        this->load_flat_values();
+        std::shared_ptr<flat_type> new_flat;
+
+        for (size_t i = 0; i < this->flat->entries.size(); i++)
+        {
+            value_ptr new_val = load_child_value(this->flat->entries[i].second);
+            if (new_val)
+            {
+                if (!new_flat)
+                {
+                    new_flat = std::make_shared<flat_type>(*this->flat);
+                    new_flat->lazy.reset();
+                }
+
+                new_flat->entries[i].second = new_val;
+            }
+        }
+
+        if (new_flat)
+        {
+            this->flat = std::move(new_flat);
+            changed = true;
+        }
+    }
+    else
+    {
+        for (auto& i : this->map)
+        {
+            value_ptr new_val = load_child_value(i.second);
+            if (new_val)
+            {
+                i.second = new_val;
                 changed = true;
             }
         }
@@ -254,7 +366,8 @@ bool ff::dict::load(ff::reader_base& reader, ff::dict& data)
         return false;
     }
 
-    data.reserve(data.size() + size);
+    std::vector<std::pair<ff::atom, ff::value_ptr>> values;
+    values.reserve(size);
 
     std::string name;
     for (size_t i = 0; i < size; i++)
@@ -270,7 +383,149 @@ bool ff::dict::load(ff::reader_base& reader, ff::dict& data)
             return false;
         }
 
-        data.set(name, val);
+        values.emplace_back(ff::atom(name), val);
+    }
+
+    if (data.empty() && !values.empty())
+    {
+        data.map.clear();
+        data.flat = ff::dict::create_flat(std::move(values));
+    }
+    else
+    {
+        for (auto& [value_name, val] : values)
+        {
+            data.set(value_name.str(), val);
+        }
+    }
+
+    return true;
+}
+
+bool ff::dict::save_indexed(ff::writer_base& writer) const
+{
+    std::vector<const value_type*> sorted_entries;
+    sorted_entries.reserve(this->size());
+
+    for (const auto& i : *this)
+    {
+        sorted_entries.push_back(&i);
+    }
+
+    std::sort(sorted_entries.begin(), sorted_entries.end(), [](const value_type* lhs, const value_type* rhs)
+        {
+            return lhs->first < rhs->first;
+        });
+
+    // Values are saved separately first, their offsets are only known after the names are laid out
+    std::vector<::indexed_entry_t> table(sorted_entries.size());
+    std::string names;
+    auto values = std::make_shared<std::vector<uint8_t>>();
+    ff::data_writer values_writer(values);
+
+    for (size_t i = 0; i < sorted_entries.size(); i++)
+    {
+        ::indexed_entry_t& entry = table[i];
+        entry.name_offset = names.size();
+        entry.name_size = sorted_entries[i]->first.size();
+        names += sorted_entries[i]->first;
+
+        entry.value_offset = values_writer.pos();
+        assert_ret_val(sorted_entries[i]->second->save_typed(values_writer), false);
+        entry.value_size = values_writer.pos() - entry.value_offset;
+    }
+
+    const size_t names_start = sizeof(::indexed_header_t) + table.size() * sizeof(::indexed_entry_t);
+    const size_t values_start = ff::math::align_up<size_t>(names_start + names.size(), 8);
+
+    for (::indexed_entry_t& entry : table)
+    {
+        entry.name_offset += names_start;
+        entry.value_offset += values_start;
+    }
+
+    const ::indexed_header_t header{ ::DICT_INDEXED_COOKIE, table.size() };
+    const std::array<uint8_t, 8> padding{};
+    const size_t padding_size = values_start - names_start - names.size();
+
+    return
+        writer.write(&header, sizeof(header)) == sizeof(header) &&
+        writer.write(table.data(), table.size() * sizeof(::indexed_entry_t)) == table.size() * sizeof(::indexed_entry_t) &&
+        writer.write(names.data(), names.size()) == names.size() &&
+        writer.write(padding.data(), padding_size) == padding_size &&
+        writer.write(values->data(), values->size()) == values->size();
+}
+
+bool ff::dict::load_indexed(const std::shared_ptr<ff::data_base>& saved_data, ff::dict& data)
+{
+    const uint8_t* bytes = saved_data ? saved_data->data() : nullptr;
+    const size_t size = saved_data ? saved_data->size() : 0;
+
+    ::indexed_header_t header;
+    if (!bytes || size < sizeof(header))
+    {
+        return false;
+    }
+
+    // The saved data may not be aligned, so copy everything out of it
+    std::memcpy(&header, bytes, sizeof(header));
+    if (header.cookie != ::DICT_INDEXED_COOKIE || header.count > (size - sizeof(header)) / sizeof(::indexed_entry_t))
+    {
+        return false;
+    }
+
+    std::vector<::indexed_entry_t> table(header.count);
+    std::memcpy(table.data(), bytes + sizeof(header), table.size() * sizeof(::indexed_entry_t));
+
+    auto lazy = std::make_shared<lazy_values_t>();
+    lazy->data = saved_data;
+    lazy->locations.reserve(table.size());
+    lazy->loaded = std::make_unique<std::atomic_bool[]>(table.size());
+
+    auto flat = std::make_shared<flat_type>();
+    flat->entries.reserve(table.size());
+    flat->lookup.reserve(table.size());
+    flat->lazy = lazy;
+
+    for (const ::indexed_entry_t& entry : table)
+    {
+        if (entry.name_offset > size || entry.name_size > size - entry.name_offset ||
+            entry.value_offset > size || entry.value_size > size - entry.value_offset)
+        {
+            return false;
+        }
+
+        ff::atom name(std::string_view(reinterpret_cast<const char*>(bytes + entry.name_offset), entry.name_size));
+        if (!flat->entries.empty() && flat->entries.back().first >= name.str())
+        {
+            // Names must be unique and sorted
+            return false;
+        }
+
+        flat->lookup.push_back(flat_lookup_t{ name.hash(), name, flat->entries.size() });
+        flat->entries.emplace_back(name.str(), nullptr);
+        lazy->locations.push_back(lazy_values_t::location_t{ entry.value_offset, entry.value_size });
+    }
+
+    std::sort(flat->lookup.begin(), flat->lookup.end(), [](const flat_lookup_t& lhs, const flat_lookup_t& rhs)
+        {
+            return lhs.hash < rhs.hash;
+        });
+
+    if (data.empty() && !flat->entries.empty())
+    {
+        data.map.clear();
+        data.flat = std::move(flat);
+    }
+    else
+    {
+        ff::dict loaded_data;
+        loaded_data.flat = std::move(flat);
+
+        for (const auto& [name, value] : loaded_data)
+        {
+            data.set(name, value);
+        }
     }
 
     return true;
@@ -278,32 +533,33 @@ bool ff::dict::load(ff::reader_base& reader, ff::dict& data)
 
 ff::dict::iterator ff::dict::begin()
 {
-    return this->map.begin();
+    return this->mutable_map().begin();
 }
 
 ff::dict::const_iterator ff::dict::begin() const
 {
-    return this->map.begin();
+    this->load_flat_values();
+    return this->flat ? const_iterator(this->flat->entries.data()) : const_iterator(this->map.cbegin());
 }
 
 ff::dict::const_iterator ff::dict::cbegin() const
 {
-    return this->map.cbegin();
+    return this->begin();
 }
 
 ff::dict::iterator ff::dict::end()
 {
-    return this->map.end();
+    return this->mutable_map().end();
 }
 
 ff::dict::const_iterator ff::dict::end() const
 {
-    return this->map.end();
+    return this->flat ? const_iterator(this->flat->entries.data() + this->flat->entries.size()) : const_iterator(this->map.cend());
 }
 
 ff::dict::const_iterator ff::dict::cend() const
 {
-    return this->map.cend();
+    return this->end();
 }
 
 void ff::dict::print(std::ostream& output) const
@@ -347,6 +603,106 @@ ff::value_ptr ff::dict::get_by_path(std::string_view path) const
     return nullptr;
 }
 
+const ff::dict::value_type* ff::dict::find_flat(size_t hash, std::string_view name) const
+{
+    const std::vector<flat_lookup_t>& lookup = this->flat->lookup;
+    auto i = std::lower_bound(lookup.cbegin(), lookup.cend(), hash, [](const flat_lookup_t& entry, size_t hash)
+        {
+            return entry.hash < hash;
+        });
+
+    for (; i != lookup.cend() && i->hash == hash; ++i)
+    {
+        if (i->name.str() == name)
+        {
+            return &this->flat_entry(i->index);
+        }
+    }
+
+    return nullptr;
+}
+
+const ff::dict::value_type& ff::dict::flat_entry(size_t index) const
+{
+    const flat_type& flat = *this->flat;
+    lazy_values_t* lazy = flat.lazy.get();
+
+    if (lazy && !lazy->loaded[index].load(std::memory_order_acquire))
+    {
+        std::scoped_lock lock(lazy->mutex);
+        if (!lazy->loaded[index].load(std::memory_order_relaxed))
+        {
+            const lazy_values_t::location_t& location = lazy->locations[index];
+            ff::data_reader reader(lazy->data->subdata(location.offset, location.size));
+            ff::value_ptr value = ff::value::load_typed(reader);
+            assert_msg(value, "Failed to load dict value");
+
+            flat.entries[index].second = value ? value : ff::value::create<nullptr_t>();
+            lazy->loaded[index].store(true, std::memory_order_release);
+        }
+    }
+
+    return flat.entries[index];
+}
+
+void ff::dict::load_flat_values() const
+{
+    lazy_values_t* lazy = this->flat ? this->flat->lazy.get() : nullptr;
+    if (lazy && !lazy->all_loaded.load(std::memory_order_acquire))
+    {
+        for (size_t i = 0; i < this->flat->entries.size(); i++)
+        {
+            this->flat_entry(i);
+        }
+
+        lazy->all_loaded.store(true, std::memory_order_release);
+    }
+}
+
+ff::dict::map_type& ff::dict::mutable_map()
+{
+    if (this->flat)
+    {
+        this->load_flat_values();
+        std::shared_ptr<const flat_type> flat = std::move(this->flat);
+        this->map.reserve(flat->entries.size());
+        this->map.insert(flat->entries.cbegin(), flat->entries.cend());
+    }
+
+    return this->map;
+}
+
+std::shared_ptr<const ff::dict::flat_type> ff::dict::create_flat(std::vector<std::pair<ff::atom, value_ptr>>&& values)
+{
+    // Later values replace earlier ones with the same name, like calling set() in order
+    std::stable_sort(values.begin(), values.end(), [](const auto& lhs, const auto& rhs)
+        {
+            return lhs.first.str() < rhs.first.str();
+        });
+
+    auto flat = std::make_shared<flat_type>();
+    flat->entries.reserve(values.size());
+    flat->lookup.reserve(values.size());
+
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (i + 1 < values.size() && values[i].first == values[i + 1].first)
+        {
+            continue;
+        }
+
+        flat->lookup.push_back(flat_lookup_t{ values[i].first.hash(), values[i].first, flat->entries.size() });
+        flat->entries.emplace_back(values[i].first.str(), std::move(values[i].second));
+    }
+
+    std::sort(flat->lookup.begin(), flat->lookup.end(), [](const flat_lookup_t& lhs, const flat_lookup_t& rhs)
+        {
+            return lhs.hash < rhs.hash;
+        });
+
+    return flat;
+}
+
 std::ostream& std::operator<<(std::ostream& ostream, const ff::dict& value)
 {
     return value.operator<<(ostream);
@@ -1,19 +1,59 @@
 #pragma once
 
-#include "../types/push_back.h"
 #include "../data_value/value.h"
+#include "../types/atom.h"
+#include "../types/push_back.h"
 
 namespace ff
 {
+    class data_base;
     class reader_base;
     class writer_base;
 
+    /// <summary>
+    /// Map of names to values
+    /// </summary>
+    /// <remarks>
+    /// Dicts that are loaded from saved data use a sorted flat array with precomputed name hashes,
+    /// which is shared by copies of the dict. The first change to a dict moves it into a hash map.
+    /// Iteration order isn't defined either way, use child_names(true) for sorted names.
+    /// Iterating a non-const dict counts as a change, so read-only loops should use a const dict.
+    ///
+    /// save_indexed() writes an offset table in front of the values, so load_indexed() can read the names
+    /// without touching any values. Each value is loaded from the saved data on first use, and data values
+    /// stay as slices of the saved data (which is mem-mapped for cached resource packs).
+    /// </remarks>
     class dict
     {
     public:
         using map_type = typename std::unordered_map<std::string_view, value_ptr>;
+        using value_type = typename map_type::value_type;
+
+        class const_iterator
+        {
+        public:
+            using iterator_category = typename std::forward_iterator_tag;
+            using value_type = typename ff::dict::value_type;
+            using difference_type = typename ptrdiff_t;
+            using pointer = typename const value_type*;
+            using reference = typename const value_type&;
+
+            const_iterator() = default;
+            const_iterator(map_type::const_iterator map_iter);
+            const_iterator(const value_type* flat_iter);
+
+            reference operator*() const;
+            pointer operator->() const;
+            const_iterator& operator++();
+            const_iterator operator++(int);
+            bool operator==(const const_iterator& other) const;
+
+        private:
+            map_type::const_iterator map_iter;
+            const value_type* flat_iter{};
+        };
+
         using iterator = typename map_type::iterator;
-        using const_iterator = typename map_type::const_iterator;
 
         dict() = default;
         dict(const dict& other) = default;
@@ -32,7 +72,7 @@ namespace ff
         void set(const dict& other, bool merge_child_dicts);
         void set(std::string_view name, const value* value);
         void set_bytes(std::string_view name, const void* data, size_t size);
-        value_ptr get(std::string_view name) const;
+        value_ptr get(ff::atom_key name) const;
         bool get_bytes(std::string_view name, void* data, size_t size) const;
 
         struct location_t
@@ -44,13 +84,14 @@ namespace ff
 
         std::vector<std::string_view> child_names(bool sorted = false) const;
         bool save(ff::writer_base& writer, ff::push_base<ff::dict::location_t>* saved_locations = nullptr) const;
+        bool save_indexed(ff::writer_base& writer) const;
         static bool load(ff::reader_base& reader, ff::dict& data);
+        static bool load_indexed(const std::shared_ptr<ff::data_base>& saved_data, ff::dict& data);
         bool load_child_dicts();
 
         iterator begin();
         const_iterator begin() const;
         const_iterator cbegin() const;
-
         iterator end();
         const_iterator end() const;
         const_iterator cend() const;
@@ -64,22 +105,17 @@ namespace ff
             this->set(name, ff::value::create<T>(std::forward<Args>(args)...));
         }
 
+        // Names are atom keys, so literal names like get<int>("mips") are hashed at compile time
         template<class T>
-        auto get(std::string_view name) const -> typename ff::type::value_traits<T>::raw_type
+        auto get(ff::atom_key name) const -> typename ff::type::value_traits<T>::raw_type
         {
             return this->get(name)->convert_or_default<T>()->get<T>();
         }
 
         template<class T, typename... Args>
-        auto get(std::string_view name, Args&&... default_value_args) const -> typename ff::type::value_traits<T>::raw_type
+        auto get(ff::atom_key name, Args&&... default_value_args) const -> typename ff::type::value_traits<T>::raw_type
         {
-            value_ptr value = this->get(name)->try_convert<T>();
-            if (!value)
-            {
-                value = ff::value::create<T>(std::forward<Args>(default_value_args)...);
-            }
-
-            return value->get<T>();
+            return this->get_or_default<T>(this->get(name), std::forward<Args>(default_value_args)...);
         }
 
         template<class T>
@@ -109,9 +145,45 @@ namespace ff
         }
 
     private:
+        struct flat_lookup_t
+        {
+            size_t hash;
+            ff::atom name;
+            size_t index;
+        };
+
+        struct lazy_values_t;
+
+        // Immutable, entries are sorted by name and lookup is sorted by hash.
+        // When lazy is set, entry values are filled in on first use by flat_entry().
+        struct flat_type
+        {
+            mutable std::vector<value_type> entries;
+            std::vector<flat_lookup_t> lookup;
+            std::shared_ptr<lazy_values_t> lazy;
+        };
+
+        template<class T, typename... Args>
+        static auto get_or_default(value_ptr value, Args&&... default_value_args) -> typename ff::type::value_traits<T>::raw_type
+        {
+            value = value->try_convert<T>();
+            if (!value)
+            {
+                value = ff::value::create<T>(std::forward<Args>(default_value_args)...);
+            }
+
+            return value->get<T>();
+        }
+
         value_ptr get_by_path(std::string_view path) const;
+        const value_type* find_flat(size_t hash, std::string_view name) const;
+        const value_type& flat_entry(size_t index) const;
+        void load_flat_values() const;
+        map_type& mutable_map();
+        static std::shared_ptr<const flat_type> create_flat(std::vector<std::pair<ff::atom, value_ptr>>&& values);
 
         map_type map;
+        std::shared_ptr<const flat_type> flat;
     };
 }
 
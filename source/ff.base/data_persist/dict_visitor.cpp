@@ -6,20 +6,70 @@
 #include "data_value/saved_data_v.h"
 #include "data_value/value.h"
 #include "data_value/value_vector_v.h"
-#include "thread/thread_dispatch.h"
+#include "thread/job_system.h"
 #include "thread/thread_pool.h"
-#include "windows/win_handle.h"
+
+// Tasks running on this thread, the innermost one first. A thread that waits for other tasks can run them, so it's a stack.
+static thread_local ff::dict_visitor_base::task_context* current_task{};
+
+namespace
+{
+    class task_scope
+    {
+    public:
+        task_scope(ff::dict_visitor_base::task_context& task, const ff::dict_visitor_base* owner)
+            : task(task)
+        {
+            this->task.owner = owner;
+            this->task.previous = ::current_task;
+            ::current_task = &this->task;
+        }
+
+        task_scope(task_scope&& other) noexcept = delete;
+        task_scope(const task_scope& other) = delete;
+
+        ~task_scope()
+        {
+            assert(::current_task == &this->task);
+            ::current_task = this->task.previous;
+        }
+
+        task_scope& operator=(task_scope&& other) noexcept = delete;
+        task_scope& operator=(const task_scope& other) = delete;
+
+    private:
+        ff::dict_visitor_base::task_context& task;
+    };
+}
 
 ff::dict_visitor_base::dict_visitor_base()
 {}
 
 ff::dict_visitor_base::~dict_visitor_base()
-{}
+{
+    while (ff::dict_visitor_base::error_node* node = this->errors.pop())
+    {
+        delete node;
+    }
+}
 
 ff::value_ptr ff::dict_visitor_base::visit_dict(const ff::dict& dict, std::vector<std::string>& errors)
 {
-    ff::value_ptr transformed_dict_value = this->transform_dict(dict);
-    errors = std::move(this->errors);
+    ff::value_ptr transformed_dict_value;
+    {
+        std::unique_ptr<ff::dict_visitor_base::task_context> task = this->start_task(nullptr);
+        ::task_scope scope(*task, this);
+        transformed_dict_value = this->transform_dict(dict);
+    }
+
+    // All tasks are done, so no push can be half way done
+    errors.clear();
+    while (ff::dict_visitor_base::error_node* node = this->errors.pop())
+    {
+        errors.push_back(std::move(node->text));
+        delete node;
+    }
+
     return errors.empty() ? transformed_dict_value : nullptr;
 }
 
@@ -28,8 +78,9 @@ void ff::dict_visitor_base::add_error(std::string_view text)
     std::ostringstream str;
     str << ::GetCurrentThreadId() << "> " << this->path() << " : " << text;
 
-    std::scoped_lock lock(this->mutex);
-    this->errors.push_back(str.str());
+    ff::dict_visitor_base::error_node* node = new ff::dict_visitor_base::error_node();
+    node->text = str.str();
+    this->errors.push(node);
 }
 
 bool ff::dict_visitor_base::async_allowed(const ff::dict& dict)
@@ -37,11 +88,39 @@ bool ff::dict_visitor_base::async_allowed(const ff::dict& dict)
     return false;
 }
 
+std::unique_ptr<ff::dict_visitor_base::task_context> ff::dict_visitor_base::new_task_context(const ff::dict_visitor_base::task_context* parent)
+{
+    return std::make_unique<ff::dict_visitor_base::task_context>();
+}
+
+std::unique_ptr<ff::dict_visitor_base::task_context> ff::dict_visitor_base::start_task(const ff::dict_visitor_base::task_context* parent)
+{
+    std::unique_ptr<ff::dict_visitor_base::task_context> task = this->new_task_context(parent);
+    if (parent)
+    {
+        task->path = parent->path;
+    }
+
+    return task;
+}
+
+ff::dict_visitor_base::task_context* ff::dict_visitor_base::task() const
+{
+    for (ff::dict_visitor_base::task_context* task = ::current_task; task; task = task->previous)
+    {
+        if (task->owner == this)
+        {
+            return task;
+        }
+    }
+
+    return nullptr;
+}
+
 std::string ff::dict_visitor_base::path() const
 {
-    std::scoped_lock lock(this->mutex);
-    auto iter = this->thread_to_path.find(::GetCurrentThreadId());
-    if (iter == this->thread_to_path.cend())
+    const ff::dict_visitor_base::task_context* task = this->task();
+    if (!task)
     {
         return std::string();
     }
@@ -49,7 +128,7 @@ std::string ff::dict_visitor_base::path() const
     std::ostringstream str;
     bool first = true;
 
-    for (const std::string& part : iter->second)
+    for (const std::string& part : task->path)
     {
         if (!first && part.find('[') != 0)
         {
@@ -65,44 +144,28 @@ std::string ff::dict_visitor_base::path() const
 
 std::string ff::dict_visitor_base::path_root_name() const
 {
-    std::string path = this->path();
-    size_t slash_pos = path.find('/');
-    if (slash_pos != std::string::npos)
-    {
-        path = path.substr(0, slash_pos);
-    }
-
-    return path;
+    const ff::dict_visitor_base::task_context* task = this->task();
+    return (task && !task->path.empty()) ? task->path.front() : std::string();
 }
 
 size_t ff::dict_visitor_base::path_depth() const
 {
-    std::scoped_lock lock(this->mutex);
-    auto i = this->thread_to_path.find(::GetCurrentThreadId());
-    return (i != this->thread_to_path.cend()) ? i->second.size() : 0;
+    const ff::dict_visitor_base::task_context* task = this->task();
+    return task ? task->path.size() : 0;
 }
 
 void ff::dict_visitor_base::push_path(std::string_view name)
 {
-    std::scoped_lock lock(this->mutex);
-    auto iter = this->thread_to_path.try_emplace(::GetCurrentThreadId(), std::vector<std::string>()).first;
-    iter->second.emplace_back(name);
+    ff::dict_visitor_base::task_context* task = this->task();
+    assert_ret(task);
+    task->path.emplace_back(name);
 }
 
 void ff::dict_visitor_base::pop_path()
 {
-    std::scoped_lock lock(this->mutex);
-    auto iter = this->thread_to_path.find(::GetCurrentThreadId());
-    if (iter != this->thread_to_path.cend())
-    {
-        std::vector<std::string>& paths = iter->second;
-        paths.pop_back();
-
-        if (paths.empty())
-        {
-            this->thread_to_path.erase(iter);
-        }
-    }
+    ff::dict_visitor_base::task_context* task = this->task();
+    assert_ret(task && !task->path.empty());
+    task->path.pop_back();
 }
 
 bool ff::dict_visitor_base::is_root() const
@@ -115,23 +178,6 @@ ff::value_ptr ff::dict_visitor_base::transform_root_value(ff::value_ptr value)
     return this->transform_value(value);
 }
 
-void ff::dict_visitor_base::async_thread_started(DWORD main_thread_id)
-{
-    std::scoped_lock lock(this->mutex);
-    auto iter = this->thread_to_path.find(main_thread_id);
-    if (iter != this->thread_to_path.cend())
-    {
-        std::vector<std::string> paths = iter->second;
-        this->thread_to_path.emplace(::GetCurrentThreadId(), std::move(paths));
-    }
-}
-
-void ff::dict_visitor_base::async_thread_done()
-{
-    std::scoped_lock lock(this->mutex);
-    this->thread_to_path.erase(::GetCurrentThreadId());
-}
-
 ff::value_ptr ff::dict_visitor_base::transform_dict(const ff::dict& dict)
 {
     if (this->async_allowed(dict))
@@ -160,51 +206,36 @@ ff::value_ptr ff::dict_visitor_base::transform_dict(const ff::dict& dict)
 
 ff::value_ptr ff::dict_visitor_base::transform_dict_async(const ff::dict& dict)
 {
-    bool root = this->is_root();
+    const bool root = this->is_root();
+    const ff::dict_visitor_base::task_context* parent_task = this->task();
     std::vector<std::string_view> names = dict.child_names();
     std::vector<ff::value_ptr> values(names.size());
-    std::vector<ff::win_event> value_events(names.size());
-    DWORD main_thread_id = ::GetCurrentThreadId();
 
-    for (size_t i = 0; i < names.size(); i++)
-    {
-        values[i] = dict.get(names[i]);
-        value_events[i] = ff::win_event();
+    // One job adds a child job for each value, so they go onto a worker's own queue. Waiting for the
+    // parent job waits for all children, and the waiting thread runs jobs instead of blocking.
+    ff::job_handle job = ff::thread_pool::add_job([this, root, parent_task, &dict, &names, &values]()
+        {
+            const ff::job_handle parent_job = ff::job_system::current_job();
 
-        ff::thread_pool::add_task([this, root, main_thread_id, i, &names, &values, &value_events]()
+            for (size_t i = 0; i < names.size(); i++)
             {
-                this->async_thread_started(main_thread_id);
-                this->push_path(names[i]);
-
-                values[i] = root
-                    ? this->transform_root_value(values[i])
-                    : this->transform_value(values[i]);
-
-                this->pop_path();
-                this->async_thread_done();
-
-                value_events[i].set();
-            });
-    }
-
-    std::vector<HANDLE> handles(value_events.size());
-    for (size_t i = 0; i < value_events.size(); i++)
-    {
-        handles[i] = value_events[i];
-    }
-
-    while (!handles.empty())
-    {
-        size_t handle_count = std::min<size_t>(ff::thread_dispatch::maximum_wait_objects, handles.size());
-        if (ff::wait_for_all_handles(handles.data(), handle_count))
-        {
-            handles.erase(handles.cbegin(), handles.cbegin() + handle_count);
-        }
-        else
-        {
-            handles.clear();
-        }
-    }
+                ff::thread_pool::add_job([this, root, parent_task, &dict, &names, &values, i]()
+                    {
+                        std::unique_ptr<ff::dict_visitor_base::task_context> task = this->start_task(parent_task);
+                        ::task_scope scope(*task, this);
+                        this->push_path(names[i]);
+
+                        ff::value_ptr old_value = dict.get(names[i]);
+                        values[i] = root
+                            ? this->transform_root_value(old_value)
+                            : this->transform_value(old_value);
+
+                        this->pop_path();
+                    }, parent_job);
+            }
+        });
+
+    job.wait();
 
     ff::dict output_dict;
     output_dict.reserve(names.size());
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../data_value/value_ptr.h"
+#include "../thread/mpsc_queue.h"
 
 namespace ff
 {
@@ -9,6 +10,22 @@ namespace ff
     class dict_visitor_base
     {
     public:
+        /// <summary>
+        /// Visiting state that belongs to one task, async tasks start with a copy of their parent's path
+        /// </summary>
+        /// <remarks>
+        /// Each task only touches its own context, so async visiting never locks. Derived visitors can
+        /// add more state by overriding new_task_context.
+        /// </remarks>
+        struct task_context
+        {
+            virtual ~task_context() = default;
+
+            std::vector<std::string> path;
+            const ff::dict_visitor_base* owner{};
+            ff::dict_visitor_base::task_context* previous{};
+        };
+
         virtual ~dict_visitor_base();
 
         ff::value_ptr visit_dict(const ff::dict& dict, std::vector<std::string>& errors);
@@ -22,6 +39,7 @@ namespace ff
         void push_path(std::string_view name);
         void pop_path();
         bool is_root() const;
+        ff::dict_visitor_base::task_context* task() const;
 
         virtual ff::value_ptr transform_dict(const ff::dict& dict);
         virtual ff::value_ptr transform_dict_async(const ff::dict& dict);
@@ -31,12 +49,16 @@ namespace ff
         virtual void add_error(std::string_view text);
 
         virtual bool async_allowed(const ff::dict& dict);
-        virtual void async_thread_started(DWORD main_thread_id);
-        virtual void async_thread_done();
+        virtual std::unique_ptr<ff::dict_visitor_base::task_context> new_task_context(const ff::dict_visitor_base::task_context* parent);
 
     private:
-        mutable std::recursive_mutex mutex;
-        std::vector<std::string> errors;
-        std::unordered_map<DWORD, std::vector<std::string>> thread_to_path;
+        struct error_node : public ff::mpsc_node
+        {
+            std::string text;
+        };
+
+        std::unique_ptr<ff::dict_visitor_base::task_context> start_task(const ff::dict_visitor_base::task_context* parent);
+
+        ff::mpsc_queue<ff::dict_visitor_base::error_node> errors;
     };
 }
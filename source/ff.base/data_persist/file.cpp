@@ -3,6 +3,138 @@
 #include "data_persist/file.h"
 #include "data_persist/filesystem.h"
 
+// Overlapped reads take a DWORD size, so bigger reads are split up
+constexpr size_t MAX_READ_SIZE = 0x40000000;
+
+namespace
+{
+    // Shared by all pieces of one read_async call, the last piece to finish completes the task
+    struct file_read_batch
+    {
+        file_read_batch(const std::shared_ptr<ff::internal::file_async>& file, size_t piece_count)
+            : task(ff::co_task_source<size_t>::create())
+            , file(file)
+            , remaining(piece_count)
+        {}
+
+        void finish_piece(size_t bytes_read)
+        {
+            this->bytes_read.fetch_add(bytes_read, std::memory_order_relaxed);
+
+            if (this->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                // Let go of the handle before anyone sees the result, it may be the last reference
+                this->file.reset();
+                this->task.set_result(this->bytes_read.load(std::memory_order_relaxed));
+            }
+        }
+
+        ff::co_task_source<size_t> task;
+        std::shared_ptr<ff::internal::file_async> file; // keeps the handle open until every piece is done
+        std::atomic_size_t remaining;
+        std::atomic_size_t bytes_read{};
+    };
+
+    struct file_read_request
+    {
+        OVERLAPPED overlapped; // must be first, the completion callback only gets this pointer
+        std::shared_ptr<::file_read_batch> batch;
+    };
+}
+
+namespace ff::internal
+{
+    /// <summary>
+    /// Overlapped handle for a file_read, bound to the Win32 thread pool
+    /// </summary>
+    class file_async : public std::enable_shared_from_this<ff::internal::file_async>
+    {
+    public:
+        file_async(HANDLE file_handle)
+            : handle(::ReOpenFile(file_handle, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, FILE_FLAG_OVERLAPPED))
+            , io(this->handle ? ::CreateThreadpoolIo(this->handle, &file_async::io_callback, nullptr, nullptr) : nullptr)
+        {
+            assert(this->io);
+        }
+
+        ~file_async()
+        {
+            // Nothing can be in flight since each request holds a reference
+            this->handle.close();
+
+            if (this->io)
+            {
+                ::CloseThreadpoolIo(this->io);
+            }
+        }
+
+        bool valid() const
+        {
+            return this->io != nullptr;
+        }
+
+        ff::co_task<size_t> read(size_t offset, const ff::file_read_buffer* buffers, size_t buffer_count)
+        {
+            size_t piece_count = 0;
+            for (size_t i = 0; i < buffer_count; i++)
+            {
+                piece_count += (buffers[i].size + ::MAX_READ_SIZE - 1) / ::MAX_READ_SIZE;
+            }
+
+            if (!piece_count)
+            {
+                return ff::co_task_source<size_t>::from_result(0);
+            }
+
+            auto batch = std::make_shared<::file_read_batch>(this->shared_from_this(), piece_count);
+            ff::co_task<size_t> task = batch->task;
+
+            for (size_t i = 0; i < buffer_count; i++)
+            {
+                uint8_t* data = static_cast<uint8_t*>(buffers[i].data);
+
+                for (size_t size = buffers[i].size; size; )
+                {
+                    const size_t piece_size = std::min(size, ::MAX_READ_SIZE);
+                    auto request = std::make_unique<::file_read_request>();
+                    request->overlapped.Offset = static_cast<DWORD>(offset);
+                    request->overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+                    request->batch = batch;
+
+                    ::StartThreadpoolIo(this->io);
+                    if (::ReadFile(this->handle, data, static_cast<DWORD>(piece_size), nullptr, &request->overlapped) || ::GetLastError() == ERROR_IO_PENDING)
+                    {
+                        // The callback owns the request now
+                        request.release();
+                    }
+                    else
+                    {
+                        // Failed right away (like reading past the end), so there won't be a callback
+                        ::CancelThreadpoolIo(this->io);
+                        batch->finish_piece(0);
+                    }
+
+                    data += piece_size;
+                    offset += piece_size;
+                    size -= piece_size;
+                }
+            }
+
+            return task;
+        }
+
+    private:
+        static void CALLBACK io_callback(PTP_CALLBACK_INSTANCE instance, void* context, void* overlapped, ULONG result, ULONG_PTR bytes_transferred, PTP_IO io)
+        {
+            std::unique_ptr<::file_read_request> request(reinterpret_cast<::file_read_request*>(overlapped));
+            request->batch->finish_piece((result == NO_ERROR) ? static_cast<size_t>(bytes_transferred) : 0);
+        }
+
+        ff::win_handle handle;
+        PTP_IO io;
+    };
+}
+
 ff::file_base::file_base(const std::filesystem::path& path)
     : path_(path)
 {}
@@ -114,6 +246,7 @@ ff::file_read::file_read(const std::filesystem::path& path)
 
 ff::file_read::file_read(file_read&& other) noexcept
     : file_base(std::move(other))
+    , async_(std::move(other.async_))
 {}
 
 ff::file_read::file_read(const file_read& other)
@@ -124,12 +257,18 @@ ff::file_read::file_read(const file_read& other)
 ff::file_read& ff::file_read::operator=(file_read&& other) noexcept
 {
     file_base::operator=(std::move(other));
+    std::swap(this->async_, other.async_);
     return *this;
 }
 
 ff::file_read& ff::file_read::operator=(const file_read& other)
 {
-    file_base::operator=(other);
+    if (this != &other)
+    {
+        file_base::operator=(other);
+        this->async_.reset();
+    }
+
     return *this;
 }
 
@@ -146,7 +285,28 @@ size_t ff::file_read::read(void* data, size_t size)
 
 ff::co_task<size_t> ff::file_read::read_async(void* data, size_t size)
 {
-    return {};
+    assert_ret_val(*this, ff::co_task_source<size_t>::from_result(0));
+
+    const size_t offset = this->pos();
+    this->pos(std::min(offset + size, std::max(offset, this->size())));
+    return this->read_async(offset, data, size);
+}
+
+ff::co_task<size_t> ff::file_read::read_async(size_t offset, void* data, size_t size)
+{
+    const ff::file_read_buffer buffer{ data, size };
+    return this->read_async(offset, &buffer, 1);
+}
+
+ff::co_task<size_t> ff::file_read::read_async(size_t offset, const ff::file_read_buffer* buffers, size_t buffer_count)
+{
+    if (!this->async_ && *this)
+    {
+        this->async_ = std::make_shared<ff::internal::file_async>(this->handle());
+    }
+
+    assert_ret_val(this->async_ && this->async_->valid(), ff::co_task_source<size_t>::from_result(0));
+    return this->async_->read(offset, buffers, buffer_count);
 }
 
 ff::file_write::file_write(const std::filesystem::path& path, bool append)
@@ -3,8 +3,22 @@
 #include "../thread/co_task.h"
 #include "../windows/win_handle.h"
 
+namespace ff::internal
+{
+    class file_async;
+}
+
 namespace ff
 {
+    /// <summary>
+    /// One destination for a scatter read, see ff::file_read::read_async
+    /// </summary>
+    struct file_read_buffer
+    {
+        void* data;
+        size_t size;
+    };
+
     class file_base
     {
     protected:
@@ -46,7 +60,15 @@ namespace ff
         file_read& operator=(const file_read& other);
 
         size_t read(void* data, size_t size);
-        ff::co_task<size_t> read_async(void* data, size_t size);
+
+        // Overlapped reads that complete on the thread pool, any number can be in flight at once.
+        // The buffers must stay valid until the task is done, but the file_read object doesn't need to.
+        ff::co_task<size_t> read_async(void* data, size_t size); // moves pos() forward right away
+        ff::co_task<size_t> read_async(size_t offset, void* data, size_t size);
+        ff::co_task<size_t> read_async(size_t offset, const ff::file_read_buffer* buffers, size_t buffer_count);
+
+    private:
+        std::shared_ptr<ff::internal::file_async> async_;
     };
 
     class file_write : public file_base
@@ -1,4 +1,5 @@
 #include "pch.h"
+#include "base/assert.h"
 #include "data_persist/json_tokenizer.h"
 #include "data_value/bool_v.h"
 #include "data_value/double_v.h"
@@ -6,6 +7,185 @@
 #include "data_value/null_v.h"
 #include "data_value/string_v.h"
 
+namespace
+{
+    // Bit N of each mask is for byte N of a 64 byte block
+    struct json_block_masks
+    {
+        uint64_t quote;
+        uint64_t backslash;
+        uint64_t space;
+        uint64_t structural;
+        uint64_t slash;
+        uint64_t control;
+    };
+}
+
+static uint64_t to_mask(__m128i bytes, size_t chunk)
+{
+    return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(bytes))) << (chunk * 16);
+}
+
+static ::json_block_masks classify_block(const char* data)
+{
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i space_range = _mm_set1_epi8('\r' - '\t');
+    ::json_block_masks masks{};
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+
+        // Same as std::isspace: space, or '\t' through '\r'
+        const __m128i tab_offset = _mm_sub_epi8(chars, tab);
+        const __m128i space = _mm_or_si128(
+            _mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')),
+            _mm_cmpeq_epi8(_mm_min_epu8(tab_offset, space_range), tab_offset));
+
+        const __m128i structural = _mm_or_si128(
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('{')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('}'))),
+                _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('[')), _mm_cmpeq_epi8(chars, _mm_set1_epi8(']')))),
+            _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(':')), _mm_cmpeq_epi8(chars, _mm_set1_epi8(','))));
+
+        masks.quote |= ::to_mask(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\"')), i);
+        masks.backslash |= ::to_mask(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\\')), i);
+        masks.space |= ::to_mask(space, i);
+        masks.structural |= ::to_mask(structural, i);
+        masks.slash |= ::to_mask(_mm_cmpeq_epi8(chars, _mm_set1_epi8('/')), i);
+
+        // Signed compare, strings can't contain anything below a space (including chars over 0x7F)
+        masks.control |= ::to_mask(_mm_cmplt_epi8(chars, _mm_set1_epi8(' ')), i);
+    }
+
+    return masks;
+}
+
+// Returns the characters that follow an odd number of backslashes, prev_escaped carries over to the next block
+static uint64_t find_escaped(uint64_t backslash, uint64_t& prev_escaped)
+{
+    constexpr uint64_t even_bits = 0x5555555555555555;
+
+    backslash &= ~prev_escaped;
+    const uint64_t follows_escape = (backslash << 1) | prev_escaped;
+    const uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+    const uint64_t even_ends = odd_starts + backslash;
+    prev_escaped = (even_ends < odd_starts) ? 1 : 0;
+
+    return (even_bits ^ (even_ends << 1)) & follows_escape;
+}
+
+// Each bit becomes the XOR of itself and all lower bits, so bits between pairs of quotes are set
+static uint64_t prefix_xor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Returns the end of a comment that starts at pos, or pos if it isn't a comment (same as json_tokenizer::skip_spaces_and_comments)
+static size_t skip_comment(const char* data, size_t size, size_t pos)
+{
+    if (pos + 1 < size && data[pos + 1] == '/')
+    {
+        size_t end = pos + 2;
+        while (end < size && data[end] && data[end] != '\r' && data[end] != '\n')
+        {
+            end++;
+        }
+
+        return end;
+    }
+
+    if (pos + 1 < size && data[pos + 1] == '*')
+    {
+        for (size_t i = pos + 2; i < size && data[i]; i++)
+        {
+            if (data[i] == '*' && i + 1 < size && data[i + 1] == '/')
+            {
+                return i + 2;
+            }
+        }
+    }
+
+    return pos;
+}
+
+std::vector<uint32_t> ff::internal::json_structural_index(std::string_view text)
+{
+    assert_ret_val(text.size() < std::numeric_limits<uint32_t>::max(), std::vector<uint32_t>());
+
+    const char* data = text.data();
+    const size_t size = text.size();
+    std::vector<uint32_t> index;
+    size_t count = 0;
+
+    uint64_t prev_in_string = 0; // all bits set when the previous block ended in a string
+    uint64_t prev_escaped = 0;
+    uint64_t prev_separator = 1;
+
+    for (size_t block_start = 0; block_start < size; )
+    {
+        const char* block = data + block_start;
+        std::array<char, 64> padded_block;
+
+        if (size - block_start < padded_block.size())
+        {
+            padded_block.fill(' ');
+            std::memcpy(padded_block.data(), block, size - block_start);
+            block = padded_block.data();
+        }
+
+        const ::json_block_masks masks = ::classify_block(block);
+        const uint64_t quote = masks.quote & ~::find_escaped(masks.backslash, prev_escaped);
+        const uint64_t in_string = ::prefix_xor(quote) ^ prev_in_string; // includes the open quote, but not the close quote
+        const uint64_t separator = masks.space | masks.structural;
+        const uint64_t follows_separator = (separator << 1) | prev_separator;
+
+        uint64_t bits = quote |
+            ((masks.structural | masks.slash | (follows_separator & ~masks.space)) & ~in_string) |
+            ((masks.backslash | masks.control) & in_string);
+
+        size_t block_size = padded_block.size();
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+        prev_separator = separator >> 63;
+
+        if (const uint64_t slash = masks.slash & ~in_string)
+        {
+            // Comments can contain anything, so skip them and start the next block after them
+            const size_t slash_pos = static_cast<size_t>(std::countr_zero(slash));
+            const size_t comment_end = ::skip_comment(data, size, block_start + slash_pos);
+            const bool is_comment = (comment_end != block_start + slash_pos);
+
+            bits &= (uint64_t(2) << slash_pos) - 1;
+            block_size = is_comment ? comment_end - block_start : slash_pos + 1;
+            prev_in_string = 0;
+            prev_escaped = 0;
+            prev_separator = is_comment ? 1 : 0;
+        }
+
+        if (index.size() < count + 64)
+        {
+            index.resize(std::max(index.size() * 2, count + 64));
+        }
+
+        for (uint32_t* out = index.data() + count; bits; bits &= bits - 1)
+        {
+            *out++ = static_cast<uint32_t>(block_start + std::countr_zero(bits));
+            count++;
+        }
+
+        block_start += block_size;
+    }
+
+    index.resize(count);
+    return index;
+}
+
 ff::value_ptr ff::internal::json_token::get() const
 {
     switch (this->type)
@@ -140,10 +320,17 @@ size_t ff::internal::json_token::size() const
     return this->text.size();
 }
 
-ff::internal::json_tokenizer::json_tokenizer(std::string_view text)
-    : pos(text.data())
+ff::internal::json_tokenizer::json_tokenizer(std::string_view text, bool use_index)
+    : start(text.data())
+    , pos(text.data())
     , end(text.data() + text.size())
-{}
+    , use_index(use_index && text.size() < std::numeric_limits<uint32_t>::max())
+{
+    if (this->use_index)
+    {
+        this->index = ff::internal::json_structural_index(text);
+    }
+}
 
 ff::internal::json_token ff::internal::json_tokenizer::next()
 {
@@ -310,7 +497,7 @@ bool ff::internal::json_tokenizer::skip_string(char& ch)
         }
         else
         {
-            ch = this->next_char();
+            ch = this->next_indexed_char();
         }
     }
 
@@ -395,7 +582,12 @@ char ff::internal::json_tokenizer::skip_spaces_and_comments(char ch)
     {
         if (std::isspace(ch))
         {
+            // Single spaces are common, only use the index for longer runs
             ch = this->next_char();
+            if (std::isspace(ch))
+            {
+                ch = this->next_indexed_char();
+            }
         }
         else if (ch == '/')
         {
@@ -457,6 +649,24 @@ char ff::internal::json_tokenizer::next_char()
     return ++this->pos < this->end ? *this->pos : '\0';
 }
 
+// Same as next_char(), but jumps over anything that the structural index says can be skipped
+char ff::internal::json_tokenizer::next_indexed_char()
+{
+    if (!this->use_index)
+    {
+        return this->next_char();
+    }
+
+    const size_t offset = static_cast<size_t>(this->pos - this->start);
+    while (this->index_pos < this->index.size() && this->index[this->index_pos] <= offset)
+    {
+        this->index_pos++;
+    }
+
+    this->pos = (this->index_pos < this->index.size()) ? this->start + this->index[this->index_pos] : this->end;
+    return this->current_char();
+}
+
 char ff::internal::json_tokenizer::peek_next_char()
 {
     return this->pos < this->end - 1 ? this->pos[1] : '\0';
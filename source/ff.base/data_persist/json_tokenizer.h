@@ -32,10 +32,27 @@ namespace ff::internal
         std::string_view text;
     };
 
+    /// <summary>
+    /// Returns the offsets of everything in JSON text that the tokenizer can't skip over
+    /// </summary>
+    /// <remarks>
+    /// Outside of strings, that's structural characters, quotes, slashes, and the first character after whitespace.
+    /// Inside of strings, that's backslashes, control characters, and the closing quote.
+    /// The text is classified 64 bytes at a time with SSE2, only comments are scanned one character at a time.
+    /// </remarks>
+    std::vector<uint32_t> json_structural_index(std::string_view text);
+
+    /// <summary>
+    /// Splits JSON text into tokens, allowing comments
+    /// </summary>
+    /// <remarks>
+    /// With use_index, whitespace and string contents are skipped by jumping through json_structural_index,
+    /// otherwise every character is visited. The tokens are the same either way.
+    /// </remarks>
     class json_tokenizer
     {
     public:
-        json_tokenizer(std::string_view text);
+        json_tokenizer(std::string_view text, bool use_index = true);
 
         json_token next();
 
@@ -47,9 +64,14 @@ namespace ff::internal
         char skip_spaces_and_comments(char ch);
         char current_char() const;
         char next_char();
+        char next_indexed_char();
         char peek_next_char();
 
+        const char* start;
         const char* pos;
         const char* end;
+        std::vector<uint32_t> index;
+        size_t index_pos{};
+        bool use_index;
     };
 }
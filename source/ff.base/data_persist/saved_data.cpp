@@ -1,4 +1,5 @@
 #include "pch.h"
+#include "base/assert.h"
 #include "types/flags.h"
 #include "data_persist/compression.h"
 #include "data_persist/data.h"
@@ -13,15 +14,16 @@ std::shared_ptr<ff::reader_base> ff::saved_data_base::loaded_reader() const
 
 std::shared_ptr<ff::data_base> ff::saved_data_base::loaded_data() const
 {
-    if (ff::flags::has(this->type(), saved_data_type::zlib_compressed))
+    const ff::compression::codec_base* codec = ff::compression::get_codec(this->type());
+    if (codec)
     {
-        auto write_buffer = std::make_shared<std::vector<uint8_t>>();
-        write_buffer->reserve(this->loaded_size());
-        data_writer writer(write_buffer);
+        // Uncompress all at once right into the final buffer
+        std::vector<uint8_t> buffer(this->loaded_size());
+        std::shared_ptr<data_base> saved_data = this->saved_data();
 
-        if (ff::compression::uncompress(*this->saved_reader(), this->saved_size(), writer))
+        if (saved_data && codec->uncompress(*saved_data, buffer.data(), buffer.size()))
         {
-            return std::make_shared<data_vector>(write_buffer);
+            return std::make_shared<data_vector>(std::move(buffer));
         }
         else
         {
@@ -49,6 +51,12 @@ std::shared_ptr<ff::data_base> ff::saved_data_static::saved_data() const
     return this->data;
 }
 
+std::shared_ptr<ff::saved_data_base> ff::saved_data_static::subdata(size_t offset, size_t saved_size, size_t loaded_size, saved_data_type type) const
+{
+    assert_ret_val(offset <= this->data->size() && saved_size <= this->data->size() - offset, nullptr);
+    return std::make_shared<saved_data_static>(this->data->subdata(offset, saved_size), loaded_size, type);
+}
+
 size_t ff::saved_data_static::saved_size() const
 {
     return this->data->size();
@@ -80,7 +88,9 @@ std::shared_ptr<ff::reader_base> ff::saved_data_file::saved_reader() const
         size_t actual_pos = file.pos(this->data_offset);
         if (actual_pos == this->data_offset && actual_pos + this->data_saved_size <= file.size())
         {
-            return std::make_shared<file_reader>(std::move(file));
+            // Don't read ahead past the end of the saved data
+            size_t chunk_size = std::max<size_t>(std::min(ff::file_reader_async::default_chunk_size, this->data_saved_size), 1);
+            return std::make_shared<file_reader_async>(std::move(file), chunk_size);
         }
     }
 
@@ -90,11 +100,12 @@ std::shared_ptr<ff::reader_base> ff::saved_data_file::saved_reader() const
 
 std::shared_ptr<ff::data_base> ff::saved_data_file::saved_data() const
 {
+    // One read straight into the buffer, rather than going through the chunks of saved_reader()
     std::vector<uint8_t> buffer(this->data_saved_size);
-    std::shared_ptr<reader_base> reader = this->saved_reader();
-    size_t actually_read = reader->read(buffer.data(), buffer.size());
+    file_read file(this->path);
+    ff::co_task<size_t> read_task = file ? file.read_async(this->data_offset, buffer.data(), buffer.size()) : ff::co_task_source<size_t>::from_result(0);
 
-    if (actually_read == this->data_saved_size)
+    if (read_task.wait() && read_task.result() == this->data_saved_size)
     {
         return std::make_shared<data_vector>(std::move(buffer));
     }
@@ -103,6 +114,12 @@ std::shared_ptr<ff::data_base> ff::saved_data_file::saved_data() const
     return nullptr;
 }
 
+std::shared_ptr<ff::saved_data_base> ff::saved_data_file::subdata(size_t offset, size_t saved_size, size_t loaded_size, saved_data_type type) const
+{
+    assert_ret_val(offset <= this->data_saved_size && saved_size <= this->data_saved_size - offset, nullptr);
+    return std::make_shared<saved_data_file>(this->path, this->data_offset + offset, saved_size, loaded_size, type);
+}
+
 size_t ff::saved_data_file::saved_size() const
 {
     return this->data_saved_size;
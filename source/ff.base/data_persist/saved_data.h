@@ -11,9 +11,12 @@ namespace ff
 
         // type of bits
         zlib_compressed = 0x01,
+        zlib_chunked = 0x02, // see ff::compression::compress_chunked
+        lz4_compressed = 0x04, // see ff::compression::compress_lz4
 
         // type of data
         dict = 0x0100,
+        dict_indexed = 0x0200, // with dict, see ff::dict::save_indexed
     };
 
     class saved_data_base
@@ -25,6 +28,7 @@ namespace ff
         virtual std::shared_ptr<data_base> saved_data() const = 0;
         virtual std::shared_ptr<reader_base> loaded_reader() const;
         virtual std::shared_ptr<data_base> loaded_data() const;
+        virtual std::shared_ptr<saved_data_base> subdata(size_t offset, size_t saved_size, size_t loaded_size, saved_data_type type) const = 0;
 
         virtual size_t saved_size() const = 0;
         virtual size_t loaded_size() const = 0;
@@ -43,6 +47,7 @@ namespace ff
 
         virtual std::shared_ptr<reader_base> saved_reader() const override;
         virtual std::shared_ptr<data_base> saved_data() const override;
+        virtual std::shared_ptr<saved_data_base> subdata(size_t offset, size_t saved_size, size_t loaded_size, saved_data_type type) const override;
 
         virtual size_t saved_size() const  override;
         virtual size_t loaded_size() const  override;
@@ -66,6 +71,7 @@ namespace ff
 
         virtual std::shared_ptr<reader_base> saved_reader() const override;
         virtual std::shared_ptr<data_base> saved_data() const override;
+        virtual std::shared_ptr<saved_data_base> subdata(size_t offset, size_t saved_size, size_t loaded_size, saved_data_type type) const override;
 
         virtual size_t saved_size() const  override;
         virtual size_t loaded_size() const  override;
@@ -290,6 +290,170 @@ std::shared_ptr<ff::saved_data_base> ff::file_reader::saved_data(size_t offset,
     return std::make_shared<saved_data_file>(this->file.path(), offset, saved_size, loaded_size, type);
 }
 
+ff::file_reader_async::file_reader_async(file_read&& file, size_t chunk_size)
+    : file(std::move(file))
+    , file_size(this->file ? this->file.size() : 0)
+    , chunk_size(chunk_size ? chunk_size : ff::file_reader_async::default_chunk_size)
+    , read_pos(this->file ? this->file.pos() : 0)
+    , buffer_start(this->read_pos)
+{
+    this->start_read(this->read_pos);
+}
+
+ff::file_reader_async::file_reader_async(const std::filesystem::path& path, size_t chunk_size)
+    : file_reader_async(file_read(path), chunk_size)
+{}
+
+ff::file_reader_async::~file_reader_async()
+{
+    // The next buffer can't be freed while it's being read into
+    this->next_read.wait();
+}
+
+ff::file_reader_async& ff::file_reader_async::operator=(file_reader_async&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->next_read.wait();
+
+        this->file = std::move(other.file);
+        this->file_size = other.file_size;
+        this->chunk_size = other.chunk_size;
+        this->read_pos = other.read_pos;
+        this->buffer_start = other.buffer_start;
+        this->buffer_size = other.buffer_size;
+        this->next_buffer_start = other.next_buffer_start;
+        this->buffer = std::move(other.buffer);
+        this->next_buffer = std::move(other.next_buffer);
+        this->next_read = std::move(other.next_read);
+    }
+
+    return *this;
+}
+
+ff::file_reader_async::operator bool() const
+{
+    return this->file;
+}
+
+bool ff::file_reader_async::operator!() const
+{
+    return !this->file;
+}
+
+ff::co_task<size_t> ff::file_reader_async::read_async(void* data, size_t size)
+{
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    size_t total = this->copy_buffered(bytes, size);
+
+    while (size && this->next_read)
+    {
+        ff::co_task<size_t> next_read = this->next_read;
+        co_await next_read;
+
+        if (!this->use_next_buffer())
+        {
+            break;
+        }
+
+        total += this->copy_buffered(bytes, size);
+    }
+
+    co_return total;
+}
+
+size_t ff::file_reader_async::read(void* data, size_t size)
+{
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    size_t total = this->copy_buffered(bytes, size);
+
+    while (size && this->next_read.wait() && this->use_next_buffer())
+    {
+        total += this->copy_buffered(bytes, size);
+    }
+
+    return total;
+}
+
+size_t ff::file_reader_async::size() const
+{
+    return this->file_size;
+}
+
+size_t ff::file_reader_async::pos() const
+{
+    return this->read_pos;
+}
+
+size_t ff::file_reader_async::pos(size_t new_pos)
+{
+    new_pos = std::min(new_pos, this->file_size);
+
+    if (new_pos < this->buffer_start || new_pos > this->buffer_start + this->buffer_size)
+    {
+        // Outside of the current buffer, so the read ahead is useless
+        this->next_read.wait();
+        this->buffer_start = new_pos;
+        this->buffer_size = 0;
+        this->start_read(new_pos);
+    }
+
+    this->read_pos = new_pos;
+    return new_pos;
+}
+
+std::shared_ptr<ff::saved_data_base> ff::file_reader_async::saved_data(size_t offset, size_t saved_size, size_t loaded_size, saved_data_type type) const
+{
+    assert(offset + saved_size <= this->size());
+    return std::make_shared<saved_data_file>(this->file.path(), offset, saved_size, loaded_size, type);
+}
+
+size_t ff::file_reader_async::copy_buffered(uint8_t*& data, size_t& size)
+{
+    const size_t buffer_end = this->buffer_start + this->buffer_size;
+    if (this->read_pos < this->buffer_start || this->read_pos >= buffer_end)
+    {
+        return 0;
+    }
+
+    const size_t copy_size = std::min(size, buffer_end - this->read_pos);
+    std::memcpy(data, this->buffer.data() + (this->read_pos - this->buffer_start), copy_size);
+    this->read_pos += copy_size;
+    data += copy_size;
+    size -= copy_size;
+
+    return copy_size;
+}
+
+bool ff::file_reader_async::use_next_buffer()
+{
+    assert(this->next_read.done() && this->next_buffer_start == this->read_pos);
+
+    const size_t size = this->next_read.result();
+    std::swap(this->buffer, this->next_buffer);
+    this->buffer_start = this->next_buffer_start;
+    this->buffer_size = size;
+    this->start_read(this->buffer_start + size);
+
+    return size != 0;
+}
+
+void ff::file_reader_async::start_read(size_t start)
+{
+    this->next_buffer_start = start;
+
+    if (start < this->file_size)
+    {
+        const size_t size = std::min(this->chunk_size, this->file_size - start);
+        this->next_buffer.resize(size);
+        this->next_read = this->file.read_async(start, this->next_buffer.data(), size);
+    }
+    else
+    {
+        this->next_read = ff::co_task_source<size_t>::from_result(0);
+    }
+}
+
 ff::data_writer::data_writer(const std::shared_ptr<std::vector<uint8_t>>& data)
     : data_writer(data, data->size())
 {}
@@ -76,6 +76,53 @@ namespace ff
         file_read file;
     };
 
+    /// <summary>
+    /// Reads a file in chunks with overlapped I/O, the next chunk is read while the current one is used
+    /// </summary>
+    /// <remarks>
+    /// read() only blocks when the disk falls behind, and read_async() never blocks a thread.
+    /// The reader must stay alive until a read_async() task is done.
+    /// </remarks>
+    class file_reader_async : public reader_base
+    {
+    public:
+        static constexpr size_t default_chunk_size = 256 * 1024;
+
+        file_reader_async(file_read&& file, size_t chunk_size = 0);
+        file_reader_async(const std::filesystem::path& path, size_t chunk_size = 0);
+        file_reader_async(file_reader_async&& other) noexcept = default;
+        file_reader_async(const file_reader_async& other) = delete;
+        virtual ~file_reader_async() override;
+
+        file_reader_async& operator=(file_reader_async&& other) noexcept;
+        file_reader_async& operator=(const file_reader_async& other) = delete;
+        operator bool() const;
+        bool operator!() const;
+
+        ff::co_task<size_t> read_async(void* data, size_t size);
+        virtual size_t read(void* data, size_t size) override;
+        virtual size_t size() const override;
+        virtual size_t pos() const override;
+        virtual size_t pos(size_t new_pos) override;
+        virtual std::shared_ptr<saved_data_base> saved_data(size_t offset, size_t saved_size, size_t loaded_size, saved_data_type type) const override;
+
+    private:
+        size_t copy_buffered(uint8_t*& data, size_t& size);
+        bool use_next_buffer();
+        void start_read(size_t start);
+
+        file_read file;
+        size_t file_size;
+        size_t chunk_size;
+        size_t read_pos;
+        size_t buffer_start{};
+        size_t buffer_size{};
+        size_t next_buffer_start{};
+        std::vector<uint8_t> buffer;
+        std::vector<uint8_t> next_buffer;
+        ff::co_task<size_t> next_read;
+    };
+
     class data_writer : public writer_base
     {
     public:
@@ -47,22 +47,24 @@ ff::value_ptr ff::type::data_type::try_convert_to(const value* val, std::type_in
         auto& data = val->get<ff::data_base>();
         ff::saved_data_type saved_data_type = static_cast<const data_v*>(val)->saved_data_type();
 
-        if (data && data->size() && ff::flags::has(saved_data_type, ff::saved_data_type::zlib_compressed))
+        const ff::compression::codec_base* codec = (data && data->size()) ? ff::compression::get_codec(saved_data_type) : nullptr;
+        saved_data_type = ff::flags::clear(saved_data_type, ff::compression::codec_types());
+
+        if (codec)
         {
             auto buffer_compressed = std::make_shared<std::vector<uint8_t>>();
             buffer_compressed->reserve(data->size());
 
-            ff::data_reader reader(data);
             ff::data_writer writer(buffer_compressed);
-            if (ff::compression::compress(reader, data->size(), writer))
+            if (codec->compress(*data, writer))
             {
-                auto saved_data = std::make_shared<ff::saved_data_static>(std::make_shared<ff::data_vector>(buffer_compressed), data->size(), saved_data_type);
+                auto saved_data = std::make_shared<ff::saved_data_static>(std::make_shared<ff::data_vector>(buffer_compressed), data->size(), ff::flags::combine(saved_data_type, codec->type()));
                 return ff::value::create<ff::saved_data_base>(saved_data);
             }
         }
         else
         {
-            auto saved_data = data ? std::make_shared<ff::saved_data_static>(data, data->size(), ff::flags::clear(saved_data_type, ff::saved_data_type::zlib_compressed)) : nullptr;
+            auto saved_data = data ? std::make_shared<ff::saved_data_static>(data, data->size(), saved_data_type) : nullptr;
             return ff::value::create<ff::saved_data_base>(saved_data);
         }
     }
@@ -76,7 +78,9 @@ ff::value_ptr ff::type::data_type::try_convert_to(const value* val, std::type_in
         {
             ff::dict dict;
             ff::data_reader reader(data);
-            if (ff::dict::load(reader, dict))
+            if (ff::flags::has(saved_data_type, ff::saved_data_type::dict_indexed)
+                ? ff::dict::load_indexed(data, dict)
+                : ff::dict::load(reader, dict))
             {
                 return ff::value::create<ff::dict>(std::move(dict));
             }
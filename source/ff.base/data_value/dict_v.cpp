@@ -35,10 +35,10 @@ ff::value_ptr ff::type::dict_type::try_convert_to(const value* val, std::type_in
         auto buffer = std::make_shared<std::vector<uint8_t>>();
 
         ff::data_writer writer(buffer);
-        if (dict.save(writer))
+        if (dict.save_indexed(writer))
         {
             auto data = std::make_shared<ff::data_vector>(buffer);
-            return ff::value::create<ff::data_base>(data, ff::saved_data_type::dict);
+            return ff::value::create<ff::data_base>(data, ff::flags::combine(ff::saved_data_type::dict, ff::saved_data_type::dict_indexed));
         }
     }
     else if (type == typeid(ff::type::saved_data_v))
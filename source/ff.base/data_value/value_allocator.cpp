@@ -1,108 +1,107 @@
 #include "pch.h"
-#include "types/pool_allocator.h"
+#include "base/log.h"
 #include "data_value/value_allocator.h"
+#include "types/pool_allocator.h"
 
-template<size_t SizeCount>
-static ff::byte_pool_allocator<std::array<size_t, SizeCount>>& get_byte_pool()
-{
-    static ff::byte_pool_allocator<std::array<size_t, SizeCount>> pool;
-    return pool;
-}
-
-constexpr size_t get_pool_size_count(size_t byte_size)
-{
-    return (byte_size + sizeof(size_t) - 1) / sizeof(size_t);
-}
+constexpr size_t SIZE_STEP = 16;
+constexpr size_t MAX_CLASS_SIZE = 4096;
 
-void* ff::internal::value_allocator::new_bytes(size_t size)
+constexpr std::array<size_t, 28> class_sizes
 {
-    size_t count = ::get_pool_size_count(size);
-
-    switch (count)
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256,
+    320, 384, 448, 512,
+    640, 768, 896, 1024,
+    1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096,
+};
+
+static_assert(class_sizes.back() == MAX_CLASS_SIZE);
+
+// Maps (size + SIZE_STEP - 1) / SIZE_STEP to an index in class_sizes
+constexpr std::array<uint8_t, MAX_CLASS_SIZE / SIZE_STEP + 1> class_indexes = []()
     {
-        case 1:
-            return ::get_byte_pool<1>().new_bytes();
-
-        case 2:
-            return ::get_byte_pool<2>().new_bytes();
+        std::array<uint8_t, MAX_CLASS_SIZE / SIZE_STEP + 1> indexes{};
 
-        case 3:
-            return ::get_byte_pool<3>().new_bytes();
+        for (size_t i = 0, class_index = 0; i < indexes.size(); i++)
+        {
+            while (::class_sizes[class_index] < i * SIZE_STEP)
+            {
+                class_index++;
+            }
 
-        case 4:
-            return ::get_byte_pool<4>().new_bytes();
+            indexes[i] = static_cast<uint8_t>(class_index);
+        }
 
-        case 5:
-            return ::get_byte_pool<5>().new_bytes();
+        return indexes;
+    }();
 
-        case 6:
-            return ::get_byte_pool<6>().new_bytes();
-
-        case 7:
-            return ::get_byte_pool<7>().new_bytes();
+static std::array<std::shared_ptr<ff::internal::pool_depot>, ::class_sizes.size()>& get_pools()
+{
+    static std::array<std::shared_ptr<ff::internal::pool_depot>, ::class_sizes.size()> pools = []()
+        {
+            std::array<std::shared_ptr<ff::internal::pool_depot>, ::class_sizes.size()> pools;
 
-        case 8:
-            return ::get_byte_pool<8>().new_bytes();
+            for (size_t i = 0; i < pools.size(); i++)
+            {
+                pools[i] = std::make_shared<ff::internal::pool_depot>(::class_sizes[i], alignof(std::max_align_t));
+            }
 
-        case 9:
-            return ::get_byte_pool<9>().new_bytes();
+            return pools;
+        }();
 
-        case 10:
-            return ::get_byte_pool<10>().new_bytes();
+    return pools;
+}
 
-        default:
-            return std::malloc(size);
+void* ff::internal::value_allocator::new_bytes(size_t size)
+{
+    if (size > ::MAX_CLASS_SIZE)
+    {
+        return std::malloc(size);
     }
+
+    return ::get_pools()[::class_indexes[(size + ::SIZE_STEP - 1) / ::SIZE_STEP]]->new_bytes();
 }
 
 void ff::internal::value_allocator::delete_bytes(void* value, size_t size)
 {
-    size_t count = ::get_pool_size_count(size);
-
-    switch (count)
+    if (size > ::MAX_CLASS_SIZE)
     {
-        case 1:
-            ::get_byte_pool<1>().delete_bytes(value);
-            break;
-
-        case 2:
-            ::get_byte_pool<2>().delete_bytes(value);
-            break;
-
-        case 3:
-            ::get_byte_pool<3>().delete_bytes(value);
-            break;
-
-        case 4:
-            ::get_byte_pool<4>().delete_bytes(value);
-            break;
-
-        case 5:
-            ::get_byte_pool<5>().delete_bytes(value);
-            break;
-
-        case 6:
-            ::get_byte_pool<6>().delete_bytes(value);
-            break;
-
-        case 7:
-            ::get_byte_pool<7>().delete_bytes(value);
-            break;
+        std::free(value);
+    }
+    else if (value)
+    {
+        ::get_pools()[::class_indexes[(size + ::SIZE_STEP - 1) / ::SIZE_STEP]]->delete_bytes(value);
+    }
+}
 
-        case 8:
-            ::get_byte_pool<8>().delete_bytes(value);
-            break;
+void ff::internal::value_allocator::log_stats()
+{
+    std::ostringstream str;
+    size_t total_live = 0;
+    size_t total_reserved = 0;
 
-        case 9:
-            ::get_byte_pool<9>().delete_bytes(value);
-            break;
+    for (size_t i = 0; i < ::class_sizes.size(); i++)
+    {
+        size_t live, allocated;
+        ::get_pools()[i]->get_stats(&live, &allocated);
+
+        if (allocated)
+        {
+            const size_t live_bytes = live * ::class_sizes[i];
+            const size_t reserved_bytes = allocated * ::class_sizes[i];
+            total_live += live_bytes;
+            total_reserved += reserved_bytes;
+
+            str << "\r\n  " << ::class_sizes[i] << " bytes: "
+                << live << "/" << allocated << " used, "
+                << live_bytes << "/" << reserved_bytes << " bytes";
+        }
+    }
 
-        case 10:
-            ::get_byte_pool<10>().delete_bytes(value);
-            break;
+    const size_t unused_percent = total_reserved ? (total_reserved - total_live) * 100 / total_reserved : 0;
 
-        default:
-            std::free(value);
-            break;
-    }
+    ff::log::write(ff::log::type::base_memory,
+        "Value allocator: ", total_live, "/", total_reserved, " bytes used, ", unused_percent, "% unused",
+        str.str());
 }
@@ -2,10 +2,18 @@
 
 namespace ff::internal
 {
+    /// <summary>
+    /// Allocates memory for ff::value objects from size class pools
+    /// </summary>
+    /// <remarks>
+    /// Sizes up to 128 bytes use 16 byte steps, then there are four geometric classes per doubling up to 4KB.
+    /// Anything bigger comes from the heap.
+    /// </remarks>
     class value_allocator
     {
     public:
         static void* new_bytes(size_t size);
         static void delete_bytes(void* value, size_t size);
+        static void log_stats();
     };
 }
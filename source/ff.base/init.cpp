@@ -17,6 +17,7 @@
 #include "data_value/size_v.h"
 #include "data_value/string_v.h"
 #include "data_value/uuid_v.h"
+#include "data_value/value_allocator.h"
 #include "data_value/value_vector_v.h"
 #include "init.h"
 #include "resource/resource_file.h"
@@ -34,6 +35,7 @@ namespace
         one_time_init_base()
             : thread_dispatch(ff::thread_dispatch_type::main)
         {
+            ff::internal::log::init();
             ::EnableMouseInPointer(TRUE);
 
             if constexpr (ff::constants::track_memory)
@@ -57,8 +59,11 @@ namespace
 
             if constexpr (ff::constants::track_memory)
             {
+                ff::internal::value_allocator::log_stats();
                 ff::memory::stop_tracking_allocations();
             }
+
+            ff::internal::log::destroy();
         }
 
         bool valid() const
@@ -4,12 +4,14 @@
 // C++
 #include <array>
 #include <atomic>
+#include <bit>
 #include <charconv>
 #include <coroutine>
 #include <cmath>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
+#include <deque>
 #include <exception>
 #include <filesystem>
 #include <forward_list>
@@ -33,6 +35,9 @@
 #include <unordered_set>
 #include <vector>
 
+// Intrinsics
+#include <emmintrin.h>
+
 // Windows
 #include <Windows.h>
 #include <ShellScalingApi.h>
@@ -0,0 +1,88 @@
+#include "pch.h"
+#include "data_persist/data.h"
+#include "data_persist/filesystem.h"
+#include "resource/resource_build_cache.h"
+
+ff::resource_build_cache::resource_build_cache(const std::filesystem::path& path)
+    : path(path)
+    , hits(0)
+    , misses(0)
+{
+    ff::filesystem::create_directories(this->path);
+}
+
+std::shared_ptr<ff::data_base> ff::resource_build_cache::load(size_t key)
+{
+    // Not mem-mapped, so that the entry can be replaced by another build
+    std::filesystem::path path = this->entry_path(key);
+    std::shared_ptr<ff::data_base> data = ff::filesystem::exists(path) ? ff::filesystem::read_binary_file(path) : nullptr;
+
+    if (data)
+    {
+        this->hits.fetch_add(1);
+    }
+    else
+    {
+        this->misses.fetch_add(1);
+    }
+
+    return data;
+}
+
+bool ff::resource_build_cache::save(size_t key, const ff::data_base& data)
+{
+    // Readers must never see a partly written entry
+    std::filesystem::path path = this->entry_path(key);
+    std::filesystem::path temp_path = path;
+    temp_path += "." + std::to_string(::GetCurrentProcessId()) + "." + std::to_string(::GetCurrentThreadId()) + ".tmp";
+
+    if (ff::filesystem::write_binary_file(temp_path, data.data(), data.size()))
+    {
+        std::error_code ec{};
+        std::filesystem::rename(temp_path, path, ec);
+
+        if (!ec)
+        {
+            return true;
+        }
+
+        ff::filesystem::remove(temp_path);
+    }
+
+    return false;
+}
+
+size_t ff::resource_build_cache::file_hash(const std::filesystem::path& path)
+{
+    {
+        std::scoped_lock lock(this->mutex);
+        auto i = this->file_hashes.find(path);
+        if (i != this->file_hashes.cend())
+        {
+            return i->second;
+        }
+    }
+
+    std::shared_ptr<ff::data_base> data = ff::filesystem::map_binary_file(path);
+    const size_t hash = data ? ff::stable_hash_bytes(data->data(), data->size()) : 0;
+
+    std::scoped_lock lock(this->mutex);
+    return this->file_hashes.try_emplace(path, hash).first->second;
+}
+
+size_t ff::resource_build_cache::hit_count() const
+{
+    return this->hits.load();
+}
+
+size_t ff::resource_build_cache::miss_count() const
+{
+    return this->misses.load();
+}
+
+std::filesystem::path ff::resource_build_cache::entry_path(size_t key) const
+{
+    std::ostringstream str;
+    str << std::hex << std::setw(16) << std::setfill('0') << key << ".res";
+    return this->path / str.str();
+}
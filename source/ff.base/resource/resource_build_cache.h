@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../base/stable_hash.h"
+
+namespace ff
+{
+    class data_base;
+
+    /// <summary>
+    /// Content addressed cache of resource objects created by ff::load_resources_from_json
+    /// </summary>
+    /// <remarks>
+    /// Keys are hashes of a resource's source values, the bytes of its input files and their paths relative to the input root,
+    /// and its factory version, so an entry never needs to be invalidated. Each entry is its own file, so builds running at the same time can share the cache.
+    /// </remarks>
+    class resource_build_cache
+    {
+    public:
+        resource_build_cache(const std::filesystem::path& path);
+        resource_build_cache(resource_build_cache&& other) noexcept = delete;
+        resource_build_cache(const resource_build_cache& other) = delete;
+
+        resource_build_cache& operator=(resource_build_cache&& other) noexcept = delete;
+        resource_build_cache& operator=(const resource_build_cache& other) = delete;
+
+        std::shared_ptr<ff::data_base> load(size_t key);
+        bool save(size_t key, const ff::data_base& data);
+        size_t file_hash(const std::filesystem::path& path);
+
+        size_t hit_count() const;
+        size_t miss_count() const;
+
+    private:
+        std::filesystem::path entry_path(size_t key) const;
+
+        std::filesystem::path path;
+        std::mutex mutex;
+        std::unordered_map<std::filesystem::path, size_t, ff::stable_hash<std::filesystem::path>> file_hashes;
+        std::atomic_size_t hits;
+        std::atomic_size_t misses;
+    };
+}
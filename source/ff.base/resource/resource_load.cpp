@@ -53,7 +53,7 @@ static std::shared_ptr<ff::resource_objects> load_cached_resources(const std::fi
     return resource_objects;
 }
 
-ff::load_resources_result ff::load_resources_from_file(const std::filesystem::path& path, ff::resource_cache_t cache_type, bool debug)
+ff::load_resources_result ff::load_resources_from_file(const std::filesystem::path& path, ff::resource_cache_t cache_type, bool debug, ff::resource_build_cache* build_cache)
 {
     ff::load_resources_result result{};
 
@@ -72,7 +72,7 @@ ff::load_resources_result ff::load_resources_from_file(const std::filesystem::pa
     if (ff::filesystem::read_text_file(path, text))
     {
         std::filesystem::path base_path = path.parent_path();
-        result = ff::load_resources_from_json(text, base_path, debug);
+        result = ff::load_resources_from_json(text, base_path, debug, build_cache);
         if (result.resources)
         {
             if (debug)
@@ -105,7 +105,7 @@ ff::load_resources_result ff::load_resources_from_file(const std::filesystem::pa
     return result;
 }
 
-ff::load_resources_result ff::load_resources_from_json(std::string_view json_text, const std::filesystem::path& base_path, bool debug)
+ff::load_resources_result ff::load_resources_from_json(std::string_view json_text, const std::filesystem::path& base_path, bool debug, ff::resource_build_cache* build_cache)
 {
     const char* error_pos;
     ff::dict dict;
@@ -120,7 +120,7 @@ ff::load_resources_result ff::load_resources_from_json(std::string_view json_tex
         return result;
     }
 
-    return ff::load_resources_from_json(dict, base_path, debug);
+    return ff::load_resources_from_json(dict, base_path, debug, build_cache);
 }
 
 bool ff::is_resource_cache_updated(const std::vector<std::filesystem::path>& source_files, const std::filesystem::path& cache_path)
@@ -2,7 +2,10 @@
 
 namespace ff::internal
 {
+    inline constexpr std::string_view RES_DEPENDENCIES = "res:dependencies";
     inline constexpr std::string_view RES_FILES = "res:files";
+    inline constexpr std::string_view RES_GROUP = "res:group";
+    inline constexpr std::string_view RES_GROUPS = "res:groups";
     inline constexpr std::string_view RES_ID_SYMBOLS = "res:id_symbols";
     inline constexpr std::string_view RES_IMPORT = "res:import";
     inline constexpr std::string_view RES_OUTPUT_FILES = "res:output_files";
@@ -25,6 +28,7 @@ namespace ff::internal
 namespace ff
 {
     class dict;
+    class resource_build_cache;
     class resource_objects;
 
     struct load_resources_result
@@ -43,8 +47,8 @@ namespace ff
         rebuild_cache,
     };
 
-    ff::load_resources_result load_resources_from_file(const std::filesystem::path& path, ff::resource_cache_t cache_type, bool debug);
-    ff::load_resources_result load_resources_from_json(std::string_view json_text, const std::filesystem::path& base_path, bool debug);
-    ff::load_resources_result load_resources_from_json(const ff::dict& json_dict, const std::filesystem::path& base_path, bool debug);
+    ff::load_resources_result load_resources_from_file(const std::filesystem::path& path, ff::resource_cache_t cache_type, bool debug, ff::resource_build_cache* build_cache = nullptr);
+    ff::load_resources_result load_resources_from_json(std::string_view json_text, const std::filesystem::path& base_path, bool debug, ff::resource_build_cache* build_cache = nullptr);
+    ff::load_resources_result load_resources_from_json(const ff::dict& json_dict, const std::filesystem::path& base_path, bool debug, ff::resource_build_cache* build_cache = nullptr);
     bool is_resource_cache_updated(const std::vector<std::filesystem::path>& source_files, const std::filesystem::path& cache_path);
 }
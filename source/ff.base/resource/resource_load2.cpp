@@ -1,16 +1,19 @@
 #include "pch.h"
 #include "base/log.h"
 #include "base/stable_hash.h"
+#include "data_persist/data.h"
 #include "data_persist/dict.h"
 #include "data_persist/dict_visitor.h"
 #include "data_persist/filesystem.h"
 #include "data_persist/json_persist.h"
+#include "data_persist/stream.h"
 #include "data_value/data_v.h"
 #include "data_value/dict_v.h"
 #include "data_value/resource_v.h"
 #include "data_value/resource_object_v.h"
 #include "data_value/string_v.h"
 #include "resource/resource.h"
+#include "resource/resource_build_cache.h"
 #include "resource/resource_load.h"
 #include "resource/resource_load_context.h"
 #include "resource/resource_object_base.h"
@@ -49,103 +52,237 @@ static std::string make_symbol_from_name(std::string_view name)
     return id.str();
 }
 
-class transformer_context : public ff::resource_load_context
+using namespace std::string_view_literals;
+
+static const size_t BUILD_CACHE_COOKIE = ff::stable_hash_func("ff::resource_build_cache@0"sv);
+
+static bool hash_source_value(const ff::value* value, ff::stable_hash_data_t& hash);
+
+// Hashes a source dict in a stable order, fails for values that can't be hashed (like objects that were already created)
+static bool hash_source_dict(const ff::dict& dict, ff::stable_hash_data_t& hash)
+{
+    for (std::string_view name : dict.child_names(true))
+    {
+        hash.hash(name.data(), name.size());
+
+        if (!::hash_source_value(dict.get(name), hash))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool hash_source_value(const ff::value* value, ff::stable_hash_data_t& hash)
+{
+    if (value->is_type<ff::dict>())
+    {
+        return ::hash_source_dict(value->get<ff::dict>(), hash);
+    }
+
+    if (value->is_type<std::vector<ff::value_ptr>>())
+    {
+        for (const ff::value_ptr& child_value : value->get<std::vector<ff::value_ptr>>())
+        {
+            if (!::hash_source_value(child_value, hash))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    if (value->is_type<ff::resource_object_base>())
+    {
+        return false;
+    }
+
+    auto data_vector = std::make_shared<std::vector<uint8_t>>();
+    ff::data_writer writer(data_vector);
+
+    if (!value->save_typed(writer))
+    {
+        return false;
+    }
+
+    hash.hash(data_vector->data(), data_vector->size());
+    return true;
+}
+
+// Passes everything to the real context, but remembers output files and errors for the build cache
+class build_cache_context : public ff::resource_load_context
 {
 public:
-    transformer_context(const std::filesystem::path& base_path, bool debug)
-        : base_path_(base_path)
-        , debug_(debug)
+    build_cache_context(ff::resource_load_context& context)
+        : context(context)
     {}
 
     virtual const std::filesystem::path& base_path() const override
     {
-        return this->base_path_;
+        return this->context.base_path();
     }
 
     virtual const std::vector<std::string>& errors() const override
     {
-        return this->errors_;
+        return this->context.errors();
     }
 
     virtual void add_error(std::string_view text) override
     {
-        if (!text.empty())
-        {
-            std::scoped_lock lock(this->mutex);
-            this->errors_.emplace_back(text);
-        }
+        this->has_errors = true;
+        this->context.add_error(text);
     }
 
     virtual void add_output_file(std::string_view name, const std::shared_ptr<ff::data_base>& data) override
     {
         if (name.size() && data && data->size())
         {
-            std::scoped_lock lock(this->mutex);
-            this->output_files_.push_back(std::make_pair(std::string(name), data));
+            this->output_files.set<ff::data_base>(name, data, ff::saved_data_type::none);
         }
+
+        this->context.add_output_file(name, data);
     }
 
     virtual bool debug() const override
     {
-        return this->debug_;
+        return this->context.debug();
     }
 
-    const ff::dict& values() const
-    {
-        static ff::dict empty_dict;
-        std::scoped_lock lock(this->mutex);
-        auto iter = this->thread_to_values.find(::GetCurrentThreadId());
-        return iter != this->thread_to_values.cend() ? iter->second.back() : empty_dict;
-    }
+    ff::dict output_files;
+    bool has_errors{};
 
-    ff::dict& push_values()
+private:
+    ff::resource_load_context& context;
+};
+
+class transformer_context : public ff::resource_load_context
+{
+public:
+    transformer_context(const std::filesystem::path& base_path, bool debug, ff::resource_build_cache* build_cache)
+        : base_path_(base_path)
+        , build_cache(build_cache)
+        , debug_(debug)
+    {}
+
+    // Reuses the object from the build cache when the resource's source values, input files, and factory are all the same
+    std::shared_ptr<ff::resource_object_base> load_from_source(const ff::resource_object_factory_base& factory, const ff::dict& dict, std::string_view root_name)
     {
-        std::scoped_lock lock(this->mutex);
+        ff::stable_hash_data_t hash;
+        const uint32_t version = factory.version();
+        hash.hash(&::BUILD_CACHE_COOKIE, sizeof(::BUILD_CACHE_COOKIE));
+        hash.hash(factory.name().data(), factory.name().size());
+        hash.hash(&version, sizeof(version));
+        hash.hash(&this->debug_, sizeof(this->debug_));
+
+        if (!this->build_cache || !::hash_source_dict(dict, hash))
+        {
+            return factory.load_from_source(dict, *this);
+        }
 
-        std::vector<ff::dict>& values = this->thread_to_values.try_emplace(::GetCurrentThreadId(), std::vector<ff::dict>()).first->second;
+        std::vector<std::filesystem::path> paths = this->paths(root_name);
+        std::sort(paths.begin(), paths.end());
 
-        ff::dict dict;
-        if (!values.empty())
+        // Paths are relative to the input root so that the same sources get the same key on any machine or checkout
+        const std::filesystem::path base_path = this->base_path_.lexically_normal();
+
+        for (const std::filesystem::path& path : paths)
         {
-            dict = values.back();
+            std::filesystem::path relative_path = path.lexically_normal().lexically_relative(base_path);
+            if (relative_path.empty())
+            {
+                relative_path = path.filename();
+            }
+
+            const std::wstring relative_string = relative_path.generic_wstring();
+            const size_t file_hash = this->build_cache->file_hash(path);
+            hash.hash(relative_string.data(), relative_string.size() * sizeof(wchar_t));
+            hash.hash(&file_hash, sizeof(file_hash));
         }
 
-        values.push_back(std::move(dict));
-        return values.back();
-    }
+        const size_t key = hash.hash();
+        std::shared_ptr<ff::data_base> cached_data = this->build_cache->load(key);
+        if (cached_data)
+        {
+            ff::data_reader reader(cached_data);
+            ff::value_ptr cached_value = ff::value::load_typed(reader);
+            ff::value_ptr cached_dict_value = cached_value ? cached_value->try_convert<ff::dict>() : nullptr;
 
-    ff::dict& push_values_from_owner_thread(DWORD owner_thread_id)
-    {
-        std::scoped_lock lock(this->mutex);
+            if (cached_dict_value)
+            {
+                ff::dict cached_dict = cached_dict_value->get<ff::dict>();
+                cached_dict.load_child_dicts();
 
-        ff::dict& dict = this->push_values();
-        auto iter = this->thread_to_values.find(owner_thread_id);
-        if (iter != this->thread_to_values.cend())
+                std::shared_ptr<ff::resource_object_base> obj = factory.load_from_cache(cached_dict.get<ff::dict>("object"));
+                if (obj)
+                {
+                    const ff::dict cached_output_files = cached_dict.get<ff::dict>("output_files");
+                    for (auto& [name, data] : cached_output_files)
+                    {
+                        this->add_output_file(name, data->get<ff::data_base>());
+                    }
+
+                    return obj;
+                }
+            }
+        }
+
+        ::build_cache_context build_context(*this);
+        std::shared_ptr<ff::resource_object_base> obj = factory.load_from_source(dict, build_context);
+        ff::dict object_dict;
+
+        if (obj && !build_context.has_errors && ff::resource_object_base::save_to_cache_typed(*obj, object_dict))
         {
-            const std::vector<ff::dict>& owner_values = iter->second;
-            dict.set(owner_values.back(), false);
+            ff::dict cached_dict;
+            cached_dict.set<ff::dict>("object", std::move(object_dict));
+            cached_dict.set<ff::dict>("output_files", std::move(build_context.output_files));
+
+            auto data_vector = std::make_shared<std::vector<uint8_t>>();
+            ff::data_writer writer(data_vector);
+
+            if (ff::value::create<ff::dict>(std::move(cached_dict))->save_typed(writer))
+            {
+                this->build_cache->save(key, ff::data_vector(data_vector));
+            }
         }
 
-        return dict;
+        return obj;
     }
 
-    void pop_values()
+    virtual const std::filesystem::path& base_path() const override
     {
-        std::scoped_lock lock(this->mutex);
+        return this->base_path_;
+    }
+
+    virtual const std::vector<std::string>& errors() const override
+    {
+        return this->errors_;
+    }
 
-        auto iter = this->thread_to_values.find(::GetCurrentThreadId());
-        if (iter != this->thread_to_values.cend())
+    virtual void add_error(std::string_view text) override
+    {
+        if (!text.empty())
         {
-            std::vector<ff::dict>& values = iter->second;
-            values.pop_back();
+            std::scoped_lock lock(this->mutex);
+            this->errors_.emplace_back(text);
+        }
+    }
 
-            if (values.empty())
-            {
-                this->thread_to_values.erase(iter);
-            }
+    virtual void add_output_file(std::string_view name, const std::shared_ptr<ff::data_base>& data) override
+    {
+        if (name.size() && data && data->size())
+        {
+            std::scoped_lock lock(this->mutex);
+            this->output_files_.push_back(std::make_pair(std::string(name), data));
         }
     }
 
+    virtual bool debug() const override
+    {
+        return this->debug_;
+    }
+
     std::shared_ptr<ff::resource> set_reference(std::string_view name_view, ff::value_ptr value = nullptr)
     {
         std::string name(name_view);
@@ -270,11 +407,11 @@ private:
     std::filesystem::path base_path_;
     std::vector<std::string> errors_;
     output_files_t output_files_;
-    std::unordered_map<DWORD, std::vector<ff::dict>> thread_to_values;
     std::unordered_map<std::string, std::shared_ptr<ff::resource>> name_to_resource;
     std::unordered_map<std::string, std::unordered_set<std::filesystem::path>> name_to_paths;
     std::unordered_set<std::filesystem::path, ff::stable_hash<std::filesystem::path>> paths_;
     std::unordered_map<std::string, std::string> id_to_name_;
+    ff::resource_build_cache* build_cache;
     bool debug_;
 };
 
@@ -345,6 +482,12 @@ public:
     using transformer_base::transformer_base;
 
 protected:
+    // Each task has its own stack of values, since values only apply to the dict that sets them and its children
+    struct values_task_context : public ff::dict_visitor_base::task_context
+    {
+        std::vector<ff::dict> values;
+    };
+
     virtual ff::value_ptr transform_dict(const ff::dict& dict) override
     {
         ff::dict input_dict = dict;
@@ -357,7 +500,7 @@ protected:
             input_dict.set(ff::internal::RES_VALUES, nullptr);
 
             ff::value_ptr values_dict = values_value->convert_or_default<ff::dict>();
-            this->context().push_values().set(values_dict->get<ff::dict>(), false);
+            this->push_values().set(values_dict->get<ff::dict>(), false);
             values_pushed = true;
         }
 
@@ -365,7 +508,7 @@ protected:
             {
                 if (values_pushed)
                 {
-                    this->context().pop_values();
+                    this->pop_values();
                 }
             });
 
@@ -400,7 +543,7 @@ protected:
 
         if (!template_name.empty())
         {
-            ff::value_ptr template_value = this->context().values().get(template_name);
+            ff::value_ptr template_value = this->values().get(template_name);
             if (!template_value)
             {
                 std::ostringstream str;
@@ -441,7 +584,7 @@ protected:
 
             if (string_value.starts_with(ff::internal::RES_PREFIX))
             {
-                value = this->context().values().get(string_value.substr(ff::internal::RES_PREFIX.size()));
+                value = this->values().get(string_value.substr(ff::internal::RES_PREFIX.size()));
                 value = this->transform_value(value);
 
                 if (!value)
@@ -462,19 +605,48 @@ protected:
         return value;
     }
 
-    virtual void async_thread_started(DWORD main_thread_id) override
+    virtual std::unique_ptr<ff::dict_visitor_base::task_context> new_task_context(const ff::dict_visitor_base::task_context* parent) override
     {
-        transformer_base::async_thread_started(main_thread_id);
-        this->context().push_values_from_owner_thread(main_thread_id);
+        auto task = std::make_unique<values_task_context>();
+        if (parent)
+        {
+            const std::vector<ff::dict>& parent_values = static_cast<const values_task_context*>(parent)->values;
+            if (!parent_values.empty())
+            {
+                task->values.push_back(parent_values.back());
+            }
+        }
+
+        return task;
     }
 
-    virtual void async_thread_done() override
+private:
+    std::vector<ff::dict>& task_values() const
     {
-        this->context().pop_values();
-        transformer_base::async_thread_done();
+        return static_cast<values_task_context*>(this->task())->values;
+    }
+
+    const ff::dict& values() const
+    {
+        static const ff::dict empty_dict;
+        const std::vector<ff::dict>& values = this->task_values();
+        return !values.empty() ? values.back() : empty_dict;
+    }
+
+    ff::dict& push_values()
+    {
+        std::vector<ff::dict>& values = this->task_values();
+        values.push_back(!values.empty() ? values.back() : ff::dict());
+        return values.back();
+    }
+
+    void pop_values()
+    {
+        std::vector<ff::dict>& values = this->task_values();
+        assert_ret(!values.empty());
+        values.pop_back();
     }
 
-private:
     bool import_file(const std::filesystem::path& path, ff::dict& json)
     {
         json.clear();
@@ -574,7 +746,7 @@ protected:
                 {
                     const std::string& type_name = type_value->get<std::string>();
                     const ff::resource_object_factory_base* factory = ff::resource_object_base::get_factory(type_name);
-                    std::shared_ptr<ff::resource_object_base> obj = factory ? factory->load_from_source(output_dict, this->context()) : nullptr;
+                    std::shared_ptr<ff::resource_object_base> obj = factory ? this->context().load_from_source(*factory, output_dict, this->path_root_name()) : nullptr;
 
                     if (obj)
                     {
@@ -616,84 +788,119 @@ protected:
     }
 
 private:
+    // Never blocks, a job thread could be waiting for jobs that include the task that's finishing obj.
+    // When obj is already being finished by another task, that task also finishes anything that depends on it.
     bool finish_loading_object(ff::resource_object_base* obj)
     {
-        // See if it's already loading
         {
-            std::unique_lock lock(this->mutex);
-            if (this->obj_to_finished.find(obj) != this->obj_to_finished.cend())
+            std::scoped_lock lock(this->mutex);
+            if (this->obj_to_finished.contains(obj))
             {
                 return true;
             }
 
-            auto iter = this->obj_to_currently_finishing.find(obj);
-            if (iter != this->obj_to_currently_finishing.cend())
+            if (this->obj_to_currently_finishing.contains(obj))
             {
-                const finishing_info& info = iter->second;
-                if (info.thread_id == ::GetCurrentThreadId())
+                if (this->waits_for_itself(obj))
                 {
                     this->add_error("Can't finish loading a resource that depends on itself");
+                    return false;
                 }
 
-                ff::win_event wait_handle = info.event_handle;
-                lock.unlock();
-
-                wait_handle.wait();
                 return true;
             }
-            else
-            {
-                finishing_info info;
-                this->obj_to_currently_finishing.try_emplace(obj, std::move(info));
-            }
+
+            this->obj_to_currently_finishing.try_emplace(obj);
         }
 
+        return this->continue_loading_object(obj);
+    }
+
+    // Returns true without finishing obj when a dependency is being finished by another task, obj is left for that task
+    bool continue_loading_object(ff::resource_object_base* obj)
+    {
         // Load dependencies
         bool result = true;
+        for (std::shared_ptr<ff::resource> dep : obj->resource_get_dependencies())
         {
-            for (std::shared_ptr<ff::resource> dep : obj->resource_get_dependencies())
+            std::shared_ptr<ff::resource_object_base> dep_obj = dep ? dep->value()->convert_or_default<ff::resource_object_base>()->get<ff::resource_object_base>() : nullptr;
+            if (!dep_obj)
             {
-                std::shared_ptr<ff::resource_object_base> dep_obj = dep ? dep->value()->convert_or_default<ff::resource_object_base>()->get<ff::resource_object_base>() : nullptr;
-                if (dep_obj && !this->finish_loading_object(dep_obj.get()))
-                {
-                    std::ostringstream str;
-                    str << "Failed to finish loading dependent resource: " << dep->name();
-                    this->add_error(str.str());
-                    result = false;
-                    break;
-                }
+                continue;
             }
 
-            result = obj->resource_load_complete(true);
+            {
+                std::scoped_lock lock(this->mutex);
+                this->obj_to_currently_finishing.at(obj).waiting_for = dep_obj.get();
+            }
+
+            if (!this->finish_loading_object(dep_obj.get()))
+            {
+                std::ostringstream str;
+                str << "Failed to finish loading dependent resource: " << dep->name();
+                this->add_error(str.str());
+                result = false;
+                break;
+            }
+
+            std::scoped_lock lock(this->mutex);
+            auto iter = this->obj_to_currently_finishing.find(dep_obj.get());
+            if (iter != this->obj_to_currently_finishing.cend())
+            {
+                iter->second.waiting_objs.push_back(obj);
+                return true;
+            }
         }
 
-        // Done
+        result = obj->resource_load_complete(true);
+
+        // Done, finish anything that was left waiting for this
+        std::vector<ff::resource_object_base*> waiting_objs;
         {
             std::scoped_lock lock(this->mutex);
 
             auto iter = this->obj_to_currently_finishing.find(obj);
-            ff::win_event event_handle = iter->second.event_handle;
+            waiting_objs = std::move(iter->second.waiting_objs);
             this->obj_to_currently_finishing.erase(iter);
-
-            event_handle.set();
-
             this->obj_to_finished.insert(obj);
         }
 
+        for (ff::resource_object_base* waiting_obj : waiting_objs)
+        {
+            if (!this->continue_loading_object(waiting_obj))
+            {
+                this->add_error("Failed to finish loading resource");
+            }
+        }
+
         return result;
     }
 
-    struct finishing_info
+    // caller must own mutex
+    bool waits_for_itself(ff::resource_object_base* obj) const
     {
-        finishing_info()
-            : thread_id(::GetCurrentThreadId())
-        {}
+        ff::resource_object_base* current = obj;
+        for (size_t i = 0; i < this->obj_to_currently_finishing.size(); i++)
+        {
+            auto iter = this->obj_to_currently_finishing.find(current);
+            current = (iter != this->obj_to_currently_finishing.cend()) ? iter->second.waiting_for : nullptr;
 
-        DWORD thread_id;
-        ff::win_event event_handle;
+            if (!current || current == obj)
+            {
+                return current == obj;
+            }
+        }
+
+        return false;
+    }
+
+    struct finishing_info
+    {
+        ff::resource_object_base* waiting_for{}; // dependency that has to finish first
+        std::vector<ff::resource_object_base*> waiting_objs; // finished by whichever task finishes this one
     };
 
-    std::recursive_mutex mutex;
+    std::mutex mutex;
     std::unordered_map<ff::resource_object_base*, finishing_info> obj_to_currently_finishing;
     std::unordered_set<ff::resource_object_base*> obj_to_finished;
 };
@@ -778,11 +985,11 @@ protected:
     }
 };
 
-ff::load_resources_result ff::load_resources_from_json(const ff::dict& json_dict, const std::filesystem::path& base_path, bool debug)
+ff::load_resources_result ff::load_resources_from_json(const ff::dict& json_dict, const std::filesystem::path& base_path, bool debug, ff::resource_build_cache* build_cache)
 {
     ff::dict dict = json_dict;
 
-    ::transformer_context context(base_path, debug);
+    ::transformer_context context(base_path, debug, build_cache);
     ::expand_file_paths_transformer t1(context);
     ::expand_values_and_templates_transformer t2(context);
     ::start_load_objects_from_dict_transformer t3(context);
@@ -790,6 +997,7 @@ ff::load_resources_result ff::load_resources_from_json(const ff::dict& json_dict
     ::finish_load_objects_from_dict_transformer t5(context);
     ::save_objects_to_dict_transformer t6(context);
     std::array<transformer_base*, 6> transformers = { &t1, &t2, &t3, &t4, &t5, &t6 };
+    ff::dict groups_dict;
 
     for (transformer_base* transformer : transformers)
     {
@@ -810,6 +1018,29 @@ ff::load_resources_result ff::load_resources_from_json(const ff::dict& json_dict
         }
 
         dict = new_dict_value->get<ff::dict>();
+
+        if (transformer == &t2)
+        {
+            // Load groups must be found before the resources get turned into objects
+            for (std::string_view name : dict.child_names())
+            {
+                ff::value_ptr child_value = dict.get(name);
+                if (!name.starts_with(ff::internal::RES_PREFIX) && child_value->is_type<ff::dict>())
+                {
+                    std::string group = child_value->get<ff::dict>().get<std::string>(ff::internal::RES_GROUP);
+                    if (!group.empty())
+                    {
+                        groups_dict.set<std::string>(name, std::move(group));
+                    }
+                }
+            }
+        }
+    }
+
+    // Resources that get loaded together
+    if (!groups_dict.empty())
+    {
+        dict.set<ff::dict>(ff::internal::RES_GROUPS, std::move(groups_dict));
     }
 
     // All input files for every single resource
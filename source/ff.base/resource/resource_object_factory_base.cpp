@@ -9,3 +9,8 @@ std::string_view ff::resource_object_factory_base::name() const
 {
     return this->name_;
 }
+
+uint32_t ff::resource_object_factory_base::version() const
+{
+    return 0;
+}
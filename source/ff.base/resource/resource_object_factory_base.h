@@ -14,6 +14,7 @@ namespace ff
         virtual ~resource_object_factory_base() = default;
 
         std::string_view name() const;
+        virtual uint32_t version() const; // change it when load_from_source output changes, so that build cache entries get rebuilt
 
         virtual std::type_index type_index() const = 0;
         virtual std::shared_ptr<resource_object_base> load_from_source(const ff::dict& dict, resource_load_context& context) const = 0;
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "base/log.h"
 #include "base/stable_hash.h"
+#include "data_persist/compression.h"
 #include "data_persist/filesystem.h"
 #include "data_persist/stream.h"
 #include "data_value/data_v.h"
@@ -17,7 +18,9 @@
 #include "resource/resource_object_base.h"
 #include "resource/resource_objects.h"
 #include "resource/resource_value_provider.h"
+#include "thread/parallel.h"
 #include "thread/thread_pool.h"
+#include "types/flags.h"
 #include "types/timer.h"
 
 using namespace std::string_view_literals;
@@ -26,6 +29,313 @@ static const size_t RESOURCE_PERSIST_COOKIE = ff::stable_hash_func("ff::resource
 static const size_t RESOURCE_PERSIST_HEADER = ff::stable_hash_func("ff::resource_objects::header@0"sv);
 static const size_t RESOURCE_PERSIST_METADATA = ff::stable_hash_func("ff::resource_objects::metadata@0"sv);
 static const size_t RESOURCE_PERSIST_DATA = ff::stable_hash_func("ff::resource_objects::data@0"sv);
+static const size_t RESOURCE_PERSIST_COOKIE_V1 = ff::stable_hash_func("ff::resource_objects@1"sv);
+static const size_t RESOURCE_PERSIST_TOC = ff::stable_hash_func("ff::resource_objects::toc@1"sv);
+
+namespace
+{
+    // The v1 table of contents is loaded with one read and used in place, it's laid out as:
+    // toc_header_t, uint32_t seeds[bucket_count] (padded to 8 bytes), toc_entry_t[table_size], toc_group_t[group_count], names
+    struct toc_header_t
+    {
+        uint64_t entry_count;
+        uint64_t table_size;
+        uint64_t bucket_count;
+        uint64_t group_count;
+        uint64_t names_size;
+        uint64_t data_size;
+    };
+
+    struct toc_entry_t
+    {
+        uint64_t name_hash;
+        uint64_t data_offset;
+        uint64_t saved_size;
+        uint64_t loaded_size;
+        uint32_t name_offset;
+        uint32_t name_size; // zero for an empty slot
+        uint32_t data_type;
+        uint32_t group; // index + 1, zero for none
+    };
+
+    struct toc_group_t
+    {
+        uint64_t data_offset;
+        uint64_t data_size;
+        uint32_t name_offset;
+        uint32_t name_size;
+    };
+
+    struct toc_resource_t
+    {
+        std::string_view name;
+        std::string_view group;
+        std::shared_ptr<ff::saved_data_base> saved_data;
+    };
+}
+
+static size_t toc_seeds_size(uint64_t bucket_count)
+{
+    return static_cast<size_t>((bucket_count * sizeof(uint32_t) + 7) & ~7ull);
+}
+
+// Hash-and-displace perfect hashing: each bucket of names gets a seed that scatters its names into empty slots
+static size_t toc_slot(uint64_t hash, uint32_t seed, uint64_t table_size)
+{
+    uint64_t value = hash ^ (seed * 0x9E3779B97F4A7C15ull);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<size_t>((value ^ (value >> 31)) % table_size);
+}
+
+static bool build_toc_table(const std::vector<uint64_t>& hashes, std::vector<uint32_t>& seeds, std::vector<size_t>& slots, size_t& table_size)
+{
+    const size_t bucket_count = std::max<size_t>(hashes.size() / 4, 1);
+    std::vector<std::vector<size_t>> buckets(bucket_count);
+
+    for (size_t i = 0; i < hashes.size(); i++)
+    {
+        buckets[hashes[i] % bucket_count].push_back(i);
+    }
+
+    // Place the biggest buckets first while the table is still mostly empty
+    std::vector<size_t> bucket_order(bucket_count);
+    for (size_t i = 0; i < bucket_count; i++)
+    {
+        bucket_order[i] = i;
+    }
+
+    std::stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](size_t l, size_t r)
+        {
+            return buckets[l].size() > buckets[r].size();
+        });
+
+    for (table_size = std::max<size_t>(hashes.size() * 5 / 4, 1); ; table_size += table_size / 4 + 1)
+    {
+        std::vector<bool> used(table_size);
+        seeds.assign(bucket_count, 0);
+        slots.assign(hashes.size(), 0);
+        bool failed = false;
+
+        for (size_t b = 0; !failed && b < bucket_count; b++)
+        {
+            const std::vector<size_t>& bucket = buckets[bucket_order[b]];
+            failed = !bucket.empty();
+
+            for (uint32_t seed = 0; failed && seed < 4096; seed++)
+            {
+                size_t placed = 0;
+                for (; placed < bucket.size(); placed++)
+                {
+                    const size_t slot = ::toc_slot(hashes[bucket[placed]], seed, table_size);
+                    if (used[slot])
+                    {
+                        break;
+                    }
+
+                    used[slot] = true;
+                    slots[bucket[placed]] = slot;
+                }
+
+                if (placed == bucket.size())
+                {
+                    seeds[bucket_order[b]] = seed;
+                    failed = false;
+                }
+                else
+                {
+                    while (placed)
+                    {
+                        used[slots[bucket[--placed]]] = false;
+                    }
+                }
+            }
+        }
+
+        if (!failed)
+        {
+            return true;
+        }
+
+        // Names with the same full hash can never be separated
+        assert_ret_val(table_size < hashes.size() * 4 + 64, false);
+    }
+}
+
+static std::vector<uint8_t> create_toc(const std::vector<::toc_resource_t>& resources)
+{
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> seeds;
+    std::vector<size_t> slots;
+    std::vector<::toc_group_t> groups;
+    std::string names;
+    size_t table_size;
+
+    hashes.reserve(resources.size());
+    for (const ::toc_resource_t& resource : resources)
+    {
+        hashes.push_back(ff::stable_hash_func(resource.name));
+    }
+
+    assert_ret_val(::build_toc_table(hashes, seeds, slots, table_size), {});
+
+    std::vector<::toc_entry_t> entries(table_size);
+    uint64_t data_offset = 0;
+
+    for (size_t i = 0; i < resources.size(); i++)
+    {
+        const ::toc_resource_t& resource = resources[i];
+        const size_t saved_size = resource.saved_data->saved_size();
+
+        // Resources are sorted by group, so each group's data is all in one range
+        if (!resource.group.empty() && (i == 0 || resource.group != resources[i - 1].group))
+        {
+            ::toc_group_t& group = groups.emplace_back();
+            group.data_offset = data_offset;
+            group.name_offset = static_cast<uint32_t>(names.size());
+            group.name_size = static_cast<uint32_t>(resource.group.size());
+            names += resource.group;
+        }
+
+        ::toc_entry_t& entry = entries[slots[i]];
+        entry.name_hash = hashes[i];
+        entry.data_offset = data_offset;
+        entry.saved_size = saved_size;
+        entry.loaded_size = resource.saved_data->loaded_size();
+        entry.name_offset = static_cast<uint32_t>(names.size());
+        entry.name_size = static_cast<uint32_t>(resource.name.size());
+        entry.data_type = static_cast<uint32_t>(resource.saved_data->type());
+        entry.group = resource.group.empty() ? 0 : static_cast<uint32_t>(groups.size());
+        names += resource.name;
+
+        data_offset += saved_size + ff::save_padding_size(saved_size);
+
+        if (entry.group)
+        {
+            groups.back().data_size = data_offset - groups.back().data_offset;
+        }
+    }
+
+    assert_ret_val(names.size() <= std::numeric_limits<uint32_t>::max(), {});
+
+    ::toc_header_t header{ resources.size(), table_size, seeds.size(), groups.size(), names.size(), data_offset };
+    const size_t seeds_size = ::toc_seeds_size(seeds.size());
+    std::vector<uint8_t> toc(sizeof(header) + seeds_size + entries.size() * sizeof(::toc_entry_t) + groups.size() * sizeof(::toc_group_t) + names.size());
+    uint8_t* dest = toc.data();
+
+    std::memcpy(dest, &header, sizeof(header));
+    std::memcpy(dest += sizeof(header), seeds.data(), seeds.size() * sizeof(uint32_t));
+    std::memcpy(dest += seeds_size, entries.data(), entries.size() * sizeof(::toc_entry_t));
+    std::copy(groups.cbegin(), groups.cend(), reinterpret_cast<::toc_group_t*>(dest += entries.size() * sizeof(::toc_entry_t)));
+    std::copy(names.cbegin(), names.cend(), dest += groups.size() * sizeof(::toc_group_t));
+
+    return toc;
+}
+
+/// <summary>
+/// A v1 resource pack whose resources haven't been added to resource_infos yet
+/// </summary>
+struct ff::resource_objects::resource_pack
+{
+    // Only checks the table sizes, so opening a pack doesn't touch every entry
+    bool init()
+    {
+        const uint8_t* data = this->toc_data->data();
+        size_t size = this->toc_data->size();
+        assert_ret_val(size >= sizeof(::toc_header_t), false);
+
+        this->header = reinterpret_cast<const ::toc_header_t*>(data);
+        const ::toc_header_t& header = *this->header;
+        assert_ret_val(header.bucket_count && header.table_size >= header.entry_count && header.table_size, false);
+        data += sizeof(::toc_header_t);
+        size -= sizeof(::toc_header_t);
+
+        assert_ret_val(header.bucket_count <= size / sizeof(uint32_t) && ::toc_seeds_size(header.bucket_count) <= size, false);
+        this->seeds = reinterpret_cast<const uint32_t*>(data);
+        data += ::toc_seeds_size(header.bucket_count);
+        size -= ::toc_seeds_size(header.bucket_count);
+
+        assert_ret_val(header.table_size <= size / sizeof(::toc_entry_t), false);
+        this->entries = reinterpret_cast<const ::toc_entry_t*>(data);
+        data += header.table_size * sizeof(::toc_entry_t);
+        size -= header.table_size * sizeof(::toc_entry_t);
+
+        assert_ret_val(header.group_count <= size / sizeof(::toc_group_t), false);
+        this->groups = reinterpret_cast<const ::toc_group_t*>(data);
+        data += header.group_count * sizeof(::toc_group_t);
+        size -= header.group_count * sizeof(::toc_group_t);
+
+        assert_ret_val(header.names_size == size, false);
+        this->names = std::string_view(reinterpret_cast<const char*>(data), size);
+        this->prefetched_groups.resize(header.group_count);
+
+        return true;
+    }
+
+    // Returns the entry index, or table_size if the name isn't in this pack
+    size_t find(std::string_view name) const
+    {
+        const uint64_t hash = ff::stable_hash_func(name);
+        const size_t index = ::toc_slot(hash, this->seeds[hash % this->header->bucket_count], this->header->table_size);
+        const ::toc_entry_t& entry = this->entries[index];
+
+        return (!name.empty() && entry.name_hash == hash && this->name(entry.name_offset, entry.name_size) == name) ? index : this->header->table_size;
+    }
+
+    std::string_view name(uint32_t offset, uint32_t size) const
+    {
+        return (offset <= this->names.size() && size <= this->names.size() - offset) ? this->names.substr(offset, size) : std::string_view();
+    }
+
+    // Sorts entry indexes by group the first time a group is prefetched, caller must own resource_mutex
+    void init_group_entries()
+    {
+        if (!this->group_entry_starts.empty())
+        {
+            return;
+        }
+
+        const size_t group_count = this->header->group_count;
+        this->group_entry_starts.resize(group_count + 1);
+
+        for (size_t i = 0; i < this->header->table_size; i++)
+        {
+            const ::toc_entry_t& entry = this->entries[i];
+            if (entry.name_size && entry.group && entry.group <= group_count)
+            {
+                this->group_entry_starts[entry.group]++;
+            }
+        }
+
+        for (size_t i = 1; i <= group_count; i++)
+        {
+            this->group_entry_starts[i] += this->group_entry_starts[i - 1];
+        }
+
+        std::vector<uint32_t> next(this->group_entry_starts.begin(), this->group_entry_starts.end() - 1);
+        this->group_entries.resize(this->group_entry_starts.back());
+
+        for (size_t i = 0; i < this->header->table_size; i++)
+        {
+            const ::toc_entry_t& entry = this->entries[i];
+            if (entry.name_size && entry.group && entry.group <= group_count)
+            {
+                this->group_entries[next[entry.group - 1]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    std::shared_ptr<ff::data_base> toc_data;
+    std::shared_ptr<ff::saved_data_base> data;
+    const ::toc_header_t* header{};
+    const uint32_t* seeds{};
+    const ::toc_entry_t* entries{};
+    const ::toc_group_t* groups{};
+    std::string_view names;
+    std::vector<bool> prefetched_groups;
+    std::vector<uint32_t> group_entry_starts; // group_entries[starts[i], starts[i + 1]) are the entries for groups[i]
+    std::vector<uint32_t> group_entries;
+};
 
 static ff::value_ptr load_typed_value(std::shared_ptr<ff::saved_data_base> saved_data)
 {
@@ -81,6 +391,7 @@ void ff::resource_objects::add_resources(const ff::dict& dict)
 void ff::resource_objects::add_resources(const ff::resource_objects& other)
 {
     std::scoped_lock lock(this->resource_mutex, other.resource_mutex);
+    other.add_all_pack_resources();
 
     this->add_metadata_only(*other.resource_metadata_dict);
 
@@ -91,17 +402,47 @@ void ff::resource_objects::add_resources(const ff::resource_objects& other)
 
     for (auto& [name, other_info] : other.resource_infos)
     {
-        this->try_add_resource(name, other_info.saved_value);
+        this->try_add_resource(name, other_info.saved_value, other_info.group.str());
     }
 }
 
 bool ff::resource_objects::add_resources(ff::reader_base& reader)
+{
+    size_t cookie;
+    assert_ret_val(ff::load(reader, cookie), false);
+
+    if (cookie == ::RESOURCE_PERSIST_COOKIE_V1)
+    {
+        return this->add_resources_v1(reader);
+    }
+
+    assert_ret_val(cookie == ::RESOURCE_PERSIST_COOKIE, false);
+    return this->add_resources_v0(reader);
+}
+
+static std::shared_ptr<ff::saved_data_base> load_metadata(ff::reader_base& reader)
+{
+    size_t cookie, data_saved_size, data_loaded_size, data_flags;
+    assert_ret_val(
+        ff::load(reader, cookie) && cookie == ::RESOURCE_PERSIST_METADATA &&
+        ff::load(reader, data_saved_size) &&
+        ff::load(reader, data_loaded_size) &&
+        ff::load(reader, data_flags), nullptr);
+
+    ff::saved_data_type data_type = static_cast<ff::saved_data_type>(data_flags & 0xFF);
+    std::shared_ptr<ff::saved_data_base> metadata_saved = reader.saved_data(reader.pos(), data_saved_size, data_loaded_size, data_type);
+
+    const size_t data_cookie_pos = reader.pos() + data_saved_size + ff::save_padding_size(data_saved_size);
+    reader.pos(data_cookie_pos);
+
+    return metadata_saved;
+}
+
+bool ff::resource_objects::add_resources_v0(ff::reader_base& reader)
 {
     std::vector<std::tuple<std::string, size_t, size_t, size_t, size_t>> resource_datas;
     std::shared_ptr<ff::saved_data_base> metadata_saved;
-
     size_t cookie;
-    assert_ret_val(ff::load(reader, cookie) && cookie == ::RESOURCE_PERSIST_COOKIE, false);
 
     // Read header and metadata
     {
@@ -121,17 +462,8 @@ bool ff::resource_objects::add_resources(ff::reader_base& reader)
             resource_datas.push_back(std::make_tuple(std::move(name), data_offset, data_saved_size, data_loaded_size, data_flags));
         }
 
-        assert_ret_val(
-            ff::load(reader, cookie) && cookie == ::RESOURCE_PERSIST_METADATA &&
-            ff::load(reader, data_saved_size) &&
-            ff::load(reader, data_loaded_size) &&
-            ff::load(reader, data_flags), false);
-
-        ff::saved_data_type data_type = static_cast<ff::saved_data_type>(data_flags & 0xFF);
-        metadata_saved = reader.saved_data(reader.pos(), data_saved_size, data_loaded_size, data_type);
-
-        const size_t data_cookie_pos = reader.pos() + data_saved_size + ff::save_padding_size(data_saved_size);
-        reader.pos(data_cookie_pos);
+        metadata_saved = ::load_metadata(reader);
+        assert_ret_val(metadata_saved, false);
     }
 
     std::scoped_lock lock(this->resource_mutex);
@@ -150,6 +482,33 @@ bool ff::resource_objects::add_resources(ff::reader_base& reader)
     return true;
 }
 
+// Nothing is allocated per resource, they get added to resource_infos the first time they're looked up
+bool ff::resource_objects::add_resources_v1(ff::reader_base& reader)
+{
+    auto pack = std::make_shared<ff::resource_objects::resource_pack>();
+    size_t cookie, toc_size;
+    assert_ret_val(ff::load(reader, cookie) && cookie == ::RESOURCE_PERSIST_TOC && ff::load(reader, toc_size), false);
+
+    std::shared_ptr<ff::saved_data_base> toc_saved = reader.saved_data(reader.pos(), toc_size, toc_size, ff::saved_data_type::none);
+    pack->toc_data = toc_saved ? toc_saved->saved_data() : nullptr;
+    assert_ret_val(pack->toc_data && pack->toc_data->size() == toc_size && pack->init(), false);
+    reader.pos(reader.pos() + toc_size + ff::save_padding_size(toc_size));
+
+    std::shared_ptr<ff::saved_data_base> metadata_saved = ::load_metadata(reader);
+    assert_ret_val(metadata_saved && ff::load(reader, cookie) && cookie == ::RESOURCE_PERSIST_DATA, false);
+
+    const size_t data_size = static_cast<size_t>(pack->header->data_size);
+    assert_ret_val(reader.pos() <= reader.size() && data_size <= reader.size() - reader.pos(), false);
+    pack->data = reader.saved_data(reader.pos(), data_size, data_size, ff::saved_data_type::none);
+    assert_ret_val(pack->data, false);
+
+    std::scoped_lock lock(this->resource_mutex);
+    this->resource_metadata_saved->push_back(metadata_saved);
+    this->resource_packs.push_back(std::move(pack));
+
+    return true;
+}
+
 bool ff::resource_objects::add_files(const std::filesystem::path& path)
 {
     std::vector<std::filesystem::path> files;
@@ -178,13 +537,63 @@ bool ff::resource_objects::add_files(const std::filesystem::path& path)
     return true;
 }
 
+// Finds the same "ref:" names that create_resource_objects will resolve
+static void find_references(const ff::value_ptr& value, std::vector<std::string>& references)
+{
+    if (!value)
+    {
+        return;
+    }
+
+    ff::value_ptr dict_value = ff::type::try_get_dict_from_data(value);
+    if (dict_value)
+    {
+        for (auto& [name, child_value] : dict_value->get<ff::dict>())
+        {
+            ::find_references(child_value, references);
+        }
+    }
+    else if (value->is_type<std::vector<ff::value_ptr>>())
+    {
+        for (const ff::value_ptr& child_value : value->get<std::vector<ff::value_ptr>>())
+        {
+            ::find_references(child_value, references);
+        }
+    }
+    else if (value->is_type<std::string>() || value->is_type<ff::resource>())
+    {
+        ff::value_ptr string_val = value->convert_or_default<std::string>();
+        std::string_view str = string_val->get<std::string>();
+
+        if (str.starts_with(ff::internal::REF_PREFIX))
+        {
+            std::string_view ref_name = str.substr(ff::internal::REF_PREFIX.size());
+            if (std::find(references.cbegin(), references.cend(), ref_name) == references.cend())
+            {
+                references.emplace_back(ref_name);
+            }
+        }
+    }
+}
+
 // caller must own resource_mutex
 void ff::resource_objects::add_resources_only(const ff::dict& dict)
 {
+    const ff::dict& groups_dict = dict.get<ff::dict>(ff::internal::RES_GROUPS);
+    ff::dict dependencies_dict;
+
     for (auto& [child_name, child_value] : dict)
     {
         if (!child_name.starts_with(ff::internal::RES_PREFIX))
         {
+            std::vector<std::string> references;
+            ::find_references(child_value, references);
+
+            if (!references.empty())
+            {
+                dependencies_dict.set<std::vector<std::string>>(child_name, std::move(references));
+            }
+
             auto data_vector = std::make_shared<std::vector<uint8_t>>();
             ff::data_writer data_writer(data_vector);
 
@@ -192,10 +601,18 @@ void ff::resource_objects::add_resources_only(const ff::dict& dict)
             {
                 auto data = std::make_shared<ff::data_vector>(data_vector);
                 auto saved_data = std::make_shared<ff::saved_data_static>(data, data->size(), ff::saved_data_type::none);
-                this->try_add_resource(child_name, saved_data);
+                this->try_add_resource(child_name, saved_data, groups_dict.get<std::string>(child_name));
             }
         }
     }
+
+    // Saved with the metadata so that load_group_async can schedule loads before anything gets loaded
+    if (!dependencies_dict.empty())
+    {
+        ff::dict old_dict = this->resource_metadata_dict->get<ff::dict>(ff::internal::RES_DEPENDENCIES);
+        old_dict.set(dependencies_dict, true);
+        this->resource_metadata_dict->set<ff::dict>(ff::internal::RES_DEPENDENCIES, std::move(old_dict));
+    }
 }
 
 static bool contains(const std::vector<std::string>& strings, const std::string& find_string, size_t old_string_size, bool is_path)
@@ -252,7 +669,7 @@ void ff::resource_objects::add_metadata_only(const ff::dict& dict) const
                 this->resource_metadata_dict->set<std::vector<std::string>>(multi_child_name, std::move(strings));
             }
         }
-        else if (child_name == ff::internal::RES_ID_SYMBOLS || child_name == ff::internal::RES_OUTPUT_FILES)
+        else if (child_name == ff::internal::RES_ID_SYMBOLS || child_name == ff::internal::RES_OUTPUT_FILES || child_name == ff::internal::RES_DEPENDENCIES)
         {
             ff::dict add_dict = child_value->get<ff::dict>();
             ff::dict old_dict = this->resource_metadata_dict->get<ff::dict>(child_name);
@@ -263,10 +680,18 @@ void ff::resource_objects::add_metadata_only(const ff::dict& dict) const
 }
 
 // caller must own resource_mutex
-bool ff::resource_objects::try_add_resource(std::string_view name, std::shared_ptr<ff::saved_data_base> data)
+bool ff::resource_objects::try_add_resource(std::string_view name, std::shared_ptr<ff::saved_data_base> data, std::string_view group)
 {
-    ff::resource_objects::resource_object_info info{ std::make_unique<std::string>(name), std::move(data) };
-    if (!this->resource_infos.try_emplace(*info.name, std::move(info)).second)
+    bool in_pack = false;
+    for (const std::shared_ptr<ff::resource_objects::resource_pack>& pack : this->resource_packs)
+    {
+        in_pack = in_pack || pack->find(name) != pack->header->table_size;
+    }
+
+    ff::resource_objects::resource_object_info info{ ff::atom(name), std::move(data) };
+    info.group = ff::atom(group);
+
+    if (in_pack || !this->resource_infos.try_emplace(info.name.str(), std::move(info)).second)
     {
         ff::log::write(ff::log::type::resource_load, "Duplicate resource: ", name);
         return false;
@@ -275,6 +700,132 @@ bool ff::resource_objects::try_add_resource(std::string_view name, std::shared_p
     return true;
 }
 
+// Earlier packs win, just like when all resources get added at once
+ff::resource_objects::resource_object_info* ff::resource_objects::try_add_pack_resource(std::string_view name) const
+{
+    for (const std::shared_ptr<ff::resource_objects::resource_pack>& pack : this->resource_packs)
+    {
+        const size_t index = pack->find(name);
+        if (index != pack->header->table_size)
+        {
+            return this->add_pack_resource(pack, index);
+        }
+    }
+
+    return nullptr;
+}
+
+ff::resource_objects::resource_object_info* ff::resource_objects::add_pack_resource(const std::shared_ptr<ff::resource_objects::resource_pack>& pack, size_t index) const
+{
+    const ::toc_entry_t& entry = pack->entries[index];
+    std::shared_ptr<ff::saved_data_base> saved_data = pack->data->subdata(
+        static_cast<size_t>(entry.data_offset),
+        static_cast<size_t>(entry.saved_size),
+        static_cast<size_t>(entry.loaded_size),
+        static_cast<ff::saved_data_type>(entry.data_type));
+    assert_ret_val(saved_data, nullptr);
+
+    ff::resource_objects::resource_object_info info{ ff::atom(pack->name(entry.name_offset, entry.name_size)), std::move(saved_data) };
+    info.pack = pack;
+
+    if (entry.group && entry.group <= pack->header->group_count)
+    {
+        const ::toc_group_t& group = pack->groups[entry.group - 1];
+        info.group = ff::atom(pack->name(group.name_offset, group.name_size));
+        info.pack_group = entry.group;
+    }
+
+    auto [iter, inserted] = this->resource_infos.try_emplace(info.name.str(), std::move(info));
+    return inserted ? &iter->second : nullptr;
+}
+
+void ff::resource_objects::add_all_pack_resources() const
+{
+    for (const std::shared_ptr<ff::resource_objects::resource_pack>& pack : this->resource_packs)
+    {
+        for (size_t i = 0; i < pack->header->table_size; i++)
+        {
+            const ::toc_entry_t& entry = pack->entries[i];
+            std::string_view name = pack->name(entry.name_offset, entry.name_size);
+            if (name.empty())
+            {
+                continue;
+            }
+
+            auto iter = this->resource_infos.find(name);
+            if (iter == this->resource_infos.cend())
+            {
+                this->add_pack_resource(pack, i);
+            }
+            else if (iter->second.pack != pack && pack->find(name) == i)
+            {
+                ff::log::write(ff::log::type::resource_load, "Duplicate resource: ", name);
+            }
+        }
+    }
+
+    this->resource_packs.clear();
+}
+
+// Reads a resource's whole group at once the first time any resource in the group gets loaded
+std::shared_ptr<ff::saved_data_base> ff::resource_objects::prefetch_saved_value(ff::resource_objects::resource_object_info& info)
+{
+    std::shared_ptr<ff::resource_objects::resource_pack> pack;
+    size_t group_index;
+    {
+        std::scoped_lock lock(this->resource_mutex);
+        if (info.prefetched_value)
+        {
+            return std::exchange(info.prefetched_value, nullptr);
+        }
+
+        if (!info.pack || !info.pack_group || info.pack->prefetched_groups[info.pack_group - 1])
+        {
+            return info.saved_value;
+        }
+
+        pack = info.pack;
+        group_index = info.pack_group - 1;
+        pack->prefetched_groups[group_index] = true;
+    }
+
+    const ::toc_group_t& group = pack->groups[group_index];
+    std::shared_ptr<ff::saved_data_base> group_saved = pack->data->subdata(
+        static_cast<size_t>(group.data_offset),
+        static_cast<size_t>(group.data_size),
+        static_cast<size_t>(group.data_size),
+        ff::saved_data_type::none);
+    std::shared_ptr<ff::data_base> group_data = group_saved ? group_saved->saved_data() : nullptr;
+
+    std::scoped_lock lock(this->resource_mutex);
+    pack->init_group_entries();
+
+    for (size_t j = pack->group_entry_starts[group_index]; group_data && j < pack->group_entry_starts[group_index + 1]; j++)
+    {
+        const ::toc_entry_t& entry = pack->entries[pack->group_entries[j]];
+        if (entry.data_offset < group.data_offset || entry.saved_size > group.data_size - (entry.data_offset - group.data_offset))
+        {
+            continue;
+        }
+
+        std::string_view name = pack->name(entry.name_offset, entry.name_size);
+        auto iter = this->resource_infos.find(name);
+        ff::resource_objects::resource_object_info* sibling = (iter != this->resource_infos.cend()) ? &iter->second : this->try_add_pack_resource(name);
+
+        if (sibling && sibling->pack == pack)
+        {
+            // Each resource gets its own copy, so the group buffer isn't kept alive by whichever resources are still loaded or never get loaded
+            const uint8_t* entry_data = group_data->data() + (entry.data_offset - group.data_offset);
+            sibling->prefetched_value = std::make_shared<ff::saved_data_static>(
+                std::make_shared<ff::data_vector>(std::vector<uint8_t>(entry_data, entry_data + entry.saved_size)),
+                static_cast<size_t>(entry.loaded_size),
+                static_cast<ff::saved_data_type>(entry.data_type));
+        }
+    }
+
+    return info.prefetched_value ? std::exchange(info.prefetched_value, nullptr) : info.saved_value;
+}
+
 // caller must own resource_mutex
 ff::dict& ff::resource_objects::resource_metadata() const
 {
@@ -300,11 +851,12 @@ ff::dict& ff::resource_objects::resource_metadata() const
 bool ff::resource_objects::save(ff::writer_base& writer) const
 {
     // Collect the memory for each resource
-    std::vector<std::tuple<std::string_view, std::shared_ptr<ff::saved_data_base>>> resource_datas;
+    std::vector<::toc_resource_t> resource_datas;
     std::shared_ptr<ff::data_base> metadata_data;
     size_t full_size_guess = sizeof(size_t) * 8; // cookies and sizes
     {
         std::scoped_lock lock(this->resource_mutex);
+        this->add_all_pack_resources();
         resource_datas.reserve(this->resource_infos.size());
 
         // Save metadata, and reuse old saved metadata if possible
@@ -326,33 +878,28 @@ bool ff::resource_objects::save(ff::writer_base& writer) const
 
         for (auto& [name, info] : this->resource_infos)
         {
-            resource_datas.push_back(std::make_tuple(name, info.saved_value));
-            full_size_guess += name.size() + info.saved_value->saved_size() + sizeof(size_t) * 6;
+            resource_datas.push_back(::toc_resource_t{ name, info.group.str(), info.saved_value });
+            full_size_guess += name.size() + info.group.str().size() + info.saved_value->saved_size() + sizeof(::toc_entry_t) * 2;
         }
     }
 
+    // Resources in the same group are saved next to each other so they can be read all at once
+    std::sort(resource_datas.begin(), resource_datas.end(), [](const ::toc_resource_t& l, const ::toc_resource_t& r)
+        {
+            return (l.group != r.group) ? l.group < r.group : l.name < r.name;
+        });
+
+    std::vector<uint8_t> toc = ::create_toc(resource_datas);
+    assert_ret_val(!toc.empty(), false);
+
     writer.reserve(full_size_guess);
-    assert_ret_val(ff::save(writer, ::RESOURCE_PERSIST_COOKIE), false);
+    assert_ret_val(ff::save(writer, ::RESOURCE_PERSIST_COOKIE_V1), false);
 
-    // Write header
+    // Write table of contents
     {
-        const size_t size = resource_datas.size();
-        assert_ret_val(ff::save(writer, ::RESOURCE_PERSIST_HEADER) && ff::save(writer, size), false);
-
-        size_t data_offset = 0;
-        for (auto& [name, saved_data] : resource_datas)
-        {
-            const size_t saved_size = saved_data->saved_size();
-            const size_t loaded_size = saved_data->loaded_size();
-            const size_t saved_type = static_cast<size_t>(saved_data->type());
-            assert_ret_val(
-                ff::save(writer, name) &&
-                ff::save(writer, data_offset) &&
-                ff::save(writer, saved_size) &&
-                ff::save(writer, loaded_size) &&
-                ff::save(writer, saved_type), false);
-            data_offset += saved_size + ff::save_padding_size(saved_size);
-        }
+        const size_t size = toc.size();
+        assert_ret_val(ff::save(writer, ::RESOURCE_PERSIST_TOC) && ff::save(writer, size), false);
+        assert_ret_val(ff::save_bytes(writer, toc.data(), toc.size()), false);
     }
 
     // Write metadata
@@ -365,13 +912,13 @@ bool ff::resource_objects::save(ff::writer_base& writer) const
         assert_ret_val(ff::save_bytes(writer, *metadata_data), false);
     }
 
-    // Write data
+    // Write data, in the same order as the table of contents
     {
         assert_ret_val(ff::save(writer, ::RESOURCE_PERSIST_DATA), false);
 
-        for (auto& [name, saved_data] : resource_datas)
+        for (const ::toc_resource_t& resource : resource_datas)
         {
-            auto data = saved_data->saved_data();
+            auto data = resource.saved_data->saved_data();
             assert_ret_val(data && ff::save_bytes(writer, *data), false);
         }
     }
@@ -382,18 +929,89 @@ bool ff::resource_objects::save(ff::writer_base& writer) const
 bool ff::resource_objects::save(ff::dict& dict) const
 {
     std::scoped_lock lock(this->resource_mutex);
+    this->add_all_pack_resources();
     dict.set(this->resource_metadata(), false);
 
+    ff::dict groups_dict;
     for (auto& [name, info] : this->resource_infos)
     {
         ff::value_ptr dict_value = ::load_typed_value(info.saved_value);
         assert_ret_val(dict_value, false);
         dict.set(name, dict_value);
+
+        if (!info.group.empty())
+        {
+            groups_dict.set<std::string>(name, std::string(info.group.str()));
+        }
+    }
+
+    if (!groups_dict.empty())
+    {
+        dict.set<ff::dict>(ff::internal::RES_GROUPS, std::move(groups_dict));
     }
 
     return true;
 }
 
+// Each resource's saved data gets compressed again with the codec picked for its res:type, a null codec leaves it uncompressed
+bool ff::resource_objects::compress_resources(const std::function<const ff::compression::codec_base* (std::string_view type)>& codec_for_type)
+{
+    std::scoped_lock lock(this->resource_mutex);
+    this->add_all_pack_resources();
+
+    std::vector<ff::resource_objects::resource_object_info*> infos;
+    infos.reserve(this->resource_infos.size());
+
+    for (auto& [name, info] : this->resource_infos)
+    {
+        infos.push_back(&info);
+    }
+
+    std::atomic_bool status = true;
+    ff::parallel_for(0, infos.size(), 1, [&infos, &codec_for_type, &status](size_t i)
+        {
+            std::shared_ptr<ff::saved_data_base>& saved_value = infos[i]->saved_value;
+            ff::value_ptr value = ::load_typed_value(saved_value);
+            ff::value_ptr dict_value = value ? ff::type::try_get_dict_from_data(value) : nullptr;
+            std::string type = dict_value ? dict_value->get<ff::dict>().get<std::string>(ff::internal::RES_TYPE) : std::string();
+
+            const ff::compression::codec_base* codec = codec_for_type(type);
+            if (codec == ff::compression::get_codec(saved_value->type()))
+            {
+                return;
+            }
+
+            std::shared_ptr<ff::data_base> data = saved_value->loaded_data();
+            const ff::saved_data_type saved_type = ff::flags::clear(saved_value->type(), ff::compression::codec_types());
+
+            if (!data)
+            {
+                status = false;
+            }
+            else if (codec)
+            {
+                auto compressed_vector = std::make_shared<std::vector<uint8_t>>();
+                ff::data_writer writer(compressed_vector);
+
+                if (codec->compress(*data, writer))
+                {
+                    saved_value = std::make_shared<ff::saved_data_static>(std::make_shared<ff::data_vector>(compressed_vector), data->size(), ff::flags::combine(saved_type, codec->type()));
+                }
+                else
+                {
+                    status = false;
+                }
+            }
+            else
+            {
+                saved_value = std::make_shared<ff::saved_data_static>(data, data->size(), saved_type);
+            }
+        }).wait();
+
+    assert_ret_val(status, false);
+    return true;
+}
+
 std::vector<std::string> ff::resource_objects::input_files() const
 {
     std::scoped_lock lock(this->resource_mutex);
@@ -469,35 +1087,20 @@ std::shared_ptr<ff::resource> ff::resource_objects::get_resource_object_here(std
     std::shared_ptr<ff::resource> resource_result;
 
     auto iter = this->resource_infos.find(name);
-    if (iter != this->resource_infos.cend())
+    ff::resource_objects::resource_object_info* info_ptr = (iter != this->resource_infos.cend()) ? &iter->second : this->try_add_pack_resource(name);
+    if (info_ptr)
     {
-        ff::resource_objects::resource_object_info& info = iter->second;
+        ff::resource_objects::resource_object_info& info = *info_ptr;
         resource_result = info.weak_value.lock();
 
         if (!resource_result)
         {
-            if (this->loading_count.fetch_add(1) == 0)
-            {
-                this->done_loading_event.reset();
-            }
-
-            resource_result = std::make_shared<ff::resource>(name);
-
-            auto loading_info = std::make_shared<ff::resource_objects::resource_object_loading_info>();
-            loading_info->loading_resource = resource_result;
-            loading_info->name = name;
-            loading_info->owner = &info;
-            loading_info->start_time = ff::timer::current_raw_time();
-            loading_info->blocked_count = 1;
-
-            info.weak_value = resource_result;
-            info.weak_loading_info = loading_info;
-
-            ff::log::write(ff::log::type::resource_load, "Loading: ", name);
+            std::shared_ptr<ff::resource_objects::resource_object_loading_info> loading_info = this->start_loading(info);
+            resource_result = loading_info->loading_resource;
 
             ff::thread_pool::add_task([this, loading_info]()
             {
-                ff::value_ptr dict_value = ::load_typed_value(loading_info->owner->saved_value);
+                ff::value_ptr dict_value = ::load_typed_value(this->prefetch_saved_value(*loading_info->owner));
                 ff::value_ptr new_value = this->create_resource_objects(loading_info, dict_value);
                 this->update_resource_object_info(loading_info, new_value);
                 // no code here since the destructor may be running
@@ -508,9 +1111,270 @@ std::shared_ptr<ff::resource> ff::resource_objects::get_resource_object_here(std
     return resource_result;
 }
 
+// Caller must own the this->resource_object_info_mutex lock
+std::shared_ptr<ff::resource_objects::resource_object_loading_info> ff::resource_objects::start_loading(ff::resource_objects::resource_object_info& info)
+{
+    if (this->loading_count.fetch_add(1) == 0)
+    {
+        this->done_loading_event.reset();
+    }
+
+    auto loading_info = std::make_shared<ff::resource_objects::resource_object_loading_info>();
+    loading_info->loading_resource = std::make_shared<ff::resource>(info.name.str());
+    loading_info->name = info.name.str();
+    loading_info->owner = &info;
+    loading_info->start_time = ff::timer::current_raw_time();
+    loading_info->blocked_count = 1;
+
+    info.weak_value = loading_info->loading_resource;
+    info.weak_loading_info = loading_info;
+
+    ff::log::write(ff::log::type::resource_load, "Loading: ", info.name.str());
+
+    return loading_info;
+}
+
+/// <summary>
+/// Dependency graph for one call to load_group_async
+/// </summary>
+struct ff::resource_objects::resource_group_load : public std::enable_shared_from_this<ff::resource_objects::resource_group_load>
+{
+    struct node_t
+    {
+        std::shared_ptr<ff::resource_objects::resource_object_loading_info> loading_info;
+        std::vector<std::string> dependencies;
+        std::vector<size_t> dependents;
+        size_t waiting_count{}; // dependencies that haven't been created yet
+    };
+
+    // Resources in a reference cycle can't wait for each other, so they start right away and block the old way
+    void break_cycles()
+    {
+        std::vector<size_t> waiting_counts(this->nodes.size());
+        std::vector<size_t> ready;
+        size_t sorted_count = 0;
+
+        for (size_t i = 0; i < this->nodes.size(); i++)
+        {
+            waiting_counts[i] = this->nodes[i].waiting_count;
+            if (!waiting_counts[i])
+            {
+                ready.push_back(i);
+            }
+        }
+
+        while (!ready.empty())
+        {
+            const size_t i = ready.back();
+            ready.pop_back();
+            sorted_count++;
+
+            for (size_t dependent : this->nodes[i].dependents)
+            {
+                if (!--waiting_counts[dependent])
+                {
+                    ready.push_back(dependent);
+                }
+            }
+        }
+
+        if (sorted_count != this->nodes.size())
+        {
+            ff::log::write(ff::log::type::resource_load, "Resource reference cycle, ", this->nodes.size() - sorted_count, " resources can't be ordered");
+
+            for (node_t& node : this->nodes)
+            {
+                std::erase_if(node.dependents, [&waiting_counts](size_t dependent)
+                    {
+                        return waiting_counts[dependent] != 0;
+                    });
+            }
+
+            for (size_t i = 0; i < this->nodes.size(); i++)
+            {
+                this->nodes[i].waiting_count = waiting_counts[i] ? 0 : this->nodes[i].waiting_count;
+            }
+        }
+    }
+
+    // Only starts about as many nodes as there are CPU cores, the rest wait in ready_nodes without using a thread.
+    // Loading reads files and can wait for other resources, so nodes run as thread pool tasks, not on job threads.
+    void start_ready_nodes()
+    {
+        std::vector<size_t> start_nodes;
+        {
+            std::scoped_lock lock(this->mutex);
+            while (this->running_count < this->max_running_count && !this->ready_nodes.empty())
+            {
+                start_nodes.push_back(this->ready_nodes.front());
+                this->ready_nodes.pop_front();
+                this->running_count++;
+            }
+        }
+
+        for (size_t i : start_nodes)
+        {
+            ff::thread_pool::add_task([group = this->shared_from_this(), i]()
+                {
+                    group->owner->run_group_node(group, i);
+                });
+        }
+    }
+
+    void finish_node(size_t index)
+    {
+        bool done;
+        {
+            std::scoped_lock lock(this->mutex);
+            this->running_count--;
+            done = !--this->remaining_count;
+
+            for (size_t dependent : this->nodes[index].dependents)
+            {
+                if (!--this->nodes[dependent].waiting_count)
+                {
+                    this->ready_nodes.push_back(dependent);
+                }
+            }
+        }
+
+        if (done)
+        {
+            this->task.set_result();
+        }
+        else
+        {
+            // The owner can't be destroyed yet since the remaining nodes are still counted in its loading_count
+            this->start_ready_nodes();
+        }
+    }
+
+    ff::resource_objects* owner{};
+    ff::co_task_source<void> task{ ff::co_task_source<void>::create() };
+    std::vector<std::shared_ptr<ff::resource>> resources; // keeps references alive until they are used
+    std::vector<node_t> nodes;
+    std::mutex mutex;
+    std::deque<size_t> ready_nodes;
+    size_t running_count{};
+    size_t remaining_count{};
+    size_t max_running_count{};
+};
+
+static ff::co_task<std::vector<std::shared_ptr<ff::resource>>> wait_for_resources(ff::co_task<> loading_task, std::vector<std::shared_ptr<ff::resource>> resources)
+{
+    co_await loading_task;
+
+    // A resource can still be blocked by a reference that was already loading outside of the group
+    for (const std::shared_ptr<ff::resource>& resource : resources)
+    {
+        co_await resource->value_async();
+    }
+
+    co_return resources;
+}
+
+ff::co_task<std::vector<std::shared_ptr<ff::resource>>> ff::resource_objects::load_group_async(const std::vector<std::string_view>& names)
+{
+    auto group = std::make_shared<ff::resource_objects::resource_group_load>();
+    std::vector<std::shared_ptr<ff::resource>> results;
+    results.reserve(names.size());
+    {
+        std::scoped_lock lock(this->resource_mutex);
+        const ff::dict& dependencies_dict = this->resource_metadata().get<ff::dict>(ff::internal::RES_DEPENDENCIES);
+        std::unordered_map<std::string_view, size_t> node_indexes;
+        std::vector<std::string> pending_names(names.crbegin(), names.crend());
+        const size_t no_node = static_cast<size_t>(-1);
+
+        // Find everything that isn't loaded yet, following references depth first
+        while (!pending_names.empty())
+        {
+            std::string name = std::move(pending_names.back());
+            pending_names.pop_back();
+
+            auto iter = this->resource_infos.find(name);
+            ff::resource_objects::resource_object_info* info = (iter != this->resource_infos.cend()) ? &iter->second : this->try_add_pack_resource(name);
+            if (!info || node_indexes.contains(info->name.str()))
+            {
+                continue;
+            }
+
+            std::shared_ptr<ff::resource> resource = info->weak_value.lock();
+            if (resource)
+            {
+                // Already loaded or loading
+                node_indexes.try_emplace(info->name.str(), no_node);
+                group->resources.push_back(std::move(resource));
+                continue;
+            }
+
+            node_indexes.try_emplace(info->name.str(), group->nodes.size());
+            ff::resource_objects::resource_group_load::node_t& node = group->nodes.emplace_back();
+            node.loading_info = this->start_loading(*info);
+            node.dependencies = dependencies_dict.get<std::vector<std::string>>(info->name);
+            group->resources.push_back(node.loading_info->loading_resource);
+            pending_names.insert(pending_names.end(), node.dependencies.crbegin(), node.dependencies.crend());
+        }
+
+        for (size_t i = 0; i < group->nodes.size(); i++)
+        {
+            for (const std::string& dependency : group->nodes[i].dependencies)
+            {
+                auto iter = node_indexes.find(dependency);
+                if (iter != node_indexes.cend() && iter->second != no_node && iter->second != i)
+                {
+                    group->nodes[iter->second].dependents.push_back(i);
+                    group->nodes[i].waiting_count++;
+                }
+            }
+        }
+
+        group->break_cycles();
+
+        for (size_t i = 0; i < group->nodes.size(); i++)
+        {
+            if (!group->nodes[i].waiting_count)
+            {
+                group->ready_nodes.push_back(i);
+            }
+        }
+
+        for (std::string_view name : names)
+        {
+            results.push_back(this->get_resource_object(name));
+        }
+    }
+
+    group->owner = this;
+    group->remaining_count = group->nodes.size();
+    group->max_running_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    if (group->nodes.empty())
+    {
+        group->task.set_result();
+    }
+    else
+    {
+        group->start_ready_nodes();
+    }
+
+    return ::wait_for_resources(group->task, std::move(results));
+}
+
+// Every dependency in the group was already created, so references to them never block
+void ff::resource_objects::run_group_node(std::shared_ptr<ff::resource_objects::resource_group_load> group, size_t index)
+{
+    std::shared_ptr<ff::resource_objects::resource_object_loading_info> loading_info = group->nodes[index].loading_info;
+    ff::value_ptr dict_value = ::load_typed_value(this->prefetch_saved_value(*loading_info->owner));
+    ff::value_ptr new_value = this->create_resource_objects(loading_info, dict_value);
+    this->update_resource_object_info(loading_info, new_value);
+    group->finish_node(index);
+}
+
 std::vector<std::string_view> ff::resource_objects::resource_object_names() const
 {
     std::scoped_lock lock(this->resource_mutex);
+    this->add_all_pack_resources();
+
     std::vector<std::string_view> names;
     names.reserve(this->resource_infos.size());
 
@@ -695,6 +1559,8 @@ ff::co_task<> ff::resource_objects::rebuild_async()
     co_await this->flush_all_resources_async();
 
     std::scoped_lock lock(this->resource_mutex);
+    this->add_all_pack_resources();
+
     std::unordered_map<std::string_view, std::shared_ptr<ff::resource>> old_resources;
 
     for (auto& [name, info] : this->resource_infos)
@@ -711,6 +1577,9 @@ ff::co_task<> ff::resource_objects::rebuild_async()
         ff::load_resources_result result = ff::load_resources_from_file(source_path, ff::resource_cache_t::use_cache_in_memory, ff::constants::profile_build);
         if (result.resources)
         {
+            std::scoped_lock other_lock(result.resources->resource_mutex);
+            result.resources->add_all_pack_resources();
+
             for (auto& [name, other_info] : result.resources->resource_infos)
             {
                 this->resource_infos.erase(name);
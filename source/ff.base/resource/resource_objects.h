@@ -14,6 +14,11 @@ namespace ff
     class resource_value_provider;
 }
 
+namespace ff::compression
+{
+    class codec_base;
+}
+
 namespace ff
 {
     class resource_objects
@@ -38,6 +43,7 @@ namespace ff
         bool add_files(const std::filesystem::path& path);
         bool save(ff::writer_base& writer) const;
         bool save(ff::dict& dict) const;
+        bool compress_resources(const std::function<const ff::compression::codec_base* (std::string_view type)>& codec_for_type);
 
         // Metadata
         std::vector<std::string> input_files() const;
@@ -46,6 +52,9 @@ namespace ff
         std::vector<std::pair<std::string, std::string>> id_to_names(std::string_view source_namespace) const;
         std::vector<std::pair<std::string, std::shared_ptr<ff::data_base>>> output_files() const;
 
+        // Loads resources and everything they reference, each one only after the resources it depends on
+        ff::co_task<std::vector<std::shared_ptr<ff::resource>>> load_group_async(const std::vector<std::string_view>& names);
+
         // ff::resource_object_loader
         virtual std::shared_ptr<ff::resource> get_resource_object(std::string_view name) override;
         virtual std::vector<std::string_view> resource_object_names() const override;
@@ -56,22 +65,31 @@ namespace ff
         virtual bool save_to_cache(ff::dict& dict) const override;
 
     private:
+        struct resource_object_info;
+        struct resource_object_loading_info;
+        struct resource_pack;
+        struct resource_group_load;
+
         void add_resources_only(const ff::dict& dict);
         void add_metadata_only(const ff::dict& dict) const;
-        bool try_add_resource(std::string_view name, std::shared_ptr<ff::saved_data_base> data);
+        bool add_resources_v0(ff::reader_base& reader);
+        bool add_resources_v1(ff::reader_base& reader);
+        bool try_add_resource(std::string_view name, std::shared_ptr<ff::saved_data_base> data, std::string_view group = {});
+        ff::resource_objects::resource_object_info* try_add_pack_resource(std::string_view name) const; // must be holding resource_mutex
+        ff::resource_objects::resource_object_info* add_pack_resource(const std::shared_ptr<ff::resource_objects::resource_pack>& pack, size_t index) const; // must be holding resource_mutex
+        void add_all_pack_resources() const; // must be holding resource_mutex
+        std::shared_ptr<ff::saved_data_base> prefetch_saved_value(ff::resource_objects::resource_object_info& info);
         ff::dict& resource_metadata() const; // must be holding resource_mutex
         void rebuild(ff::push_base<ff::co_task<>>& tasks);
         ff::co_task<> rebuild_async();
 
-        struct resource_object_info;
-
         struct resource_object_loading_info
         {
             std::recursive_mutex mutex;
             std::shared_ptr<ff::resource> loading_resource;
             ff::value_ptr final_value;
             std::vector<std::shared_ptr<ff::resource_objects::resource_object_loading_info>> parent_loading_infos;
-            std::string name;
+            std::string_view name; // atom string, never freed
             ff::resource_objects::resource_object_info* owner{};
             int64_t start_time{};
             int blocked_count{};
@@ -79,12 +97,18 @@ namespace ff
 
         struct resource_object_info
         {
-            std::unique_ptr<std::string> name;
+            ff::atom name;
             std::shared_ptr<ff::saved_data_base> saved_value;
+            std::shared_ptr<ff::saved_data_base> prefetched_value; // read along with its group, only used by the next load
             std::weak_ptr<ff::resource> weak_value;
             std::weak_ptr<ff::resource_objects::resource_object_loading_info> weak_loading_info;
+            ff::atom group; // resources in the same group are saved next to each other and loaded with one read
+            std::shared_ptr<ff::resource_objects::resource_pack> pack; // set when the resource came from a v1 pack
+            size_t pack_group{}; // index + 1 into the pack's groups, zero for none
         };
 
+        std::shared_ptr<ff::resource_objects::resource_object_loading_info> start_loading(ff::resource_objects::resource_object_info& info); // must be holding resource_mutex
+        void run_group_node(std::shared_ptr<ff::resource_objects::resource_group_load> group, size_t index);
         void update_resource_object_info(std::shared_ptr<ff::resource_objects::resource_object_loading_info> loading_info, ff::value_ptr new_value);
         ff::value_ptr create_resource_objects(std::shared_ptr<ff::resource_objects::resource_object_loading_info> loading_info, ff::value_ptr value);
         std::shared_ptr<ff::resource> get_resource_object_here(std::string_view name);
@@ -92,7 +116,8 @@ namespace ff
         mutable std::recursive_mutex resource_mutex;
         std::unique_ptr<std::vector<std::shared_ptr<ff::saved_data_base>>> resource_metadata_saved;
         std::unique_ptr<ff::dict> resource_metadata_dict;
-        std::unordered_map<std::string_view, ff::resource_objects::resource_object_info> resource_infos;
+        mutable std::unordered_map<std::string_view, ff::resource_objects::resource_object_info> resource_infos;
+        mutable std::vector<std::shared_ptr<ff::resource_objects::resource_pack>> resource_packs; // only moved into resource_infos when needed
 
         std::atomic<int> loading_count;
         ff::win_event done_loading_event;
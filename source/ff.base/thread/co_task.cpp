@@ -2,40 +2,135 @@
 #include "thread/co_task.h"
 #include "thread/thread_pool.h"
 
-ff::internal::co_data_base::~co_data_base()
+static thread_local bool frame_cache_destroyed{};
+
+namespace
 {
-    continuation_type continuations;
+    /// <summary>
+    /// Recycles coroutine frames by size class. Frames are often freed on a different thread than they were
+    /// allocated on, so each cache is capped and the rest go back to the heap.
+    /// </summary>
+    class co_frame_cache
     {
-        std::scoped_lock lock(this->mutex);
-        std::swap(continuations, this->continuations);
-    }
+    public:
+        static constexpr size_t class_size = 64;
+        static constexpr size_t class_count = 32;
+        static constexpr size_t max_cached_per_class = 64;
 
-    continuations.reverse();
-    for (const auto& continuation : continuations)
-    {
-        continuation(false);
-    }
+        ~co_frame_cache()
+        {
+            for (free_frame* frame : this->free_frames)
+            {
+                while (frame)
+                {
+                    free_frame* next = frame->next;
+                    ::operator delete(frame);
+                    frame = next;
+                }
+            }
+
+            ::frame_cache_destroyed = true;
+        }
+
+        void* allocate(size_t size)
+        {
+            const size_t index = (size + class_size - 1) / class_size - 1;
+            if (index >= class_count)
+            {
+                return ::operator new(size);
+            }
+
+            free_frame* frame = this->free_frames[index];
+            if (frame)
+            {
+                this->free_frames[index] = frame->next;
+                this->free_counts[index]--;
+                return frame;
+            }
+
+            return ::operator new((index + 1) * class_size);
+        }
+
+        void deallocate(void* ptr, size_t size)
+        {
+            const size_t index = (size + class_size - 1) / class_size - 1;
+            if (index >= class_count || this->free_counts[index] >= max_cached_per_class)
+            {
+                ::operator delete(ptr);
+                return;
+            }
 
-    assert(this->continuations.empty());
+            free_frame* frame = static_cast<free_frame*>(ptr);
+            frame->next = this->free_frames[index];
+            this->free_frames[index] = frame;
+            this->free_counts[index]++;
+        }
+
+    private:
+        struct free_frame
+        {
+            free_frame* next;
+        };
+
+        std::array<free_frame*, class_count> free_frames{};
+        std::array<size_t, class_count> free_counts{};
+    };
 }
 
-bool ff::internal::co_data_base::done() const
+static thread_local ::co_frame_cache frame_cache;
+
+void* ff::internal::co_frame_allocator::operator new(size_t size)
 {
-    bool done_value = this->done_;
-    if (!done_value)
+    return ::frame_cache_destroyed ? ::operator new(std::max(size, ::co_frame_cache::class_size)) : ::frame_cache.allocate(size);
+}
+
+void ff::internal::co_frame_allocator::operator delete(void* ptr, size_t size)
+{
+    if (::frame_cache_destroyed)
     {
-        std::scoped_lock lock(this->mutex);
-        done_value = this->done_;
+        ::operator delete(ptr);
+    }
+    else
+    {
+        ::frame_cache.deallocate(ptr, size);
     }
+}
 
-    return done_value;
+ff::internal::co_data_base::~co_data_base()
+{
+    continuation_func first;
+    continuation_type others;
+    this->take_continuations(first, others);
+    ff::internal::co_data_base::run_continuations(first, others, false);
+}
+
+bool ff::internal::co_data_base::done() const
+{
+    return this->done_.load(std::memory_order_acquire);
 }
 
 bool ff::internal::co_data_base::wait(size_t timeout_ms)
 {
-    if (!this->done_ && !this->done_event.wait(timeout_ms))
+    if (!this->done_)
     {
-        return false;
+        ff::win_event* done_event = nullptr;
+        {
+            std::scoped_lock lock(this->mutex);
+            if (!this->done_)
+            {
+                if (!this->done_event)
+                {
+                    this->done_event = std::make_unique<ff::win_event>();
+                }
+
+                done_event = this->done_event.get();
+            }
+        }
+
+        if (done_event && !done_event->wait(timeout_ms))
+        {
+            return false;
+        }
     }
 
     if (this->exception)
@@ -48,48 +143,77 @@ bool ff::internal::co_data_base::wait(size_t timeout_ms)
 
 void ff::internal::co_data_base::continue_with(continuation_func&& continuation)
 {
-    continuation_func run_continuation_now;
     {
         std::scoped_lock lock(this->mutex);
-        if (this->done_)
-        {
-            std::swap(run_continuation_now, continuation);
-        }
-        else
+        if (!this->done_)
         {
-            this->continuations.push_front(std::move(continuation));
+            if (!this->first_continuation)
+            {
+                this->first_continuation = std::move(continuation);
+            }
+            else
+            {
+                this->continuations.push_front(std::move(continuation));
+            }
+
+            return;
         }
     }
 
-    if (run_continuation_now)
-    {
-        assert(this->continuations.empty());
-        run_continuation_now(true);
-    }
+    assert(!this->first_continuation && this->continuations.empty());
+    continuation(true);
 }
 
 void ff::internal::co_data_base::run_continuations()
 {
-    continuation_type continuations;
+    continuation_func first;
+    continuation_type others;
     {
         std::scoped_lock lock(this->mutex);
         assert(!this->done_);
-        std::swap(continuations, this->continuations);
+        first = std::move(this->first_continuation);
+        std::swap(others, this->continuations);
         this->done_ = true;
-        this->done_event.set();
+
+        if (this->done_event)
+        {
+            this->done_event->set();
+        }
     }
 
-    continuations.reverse();
-    for (const auto& continuation : continuations)
+    ff::internal::co_data_base::run_continuations(first, others, true);
+}
+
+void ff::internal::co_data_base::take_continuations(continuation_func& first, continuation_type& others)
+{
+    std::scoped_lock lock(this->mutex);
+    first = std::move(this->first_continuation);
+    std::swap(others, this->continuations);
+}
+
+void ff::internal::co_data_base::run_continuations(continuation_func& first, continuation_type& others, bool resume)
+{
+    if (first)
+    {
+        first(resume);
+    }
+
+    others.reverse();
+    for (const continuation_func& continuation : others)
     {
-        continuation(true);
+        continuation(resume);
     }
 }
 
 void ff::internal::co_data_base::set_exception()
+{
+    this->set_exception(std::current_exception());
+}
+
+void ff::internal::co_data_base::set_exception(std::exception_ptr exception)
 {
     assert(!this->done());
-    this->exception = std::current_exception();
+    this->exception = exception;
 }
 
 ff::internal::co_thread_awaiter ff::task::resume_on_main()
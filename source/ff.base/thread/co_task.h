@@ -3,15 +3,20 @@
 #include "../base/assert.h"
 #include "../base/constants.h"
 #include "../thread/thread_dispatch.h"
+#include "../types/inline_function.h"
 
 namespace ff::internal
 {
     /// <summary>
     /// Coroutine data shared between the promise and task
     /// </summary>
+    /// <remarks>
+    /// The first continuation is stored inline since there is usually only one awaiter,
+    /// and the wait event is only created if some thread actually needs to block in wait().
+    /// </remarks>
     class co_data_base
     {
-        using continuation_func = typename std::function<void(bool)>;
+        using continuation_func = typename ff::inline_function<void(bool)>;
         using continuation_type = typename std::forward_list<continuation_func>;
 
     public:
@@ -22,13 +27,27 @@ namespace ff::internal
         void continue_with(continuation_func&& continuation);
         void run_continuations();
         void set_exception();
+        void set_exception(std::exception_ptr exception);
 
     private:
+        void take_continuations(continuation_func& first, continuation_type& others);
+        static void run_continuations(continuation_func& first, continuation_type& others, bool resume);
+
         mutable std::mutex mutex;
-        ff::win_event done_event;
+        std::unique_ptr<ff::win_event> done_event;
+        continuation_func first_continuation;
         continuation_type continuations;
         std::exception_ptr exception{};
-        bool done_{};
+        std::atomic_bool done_{};
+    };
+
+    /// <summary>
+    /// Coroutine frames are allocated through this, it recycles frames in a per-thread cache
+    /// </summary>
+    struct co_frame_allocator
+    {
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
     };
 
     template<class T>
@@ -123,7 +142,7 @@ namespace ff::internal
     };
 
     template<class Task, class T = typename Task::result_type>
-    class co_promise
+    class co_promise : public ff::internal::co_frame_allocator
     {
     public:
         using this_type = typename ff::internal::co_promise<Task>;
@@ -165,7 +184,7 @@ namespace ff::internal
     };
 
     template<class Task>
-    class co_promise<Task, void>
+    class co_promise<Task, void> : public ff::internal::co_frame_allocator
     {
     public:
         using this_type = typename ff::internal::co_promise<Task>;
@@ -313,6 +332,13 @@ namespace ff
             this->data_->set_result(std::move(value));
             this->data_->run_continuations();
         }
+
+        void set_exception(std::exception_ptr exception) const
+        {
+            assert(this->valid() && !this->done());
+            this->data_->set_exception(exception);
+            this->data_->run_continuations();
+        }
     };
 
     template<>
@@ -349,6 +375,13 @@ namespace ff
             this->data_->set_result();
             this->data_->run_continuations();
         }
+
+        void set_exception(std::exception_ptr exception) const
+        {
+            assert(this->valid() && !this->done());
+            this->data_->set_exception(exception);
+            this->data_->run_continuations();
+        }
     };
 }
 
@@ -0,0 +1,381 @@
+#include "pch.h"
+#include "base/assert.h"
+#include "base/math.h"
+#include "thread/job_system.h"
+#include "thread/thread_pool.h"
+#include "types/stack_vector.h"
+
+static thread_local ff::job_system* current_job_system{};
+static thread_local size_t current_worker_index{};
+static thread_local ff::internal::job_data* current_job_data{};
+static thread_local size_t wait_nesting{};
+
+static bool is_job_in_tree(const ff::internal::job_data* job, const ff::internal::job_data* root)
+{
+    // Parents stay set until a job finishes, so this works for any job that's still queued
+    for (; job; job = job->parent.get())
+    {
+        if (job == root)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+ff::internal::job_data::job_data(ff::job_system* owner, ff::job_func&& func, ff::internal::job_data* parent)
+    : owner(owner)
+    , func(std::move(func))
+    , parent(parent)
+    , has_exception(false)
+    , unfinished(1)
+    , refs(0)
+{}
+
+void ff::internal::job_data::add_ref()
+{
+    this->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ff::internal::job_data::release_ref()
+{
+    if (this->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        this->owner->delete_job(this);
+    }
+}
+
+void ff::internal::job_data::set_exception(const std::exception_ptr& exception)
+{
+    if (!this->has_exception.exchange(true, std::memory_order_acq_rel))
+    {
+        this->exception = exception;
+    }
+}
+
+ff::job_handle::job_handle(ff::internal::job_data* data)
+    : data_(data)
+{}
+
+ff::job_handle::operator bool() const
+{
+    return this->valid();
+}
+
+bool ff::job_handle::valid() const
+{
+    return this->data_ != nullptr;
+}
+
+bool ff::job_handle::done() const
+{
+    return !this->valid() || !this->data_->unfinished.load(std::memory_order_acquire);
+}
+
+void ff::job_handle::wait() const
+{
+    if (this->valid())
+    {
+        this->data_->owner->wait(*this);
+    }
+}
+
+ff::internal::job_data* ff::job_handle::data() const
+{
+    return this->data_.get();
+}
+
+ff::job_system::job_system(size_t thread_count)
+    : inject_size(0)
+    , pending_jobs(0)
+    , wake_counter(0)
+    , sleeping_workers(0)
+    , stopping(false)
+{
+    thread_count = thread_count ? thread_count : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    this->workers.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        this->workers.push_back(std::make_unique<worker_t>());
+    }
+
+    // Don't start any thread until all workers exist, they steal from each other
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        this->workers[i]->thread = std::jthread(&ff::job_system::worker_thread, this, i);
+    }
+}
+
+ff::job_system::~job_system()
+{
+    this->wait_idle();
+    this->stopping.store(true);
+    this->wake_counter.fetch_add(1);
+    this->wake_counter.notify_all();
+
+    for (std::unique_ptr<worker_t>& worker : this->workers)
+    {
+        worker->thread.join();
+    }
+
+    this->workers.clear();
+    this->job_pool.reduce_if_empty();
+}
+
+ff::job_handle ff::job_system::run(ff::job_func&& func, const ff::job_handle& parent)
+{
+    assert(!parent.valid() || parent.data()->owner == this);
+
+    ff::internal::job_data* parent_data = parent.data();
+    if (parent_data)
+    {
+        // The parent can't finish until this child finishes
+        parent_data->unfinished.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ff::internal::job_data* job = this->job_pool.new_obj(this, std::move(func), parent_data);
+    ff::job_handle handle(job);
+
+    this->pending_jobs.fetch_add(1, std::memory_order_relaxed);
+    job->add_ref(); // owned by the queue until executed
+    this->push(job);
+
+    return handle;
+}
+
+void ff::job_system::wait(const ff::job_handle& job)
+{
+    ff::internal::job_data* data = job.data();
+    assert_ret(data && data->owner == this);
+
+    // Jobs run while waiting nest on this thread's stack, so after a while only run jobs that this one is waiting for
+    const bool run_any_job = ::wait_nesting < ff::job_system::max_wait_nesting;
+    ::wait_nesting++;
+
+    while (int unfinished = data->unfinished.load(std::memory_order_acquire))
+    {
+        ff::internal::job_data* other_job = run_any_job ? this->find_job() : this->find_job(data);
+        if (other_job)
+        {
+            this->execute(other_job);
+        }
+        else
+        {
+            data->unfinished.wait(unfinished, std::memory_order_acquire);
+        }
+    }
+
+    ::wait_nesting--;
+
+    if (data->exception)
+    {
+        std::rethrow_exception(data->exception);
+    }
+}
+
+void ff::job_system::wait_idle()
+{
+    assert_msg_ret(!::current_job_data, "A job can't wait for all jobs to finish, including itself");
+
+    while (size_t pending = this->pending_jobs.load(std::memory_order_acquire))
+    {
+        ff::internal::job_data* other_job = this->find_job();
+        if (other_job)
+        {
+            this->execute(other_job);
+        }
+        else
+        {
+            this->pending_jobs.wait(pending, std::memory_order_acquire);
+        }
+    }
+}
+
+bool ff::job_system::current_thread() const
+{
+    return ::current_job_system == this;
+}
+
+size_t ff::job_system::thread_count() const
+{
+    return this->workers.size();
+}
+
+ff::job_handle ff::job_system::current_job()
+{
+    return ff::job_handle(::current_job_data);
+}
+
+void ff::job_system::worker_thread(size_t index)
+{
+    ff::set_thread_name("ff::job_system::worker");
+    ::current_job_system = this;
+    ::current_worker_index = index;
+
+    while (true)
+    {
+        ff::internal::job_data* job = this->find_job();
+        if (job)
+        {
+            this->execute(job);
+            continue;
+        }
+
+        // Check again after reading the counter so that a push can't be missed before sleeping
+        uint32_t wake_value = this->wake_counter.load();
+        if ((job = this->find_job()) != nullptr)
+        {
+            this->execute(job);
+            continue;
+        }
+
+        if (this->stopping.load())
+        {
+            break;
+        }
+
+        this->sleeping_workers.fetch_add(1);
+        this->wake_counter.wait(wake_value);
+        this->sleeping_workers.fetch_sub(1);
+    }
+
+    ::current_job_system = nullptr;
+}
+
+void ff::job_system::push(ff::internal::job_data* job)
+{
+    if (::current_job_system == this)
+    {
+        this->workers[::current_worker_index]->queue.push(job);
+    }
+    else
+    {
+        std::scoped_lock lock(this->inject_mutex);
+        this->inject_queue.push_back(job);
+        this->inject_size.fetch_add(1, std::memory_order_release);
+    }
+
+    this->wake_counter.fetch_add(1);
+
+    if (this->sleeping_workers.load())
+    {
+        this->wake_counter.notify_one();
+    }
+}
+
+ff::internal::job_data* ff::job_system::find_job()
+{
+    const size_t worker_count = this->workers.size();
+    const bool is_worker = (::current_job_system == this);
+    ff::internal::job_data* job = nullptr;
+
+    if (is_worker && (job = this->workers[::current_worker_index]->queue.pop()) != nullptr)
+    {
+        return job;
+    }
+
+    if (this->inject_size.load(std::memory_order_acquire))
+    {
+        std::scoped_lock lock(this->inject_mutex);
+        if (!this->inject_queue.empty())
+        {
+            job = this->inject_queue.front();
+            this->inject_queue.pop_front();
+            this->inject_size.fetch_sub(1, std::memory_order_release);
+            return job;
+        }
+    }
+
+    const size_t start = is_worker ? ::current_worker_index + 1 : static_cast<size_t>(ff::math::random_non_negative());
+    for (size_t i = 0; i < worker_count; i++)
+    {
+        worker_t& victim = *this->workers[(start + i) % worker_count];
+        if (!victim.queue.empty() && (job = victim.queue.steal()) != nullptr)
+        {
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+// Only looks at this worker's own queue, where a waiting job's children usually are. Other jobs are put back in the same order.
+ff::internal::job_data* ff::job_system::find_job(const ff::internal::job_data* root)
+{
+    if (::current_job_system != this)
+    {
+        return nullptr;
+    }
+
+    ff::work_stealing_queue<ff::internal::job_data*>& queue = this->workers[::current_worker_index]->queue;
+    ff::stack_vector<ff::internal::job_data*, 16> other_jobs;
+    ff::internal::job_data* job;
+
+    while ((job = queue.pop()) != nullptr && !::is_job_in_tree(job, root))
+    {
+        other_jobs.push_back(job);
+    }
+
+    for (size_t i = other_jobs.size(); i > 0; i--)
+    {
+        queue.push(other_jobs[i - 1]);
+    }
+
+    return job;
+}
+
+void ff::job_system::execute(ff::internal::job_data* job)
+{
+    ff::internal::job_data* old_job = ::current_job_data;
+    ::current_job_data = job;
+
+    if (job->func)
+    {
+        try
+        {
+            job->func();
+        }
+        catch (...)
+        {
+            job->set_exception(std::current_exception());
+        }
+
+        job->func = nullptr;
+    }
+
+    ::current_job_data = old_job;
+
+    this->finish(job);
+    job->release_ref(); // from the queue
+}
+
+void ff::job_system::finish(ff::internal::job_data* job)
+{
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        ff::intrusive_ptr<ff::internal::job_data> parent = std::move(job->parent);
+        if (parent && job->exception)
+        {
+            parent->set_exception(job->exception);
+        }
+
+        job->unfinished.notify_all();
+
+        if (this->pending_jobs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            this->pending_jobs.notify_all();
+        }
+
+        if (parent)
+        {
+            this->finish(parent.get());
+        }
+    }
+}
+
+void ff::job_system::delete_job(ff::internal::job_data* job)
+{
+    this->job_pool.delete_obj(job);
+}
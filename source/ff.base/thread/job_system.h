@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../thread/work_stealing_queue.h"
+#include "../types/inline_function.h"
+#include "../types/intrusive_ptr.h"
+#include "../types/pool_allocator.h"
+
+namespace ff
+{
+    class job_system;
+
+    using job_func = typename ff::inline_function<void()>;
+}
+
+namespace ff::internal
+{
+    struct job_data
+    {
+        job_data(ff::job_system* owner, ff::job_func&& func, ff::internal::job_data* parent);
+        job_data(job_data&& other) noexcept = delete;
+        job_data(const job_data& other) = delete;
+        job_data& operator=(job_data&& other) noexcept = delete;
+        job_data& operator=(const job_data& other) = delete;
+
+        void add_ref();
+        void release_ref();
+        void set_exception(const std::exception_ptr& exception);
+
+        ff::job_system* owner;
+        ff::job_func func;
+        ff::intrusive_ptr<ff::internal::job_data> parent;
+        std::exception_ptr exception; // first one thrown by this job or a child job, only read after unfinished is zero
+        std::atomic_bool has_exception;
+        std::atomic_int unfinished; // this job plus any child jobs that haven't finished yet
+        std::atomic_int refs;
+    };
+}
+
+namespace ff
+{
+    /// <summary>
+    /// Reference to a job that was added to a job_system, used to wait for it and its child jobs
+    /// </summary>
+    class job_handle
+    {
+    public:
+        job_handle() = default;
+        job_handle(ff::internal::job_data* data);
+        job_handle(job_handle&& other) noexcept = default;
+        job_handle(const job_handle& other) = default;
+
+        job_handle& operator=(job_handle&& other) noexcept = default;
+        job_handle& operator=(const job_handle& other) = default;
+
+        operator bool() const;
+        bool valid() const;
+        bool done() const;
+        void wait() const;
+        ff::internal::job_data* data() const;
+
+    private:
+        ff::intrusive_ptr<ff::internal::job_data> data_;
+    };
+
+    /// <summary>
+    /// Work stealing scheduler for short jobs that don't block
+    /// </summary>
+    /// <remarks>
+    /// Each worker thread owns a Chase-Lev deque. Jobs added from a worker go onto its own deque and idle
+    /// workers steal from the others. Jobs added from any other thread go through a shared injection queue.
+    /// A job isn't done until all of its child jobs are done, and waiting for a job on a worker thread
+    /// runs other jobs instead of blocking. Those jobs nest on the waiting thread's stack, so after
+    /// max_wait_nesting levels a waiting thread only runs jobs that belong to the job it's waiting for.
+    /// If a job or any of its child jobs throws, wait() rethrows the first exception.
+    /// Only the C++ standard library is used for threads and waiting.
+    /// </remarks>
+    class job_system
+    {
+    public:
+        job_system(size_t thread_count = 0);
+        job_system(job_system&& other) noexcept = delete;
+        job_system(const job_system& other) = delete;
+        ~job_system();
+
+        job_system& operator=(job_system&& other) noexcept = delete;
+        job_system& operator=(const job_system& other) = delete;
+
+        ff::job_handle run(ff::job_func&& func, const ff::job_handle& parent = {});
+        void wait(const ff::job_handle& job);
+        void wait_idle();
+        bool current_thread() const;
+        size_t thread_count() const;
+
+        static ff::job_handle current_job();
+        static constexpr size_t max_wait_nesting = 16;
+
+    private:
+        friend struct ff::internal::job_data;
+
+        struct worker_t
+        {
+            ff::work_stealing_queue<ff::internal::job_data*> queue;
+            std::jthread thread;
+        };
+
+        void worker_thread(size_t index);
+        void push(ff::internal::job_data* job);
+        ff::internal::job_data* find_job();
+        ff::internal::job_data* find_job(const ff::internal::job_data* root);
+        void execute(ff::internal::job_data* job);
+        void finish(ff::internal::job_data* job);
+        void delete_job(ff::internal::job_data* job);
+
+        ff::pool_allocator<ff::internal::job_data> job_pool;
+        std::vector<std::unique_ptr<worker_t>> workers;
+        std::mutex inject_mutex;
+        std::deque<ff::internal::job_data*> inject_queue;
+        std::atomic_size_t inject_size;
+        std::atomic_size_t pending_jobs;
+        std::atomic_uint32_t wake_counter;
+        std::atomic_size_t sleeping_workers;
+        std::atomic_bool stopping;
+    };
+}
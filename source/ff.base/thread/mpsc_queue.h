@@ -0,0 +1,98 @@
+#pragma once
+
+namespace ff
+{
+    /// <summary>
+    /// Base class for items in an ff::mpsc_queue
+    /// </summary>
+    struct mpsc_node
+    {
+        std::atomic<ff::mpsc_node*> mpsc_next{};
+    };
+
+    /// <summary>
+    /// Intrusive lock-free multi-producer single-consumer FIFO queue
+    /// </summary>
+    /// <remarks>
+    /// Any thread can push(), only one thread at a time can pop(). Pushing is a single atomic exchange.
+    /// The queue doesn't own its items, T must derive from ff::mpsc_node.
+    /// pop() can return nullptr while a push is half way done on another thread, so callers that need to
+    /// see every item must track their own count (see ff::thread_dispatch).
+    /// Based on Dmitry Vyukov's intrusive MPSC node-based queue.
+    /// </remarks>
+    template<class T>
+    class mpsc_queue
+    {
+        static_assert(std::is_base_of_v<ff::mpsc_node, T>);
+
+    public:
+        mpsc_queue()
+            : head(&this->stub)
+            , tail(&this->stub)
+        {}
+
+        mpsc_queue(mpsc_queue&& other) noexcept = delete;
+        mpsc_queue(const mpsc_queue& other) = delete;
+        mpsc_queue& operator=(mpsc_queue&& other) noexcept = delete;
+        mpsc_queue& operator=(const mpsc_queue& other) = delete;
+
+        void push(T* item)
+        {
+            this->push_node(item);
+        }
+
+        T* pop()
+        {
+            ff::mpsc_node* tail = this->tail;
+            ff::mpsc_node* next = tail->mpsc_next.load(std::memory_order_acquire);
+
+            if (tail == &this->stub)
+            {
+                if (!next)
+                {
+                    return nullptr;
+                }
+
+                this->tail = next;
+                tail = next;
+                next = next->mpsc_next.load(std::memory_order_acquire);
+            }
+
+            if (next)
+            {
+                this->tail = next;
+                return static_cast<T*>(tail);
+            }
+
+            if (tail != this->head.load(std::memory_order_acquire))
+            {
+                // A push is in progress
+                return nullptr;
+            }
+
+            // Put the stub back so that the last real item can be removed
+            this->push_node(&this->stub);
+
+            next = tail->mpsc_next.load(std::memory_order_acquire);
+            if (next)
+            {
+                this->tail = next;
+                return static_cast<T*>(tail);
+            }
+
+            return nullptr;
+        }
+
+    private:
+        void push_node(ff::mpsc_node* node)
+        {
+            node->mpsc_next.store(nullptr, std::memory_order_relaxed);
+            ff::mpsc_node* prev = this->head.exchange(node, std::memory_order_acq_rel);
+            prev->mpsc_next.store(node, std::memory_order_release);
+        }
+
+        alignas(std::hardware_destructive_interference_size) std::atomic<ff::mpsc_node*> head;
+        alignas(std::hardware_destructive_interference_size) ff::mpsc_node* tail;
+        ff::mpsc_node stub;
+    };
+}
@@ -0,0 +1,14 @@
+#include "pch.h"
+#include "thread/parallel.h"
+
+size_t ff::internal::parallel::chunk_size(const ff::job_system* jobs, size_t count, size_t grain)
+{
+    if (!grain)
+    {
+        // A few chunks per thread leaves room for stealing to balance out uneven work
+        const size_t thread_count = jobs ? jobs->thread_count() : 1;
+        grain = count / (thread_count * 4);
+    }
+
+    return std::max<size_t>(grain, 1);
+}
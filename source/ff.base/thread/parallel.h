@@ -0,0 +1,259 @@
+#pragma once
+
+#include "../thread/co_task.h"
+#include "../thread/job_system.h"
+#include "../thread/thread_pool.h"
+
+namespace ff::internal::parallel
+{
+    /// <summary>
+    /// Shared by all chunks of one parallel call, the last chunk to finish completes the task
+    /// </summary>
+    template<class Task>
+    struct chunk_state
+    {
+        chunk_state(const Task& task, size_t chunk_count)
+            : task(task)
+            , remaining(chunk_count)
+        {}
+
+        void set_exception()
+        {
+            std::scoped_lock lock(this->exception_mutex);
+            if (!this->exception)
+            {
+                this->exception = std::current_exception();
+            }
+        }
+
+        // Returns true for the last chunk to finish
+        bool finish_chunk()
+        {
+            return this->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+
+        Task task;
+        std::atomic_size_t remaining;
+        std::mutex exception_mutex;
+        std::exception_ptr exception;
+    };
+
+    size_t chunk_size(const ff::job_system* jobs, size_t count, size_t grain);
+
+    /// <summary>
+    /// Adds one job that fans out the rest of the chunks from a worker thread, so they go onto a
+    /// worker's own deque (and get stolen) rather than through the shared injection queue.
+    /// </summary>
+    template<class ChunkFunc>
+    void run_chunks(ff::job_system& jobs, size_t chunk_count, ChunkFunc&& chunk_func)
+    {
+        jobs.run([&jobs, chunk_count, chunk_func = std::forward<ChunkFunc>(chunk_func)]()
+            {
+                for (size_t i = 1; i < chunk_count; i++)
+                {
+                    jobs.run([chunk_func, i]()
+                        {
+                            chunk_func(i);
+                        });
+                }
+
+                chunk_func(0);
+            });
+    }
+}
+
+namespace ff
+{
+    /// <summary>
+    /// Calls func(index) for every index in [begin, end) using the job system
+    /// </summary>
+    /// <remarks>
+    /// The range is split into chunks of about grain indexes each (0 picks a grain based on the thread count).
+    /// The returned task completes after every index is done, so it can be waited on or awaited from a coroutine.
+    /// If func throws, the first exception is rethrown by the task.
+    /// </remarks>
+    template<class Func>
+    ff::co_task<> parallel_for(ff::job_system* jobs, size_t begin, size_t end, size_t grain, Func&& func)
+    {
+        const size_t count = (end > begin) ? end - begin : 0;
+        const size_t chunk_size = ff::internal::parallel::chunk_size(jobs, count, grain);
+        const size_t chunk_count = count ? (count + chunk_size - 1) / chunk_size : 0;
+
+        if (chunk_count <= 1 || !jobs)
+        {
+            // Runs inline, but exceptions still go through the task like they do for chunks
+            try
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    func(i);
+                }
+            }
+            catch (...)
+            {
+                ff::co_task_source<void> task = ff::co_task_source<void>::create();
+                task.set_exception(std::current_exception());
+                return task;
+            }
+
+            return ff::co_task_source<void>::from_result();
+        }
+
+        struct for_state : public ff::internal::parallel::chunk_state<ff::co_task_source<void>>
+        {
+            for_state(size_t chunk_count, Func&& func)
+                : ff::internal::parallel::chunk_state<ff::co_task_source<void>>(ff::co_task_source<void>::create(), chunk_count)
+                , func(std::forward<Func>(func))
+            {}
+
+            std::decay_t<Func> func;
+        };
+
+        auto state = std::make_shared<for_state>(chunk_count, std::forward<Func>(func));
+        ff::co_task<> task = state->task;
+
+        ff::internal::parallel::run_chunks(*jobs, chunk_count, [state, begin, end, chunk_size](size_t chunk)
+            {
+                const size_t chunk_begin = begin + chunk * chunk_size;
+                const size_t chunk_end = std::min(chunk_begin + chunk_size, end);
+
+                try
+                {
+                    for (size_t i = chunk_begin; i < chunk_end; i++)
+                    {
+                        state->func(i);
+                    }
+                }
+                catch (...)
+                {
+                    state->set_exception();
+                }
+
+                if (state->finish_chunk())
+                {
+                    if (state->exception)
+                    {
+                        state->task.set_exception(state->exception);
+                    }
+                    else
+                    {
+                        state->task.set_result();
+                    }
+                }
+            });
+
+        return task;
+    }
+
+    template<class Func>
+    ff::co_task<> parallel_for(size_t begin, size_t end, size_t grain, Func&& func)
+    {
+        return ff::parallel_for(ff::thread_pool::job_system(), begin, end, grain, std::forward<Func>(func));
+    }
+
+    /// <summary>
+    /// Maps every index in [begin, end) to a value with map_func(index) and combines them with reduce_func(a, b)
+    /// </summary>
+    /// <remarks>
+    /// Each chunk reduces its own indexes starting from identity, then the chunk results are reduced in order
+    /// by whichever chunk finishes last. So reduce_func only needs to be associative, not commutative,
+    /// and the result doesn't depend on thread timing.
+    /// </remarks>
+    template<class T, class MapFunc, class ReduceFunc>
+    ff::co_task<T> parallel_reduce(ff::job_system* jobs, size_t begin, size_t end, size_t grain, const T& identity, MapFunc&& map_func, ReduceFunc&& reduce_func)
+    {
+        const size_t count = (end > begin) ? end - begin : 0;
+        const size_t chunk_size = ff::internal::parallel::chunk_size(jobs, count, grain);
+        const size_t chunk_count = count ? (count + chunk_size - 1) / chunk_size : 0;
+
+        if (chunk_count <= 1 || !jobs)
+        {
+            try
+            {
+                T value = identity;
+                for (size_t i = begin; i < end; i++)
+                {
+                    value = reduce_func(std::move(value), map_func(i));
+                }
+
+                return ff::co_task_source<T>::from_result(std::move(value));
+            }
+            catch (...)
+            {
+                ff::co_task_source<T> task = ff::co_task_source<T>::create();
+                task.set_exception(std::current_exception());
+                return task;
+            }
+        }
+
+        struct reduce_state : public ff::internal::parallel::chunk_state<ff::co_task_source<T>>
+        {
+            reduce_state(size_t chunk_count, const T& identity, MapFunc&& map_func, ReduceFunc&& reduce_func)
+                : ff::internal::parallel::chunk_state<ff::co_task_source<T>>(ff::co_task_source<T>::create(), chunk_count)
+                , results(chunk_count, identity)
+                , map_func(std::forward<MapFunc>(map_func))
+                , reduce_func(std::forward<ReduceFunc>(reduce_func))
+            {}
+
+            std::vector<T> results;
+            std::decay_t<MapFunc> map_func;
+            std::decay_t<ReduceFunc> reduce_func;
+        };
+
+        auto state = std::make_shared<reduce_state>(chunk_count, identity, std::forward<MapFunc>(map_func), std::forward<ReduceFunc>(reduce_func));
+        ff::co_task<T> task = state->task;
+
+        ff::internal::parallel::run_chunks(*jobs, chunk_count, [state, begin, end, chunk_size](size_t chunk)
+            {
+                const size_t chunk_begin = begin + chunk * chunk_size;
+                const size_t chunk_end = std::min(chunk_begin + chunk_size, end);
+
+                try
+                {
+                    T value = std::move(state->results[chunk]);
+                    for (size_t i = chunk_begin; i < chunk_end; i++)
+                    {
+                        value = state->reduce_func(std::move(value), state->map_func(i));
+                    }
+
+                    state->results[chunk] = std::move(value);
+                }
+                catch (...)
+                {
+                    state->set_exception();
+                }
+
+                if (state->finish_chunk())
+                {
+                    if (state->exception)
+                    {
+                        state->task.set_exception(state->exception);
+                        return;
+                    }
+
+                    try
+                    {
+                        T value = std::move(state->results[0]);
+                        for (size_t i = 1; i < state->results.size(); i++)
+                        {
+                            value = state->reduce_func(std::move(value), std::move(state->results[i]));
+                        }
+
+                        state->task.set_result(std::move(value));
+                    }
+                    catch (...)
+                    {
+                        state->task.set_exception(std::current_exception());
+                    }
+                }
+            });
+
+        return task;
+    }
+
+    template<class T, class MapFunc, class ReduceFunc>
+    ff::co_task<T> parallel_reduce(size_t begin, size_t end, size_t grain, const T& identity, MapFunc&& map_func, ReduceFunc&& reduce_func)
+    {
+        return ff::parallel_reduce(ff::thread_pool::job_system(), begin, end, grain, identity, std::forward<MapFunc>(map_func), std::forward<ReduceFunc>(reduce_func));
+    }
+}
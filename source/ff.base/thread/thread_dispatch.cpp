@@ -14,11 +14,15 @@ namespace ff
     void set_thread_name(std::string_view name);
 }
 
+ff::thread_dispatch::func_node::func_node(std::function<void()>&& func)
+    : func(std::move(func))
+{}
+
 ff::thread_dispatch::thread_dispatch(thread_dispatch_type type)
-    : thread_id(::GetCurrentThreadId())
+    : func_count(0)
+    , post_count(0)
+    , thread_id(::GetCurrentThreadId())
     , destroyed(false)
-    , message_window(ff::window::create_message_window())
-    , message_window_connection(this->message_window.message_sink().connect(std::bind(&thread_dispatch::handle_message, this, std::placeholders::_1, std::placeholders::_2)))
 {
     this->flushed_event.set();
 
@@ -28,6 +32,9 @@ ff::thread_dispatch::thread_dispatch(thread_dispatch_type type)
             assert(!::main_thread_dispatch);
             ::main_thread_dispatch = this;
             ff::set_thread_name("ff::main");
+
+            this->message_window = ff::window::create_message_window();
+            this->message_window_connection = this->message_window.message_sink().connect(std::bind(&thread_dispatch::handle_message, this, std::placeholders::_1, std::placeholders::_2));
             break;
 
         case thread_dispatch_type::game:
@@ -46,10 +53,13 @@ ff::thread_dispatch::thread_dispatch(thread_dispatch_type type)
 
 ff::thread_dispatch::~thread_dispatch()
 {
-    // Don't allow new dispatches
+    // Don't allow new dispatches, and wait for any post that already got past the check.
+    // It could still be waking this thread after its func was queued.
+    this->destroyed = true;
+
+    while (this->post_count.load())
     {
-        std::scoped_lock lock(this->mutex);
-        this->destroyed = true;
+        std::this_thread::yield();
     }
 
     this->flush(true);
@@ -147,27 +157,34 @@ void ff::thread_dispatch::post(std::function<void()>&& func, bool run_if_current
         return;
     }
 
-    std::scoped_lock lock(this->mutex);
+    // Counted before checking destroyed so that the destructor waits until this post is done with the queue and events
+    this->post_count.fetch_add(1);
 
     if (this->destroyed)
     {
+        this->post_count.fetch_sub(1);
         func();
         return;
     }
 
-    bool was_empty = this->funcs.empty();
-    this->funcs.push_front(std::move(func));
+    const size_t previous_count = this->func_count.fetch_add(1);
+    this->funcs.push(this->func_node_pool.new_obj(std::move(func)));
 
-    if (was_empty)
+    if (!previous_count)
     {
-        this->flushed_event.reset();
+        std::scoped_lock lock(this->wake_mutex);
 
-        if (!this->pending_event.is_set())
+        // The dispatch thread may have already run the func and set flushed_event
+        if (this->func_count.load())
         {
+            this->flushed_event.reset();
             this->pending_event.set();
             this->post_flush();
         }
     }
+
+    // The destructor can finish as soon as this is uncounted, so nothing else may be touched after it
+    this->post_count.fetch_sub(1);
 }
 
 bool ff::thread_dispatch::send(std::function<void()>&& func, size_t timeout_ms, bool allow_dispatch)
@@ -311,28 +328,30 @@ void ff::thread_dispatch::flush(bool force)
 
     if (force || this->current_thread())
     {
-        std::forward_list<std::function<void()>> funcs;
-        {
-            std::scoped_lock lock(this->mutex);
-            funcs = std::move(this->funcs);
-        }
+        // Reset before running anything, a post that makes the queue non-empty again will set it
+        this->pending_event.reset();
 
-        while (!funcs.empty())
+        while (this->func_count.load())
         {
-            funcs.reverse();
-            for (auto& func : funcs)
+            func_node* node = this->funcs.pop();
+            if (!node)
             {
-                func();
+                // Another thread is in the middle of a push
+                std::this_thread::yield();
+                continue;
             }
 
-            std::scoped_lock lock(this->mutex);
-            funcs = std::move(this->funcs);
+            // Uncount before running the func, it could flush recursively
+            std::function<void()> func = std::move(node->func);
+            this->func_node_pool.delete_obj(node);
+            this->func_count.fetch_sub(1);
+            func();
+        }
 
-            if (funcs.empty())
-            {
-                this->flushed_event.set();
-                this->pending_event.reset();
-            }
+        std::scoped_lock lock(this->wake_mutex);
+        if (!this->func_count.load())
+        {
+            this->flushed_event.set();
         }
     }
     else
@@ -343,7 +362,10 @@ void ff::thread_dispatch::flush(bool force)
 
 void ff::thread_dispatch::post_flush()
 {
-    ::PostMessage(this->message_window, WM_USER, 0, 0);
+    if (this->message_window)
+    {
+        ::PostMessage(this->message_window, WM_USER, 0, 0);
+    }
 }
 
 void ff::thread_dispatch::handle_message(ff::window* window, ff::window_message& msg)
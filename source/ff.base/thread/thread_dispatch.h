@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../thread/mpsc_queue.h"
+#include "../types/pool_allocator.h"
 #include "../types/signal.h"
 #include "../windows/win_handle.h"
 #include "../windows/window.h"
@@ -44,17 +46,29 @@ namespace ff
         static constexpr size_t maximum_wait_objects = MAXIMUM_WAIT_OBJECTS - 2;
 
     private:
+        struct func_node : public ff::mpsc_node
+        {
+            func_node(std::function<void()>&& func);
+
+            std::function<void()> func;
+        };
+
         void flush(bool force);
         void post_flush();
+        void handle_message(ff::window* window, ff::window_message& msg);
 
-        std::recursive_mutex mutex;
-        std::forward_list<std::function<void()>> funcs;
+        // Posting is lock free, the mutex is only used when the queue goes from empty to not empty and back
+        ff::mpsc_queue<func_node> funcs;
+        ff::pool_allocator<func_node> func_node_pool;
+        std::atomic_size_t func_count;
+        std::atomic_size_t post_count; // posts still using the queue or events, the destructor waits for them
+        std::mutex wake_mutex;
         ff::win_event flushed_event;
         ff::win_event pending_event;
         DWORD thread_id;
-        bool destroyed;
-        void handle_message(ff::window* window, ff::window_message& msg);
+        std::atomic_bool destroyed;
 
+        // Only the main thread needs to wake up from its message loop, other threads wait for pending_event
         ff::window message_window;
         ff::signal_connection message_window_connection;
     };
@@ -41,6 +41,7 @@ static TP_CALLBACK_ENVIRON pool_env{};
 static PTP_CLEANUP_GROUP pool_cleanup{};
 static size_t next_data_handle{ 1 }; // odd numbers are for data_map lookups, otherwise it's a ::task_data_t*
 static std::unordered_map<size_t, std::unique_ptr<::task_data_t>, ff::no_hash<size_t>> data_map;
+static std::unique_ptr<ff::job_system> job_system;
 
 static std::tuple<FILETIME, bool> delay_to_filetime(size_t delay_ms)
 {
@@ -154,6 +155,11 @@ static void flush(bool destroying)
 
     std::jthread([&data_map]()
         {
+            if (::job_system)
+            {
+                ::job_system->wait_idle();
+            }
+
             for (auto i = data_map.begin(); i != data_map.end(); i++)
             {
                 i->second->func();
@@ -178,6 +184,7 @@ void ff::internal::thread_pool::init()
     ::InitializeThreadpoolEnvironment(&::pool_env);
     ::pool_cleanup = ::CreateThreadpoolCleanupGroup();
     ::SetThreadpoolCallbackCleanupGroup(&::pool_env, ::pool_cleanup, nullptr);
+    ::job_system = std::make_unique<ff::job_system>();
     ::pool_valid = true;
 }
 
@@ -186,6 +193,7 @@ void ff::internal::thread_pool::destroy()
     assert(::pool_valid);
 
     ::flush(true);
+    ::job_system.reset();
 
     std::scoped_lock lock(::mutex);
     ::CloseThreadpoolCleanupGroup(::pool_cleanup);
@@ -226,6 +234,22 @@ void ff::thread_pool::add_wait(std::function<void()>&& func, HANDLE handle, size
     }
 }
 
+ff::job_handle ff::thread_pool::add_job(ff::job_func&& func, const ff::job_handle& parent)
+{
+    if (::pool_valid)
+    {
+        return ::job_system->run(std::move(func), parent);
+    }
+
+    func();
+    return {};
+}
+
+ff::job_system* ff::thread_pool::job_system()
+{
+    return ::job_system.get();
+}
+
 void ff::set_thread_name(std::string_view name)
 {
     if constexpr (ff::constants::debug_build)
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../thread/job_system.h"
+
 namespace ff
 {
     void set_thread_name(std::string_view name);
@@ -11,6 +13,9 @@ namespace ff::thread_pool
     void add_timer(std::function<void()>&& func, size_t delay_ms, std::stop_token stop = {});
     void add_wait(std::function<void()>&& func, HANDLE handle, size_t timeout_ms = INFINITE);
     void flush();
+
+    ff::job_handle add_job(ff::job_func&& func, const ff::job_handle& parent = {});
+    ff::job_system* job_system();
 }
 
 namespace ff::internal::thread_pool
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "../base/math.h"
+
+namespace ff
+{
+    /// <summary>
+    /// Chase-Lev work stealing deque of pointers
+    /// </summary>
+    /// <remarks>
+    /// Only the owning thread may call push() and pop(), which work on the bottom of the deque.
+    /// Any thread may call steal(), which takes from the top. The buffer grows as needed and old buffers
+    /// are kept alive until the queue is destroyed since a thief could still be reading from them.
+    /// See "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Nardelli 2013).
+    /// </remarks>
+    template<class T>
+    class work_stealing_queue
+    {
+        static_assert(std::is_pointer_v<T>);
+
+    public:
+        work_stealing_queue(size_t capacity = 256)
+            : ring(std::make_unique<ring_t>(ff::math::nearest_power_of_two(std::max<size_t>(capacity, 16))))
+            , buffer(ring.get())
+        {}
+
+        work_stealing_queue(work_stealing_queue&& other) noexcept = delete;
+        work_stealing_queue(const work_stealing_queue& other) = delete;
+        work_stealing_queue& operator=(work_stealing_queue&& other) noexcept = delete;
+        work_stealing_queue& operator=(const work_stealing_queue& other) = delete;
+
+        void push(T item)
+        {
+            int64_t b = this->bottom.load(std::memory_order_relaxed);
+            int64_t t = this->top.load(std::memory_order_acquire);
+            ring_t* a = this->buffer.load(std::memory_order_relaxed);
+
+            if (b - t > static_cast<int64_t>(a->mask))
+            {
+                a = this->grow(a, b, t);
+            }
+
+            a->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        T pop()
+        {
+            int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+            ring_t* a = this->buffer.load(std::memory_order_relaxed);
+            this->bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = this->top.load(std::memory_order_relaxed);
+            T item = nullptr;
+
+            if (t <= b)
+            {
+                item = a->get(b);
+
+                if (t == b)
+                {
+                    // Racing against thieves for the last item
+                    if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    {
+                        item = nullptr;
+                    }
+
+                    this->bottom.store(b + 1, std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                this->bottom.store(b + 1, std::memory_order_relaxed);
+            }
+
+            return item;
+        }
+
+        T steal()
+        {
+            int64_t t = this->top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = this->bottom.load(std::memory_order_acquire);
+
+            if (t < b)
+            {
+                ring_t* a = this->buffer.load(std::memory_order_acquire);
+                T item = a->get(t);
+
+                if (this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return item;
+                }
+            }
+
+            return nullptr;
+        }
+
+        bool empty() const
+        {
+            return this->bottom.load(std::memory_order_relaxed) <= this->top.load(std::memory_order_relaxed);
+        }
+
+        size_t size() const
+        {
+            int64_t count = this->bottom.load(std::memory_order_relaxed) - this->top.load(std::memory_order_relaxed);
+            return static_cast<size_t>(std::max<int64_t>(count, 0));
+        }
+
+    private:
+        struct ring_t
+        {
+            ring_t(size_t capacity)
+                : mask(capacity - 1)
+                , items(std::make_unique<std::atomic<T>[]>(capacity))
+            {}
+
+            T get(int64_t index) const
+            {
+                return this->items[static_cast<size_t>(index) & this->mask].load(std::memory_order_relaxed);
+            }
+
+            void put(int64_t index, T item)
+            {
+                this->items[static_cast<size_t>(index) & this->mask].store(item, std::memory_order_relaxed);
+            }
+
+            size_t mask;
+            std::unique_ptr<std::atomic<T>[]> items;
+            std::unique_ptr<ring_t> previous;
+        };
+
+        ring_t* grow(ring_t* old_ring, int64_t b, int64_t t)
+        {
+            std::unique_ptr<ring_t> new_ring = std::make_unique<ring_t>((old_ring->mask + 1) * 2);
+
+            for (int64_t i = t; i < b; i++)
+            {
+                new_ring->put(i, old_ring->get(i));
+            }
+
+            new_ring->previous = std::move(this->ring);
+            this->ring = std::move(new_ring);
+            this->buffer.store(this->ring.get(), std::memory_order_release);
+
+            return this->ring.get();
+        }
+
+        std::unique_ptr<ring_t> ring; // owns all rings, newest first
+        alignas(std::hardware_destructive_interference_size) std::atomic<int64_t> top{};
+        alignas(std::hardware_destructive_interference_size) std::atomic<int64_t> bottom{};
+        std::atomic<ring_t*> buffer;
+    };
+}
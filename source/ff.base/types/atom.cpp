@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "types/atom.h"
+
+// Buckets are constant initialized, so atoms work during static init. Each bucket is a list that only grows at the front.
+static constexpr size_t atom_bucket_count = 8192;
+static std::atomic<const ff::internal::atom_data*> atom_buckets[::atom_bucket_count];
+
+static const ff::internal::atom_data* find_atom_data(const ff::internal::atom_data* data, const ff::internal::atom_data* stop, std::string_view str, size_t hash)
+{
+    for (; data != stop; data = data->next)
+    {
+        if (data->hash == hash && data->str == str)
+        {
+            return data;
+        }
+    }
+
+    return nullptr;
+}
+
+static const ff::internal::atom_data* get_atom_data(std::string_view str)
+{
+    const size_t hash = ff::atom::hash(str);
+    std::atomic<const ff::internal::atom_data*>& bucket = ::atom_buckets[hash % ::atom_bucket_count];
+    const ff::internal::atom_data* head = bucket.load(std::memory_order_acquire);
+
+    const ff::internal::atom_data* data = ::find_atom_data(head, nullptr, str, hash);
+    if (data)
+    {
+        return data;
+    }
+
+    // Atoms are never freed, so they don't come from the CRT heap where they would show up as leaks.
+    // The string is stored right after the atom data.
+    void* memory = ::HeapAlloc(::GetProcessHeap(), 0, sizeof(ff::internal::atom_data) + str.size());
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+
+    char* new_str = reinterpret_cast<char*>(memory) + sizeof(ff::internal::atom_data);
+    std::memcpy(new_str, str.data(), str.size());
+    ff::internal::atom_data* new_data = ::new(memory) ff::internal::atom_data{ std::string_view(new_str, str.size()), hash, head };
+
+    while (!bucket.compare_exchange_weak(new_data->next, new_data, std::memory_order_release, std::memory_order_acquire))
+    {
+        // Only atoms in front of the old head are new, check if another thread just added the same string
+        data = ::find_atom_data(new_data->next, head, str, hash);
+        if (data)
+        {
+            ::HeapFree(::GetProcessHeap(), 0, memory);
+            return data;
+        }
+
+        head = new_data->next;
+    }
+
+    return new_data;
+}
+
+ff::atom::atom(std::string_view str)
+    : data(!str.empty() ? ::get_atom_data(str) : nullptr)
+{}
+
+std::string_view ff::atom::str() const
+{
+    return this->data ? this->data->str : std::string_view();
+}
+
+size_t ff::atom::hash() const
+{
+    return this->data ? this->data->hash : 0;
+}
+
+bool ff::atom::empty() const
+{
+    return !this->data;
+}
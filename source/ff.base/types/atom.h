@@ -0,0 +1,118 @@
+#pragma once
+
+#include "../base/stable_hash.h"
+
+namespace ff::internal
+{
+    struct atom_data
+    {
+        std::string_view str;
+        size_t hash;
+        const ff::internal::atom_data* next; // in the same table bucket
+    };
+}
+
+namespace ff
+{
+    /// <summary>
+    /// Interned string, comparing and hashing atoms doesn't look at the string
+    /// </summary>
+    /// <remarks>
+    /// All atoms live in one process-wide table that never locks and never frees anything, so only use atoms
+    /// for names (like dict keys, resource names, and log types), not for arbitrary text.
+    /// The hash is ff::stable_hash_func of the string, and it's computed at compile time for literals.
+    /// </remarks>
+    class atom
+    {
+    public:
+        atom() = default;
+        atom(const atom& other) = default;
+        explicit atom(std::string_view str);
+
+        atom& operator=(const atom& other) = default;
+        bool operator==(const atom& other) const = default;
+
+        std::string_view str() const;
+        size_t hash() const;
+        bool empty() const;
+
+        // Same as atom(str).hash() without interning the string
+        static constexpr size_t hash(std::string_view str)
+        {
+            if (str.empty())
+            {
+                return 0;
+            }
+
+            return std::is_constant_evaluated()
+                ? ff::internal::lookup3::hash_chars(str)
+                : ff::stable_hash_bytes(str.data(), str.size());
+        }
+
+    private:
+        const ff::internal::atom_data* data{};
+    };
+
+    /// <summary>
+    /// A name and its atom hash, for lookups that shouldn't hash the same name over and over
+    /// </summary>
+    /// <remarks>
+    /// String literals go through a consteval constructor, so their hash is always computed at compile time.
+    /// Keys from runtime strings (char buffers, pointers, std::string) only hash when hash() is called,
+    /// so lookups that don't need the hash don't pay for it.
+    /// </remarks>
+    struct atom_key
+    {
+        template<size_t N>
+        consteval atom_key(const char(&str)[N])
+            : str(str, std::char_traits<char>::length(str))
+            , hash_(ff::atom::hash(std::string_view(str, std::char_traits<char>::length(str))))
+        {}
+
+        template<size_t N>
+        constexpr atom_key(char(&str)[N])
+            : atom_key(std::string_view(str, std::char_traits<char>::length(str)))
+        {}
+
+        template<class T, std::enable_if_t<std::is_same_v<T, const char*> || std::is_same_v<T, char*>, int> = 0>
+        constexpr atom_key(T str)
+            : atom_key(std::string_view(str))
+        {}
+
+        constexpr atom_key(std::string_view str)
+            : str(str)
+            , hash_(std::is_constant_evaluated() ? ff::atom::hash(str) : 0)
+        {}
+
+        atom_key(const std::string& str)
+            : atom_key(std::string_view(str))
+        {}
+
+        atom_key(ff::atom atom)
+            : str(atom.str())
+            , hash_(atom.hash())
+        {}
+
+        constexpr size_t hash() const
+        {
+            return this->hash_ ? this->hash_ : ff::atom::hash(this->str);
+        }
+
+        std::string_view str;
+
+    private:
+        size_t hash_;
+    };
+}
+
+namespace std
+{
+    template<>
+    struct hash<ff::atom>
+    {
+        size_t operator()(const ff::atom& value) const noexcept
+        {
+            return value.hash();
+        }
+    };
+}
@@ -2,6 +2,19 @@
 #include "base/math.h"
 #include "types/frame_allocator.h"
 
+static std::atomic_size_t frame_counter;
+
+namespace
+{
+    struct thread_frame_allocator_t
+    {
+        ff::frame_allocator allocator;
+        size_t frame{};
+    };
+}
+
+static thread_local ::thread_frame_allocator_t thread_frame_data;
+
 ff::frame_allocator::frame_allocator(size_t size)
 {
     size = std::max<size_t>(1024, ff::math::nearest_power_of_two(size));
@@ -14,6 +27,7 @@ void* ff::frame_allocator::alloc(size_t size, size_t align)
     if (!pos || pos + size > this->buffer.end)
     {
         size_t buffer_size = std::max<size_t>((this->buffer.end - this->buffer.data.get()) * 2, ff::math::nearest_power_of_two(size + align));
+        this->temp_used += this->buffer.pos - this->buffer.data.get();
         this->temp_buffers.push_back(std::move(this->buffer));
 
         this->buffer.data.reset(new uint8_t[buffer_size]);
@@ -27,8 +41,76 @@ void* ff::frame_allocator::alloc(size_t size, size_t align)
     return pos;
 }
 
+void ff::frame_allocator::free(void* data, size_t size)
+{
+    // Only the most recent allocation can be given back, which is common when a vector grows
+    if (data && static_cast<uint8_t*>(data) + size == this->buffer.pos)
+    {
+        this->buffer.pos = static_cast<uint8_t*>(data);
+    }
+}
+
 void ff::frame_allocator::clear()
 {
-    this->temp_buffers.clear();
+    const size_t used = this->temp_used + (this->buffer.pos - this->buffer.data.get());
+    const size_t buffer_size = this->buffer.end - this->buffer.data.get();
+    this->high_water_ = std::max(this->high_water_, used);
+
+    if (!this->temp_buffers.empty())
+    {
+        this->temp_buffers.clear();
+        this->temp_used = 0;
+        this->quiet_frames = 0;
+
+        // Replace all the buffers from this frame with one that would have fit everything
+        if (used > buffer_size)
+        {
+            this->reset_buffer(ff::math::nearest_power_of_two(used));
+        }
+    }
+    else if (this->buffer.data && used <= buffer_size / 4)
+    {
+        // A spike shouldn't keep a big buffer around forever, so shrink after a while of using little of it
+        this->quiet_high_water = this->quiet_frames++ ? std::max(this->quiet_high_water, used) : used;
+
+        if (this->quiet_frames >= ff::frame_allocator::shrink_frames)
+        {
+            this->reset_buffer(std::max<size_t>(1024, ff::math::nearest_power_of_two(this->quiet_high_water) * 2));
+        }
+    }
+    else
+    {
+        this->quiet_frames = 0;
+    }
+
     this->buffer.pos = this->buffer.data.get();
 }
+
+void ff::frame_allocator::reset_buffer(size_t size)
+{
+    this->buffer.data.reset(new uint8_t[size]);
+    this->buffer.end = this->buffer.data.get() + size;
+    this->quiet_frames = 0;
+}
+
+size_t ff::frame_allocator::high_water() const
+{
+    return this->high_water_;
+}
+
+ff::frame_allocator& ff::thread_frame_allocator()
+{
+    const size_t frame = ::frame_counter.load(std::memory_order_relaxed);
+    if (::thread_frame_data.frame != frame)
+    {
+        ::thread_frame_data.frame = frame;
+        ::thread_frame_data.allocator.clear();
+    }
+
+    return ::thread_frame_data.allocator;
+}
+
+void ff::frame_allocator_next_frame()
+{
+    ::frame_counter.fetch_add(1, std::memory_order_relaxed);
+}
@@ -2,9 +2,20 @@
 
 namespace ff
 {
+    /// <summary>
+    /// Fast bump allocator for memory that only needs to live until the next clear()
+    /// </summary>
+    /// <remarks>
+    /// When the buffer runs out, a bigger one is allocated and the old one is kept until clear().
+    /// clear() then replaces them all with a single buffer big enough for everything that was used,
+    /// so a steady workload stops allocating after a few frames. After shrink_frames clears that used
+    /// at most a quarter of the buffer, it's replaced with a smaller one. Not thread safe.
+    /// </remarks>
     class frame_allocator
     {
     public:
+        static constexpr size_t shrink_frames = 120;
+
         frame_allocator(size_t size = 0);
         frame_allocator(frame_allocator&& other) noexcept = default;
         frame_allocator(const frame_allocator& other) = delete;
@@ -13,7 +24,9 @@ namespace ff
         frame_allocator& operator=(const frame_allocator& other) = delete;
 
         void* alloc(size_t size, size_t align);
+        void free(void* data, size_t size);
         void clear();
+        size_t high_water() const;
 
         template<class T>
         T* alloc(size_t count = 1)
@@ -29,6 +42,8 @@ namespace ff
         }
 
     private:
+        void reset_buffer(size_t size);
+
         struct buffer_t
         {
             std::unique_ptr<uint8_t[]> data;
@@ -38,5 +53,70 @@ namespace ff
 
         std::vector<buffer_t> temp_buffers;
         buffer_t buffer;
+        size_t temp_used{};
+        size_t high_water_{};
+        size_t quiet_high_water{}; // most used by one frame since quiet_frames started counting
+        size_t quiet_frames{};
     };
+
+    /// <summary>
+    /// Returns this thread's frame allocator, it gets cleared during the first call after each frame boundary
+    /// </summary>
+    /// <remarks>
+    /// Memory from this allocator must not be used after the frame it was allocated in.
+    /// The app calls ff::frame_allocator_next_frame() before each frame starts.
+    /// </remarks>
+    ff::frame_allocator& thread_frame_allocator();
+    void frame_allocator_next_frame();
+
+    /// <summary>
+    /// STL allocator that uses a frame allocator (this thread's allocator by default)
+    /// </summary>
+    /// <remarks>
+    /// Containers using this must stay on the thread that created them and must be destroyed before the frame ends.
+    /// </remarks>
+    template<class T>
+    class frame_stl_allocator
+    {
+    public:
+        using value_type = typename T;
+
+        frame_stl_allocator()
+            : allocator(&ff::thread_frame_allocator())
+        {}
+
+        frame_stl_allocator(ff::frame_allocator& allocator)
+            : allocator(&allocator)
+        {}
+
+        template<class T2>
+        frame_stl_allocator(const ff::frame_stl_allocator<T2>& other)
+            : allocator(other.allocator)
+        {}
+
+        T* allocate(size_t count)
+        {
+            return this->allocator->alloc<T>(count);
+        }
+
+        void deallocate(T* data, size_t count)
+        {
+            this->allocator->free(data, sizeof(T) * count);
+        }
+
+        template<class T2>
+        bool operator==(const ff::frame_stl_allocator<T2>& other) const
+        {
+            return this->allocator == other.allocator;
+        }
+
+    private:
+        template<class T2>
+        friend class ff::frame_stl_allocator;
+
+        ff::frame_allocator* allocator;
+    };
+
+    template<class T>
+    using frame_vector = typename std::vector<T, ff::frame_stl_allocator<T>>;
 }
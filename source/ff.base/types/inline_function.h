@@ -0,0 +1,164 @@
+#pragma once
+
+#include "../base/assert.h"
+
+namespace ff
+{
+    template<class Func, size_t Size = sizeof(void*) * 8>
+    class inline_function;
+
+    /// <summary>
+    /// Move-only replacement for std::function that stores small callables without a heap allocation
+    /// </summary>
+    /// <remarks>
+    /// Callables that don't fit in Size bytes (or can't be moved without throwing) still work,
+    /// they are just allocated on the heap like std::function would do.
+    /// </remarks>
+    template<class R, class... Args, size_t Size>
+    class inline_function<R(Args...), Size>
+    {
+    public:
+        using this_type = typename inline_function<R(Args...), Size>;
+
+        inline_function() = default;
+        inline_function(std::nullptr_t) {}
+        inline_function(const this_type& other) = delete;
+
+        inline_function(this_type&& other) noexcept
+        {
+            *this = std::move(other);
+        }
+
+        template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, this_type> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>>>
+        inline_function(F&& func)
+        {
+            this->construct(std::forward<F>(func));
+        }
+
+        ~inline_function()
+        {
+            this->reset();
+        }
+
+        this_type& operator=(const this_type& other) = delete;
+
+        this_type& operator=(this_type&& other) noexcept
+        {
+            if (this != &other)
+            {
+                this->reset();
+
+                if (other.vtable)
+                {
+                    other.vtable->move(this->storage, other.storage);
+                    this->vtable = other.vtable;
+                    other.vtable = nullptr;
+                }
+            }
+
+            return *this;
+        }
+
+        this_type& operator=(std::nullptr_t)
+        {
+            this->reset();
+            return *this;
+        }
+
+        template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, this_type> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>>>
+        this_type& operator=(F&& func)
+        {
+            this->reset();
+            this->construct(std::forward<F>(func));
+            return *this;
+        }
+
+        R operator()(Args... args) const
+        {
+            assert(this->vtable);
+            return this->vtable->invoke(const_cast<uint8_t*>(this->storage), std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const
+        {
+            return this->vtable != nullptr;
+        }
+
+        void reset()
+        {
+            if (this->vtable)
+            {
+                this->vtable->destroy(this->storage);
+                this->vtable = nullptr;
+            }
+        }
+
+        static constexpr size_t inline_size = Size;
+
+    private:
+        struct vtable_t
+        {
+            R(*invoke)(void* storage, Args&&... args);
+            void(*move)(void* dest, void* source);
+            void(*destroy)(void* storage);
+        };
+
+        template<class F>
+        static constexpr bool is_inline = sizeof(F) <= Size && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+
+        template<class F>
+        static const vtable_t* get_vtable()
+        {
+            if constexpr (is_inline<F>)
+            {
+                static constexpr vtable_t vtable
+                {
+                    [](void* storage, Args&&... args) -> R { return std::invoke(*static_cast<F*>(storage), std::forward<Args>(args)...); },
+                    [](void* dest, void* source) { ::new(dest) F(std::move(*static_cast<F*>(source))); static_cast<F*>(source)->~F(); },
+                    [](void* storage) { static_cast<F*>(storage)->~F(); },
+                };
+
+                return &vtable;
+            }
+            else
+            {
+                static constexpr vtable_t vtable
+                {
+                    [](void* storage, Args&&... args) -> R { return std::invoke(**static_cast<F**>(storage), std::forward<Args>(args)...); },
+                    [](void* dest, void* source) { *static_cast<F**>(dest) = *static_cast<F**>(source); },
+                    [](void* storage) { delete *static_cast<F**>(storage); },
+                };
+
+                return &vtable;
+            }
+        }
+
+        template<class F>
+        void construct(F&& func)
+        {
+            using func_type = typename std::decay_t<F>;
+
+            if constexpr (std::is_pointer_v<func_type> || std::is_member_pointer_v<func_type> || std::is_same_v<func_type, std::function<R(Args...)>>)
+            {
+                if (!func)
+                {
+                    return;
+                }
+            }
+
+            if constexpr (is_inline<func_type>)
+            {
+                ::new(this->storage) func_type(std::forward<F>(func));
+            }
+            else
+            {
+                *reinterpret_cast<func_type**>(this->storage) = new func_type(std::forward<F>(func));
+            }
+
+            this->vtable = this_type::template get_vtable<func_type>();
+        }
+
+        alignas(std::max_align_t) uint8_t storage[Size];
+        const vtable_t* vtable{};
+    };
+}
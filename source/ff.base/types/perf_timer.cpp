@@ -57,6 +57,16 @@ void ff::perf_measures::no_op(const ff::perf_counter& counter)
     this->add_entry(counter);
 }
 
+void ff::perf_measures::hit(const ff::perf_counter& counter, size_t count)
+{
+    ff::perf_measures::perf_counter_stats& stats = this->stats[counter.index];
+    stats.hit_total += count;
+    stats.hit_floor_second += count;
+    stats.hit_round_second += count;
+
+    this->add_entry(counter).count += count;
+}
+
 ff::perf_measures::perf_counter_entry& ff::perf_measures::add_entry(const ff::perf_counter& counter)
 {
     ff::perf_measures::perf_counter_entry& entry = this->entries[counter.index];
@@ -179,11 +189,17 @@ void ff::perf_timer::no_op(const ff::perf_counter& counter)
     counter.measures.no_op(counter);
 }
 
+void ff::perf_timer::hit(const ff::perf_counter& counter, size_t count)
+{
+    counter.measures.hit(counter, count);
+}
+
 #else
 
 ff::perf_timer::perf_timer(const ff::perf_counter& counter) {}
 ff::perf_timer::perf_timer(const ff::perf_counter& counter, int64_t ticks) {}
 ff::perf_timer::~perf_timer() {}
 void ff::perf_timer::no_op(const ff::perf_counter& counter) {}
+void ff::perf_timer::hit(const ff::perf_counter& counter, size_t count) {}
 
 #endif
@@ -76,6 +76,7 @@ namespace ff
         void start(const ff::perf_counter& counter);
         void end(const ff::perf_counter& counter, int64_t ticks);
         void no_op(const ff::perf_counter& counter);
+        void hit(const ff::perf_counter& counter, size_t count);
         int64_t reset(double absolute_seconds, ff::perf_results* results = nullptr, bool get_timer_results = false, int64_t override_start_ticks = 0);
 
     private:
@@ -124,6 +125,7 @@ namespace ff
         ~perf_timer();
 
         static void no_op(const ff::perf_counter& counter);
+        static void hit(const ff::perf_counter& counter, size_t count); // counts without timing anything
 
     private:
         perf_timer() = delete;
@@ -0,0 +1,362 @@
+#include "pch.h"
+#include "types/pool_allocator.h"
+
+// The top bits of the free batch pointer are used as an ABA tag
+static_assert(sizeof(void*) == sizeof(uint64_t));
+constexpr uint64_t POINTER_BITS = 48;
+constexpr uint64_t POINTER_MASK = (uint64_t(1) << POINTER_BITS) - 1;
+
+static std::atomic_uint64_t next_depot_id;
+
+// Set when this thread's caches are destroyed, any later calls on this thread use the shared free batches
+static thread_local bool thread_caches_destroyed;
+
+namespace
+{
+    struct depot_slots_t
+    {
+        std::mutex mutex;
+        std::vector<size_t> free_slots;
+        size_t next_slot{};
+    };
+}
+
+static ::depot_slots_t& depot_slots()
+{
+    static ::depot_slots_t slots;
+    return slots;
+}
+
+static size_t alloc_depot_slot()
+{
+    ::depot_slots_t& slots = ::depot_slots();
+    std::scoped_lock lock(slots.mutex);
+
+    if (slots.free_slots.empty())
+    {
+        return slots.next_slot++;
+    }
+
+    size_t slot = slots.free_slots.back();
+    slots.free_slots.pop_back();
+    return slot;
+}
+
+static void free_depot_slot(size_t slot)
+{
+    ::depot_slots_t& slots = ::depot_slots();
+    std::scoped_lock lock(slots.mutex);
+    slots.free_slots.push_back(slot);
+}
+
+namespace ff::internal
+{
+    /// <summary>
+    /// One thread's free nodes for one pool
+    /// </summary>
+    struct pool_thread_cache
+    {
+        pool_thread_cache(ff::internal::pool_depot& depot)
+            : depot_id(depot.id)
+            , depot(depot.weak_from_this())
+        {}
+
+        // Gives everything back to the depot when the thread exits
+        void release()
+        {
+            std::shared_ptr<ff::internal::pool_depot> depot = this->depot.lock();
+            if (depot)
+            {
+                std::scoped_lock lock(depot->mutex);
+                std::erase(depot->thread_caches, this);
+                depot->retired_size += this->size.load(std::memory_order_relaxed);
+
+                if (this->free_nodes)
+                {
+                    depot->push_batch(this->free_nodes);
+                }
+            }
+
+            this->free_nodes = nullptr;
+            this->free_count = 0;
+        }
+
+        const uint64_t depot_id;
+        const std::weak_ptr<ff::internal::pool_depot> depot;
+        ff::internal::pool_node* free_nodes{};
+        size_t free_count{};
+
+        // Only changed by the owning thread, read by get_stats on any thread
+        std::atomic<ptrdiff_t> size{};
+    };
+}
+
+namespace
+{
+    class thread_caches_t
+    {
+    public:
+        ~thread_caches_t()
+        {
+            ::thread_caches_destroyed = true;
+
+            for (auto& cache : this->caches)
+            {
+                if (cache)
+                {
+                    cache->release();
+                }
+            }
+        }
+
+        ff::internal::pool_thread_cache* get(size_t slot) const
+        {
+            return (slot < this->caches.size()) ? this->caches[slot].get() : nullptr;
+        }
+
+        ff::internal::pool_thread_cache& set(size_t slot, ff::internal::pool_depot& depot)
+        {
+            if (slot >= this->caches.size())
+            {
+                this->caches.resize(slot + 1);
+            }
+
+            // A cache already in this slot belongs to a pool that no longer exists
+            std::unique_ptr<ff::internal::pool_thread_cache>& cache = this->caches[slot];
+            if (cache)
+            {
+                cache->release();
+            }
+
+            cache = std::make_unique<ff::internal::pool_thread_cache>(depot);
+            return *cache;
+        }
+
+    private:
+        std::vector<std::unique_ptr<ff::internal::pool_thread_cache>> caches;
+    };
+}
+
+static thread_local ::thread_caches_t thread_cache_list;
+
+static ff::internal::pool_node* get_batch_pointer(uint64_t value)
+{
+    return reinterpret_cast<ff::internal::pool_node*>(value & ::POINTER_MASK);
+}
+
+static uint64_t make_batch_pointer(ff::internal::pool_node* node, uint64_t old_value)
+{
+    assert(!(reinterpret_cast<uint64_t>(node) & ~::POINTER_MASK));
+    const uint64_t tag = (old_value >> ::POINTER_BITS) + 1;
+    return reinterpret_cast<uint64_t>(node) | (tag << ::POINTER_BITS);
+}
+
+ff::internal::pool_depot::pool_depot(size_t node_size, size_t node_align)
+    : id(::next_depot_id.fetch_add(1) + 1)
+    , slot(::alloc_depot_slot())
+    , node_size(node_size)
+    , node_align(node_align)
+{}
+
+ff::internal::pool_depot::~pool_depot()
+{
+    for (const block_t& block : this->blocks)
+    {
+        ::operator delete(block.data, std::align_val_t(this->node_align));
+    }
+
+    ::free_depot_slot(this->slot);
+}
+
+void* ff::internal::pool_depot::new_bytes()
+{
+    ff::internal::pool_thread_cache* cache_ptr = this->thread_cache();
+    if (!cache_ptr)
+    {
+        return this->new_shared_bytes();
+    }
+
+    ff::internal::pool_thread_cache& cache = *cache_ptr;
+
+    if (!cache.free_nodes)
+    {
+        cache.free_nodes = this->pop_batch();
+
+        for (ff::internal::pool_node* node = cache.free_nodes; node; node = node->next)
+        {
+            cache.free_count++;
+        }
+    }
+
+    ff::internal::pool_node* node = cache.free_nodes;
+    cache.free_nodes = node->next;
+    cache.free_count--;
+    cache.size.store(cache.size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    return node;
+}
+
+void ff::internal::pool_depot::delete_bytes(void* data)
+{
+    ff::internal::pool_thread_cache* cache_ptr = this->thread_cache();
+    if (!cache_ptr)
+    {
+        this->delete_shared_bytes(data);
+        return;
+    }
+
+    ff::internal::pool_thread_cache& cache = *cache_ptr;
+    ff::internal::pool_node* node = static_cast<ff::internal::pool_node*>(data);
+
+    node->next = cache.free_nodes;
+    cache.free_nodes = node;
+    cache.free_count++;
+    cache.size.store(cache.size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+
+    if (cache.free_count >= ff::internal::pool_depot::batch_size * 2)
+    {
+        // Keep one batch and give the other one to the depot
+        ff::internal::pool_node* last = cache.free_nodes;
+        for (size_t i = 1; i < ff::internal::pool_depot::batch_size; i++)
+        {
+            last = last->next;
+        }
+
+        ff::internal::pool_node* batch = last->next;
+        last->next = nullptr;
+        cache.free_count -= ff::internal::pool_depot::batch_size;
+        this->push_batch(batch);
+    }
+}
+
+void ff::internal::pool_depot::get_stats(size_t* size, size_t* allocated)
+{
+    std::scoped_lock lock(this->mutex);
+
+    if (size)
+    {
+        *size = this->size_locked();
+    }
+
+    if (allocated)
+    {
+        *allocated = this->allocated;
+    }
+}
+
+ff::internal::pool_thread_cache* ff::internal::pool_depot::thread_cache()
+{
+    if (::thread_caches_destroyed)
+    {
+        return nullptr;
+    }
+
+    ff::internal::pool_thread_cache* cache = ::thread_cache_list.get(this->slot);
+    if (!cache || cache->depot_id != this->id)
+    {
+        cache = &::thread_cache_list.set(this->slot, *this);
+
+        std::scoped_lock lock(this->mutex);
+        this->thread_caches.push_back(cache);
+    }
+
+    return cache;
+}
+
+void* ff::internal::pool_depot::new_shared_bytes()
+{
+    // Take one node from a shared batch and give the rest back
+    ff::internal::pool_node* batch = this->pop_batch();
+    if (batch->next)
+    {
+        this->push_batch(batch->next);
+    }
+
+    std::scoped_lock lock(this->mutex);
+    this->retired_size++;
+    return batch;
+}
+
+void ff::internal::pool_depot::delete_shared_bytes(void* data)
+{
+    ff::internal::pool_node* node = ::new(data) ff::internal::pool_node{};
+    this->push_batch(node);
+
+    std::scoped_lock lock(this->mutex);
+    this->retired_size--;
+}
+
+ff::internal::pool_node* ff::internal::pool_depot::pop_batch()
+{
+    while (true)
+    {
+        uint64_t value = this->free_batches.load(std::memory_order_acquire);
+        while (ff::internal::pool_node* batch = ::get_batch_pointer(value))
+        {
+            // The batch may already be taken and reused, but its memory stays valid and the tag makes the exchange fail
+            ff::internal::pool_node* next_batch = batch->next_batch.load(std::memory_order_relaxed);
+            if (this->free_batches.compare_exchange_weak(value, ::make_batch_pointer(next_batch, value), std::memory_order_acquire))
+            {
+                return batch;
+            }
+        }
+
+        std::scoped_lock lock(this->mutex);
+        if (::get_batch_pointer(this->free_batches.load(std::memory_order_acquire)))
+        {
+            continue;
+        }
+
+        // Grow by doubling, then keep the first batch and share the rest
+        const size_t node_count = std::max<size_t>(this->blocks.empty() ? 8 : this->blocks.back().size * 2, 8);
+        uint8_t* data = static_cast<uint8_t*>(::operator new(node_count * this->node_size, std::align_val_t(this->node_align)));
+        this->blocks.push_back(block_t{ data, node_count });
+        this->allocated += node_count;
+
+        ff::internal::pool_node* first_batch = nullptr;
+        for (size_t i = 0; i < node_count; i += ff::internal::pool_depot::batch_size)
+        {
+            const size_t count = std::min(node_count - i, ff::internal::pool_depot::batch_size);
+            ff::internal::pool_node* batch = nullptr;
+
+            for (size_t h = count; h > 0; h--)
+            {
+                ff::internal::pool_node* node = ::new(data + (i + h - 1) * this->node_size) ff::internal::pool_node{ batch };
+                batch = node;
+            }
+
+            if (first_batch)
+            {
+                this->push_batch(batch);
+            }
+            else
+            {
+                first_batch = batch;
+            }
+        }
+
+        return first_batch;
+    }
+}
+
+void ff::internal::pool_depot::push_batch(ff::internal::pool_node* first)
+{
+    uint64_t value = this->free_batches.load(std::memory_order_relaxed);
+    do
+    {
+        first->next_batch.store(::get_batch_pointer(value), std::memory_order_relaxed);
+    }
+    while (!this->free_batches.compare_exchange_weak(value, ::make_batch_pointer(first, value), std::memory_order_release, std::memory_order_relaxed));
+}
+
+size_t ff::internal::pool_depot::size_locked() const
+{
+    ptrdiff_t size = this->retired_size;
+    for (const ff::internal::pool_thread_cache* cache : this->thread_caches)
+    {
+        size += cache->size.load(std::memory_order_relaxed);
+    }
+
+    assert(size >= 0);
+    return static_cast<size_t>(size);
+}
@@ -1,31 +1,104 @@
 #pragma once
 
+#include "../base/assert.h"
 #include "../base/math.h"
 
 namespace ff::internal
 {
+    struct pool_thread_cache;
+
+    /// <summary>
+    /// Free node in a thread safe pool, batches of nodes are linked by next and the batches by next_batch
+    /// </summary>
+    struct pool_node
+    {
+        ff::internal::pool_node* next;
+        std::atomic<ff::internal::pool_node*> next_batch;
+    };
+
+    template<class T>
+    struct pool_node_layout
+    {
+        static constexpr size_t align = std::max({ alignof(T), alignof(std::max_align_t), alignof(ff::internal::pool_node) });
+        static constexpr size_t size = ff::math::align_up(std::max(sizeof(T), sizeof(ff::internal::pool_node)), align);
+    };
+
+    /// <summary>
+    /// Memory shared by all threads that use one thread safe ff::byte_pool_allocator
+    /// </summary>
+    /// <remarks>
+    /// Each thread keeps its own list of free nodes (a magazine) for every pool it uses, so new_bytes and delete_bytes
+    /// normally don't touch any shared memory. Only full batches of nodes move between a thread and the shared
+    /// depot, using a lock-free stack. The mutex is only taken to grow the pool or when a thread starts or stops using it.
+    /// </remarks>
+    class pool_depot : public std::enable_shared_from_this<ff::internal::pool_depot>
+    {
+    public:
+        static constexpr size_t batch_size = 32;
+
+        pool_depot(size_t node_size, size_t node_align);
+        pool_depot(pool_depot&& other) noexcept = delete;
+        pool_depot(const pool_depot& other) = delete;
+        ~pool_depot();
+
+        pool_depot& operator=(pool_depot&& other) noexcept = delete;
+        pool_depot& operator=(const pool_depot& other) = delete;
+
+        void* new_bytes();
+        void delete_bytes(void* data);
+        void get_stats(size_t* size, size_t* allocated);
+
+    private:
+        friend struct ff::internal::pool_thread_cache;
+
+        ff::internal::pool_thread_cache* thread_cache();
+        void* new_shared_bytes();
+        void delete_shared_bytes(void* data);
+        ff::internal::pool_node* pop_batch();
+        void push_batch(ff::internal::pool_node* first);
+        size_t size_locked() const;
+
+        struct block_t
+        {
+            void* data;
+            size_t size;
+        };
+
+        const uint64_t id;
+        const size_t slot; // index into each thread's list of caches, reused after this depot is gone
+        const size_t node_size;
+        const size_t node_align;
+
+        std::mutex mutex;
+        std::vector<block_t> blocks;
+        std::vector<ff::internal::pool_thread_cache*> thread_caches;
+        ptrdiff_t retired_size{};
+        size_t allocated{};
+
+        // Tagged pointer to the first free batch, the tag in the high bits prevents ABA problems
+        alignas(std::hardware_destructive_interference_size) std::atomic_uint64_t free_batches{};
+    };
+
     template<class T>
     struct byte_pool
     {
-        union alignas(::SLIST_ENTRY) alignas(T) alignas(std::max_align_t) node_type
+        union alignas(T) alignas(std::max_align_t) node_type
         {
-            ::SLIST_ENTRY entry;
+            node_type* next;
             std::array<uint8_t, sizeof(T)> item;
         };
 
-        byte_pool(size_t size, ::PSLIST_ENTRY& first_entry, ::PSLIST_ENTRY& last_entry)
+        byte_pool(size_t size, node_type*& first_node)
             : size(std::max<size_t>(ff::math::nearest_power_of_two(size), 8))
             , nodes(std::make_unique<node_type[]>(this->size))
         {
             for (size_t i = 0; i < this->size - 1; i++)
             {
-                this->nodes[i].entry.Next = &this->nodes[i + 1].entry;
+                this->nodes[i].next = &this->nodes[i + 1];
             }
 
-            this->nodes[this->size - 1].entry.Next = nullptr;
-
-            first_entry = &this->nodes[0].entry;
-            last_entry = &this->nodes[this->size - 1].entry;
+            this->nodes[this->size - 1].next = nullptr;
+            first_node = &this->nodes[0];
         }
 
         std::unique_ptr<byte_pool<T>>& last_pool(size_t& previous_size)
@@ -46,9 +119,9 @@ namespace ff
     /// Allocates buffers of a single size and alignment from a reusable memory pool
     /// </summary>
     /// <remarks>
-    /// This byte pool allocator can be thread safe or not. The thread safe code is lock free during
-    /// normal calls to new_bytes and delete_bytes. Only when new_bytes needs to allocate more pool memory
-    /// is a lock briefly taken. Generally you should use the ff::pool_allocator class instead.
+    /// This byte pool allocator can be thread safe or not. The thread safe version caches free buffers per thread
+    /// (see ff::internal::pool_depot) and is lock free except when the pool needs to grow.
+    /// Generally you should use the ff::pool_allocator class instead.
     /// </remarks>
     /// <typeparam name="T">Buffer size and alignment are based on the size of this type</typeparam>
     /// <typeparam name="ThreadSafe">true if calls into this pool need to be thread safe</typeparam>
@@ -57,124 +130,80 @@ namespace ff
     {
     public:
         using this_type = typename byte_pool_allocator<T, ThreadSafe>;
-        using pool_type = typename ff::internal::byte_pool<T>;
+        using layout_type = typename ff::internal::pool_node_layout<T>;
 
         byte_pool_allocator()
-            : size(0)
-        {
-            ::InitializeSListHead(&this->free_list);
-        }
+            : depot(this_type::create_depot())
+        {}
 
         byte_pool_allocator(this_type&& other)
-            : pool_list(std::move(other.pool_list))
-            , free_list(other.free_list)
-            , size(other.size.load())
+            : depot(std::move(other.depot))
         {
-            ::InitializeSListHead(&other.free_list);
-            other.size = 0;
+            other.depot = this_type::create_depot();
         }
 
         ~byte_pool_allocator()
         {
-            assert(!this->size);
-            ::InterlockedFlushSList(&this->free_list);
+            assert(!this->size());
         }
 
         this_type& operator=(this_type&& other)
         {
             if (this != &other)
             {
-                assert(!this->size);
+                assert(!this->size());
 
-                std::scoped_lock lock(this->mutex, other.mutex);
-
-                this->pool_list = std::move(other.pool_list);
-                this->free_list = other.free_list;
-                this->size = other.size;
-
-                ::InitializeSListHead(&other.free_list);
-                other.size = 0;
+                this->depot = std::move(other.depot);
+                other.depot = this_type::create_depot();
             }
 
-
             return *this;
         }
 
         void* new_bytes()
         {
-            ::PSLIST_ENTRY free_entry = nullptr;
-            while (!free_entry && !(free_entry = ::InterlockedPopEntrySList(&this->free_list)))
-            {
-                std::scoped_lock lock(this->mutex);
-
-                if (!(free_entry = ::InterlockedPopEntrySList(&this->free_list)))
-                {
-                    size_t previous_size = 0;
-                    std::unique_ptr<pool_type>& last_pool = !this->pool_list ? this->pool_list : this->pool_list->last_pool(previous_size);
-                    ::PSLIST_ENTRY first_entry = nullptr, last_entry = nullptr;
-                    last_pool.reset(new pool_type(previous_size * 2, first_entry, last_entry));
-
-                    ::InterlockedPushListSListEx(&this->free_list, first_entry, last_entry, static_cast<ULONG>(last_pool->size));
-                }
-            }
-
-            this->size.fetch_add(1);
-            return free_entry;
+            return this->depot->new_bytes();
         }
 
         void delete_bytes(void* obj)
         {
             if (obj)
             {
-                assert(this->size);
-
-                typename pool_type::node_type* node = reinterpret_cast<typename pool_type::node_type*>(obj);
-                ::InterlockedPushEntrySList(&this->free_list, &node->entry);
-                this->size.fetch_sub(1);
+                this->depot->delete_bytes(obj);
             }
         }
 
         void reduce_if_empty()
         {
-            if (!this->size)
+            if (!this->size())
             {
-                std::scoped_lock lock(this->mutex);
-                if (!this->size)
-                {
-                    ::InterlockedFlushSList(&this->free_list);
-                    this->pool_list.reset();
-                }
+                // Free buffers cached by other threads belong to the old depot and won't be used again
+                this->depot = this_type::create_depot();
             }
         }
 
         void get_stats(size_t* size, size_t* allocated) const
         {
-            std::scoped_lock lock(this->mutex);
-
-            if (size)
-            {
-                *size = this->size;
-            }
-
-            if (allocated)
-            {
-                *allocated = 0;
-
-                for (std::unique_ptr<pool_type>* i = &this->pool_list; *i; i = &(*i)->next_pool)
-                {
-                    *allocated += (*i)->size;
-                }
-            }
+            this->depot->get_stats(size, allocated);
         }
 
     private:
         byte_pool_allocator(const this_type& other) = delete;
         byte_pool_allocator& operator=(const this_type& other) = delete;
 
-        std::mutex mutex;
-        std::unique_ptr<pool_type> pool_list;
-        std::atomic_size_t size;
-        ::SLIST_HEADER free_list;
+        static std::shared_ptr<ff::internal::pool_depot> create_depot()
+        {
+            return std::make_shared<ff::internal::pool_depot>(layout_type::size, layout_type::align);
+        }
+
+        size_t size() const
+        {
+            size_t size = 0;
+            this->get_stats(&size, nullptr);
+            return size;
+        }
+
+        std::shared_ptr<ff::internal::pool_depot> depot;
     };
 
     template<class T>
@@ -183,6 +212,7 @@ namespace ff
     public:
         using this_type = typename byte_pool_allocator<T, false>;
         using pool_type = typename ff::internal::byte_pool<T>;
+        using node_type = typename pool_type::node_type;
 
         byte_pool_allocator()
             : first_free(nullptr)
@@ -226,24 +256,23 @@ namespace ff
             {
                 size_t previous_size = 0;
                 std::unique_ptr<pool_type>& last_pool = !this->pool_list ? this->pool_list : this->pool_list->last_pool(previous_size);
-                ::PSLIST_ENTRY last_entry;
-                last_pool.reset(new pool_type(previous_size * 2, this->first_free, last_entry));
+                last_pool.reset(new pool_type(previous_size * 2, this->first_free));
             }
 
-            ::PSLIST_ENTRY free_entry = this->first_free;
-            this->first_free = this->first_free->Next;
+            node_type* free_node = this->first_free;
+            this->first_free = free_node->next;
             this->size++;
 
-            return free_entry;
+            return free_node;
         }
 
         void delete_bytes(void* obj)
         {
             if (obj)
             {
-                typename pool_type::node_type* node = reinterpret_cast<typename pool_type::node_type*>(obj);
-                node->entry.Next = this->first_free;
-                this->first_free = &node->entry;
+                node_type* node = reinterpret_cast<node_type*>(obj);
+                node->next = this->first_free;
+                this->first_free = node;
                 this->size--;
             }
         }
@@ -280,7 +309,7 @@ namespace ff
         byte_pool_allocator& operator=(const byte_pool_allocator& other) = delete;
 
         std::unique_ptr<pool_type> pool_list;
-        ::PSLIST_ENTRY first_free;
+        node_type* first_free;
         size_t size;
     };
 
@@ -290,7 +319,7 @@ namespace ff
     /// <remarks>
     /// This pool allocator can be thread safe or not. The thread safe code is lock free during
     /// normal calls to new_obj and delete_obj. Only when new_obj needs to allocate more pool memory
-    /// is a lock briefly taken.
+    /// is a lock briefly taken. See ff::byte_pool_allocator.
     /// </remarks>
     /// <typeparam name="T">Object type</typeparam>
     /// <typeparam name="ThreadSafe">true if calls into this pool need to be thread safe</typeparam>
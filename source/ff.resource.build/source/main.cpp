@@ -17,12 +17,14 @@ constexpr std::string_view ASSETS_COMBINED_NAMESPACE = "assets_combined";
 static int show_usage()
 {
     std::cerr << "Command line options:\n";
-    std::cerr << "  1) " << ::PROGRAM_NAME << ".exe -in \"input file\" [-out \"output file\"] [-pdb \"output path\"] [-header \"output C++\"] [-ref \"types.dll\"] [-debug] [-force]\n";
+    std::cerr << "  1) " << ::PROGRAM_NAME << ".exe -in \"input file\" [-out \"output file\"] [-pdb \"output path\"] [-header \"output C++\"] [-ref \"types.dll\"] [-codec [type=]codec] [-cache \"cache path\"] [-debug] [-force]\n";
     std::cerr << "  3) " << ::PROGRAM_NAME << ".exe -dump \"pack file\"\n";
     std::cerr << "  4) " << ::PROGRAM_NAME << ".exe -dumpbin \"pack file\"\n\n";
     std::cerr << "NOTES:\n";
     std::cerr << "  -verbose can be added to any command for extra log output.\n";
     std::cerr << "  With -ref, the reference DLL must contain an exported C method: 'void ff_init()'.\n";
+    std::cerr << "  With -codec, resources of a type (or all other resources) are compressed with: none, zlib, zlib_chunked, lz4.\n";
+    std::cerr << "  Unchanged resources are reused from the -cache folder (default is in the local app data folder), -force rebuilds everything.\n";
     std::cerr << "  Using -dumpbin will save all binary resources to a temp folder and open it.\n";
 
     return ::EXIT_CODE_BAD_COMMAND_LINE;
@@ -113,12 +115,24 @@ static void test_load_resources(const ff::resource_objects& resources)
     }
 }
 
+// Maps a resource type to a codec name, the empty type is the default for all other resources
+using codec_map_t = std::unordered_map<std::string, std::string>;
+
+static const ff::compression::codec_base* get_codec_for_type(const ::codec_map_t& codecs, std::string_view type)
+{
+    auto i = codecs.find(std::string(type));
+    i = (i != codecs.end()) ? i : codecs.find(std::string());
+    return (i != codecs.end()) ? ff::compression::get_codec(i->second) : nullptr;
+}
+
 static bool compile_resource_pack(
     const std::vector<std::filesystem::path>& input_files,
     const std::filesystem::path& output_file,
     const std::filesystem::path& pdb_output,
     const std::filesystem::path& header_file,
     const std::filesystem::path& symbol_header_file,
+    const ::codec_map_t& codecs,
+    ff::resource_build_cache* build_cache,
     const bool force,
     const bool debug)
 {
@@ -135,7 +149,7 @@ static bool compile_resource_pack(
         if (file_extension == ".json")
         {
             const ff::resource_cache_t cache_type = force ? ff::resource_cache_t::rebuild_cache : ff::resource_cache_t::use_cache_mem_mapped;
-            result = ff::load_resources_from_file(input_file, cache_type, debug);
+            result = ff::load_resources_from_file(input_file, cache_type, debug, build_cache);
         }
         else if (file_extension == ".pack")
         {
@@ -172,6 +186,15 @@ static bool compile_resource_pack(
             built_resources.add_resources(*result.resources);
         }
 
+        if (!codecs.empty() && !built_resources.compress_resources([&codecs](std::string_view type)
+            {
+                return ::get_codec_for_type(codecs, type);
+            }))
+        {
+            std::cerr << "Failed to compress resources\n";
+            return false;
+        }
+
         ::test_load_resources(built_resources);
     }
 
@@ -181,7 +204,7 @@ static bool compile_resource_pack(
     if (!output_file.empty())
     {
         bool written = false;
-        bool use_single_cache = load_results.size() == 1 && !load_results.front().cache_path.empty();
+        bool use_single_cache = load_results.size() == 1 && !load_results.front().cache_path.empty() && codecs.empty();
 
         if (use_single_cache)
         {
@@ -355,6 +378,8 @@ static int do_compile(
     const std::filesystem::path& pdb_output,
     const std::filesystem::path& header_file,
     const std::filesystem::path& symbol_header_file,
+    const std::filesystem::path& cache_path,
+    const ::codec_map_t& codecs,
     const bool force,
     const bool debug,
     const bool verbose)
@@ -381,12 +406,20 @@ static int do_compile(
         return ::EXIT_CODE_BAD_REFERENCE;
     }
 
-    if (!::compile_resource_pack(input_files, output_file, pdb_output, header_file, symbol_header_file, force, debug))
+    // Forced builds don't read old cache entries
+    std::unique_ptr<ff::resource_build_cache> build_cache = force ? nullptr : std::make_unique<ff::resource_build_cache>(cache_path);
+
+    if (!::compile_resource_pack(input_files, output_file, pdb_output, header_file, symbol_header_file, codecs, build_cache.get(), force, debug))
     {
         std::cerr << ::PROGRAM_NAME << ": Compile failed\n";
         return ::EXIT_CODE_COMPILE_FAILED;
     }
 
+    if (verbose && build_cache)
+    {
+        std::cout << ::PROGRAM_NAME << ": Build cache hits: " << build_cache->hit_count() << ", misses: " << build_cache->miss_count() << "\n";
+    }
+
     return ::EXIT_CODE_SUCCESS;
 }
 
@@ -486,6 +519,8 @@ int main()
     std::filesystem::path pdb_output;
     std::filesystem::path header_file;
     std::filesystem::path symbol_header_file;
+    std::filesystem::path cache_path = ff::filesystem::user_local_path() / "ff.cache" / "build";
+    ::codec_map_t codecs;
 
     auto at_exit = ff::scope_exit([&timer, &command_flags]()
     {
@@ -557,6 +592,30 @@ int main()
 
                 reference_files.push_back(std::filesystem::current_path() / ff::filesystem::to_path(args[++i]));
             }
+            else if (arg == "-codec" && i + 1 < args.size())
+            {
+                // "-codec lz4" is the default, "-codec texture=lz4" is just for one resource type
+                std::string_view codec_arg = args[++i];
+                const size_t equals = codec_arg.find('=');
+                std::string type(equals != std::string_view::npos ? codec_arg.substr(0, equals) : std::string_view());
+                std::string codec_name(equals != std::string_view::npos ? codec_arg.substr(equals + 1) : codec_arg);
+
+                if (command != command_t::compile || (codec_name != "none" && !ff::compression::get_codec(codec_name)))
+                {
+                    return ::show_usage();
+                }
+
+                codecs.insert_or_assign(std::move(type), std::move(codec_name));
+            }
+            else if (arg == "-cache" && i + 1 < args.size())
+            {
+                if (command != command_t::compile)
+                {
+                    return ::show_usage();
+                }
+
+                cache_path = std::filesystem::current_path() / ff::filesystem::to_path(args[++i]);
+            }
             else if ((arg == "-dump" || arg == "-dumpbin") && i + 1 < args.size())
             {
                 if (command != command_t::none || !input_files.empty())
@@ -620,7 +679,7 @@ int main()
     switch (command)
     {
         case command_t::compile:
-            return ::do_compile(input_files, output_file, reference_files, pdb_output, header_file, symbol_header_file, force, debug, verbose);
+            return ::do_compile(input_files, output_file, reference_files, pdb_output, header_file, symbol_header_file, cache_path, codecs, force, debug, verbose);
 
         case command_t::dump_text:
             return ::do_dump(input_files[0], false);
@@ -0,0 +1,95 @@
+﻿#include "pch.h"
+
+// Literal atom hashes are computed at compile time, and they must match the runtime hash
+static_assert(ff::atom::hash("mips") == ff::internal::lookup3::hash_chars("mips"));
+static_assert(ff::atom_key("mips").hash() == ff::internal::lookup3::hash_chars("mips"));
+
+// Arrays bigger than their string only use the chars before the null
+static constexpr char padded_name[16] = "mips";
+static_assert(ff::atom_key(padded_name).str.size() == 4);
+static_assert(ff::atom_key(padded_name).hash() == ff::atom::hash("mips"));
+
+namespace ff::test::base
+{
+    TEST_CLASS(atom_tests)
+    {
+    public:
+        TEST_METHOD(intern)
+        {
+            const std::string name = "atom_tests/intern";
+            const ff::atom atom1(name);
+            const ff::atom atom2("atom_tests/intern"sv);
+
+            Assert::IsTrue(atom1 == atom2);
+            Assert::IsTrue(atom1.str().data() == atom2.str().data());
+            Assert::IsTrue(atom1.str() == name);
+            Assert::AreEqual(ff::stable_hash_func(std::string_view(name)), atom1.hash());
+            Assert::AreEqual(atom1.hash(), ff::atom_key("atom_tests/intern").hash());
+
+            Assert::IsTrue(ff::atom().empty());
+            Assert::IsTrue(ff::atom(""sv).empty());
+            Assert::AreEqual<size_t>(0, ff::atom::hash(""));
+        }
+
+        TEST_METHOD(key_from_buffer)
+        {
+            char buffer[32] = "atom_tests/buffer";
+            const ff::atom_key key(buffer);
+
+            Assert::IsTrue(key.str == "atom_tests/buffer");
+            Assert::AreEqual(ff::atom("atom_tests/buffer"sv).hash(), key.hash());
+        }
+
+        TEST_METHOD(threads)
+        {
+            const size_t thread_count = 8;
+            const size_t name_count = 10000;
+            std::vector<std::vector<const char*>> thread_strings(thread_count);
+            std::vector<std::jthread> threads;
+
+            for (size_t i = 0; i < thread_count; i++)
+            {
+                threads.emplace_back([&strings = thread_strings[i]]()
+                    {
+                        for (size_t j = 0; j < name_count; j++)
+                        {
+                            std::ostringstream name;
+                            name << "atom_tests/threads/" << j;
+                            strings.push_back(ff::atom(name.str()).str().data());
+                        }
+                    });
+            }
+
+            threads.clear();
+
+            for (size_t i = 1; i < thread_count; i++)
+            {
+                Assert::IsTrue(thread_strings[0] == thread_strings[i]);
+            }
+        }
+
+        TEST_METHOD(dict_keys)
+        {
+            ff::dict dict;
+            dict.set<int>("mips", 4);
+
+            const std::string name = "mips";
+            const char* name_ptr = name.c_str();
+
+            Assert::AreEqual(4, dict.get<int>("mips"));
+            Assert::AreEqual(4, dict.get<int>(name));
+            Assert::AreEqual(4, dict.get<int>(name_ptr));
+            Assert::AreEqual(4, dict.get<int>(ff::atom(name)));
+            Assert::AreEqual(8, dict.get<int>("missing", 8));
+            Assert::IsTrue(dict.child_names()[0].data() == ff::atom(name).str().data());
+        }
+
+        TEST_METHOD(log_types)
+        {
+            const ff::log::type type = ff::log::register_type("atom_tests/log", false);
+            Assert::IsTrue(type == ff::log::lookup_type("atom_tests/log"));
+            Assert::IsTrue(ff::log::type::test == ff::log::lookup_type("ff/test"));
+            Assert::IsTrue(ff::log::type_name(type).data() == ff::atom("atom_tests/log"sv).str().data());
+        }
+    };
+}
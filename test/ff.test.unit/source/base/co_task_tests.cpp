@@ -88,6 +88,50 @@ namespace ff::test::base
             Assert::AreEqual(10, i);
         }
 
+        TEST_METHOD(many_continuations)
+        {
+            std::atomic_int count = 0;
+            ff::co_task<int> task = ff::test::base::co_task_tests::test_return_int(10);
+
+            for (int i = 0; i < 8; i++)
+            {
+                task.continue_with<void>([&count](ff::co_task<int> task2)
+                {
+                    count.fetch_add(task2.result());
+                });
+            }
+
+            Assert::IsTrue(task.wait(2000));
+            Assert::AreEqual(10, task.result());
+
+            for (int i = 0; i < 100 && count.load() != 80; i++)
+            {
+                std::this_thread::sleep_for(10ms);
+            }
+
+            Assert::AreEqual(80, count.load());
+        }
+
+        TEST_METHOD(frame_benchmark)
+        {
+            const int task_count = 100000;
+            int64_t sum = 0;
+            ff::timer timer;
+
+            for (int i = 0; i < task_count; i++)
+            {
+                ff::co_task<int> task = ff::test::base::co_task_tests::test_return_now(i);
+                sum += task.result();
+            }
+
+            const double seconds = timer.tick();
+            Assert::AreEqual<int64_t>(static_cast<int64_t>(task_count) * (task_count - 1) / 2, sum);
+
+            ff::log::write(ff::log::type::test, "Short co_tasks: ", task_count,
+                ", time: ", seconds * 1000.0, "ms",
+                ", per task: ", seconds * 1000000000.0 / task_count, "ns");
+        }
+
     private:
         ff::co_task<> delay_for(size_t delay_ms, std::stop_token stop)
         {
@@ -151,5 +195,10 @@ namespace ff::test::base
             co_await ff::task::delay(100);
             co_return result;
         }
+
+        ff::co_task<int> test_return_now(int result)
+        {
+            co_return result;
+        }
     };
 }
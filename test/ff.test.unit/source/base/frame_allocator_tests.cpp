@@ -24,5 +24,68 @@ namespace ff::test::base
             void* a4 = allocator.alloc(1024, 256);
             Assert::AreEqual(a3, a4);
         }
+
+        TEST_METHOD(coalesce_on_clear)
+        {
+            ff::frame_allocator allocator;
+            for (int i = 0; i < 4; i++)
+            {
+                allocator.alloc(1024, 16);
+            }
+
+            allocator.clear();
+            Assert::AreEqual<size_t>(4096, allocator.high_water());
+
+            // Everything from the last frame fits in one buffer now
+            uint8_t* first = allocator.alloc<uint8_t>(1024);
+            for (size_t i = 1; i < 4; i++)
+            {
+                Assert::IsTrue(first + i * 1024 == allocator.alloc<uint8_t>(1024));
+            }
+        }
+
+        TEST_METHOD(shrink_after_quiet_frames)
+        {
+            ff::frame_allocator allocator;
+            allocator.alloc(65536, 16);
+            allocator.clear();
+
+            // The big buffer stays while it's still being used
+            uint8_t* first = allocator.alloc<uint8_t>(16);
+            for (size_t i = 1; i < ff::frame_allocator::shrink_frames; i++)
+            {
+                allocator.clear();
+                Assert::IsTrue(first == allocator.alloc<uint8_t>(16));
+            }
+
+            allocator.clear();
+            Assert::IsTrue(first != allocator.alloc<uint8_t>(16));
+            Assert::AreEqual<size_t>(65536, allocator.high_water());
+        }
+
+        TEST_METHOD(stl_allocator)
+        {
+            ff::frame_allocator allocator;
+            ff::frame_vector<int> values{ ff::frame_stl_allocator<int>(allocator) };
+
+            for (int i = 0; i < 1000; i++)
+            {
+                values.push_back(i);
+            }
+
+            Assert::AreEqual<size_t>(1000, values.size());
+            Assert::AreEqual(999, values.back());
+        }
+
+        TEST_METHOD(thread_allocator)
+        {
+            ff::frame_allocator_next_frame();
+            ff::frame_allocator& allocator = ff::thread_frame_allocator();
+            void* data = allocator.alloc(256, 16);
+
+            ff::frame_allocator_next_frame();
+            Assert::IsTrue(&allocator == &ff::thread_frame_allocator());
+            Assert::AreEqual(data, allocator.alloc(256, 16));
+        }
     };
 }
@@ -0,0 +1,252 @@
+#include "pch.h"
+
+namespace ff::test::base
+{
+    TEST_CLASS(job_system_tests)
+    {
+    public:
+        TEST_METHOD(simple)
+        {
+            ff::job_system jobs(4);
+            std::atomic_int count = 0;
+            std::vector<ff::job_handle> handles;
+
+            for (int i = 0; i < 1000; i++)
+            {
+                handles.push_back(jobs.run([&count]()
+                    {
+                        count.fetch_add(1);
+                    }));
+            }
+
+            for (const ff::job_handle& handle : handles)
+            {
+                handle.wait();
+                Assert::IsTrue(handle.done());
+            }
+
+            Assert::AreEqual(1000, count.load());
+        }
+
+        TEST_METHOD(child_jobs)
+        {
+            ff::job_system jobs(4);
+            std::atomic_int count = 0;
+
+            ff::job_handle root = jobs.run([&jobs, &count]()
+                {
+                    for (int i = 0; i < 16; i++)
+                    {
+                        jobs.run([&jobs, &count]()
+                            {
+                                for (int h = 0; h < 16; h++)
+                                {
+                                    jobs.run([&count]()
+                                        {
+                                            std::this_thread::sleep_for(1ms);
+                                            count.fetch_add(1);
+                                        }, ff::job_system::current_job());
+                                }
+                            }, ff::job_system::current_job());
+                    }
+                });
+
+            root.wait();
+            Assert::IsTrue(root.done());
+            Assert::AreEqual(16 * 16, count.load());
+        }
+
+        TEST_METHOD(child_exception)
+        {
+            ff::job_system jobs(4);
+            std::atomic_int count = 0;
+
+            ff::job_handle root = jobs.run([&jobs, &count]()
+                {
+                    for (int i = 0; i < 16; i++)
+                    {
+                        jobs.run([&count, i]()
+                            {
+                                if (i == 8)
+                                {
+                                    throw std::runtime_error("test");
+                                }
+
+                                count.fetch_add(1);
+                            }, ff::job_system::current_job());
+                    }
+                });
+
+            // The other children still run, and the job system keeps working after the exception
+            Assert::ExpectException<std::runtime_error>([&root]()
+                {
+                    root.wait();
+                });
+
+            Assert::IsTrue(root.done());
+            Assert::AreEqual(15, count.load());
+
+            jobs.run([&count]()
+                {
+                    count.fetch_add(1);
+                }).wait();
+
+            Assert::AreEqual(16, count.load());
+        }
+
+        TEST_METHOD(wait_nesting)
+        {
+            static thread_local size_t depth = 0;
+            std::atomic_size_t max_depth = 0;
+            ff::job_system jobs(4);
+
+            // Every job waits for its children, so waiting threads keep picking up other roots' jobs
+            auto nested_job = [&jobs, &max_depth](size_t level, auto& self) -> void
+                {
+                    depth++;
+                    for (size_t old_max = max_depth.load(); depth > old_max && !max_depth.compare_exchange_weak(old_max, depth);)
+                    {}
+
+                    if (level)
+                    {
+                        std::vector<ff::job_handle> children;
+                        for (size_t i = 0; i < 4; i++)
+                        {
+                            children.push_back(jobs.run([level, &self]()
+                                {
+                                    self(level - 1, self);
+                                }));
+                        }
+
+                        for (const ff::job_handle& child : children)
+                        {
+                            child.wait();
+                        }
+                    }
+
+                    depth--;
+                };
+
+            std::vector<ff::job_handle> roots;
+            for (size_t i = 0; i < 256; i++)
+            {
+                roots.push_back(jobs.run([&nested_job]()
+                    {
+                        nested_job(3, nested_job);
+                    }));
+            }
+
+            for (const ff::job_handle& root : roots)
+            {
+                root.wait();
+            }
+
+            // Unrelated jobs only nest up to the limit, then only the waited-on job's own tree (4 levels here)
+            Assert::IsTrue(max_depth.load() <= ff::job_system::max_wait_nesting + 5);
+        }
+
+        TEST_METHOD(wait_idle)
+        {
+            std::atomic_int count = 0;
+            {
+                ff::job_system jobs(2);
+
+                for (int i = 0; i < 64; i++)
+                {
+                    jobs.run([&count]()
+                        {
+                            std::this_thread::sleep_for(1ms);
+                            count.fetch_add(1);
+                        });
+                }
+
+                jobs.wait_idle();
+                Assert::AreEqual(64, count.load());
+            }
+        }
+
+        TEST_METHOD(large_capture)
+        {
+            ff::job_system jobs(1);
+            std::array<int, 64> values{};
+            values[63] = 63;
+            int result = 0;
+
+            jobs.run([values, &result]()
+                {
+                    result = values[63];
+                }).wait();
+
+            Assert::AreEqual(63, result);
+        }
+
+        TEST_METHOD(thread_pool_jobs)
+        {
+            std::atomic_int count = 0;
+            ff::job_handle root = ff::thread_pool::add_job([&count]()
+                {
+                    for (int i = 0; i < 100; i++)
+                    {
+                        ff::thread_pool::add_job([&count]()
+                            {
+                                count.fetch_add(1);
+                            }, ff::job_system::current_job());
+                    }
+                });
+
+            root.wait();
+            Assert::AreEqual(100, count.load());
+        }
+
+        TEST_METHOD(benchmark)
+        {
+            const size_t task_count = 100000;
+            std::atomic_size_t count = 0;
+            ff::timer timer;
+
+            // Win32 thread pool
+            {
+                ff::win_event done_event;
+                for (size_t i = 0; i < task_count; i++)
+                {
+                    ff::thread_pool::add_task([&count, &done_event, task_count]()
+                        {
+                            if (count.fetch_add(1) + 1 == task_count)
+                            {
+                                done_event.set();
+                            }
+                        });
+                }
+
+                Assert::IsTrue(done_event.wait(10000));
+            }
+
+            const double task_seconds = timer.tick();
+            count = 0;
+
+            // Job system
+            {
+                ff::job_handle root = ff::thread_pool::add_job([&count, task_count]()
+                    {
+                        for (size_t i = 0; i < task_count; i++)
+                        {
+                            ff::thread_pool::add_job([&count]()
+                                {
+                                    count.fetch_add(1);
+                                }, ff::job_system::current_job());
+                        }
+                    });
+
+                root.wait();
+                Assert::AreEqual(task_count, count.load());
+            }
+
+            const double job_seconds = timer.tick();
+
+            ff::log::write(ff::log::type::test, "Tasks: ", task_count,
+                ", add_task: ", task_seconds * 1000.0, "ms",
+                ", add_job: ", job_seconds * 1000.0, "ms",
+                ", threads: ", ff::thread_pool::job_system()->thread_count());
+        }
+    };
+}
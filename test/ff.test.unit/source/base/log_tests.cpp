@@ -0,0 +1,138 @@
+﻿#include "pch.h"
+
+namespace ff::test::base
+{
+    TEST_CLASS(log_tests)
+    {
+    public:
+        TEST_METHOD(write_values)
+        {
+            std::ostringstream output;
+            ff::log::file(&output);
+            ff::scope_exit cleanup([]()
+                {
+                    ff::log::file(nullptr);
+                });
+
+            std::string text = "text";
+            ff::log::write(ff::log::type::test, "string: ", text, ", int: ", 12, ", float: ", 1.5f, ", char: ", 'c', ", path: ", std::filesystem::path("a/b"));
+            ff::log::flush();
+
+            const std::string output_text = output.str();
+            Assert::IsTrue(output_text.starts_with("[ff/test,"));
+            Assert::IsTrue(output_text.ends_with("] string: text, int: 12, float: 1.5, char: c, path: \"a/b\"\r\n"));
+        }
+
+        TEST_METHOD(pointer_values)
+        {
+            std::ostringstream output;
+            ff::log::file(&output);
+            ff::scope_exit cleanup([]()
+                {
+                    ff::log::file(nullptr);
+                });
+
+            // Pointed-to text must be captured by write(), not when the writer thread gets to it
+            unsigned char buffer[8] = "before";
+            ff::log::write(ff::log::type::test, "text: ", static_cast<const unsigned char*>(buffer));
+            std::memcpy(buffer, "after", 6);
+            ff::log::flush();
+
+            Assert::IsTrue(output.str().ends_with("] text: before\r\n"));
+        }
+
+        TEST_METHOD(type_enabled)
+        {
+            std::ostringstream output;
+            ff::log::file(&output);
+            ff::scope_exit cleanup([]()
+                {
+                    ff::log::type_enabled(ff::log::type::test, true);
+                    ff::log::file(nullptr);
+                });
+
+            ff::log::type_enabled(ff::log::type::test, false);
+            Assert::IsFalse(ff::log::type_enabled(ff::log::type::test));
+            ff::log::write(ff::log::type::test, "hidden");
+
+            ff::log::type_enabled(ff::log::type::test, true);
+            Assert::IsTrue(ff::log::type_enabled(ff::log::type::test));
+            ff::log::write(ff::log::type::test, "visible");
+            ff::log::flush();
+
+            Assert::IsTrue(output.str().find("hidden") == std::string::npos);
+            Assert::IsTrue(output.str().find("] visible\r\n") != std::string::npos);
+        }
+
+        TEST_METHOD(threads)
+        {
+            const size_t thread_count = 8;
+            const size_t write_count = 10000;
+            const size_t old_dropped = ff::log::dropped_count();
+
+            std::ostringstream output;
+            ff::log::file(&output);
+            ff::scope_exit cleanup([]()
+                {
+                    ff::log::file(nullptr);
+                });
+
+            std::vector<std::jthread> threads;
+            for (size_t i = 0; i < thread_count; i++)
+            {
+                threads.emplace_back([i, write_count]()
+                    {
+                        for (size_t h = 0; h < write_count; h++)
+                        {
+                            // Some records are too big for the ring
+                            ff::log::write(ff::log::type::test, "thread: ", i, ", record: ", h, (h % 1000) ? std::string() : std::string(32768, '.'));
+                        }
+                    });
+            }
+
+            threads.clear();
+            ff::log::flush();
+
+            // Every record is either written or counted as dropped
+            size_t record_count = 0;
+            std::istringstream input(output.str());
+            for (std::string line; std::getline(input, line); )
+            {
+                record_count += (line.find("] thread: ") != std::string::npos) ? 1 : 0;
+            }
+
+            Assert::AreEqual(thread_count * write_count, record_count + ff::log::dropped_count() - old_dropped);
+        }
+
+        TEST_METHOD(benchmark)
+        {
+            const size_t write_count = 100000;
+            std::ostringstream output;
+            ff::log::file(&output);
+            ff::scope_exit cleanup([]()
+                {
+                    ff::log::type_enabled(ff::log::type::test, true);
+                    ff::log::file(nullptr);
+                });
+
+            for (bool enabled : { false, true })
+            {
+                ff::log::type_enabled(ff::log::type::test, enabled);
+                const size_t old_dropped = ff::log::dropped_count();
+                ff::timer timer;
+
+                for (size_t i = 0; i < write_count; i++)
+                {
+                    ff::log::write(ff::log::type::test, "Benchmark record: ", i, ", value: ", 1.5);
+                }
+
+                const double seconds = timer.tick();
+                ff::log::flush();
+                ff::log::type_enabled(ff::log::type::test, true);
+                ff::log::write(ff::log::type::test, "log write enabled: ", enabled,
+                    ", time per write: ", seconds * 1000000000.0 / write_count, "ns",
+                    ", dropped: ", ff::log::dropped_count() - old_dropped);
+            }
+        }
+    };
+}
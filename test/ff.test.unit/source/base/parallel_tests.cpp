@@ -0,0 +1,174 @@
+#include "pch.h"
+
+namespace ff::test::base
+{
+    TEST_CLASS(parallel_tests)
+    {
+    public:
+        TEST_METHOD(parallel_for)
+        {
+            std::vector<int> values(100000);
+
+            ff::parallel_for(0, values.size(), 0, [&values](size_t i)
+                {
+                    values[i] = static_cast<int>(i);
+                }).wait();
+
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                Assert::AreEqual(static_cast<int>(i), values[i]);
+            }
+        }
+
+        TEST_METHOD(parallel_for_empty)
+        {
+            int count = 0;
+            ff::co_task<> task = ff::parallel_for(10, 10, 0, [&count](size_t i)
+                {
+                    count++;
+                });
+
+            Assert::IsTrue(task.done());
+            Assert::AreEqual(0, count);
+        }
+
+        TEST_METHOD(parallel_for_exception)
+        {
+            ff::co_task<> task = ff::parallel_for(0, 1000, 10, [](size_t i)
+                {
+                    if (i == 500)
+                    {
+                        throw std::runtime_error("test");
+                    }
+                });
+
+            Assert::ExpectException<std::runtime_error>([task]()
+                {
+                    task.wait();
+                });
+        }
+
+        TEST_METHOD(parallel_exception_inline)
+        {
+            // Without a job system everything runs inline, exceptions must still come through the task
+            ff::co_task<> for_task = ff::parallel_for(nullptr, 0, 10, 0, [](size_t i)
+                {
+                    throw std::runtime_error("test");
+                });
+
+            ff::co_task<int> reduce_task = ff::parallel_reduce<int>(nullptr, 0, 10, 0, 0,
+                [](size_t i) -> int
+                {
+                    throw std::runtime_error("test");
+                },
+                [](int a, int b)
+                {
+                    return a + b;
+                });
+
+            Assert::IsTrue(for_task.done() && reduce_task.done());
+            Assert::ExpectException<std::runtime_error>([for_task]()
+                {
+                    for_task.wait();
+                });
+
+            Assert::ExpectException<std::runtime_error>([reduce_task]()
+                {
+                    reduce_task.wait();
+                });
+        }
+
+        TEST_METHOD(parallel_reduce)
+        {
+            ff::co_task<uint64_t> task = ff::parallel_reduce<uint64_t>(1, 100001, 1000, 0,
+                [](size_t i)
+                {
+                    return static_cast<uint64_t>(i);
+                },
+                [](uint64_t a, uint64_t b)
+                {
+                    return a + b;
+                });
+
+            task.wait();
+            Assert::AreEqual<uint64_t>(5000050000, task.result());
+        }
+
+        TEST_METHOD(parallel_reduce_order)
+        {
+            ff::co_task<std::string> task = ff::parallel_reduce<std::string>(0, 26, 3, std::string(),
+                [](size_t i)
+                {
+                    return std::string(1, static_cast<char>('a' + i));
+                },
+                [](std::string a, std::string b)
+                {
+                    return a + b;
+                });
+
+            task.wait();
+            Assert::AreEqual(std::string("abcdefghijklmnopqrstuvwxyz"), task.result());
+        }
+
+        TEST_METHOD(await_from_task)
+        {
+            int result = 0;
+            ff::co_task<> task = ff::test::base::parallel_tests::await_parallel(result);
+            Assert::IsTrue(task.wait(10000));
+            Assert::AreEqual(4950, result);
+        }
+
+        TEST_METHOD(benchmark)
+        {
+            const size_t count = 1 << 22;
+            const size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+            std::vector<float> values(count);
+            double one_thread_seconds = 0;
+
+            for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+            {
+                ff::job_system jobs(thread_count);
+                ff::timer timer;
+
+                for (int repeat = 0; repeat < 8; repeat++)
+                {
+                    ff::parallel_for(&jobs, 0, count, 4096, [&values](size_t i)
+                        {
+                            values[i] = std::sqrt(static_cast<float>(i)) * std::sin(static_cast<float>(i));
+                        }).wait();
+                }
+
+                const double seconds = timer.tick();
+                one_thread_seconds = (thread_count == 1) ? seconds : one_thread_seconds;
+
+                ff::log::write(ff::log::type::test, "parallel_for threads: ", thread_count,
+                    ", time: ", seconds * 1000.0, "ms",
+                    ", speedup: ", one_thread_seconds / seconds);
+            }
+        }
+
+    private:
+        ff::co_task<> await_parallel(int& result)
+        {
+            co_await ff::task::resume_on_task();
+
+            std::atomic_int sum = 0;
+            co_await ff::parallel_for(0, 100, 1, [&sum](size_t i)
+                {
+                    sum.fetch_add(static_cast<int>(i));
+                });
+
+            result = co_await ff::parallel_reduce<int>(0, 100, 1, 0,
+                [](size_t i)
+                {
+                    return static_cast<int>(i);
+                },
+                [](int a, int b)
+                {
+                    return a + b;
+                });
+
+            Assert::AreEqual(result, sum.load());
+        }
+    };
+}
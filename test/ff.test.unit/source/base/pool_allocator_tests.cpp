@@ -58,12 +58,119 @@ namespace ff::test::base
     public:
         TEST_METHOD(basic_thread_safe)
         {
-            ::pool_allocator_test<false>();
+            ::pool_allocator_test<true>();
         }
 
         TEST_METHOD(basic_thread_unsafe)
         {
             ::pool_allocator_test<false>();
         }
+
+        TEST_METHOD(cross_thread)
+        {
+            using test_data = std::tuple<int, float>;
+            ff::pool_allocator<test_data> pool;
+            std::vector<test_data*> all;
+
+            for (int i = 0; i < 1000; i++)
+            {
+                all.push_back(pool.new_obj(i, static_cast<float>(i)));
+            }
+
+            // Free on another thread, then allocate everything again on this one
+            std::thread([&pool, &all]()
+                {
+                    for (test_data* data : all)
+                    {
+                        pool.delete_obj(data);
+                    }
+                }).join();
+
+            size_t size, allocated;
+            pool.get_stats(&size, &allocated);
+            Assert::AreEqual<size_t>(0, size);
+
+            for (int i = 0; i < 1000; i++)
+            {
+                all[i] = pool.new_obj(i, static_cast<float>(i));
+            }
+
+            size_t allocated2;
+            pool.get_stats(&size, &allocated2);
+            Assert::AreEqual<size_t>(1000, size);
+            Assert::AreEqual(allocated, allocated2);
+
+            for (test_data* data : all)
+            {
+                pool.delete_obj(data);
+            }
+        }
+
+        TEST_METHOD(contention_benchmark)
+        {
+            using test_data = std::array<size_t, 4>;
+            const size_t op_count = 1 << 20;
+            const size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+            for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+            {
+                ff::pool_allocator<test_data> pool;
+                double pool_seconds = 0;
+                double heap_seconds = 0;
+
+                for (int use_pool = 1; use_pool >= 0; use_pool--)
+                {
+                    ff::timer timer;
+                    std::vector<std::thread> threads;
+
+                    for (size_t i = 0; i < thread_count; i++)
+                    {
+                        threads.emplace_back([&pool, use_pool, op_count]()
+                            {
+                                std::array<test_data*, 64> live{};
+                                for (size_t h = 0; h < op_count; h++)
+                                {
+                                    test_data*& data = live[h % live.size()];
+                                    if (use_pool)
+                                    {
+                                        pool.delete_obj(data);
+                                        data = pool.new_obj();
+                                    }
+                                    else
+                                    {
+                                        delete data;
+                                        data = new test_data();
+                                    }
+                                }
+
+                                for (test_data* data : live)
+                                {
+                                    if (use_pool)
+                                    {
+                                        pool.delete_obj(data);
+                                    }
+                                    else
+                                    {
+                                        delete data;
+                                    }
+                                }
+                            });
+                    }
+
+                    for (std::thread& thread : threads)
+                    {
+                        thread.join();
+                    }
+
+                    const double seconds = timer.tick();
+                    pool_seconds = use_pool ? seconds : pool_seconds;
+                    heap_seconds = use_pool ? heap_seconds : seconds;
+                }
+
+                ff::log::write(ff::log::type::test, "pool_allocator threads: ", thread_count,
+                    ", pool: ", pool_seconds * 1000.0, "ms",
+                    ", new/delete: ", heap_seconds * 1000.0, "ms");
+            }
+        }
     };
 }
@@ -0,0 +1,113 @@
+﻿#include "pch.h"
+
+static std::vector<uint8_t> create_hash_test_data(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+
+    return data;
+}
+
+namespace ff::test::base
+{
+    TEST_CLASS(stable_hash_tests)
+    {
+    public:
+        TEST_METHOD(stable_hash_unchanged)
+        {
+            // Persisted cookies depend on this, it must never change
+            const std::vector<uint8_t> data = ::create_hash_test_data(64);
+            Assert::AreEqual<size_t>(0xaff09d757d549f50ULL, ff::stable_hash_bytes(data.data(), data.size()));
+        }
+
+        TEST_METHOD(wide_hash_values)
+        {
+            // Same values as XXH3_64bits_withSeed, covers each size path
+            struct expected_hash
+            {
+                size_t size;
+                uint64_t hash;
+                uint64_t seeded_hash;
+            };
+
+            const expected_hash expected_hashes[] =
+            {
+                { 0, 0x2d06800538d394c2ULL, 0xb029411ff43d84d2ULL },
+                { 3, 0x5c83885a0fb5d516ULL, 0x4d629dedfa4a1ebfULL },
+                { 8, 0x96cc97a6768fd7a9ULL, 0xd108df704dd8b358ULL },
+                { 16, 0x913bd4a8038027a7ULL, 0x125ad96bf3142cb2ULL },
+                { 64, 0x13886553e7dc3fa3ULL, 0x257b4a0c6f0dd803ULL },
+                { 200, 0x70d27115faab301eULL, 0xba60feb5f0660bd2ULL },
+                { 4096, 0x99e3c931dab3e711ULL, 0x6c012bd9da1209b9ULL },
+            };
+
+            const std::vector<uint8_t> data = ::create_hash_test_data(4096);
+            Assert::AreEqual(1u, ff::wide_hash_version);
+
+            for (const expected_hash& expected : expected_hashes)
+            {
+                Assert::AreEqual(expected.hash, ff::wide_hash_bytes(data.data(), expected.size));
+                Assert::AreEqual(expected.seeded_hash, ff::wide_hash_bytes(data.data(), expected.size, 42));
+            }
+        }
+
+        TEST_METHOD(wide_hash_unaligned)
+        {
+            const std::vector<uint8_t> data = ::create_hash_test_data(1024);
+            std::vector<uint8_t> shifted(data.size() + 3);
+
+            for (size_t size = 0; size <= 1021; size++)
+            {
+                std::memcpy(shifted.data() + 3, data.data(), size);
+                Assert::AreEqual(ff::wide_hash_bytes(data.data(), size), ff::wide_hash_bytes(shifted.data() + 3, size));
+            }
+        }
+
+        TEST_METHOD(wide_hash_types)
+        {
+            const DirectX::XMFLOAT4X4 matrix(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+            Assert::AreEqual(static_cast<size_t>(ff::wide_hash_bytes(&matrix, sizeof(matrix))), ff::wide_hash<DirectX::XMFLOAT4X4>()(matrix));
+
+            const std::string text = "Hello world";
+            Assert::AreEqual(static_cast<size_t>(ff::wide_hash_bytes(text.data(), text.size())), ff::wide_hash<std::string>()(text));
+            Assert::AreEqual(ff::wide_hash<std::string>()(text), ff::wide_hash<std::string_view>()(text));
+        }
+
+        TEST_METHOD(benchmark)
+        {
+            const size_t total_bytes = 64 * 1024 * 1024;
+            std::vector<uint8_t> data = ::create_hash_test_data(4096);
+
+            for (size_t size : { 8, 16, 64, 4096 })
+            {
+                const size_t count = total_bytes / size;
+                size_t stable_total = 0;
+                uint64_t wide_total = 0;
+
+                ff::timer timer;
+                for (size_t i = 0; i < count; i++)
+                {
+                    data[0] = static_cast<uint8_t>(i);
+                    stable_total += ff::stable_hash_bytes(data.data(), size);
+                }
+
+                const double stable_seconds = timer.tick();
+                for (size_t i = 0; i < count; i++)
+                {
+                    data[0] = static_cast<uint8_t>(i);
+                    wide_total += ff::wide_hash_bytes(data.data(), size);
+                }
+
+                const double wide_seconds = timer.tick();
+                Assert::IsTrue(stable_total != 0 && wide_total != 0);
+
+                ff::log::write(ff::log::type::test, "Hash ", size, " bytes",
+                    ", stable: ", stable_seconds * 1000000000.0 / count, "ns (", total_bytes / stable_seconds / 1048576.0, " MB/s)",
+                    ", wide: ", wide_seconds * 1000000000.0 / count, "ns (", total_bytes / wide_seconds / 1048576.0, " MB/s)");
+            }
+        }
+    };
+}
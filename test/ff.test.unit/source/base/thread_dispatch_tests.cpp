@@ -39,5 +39,190 @@ namespace ff::test::base
                     Assert::AreEqual(20, i2);
                 });
         }
+
+        TEST_METHOD(fifo_order)
+        {
+            std::jthread([]()
+                {
+                    ff::thread_dispatch td(ff::thread_dispatch_type::task);
+                    std::vector<int> order;
+
+                    for (int i = 0; i < 100; i++)
+                    {
+                        td.post([&order, i]()
+                            {
+                                order.push_back(i);
+                            });
+                    }
+
+                    td.flush();
+
+                    Assert::AreEqual<size_t>(100, order.size());
+                    for (int i = 0; i < 100; i++)
+                    {
+                        Assert::AreEqual(i, order[i]);
+                    }
+                });
+        }
+
+        TEST_METHOD(post_while_destroyed)
+        {
+            constexpr size_t producer_count = 4;
+            constexpr size_t posts_before_destroy = 10000;
+
+            std::atomic_size_t posted_count = 0;
+            std::atomic_size_t run_count = 0;
+            std::atomic_bool stop = false;
+            ff::win_event created_event;
+
+            // The storage outlives the producers, so a post that starts after the destructor returns only sees that it was destroyed
+            std::optional<ff::thread_dispatch> td;
+
+            std::jthread owner([&td, &posted_count, &created_event]()
+                {
+                    td.emplace(ff::thread_dispatch_type::task);
+                    created_event.set();
+
+                    while (posted_count.load() < posts_before_destroy)
+                    {
+                        td->wait_for_dispatch();
+                    }
+
+                    // Producers are still posting while this runs
+                    td.reset();
+                });
+
+            created_event.wait(INFINITE, false);
+            ff::thread_dispatch* dispatch = &*td;
+            {
+                std::vector<std::jthread> producers;
+                for (size_t i = 0; i < producer_count; i++)
+                {
+                    producers.emplace_back([dispatch, &posted_count, &run_count, &stop]()
+                        {
+                            while (!stop.load())
+                            {
+                                posted_count.fetch_add(1);
+                                dispatch->post([&run_count]()
+                                    {
+                                        run_count.fetch_add(1);
+                                    });
+                            }
+                        });
+                }
+
+                owner.join();
+                stop.store(true);
+            }
+
+            // Every post ran exactly once, either by the dispatch thread or inline after it was destroyed
+            Assert::AreEqual(posted_count.load(), run_count.load());
+        }
+
+        TEST_METHOD(benchmark)
+        {
+            constexpr size_t producer_count = 8;
+            constexpr size_t posts_per_producer = 100000;
+            constexpr size_t total_posts = producer_count * posts_per_producer;
+
+            // The old implementation: a locked list that is swapped out and reversed by the consumer
+            struct locked_list_dispatch
+            {
+                void post(std::function<void()>&& func)
+                {
+                    std::scoped_lock lock(this->mutex);
+                    bool was_empty = this->funcs.empty();
+                    this->funcs.push_front(std::move(func));
+
+                    if (was_empty)
+                    {
+                        this->pending_event.set();
+                    }
+                }
+
+                void flush()
+                {
+                    std::forward_list<std::function<void()>> funcs;
+                    {
+                        std::scoped_lock lock(this->mutex);
+                        funcs = std::move(this->funcs);
+                        this->pending_event.reset();
+                    }
+
+                    funcs.reverse();
+                    for (auto& func : funcs)
+                    {
+                        func();
+                    }
+                }
+
+                std::recursive_mutex mutex;
+                std::forward_list<std::function<void()>> funcs;
+                ff::win_event pending_event;
+            };
+
+            double locked_seconds = 0;
+            double lock_free_seconds = 0;
+
+            std::jthread([&locked_seconds]()
+                {
+                    locked_list_dispatch td;
+                    size_t count = 0;
+                    ff::timer timer;
+                    {
+                        std::vector<std::jthread> producers;
+                        for (size_t i = 0; i < producer_count; i++)
+                        {
+                            producers.emplace_back([&td, &count]()
+                                {
+                                    for (size_t h = 0; h < posts_per_producer; h++)
+                                    {
+                                        td.post([&count]() { count++; });
+                                    }
+                                });
+                        }
+
+                        while (count < total_posts)
+                        {
+                            td.pending_event.wait(INFINITE, false);
+                            td.flush();
+                        }
+                    }
+
+                    locked_seconds = timer.tick();
+                });
+
+            std::jthread([&lock_free_seconds]()
+                {
+                    ff::thread_dispatch td(ff::thread_dispatch_type::task);
+                    size_t count = 0;
+                    ff::timer timer;
+                    {
+                        std::vector<std::jthread> producers;
+                        for (size_t i = 0; i < producer_count; i++)
+                        {
+                            producers.emplace_back([&td, &count]()
+                                {
+                                    for (size_t h = 0; h < posts_per_producer; h++)
+                                    {
+                                        td.post([&count]() { count++; });
+                                    }
+                                });
+                        }
+
+                        while (count < total_posts)
+                        {
+                            td.wait_for_dispatch();
+                        }
+                    }
+
+                    lock_free_seconds = timer.tick();
+                });
+
+            ff::log::write(ff::log::type::test, "thread_dispatch::post, producers: ", producer_count,
+                ", posts: ", total_posts,
+                ", locked list: ", locked_seconds * 1000.0, "ms",
+                ", lock free queue: ", lock_free_seconds * 1000.0, "ms");
+        }
     };
 }
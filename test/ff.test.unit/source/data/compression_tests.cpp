@@ -43,5 +43,206 @@ namespace ff::test::data
                 Assert::IsTrue(!std::memcmp(com_spec_data->data(), uncompress_vector->data(), uncompress_vector->size()));
             }
         }
+
+        TEST_METHOD(compress_chunked)
+        {
+            std::vector<uint8_t> data = ff::test::data::compression_tests::create_test_data(1024 * 1024 + 123);
+            auto compress_vector = std::make_shared<std::vector<uint8_t>>();
+
+            ff::data_writer writer(compress_vector);
+            Assert::IsTrue(ff::compression::compress_chunked(ff::data_static(data.data(), data.size()), writer, 64 * 1024));
+
+            ff::data_vector compress_data(compress_vector);
+            Assert::IsTrue(compress_data.size() < data.size());
+            Assert::AreEqual(data.size(), ff::compression::chunked_loaded_size(compress_data));
+
+            // All at once
+            std::vector<uint8_t> uncompress_vector(data.size());
+            Assert::IsTrue(ff::compression::uncompress_chunked(compress_data, 0, uncompress_vector.data(), uncompress_vector.size()));
+            Assert::IsTrue(uncompress_vector == data);
+
+            // Random access, within one chunk and across chunk boundaries
+            const std::array<std::pair<size_t, size_t>, 5> ranges{ { { 5, 10 }, { 64 * 1024 - 10, 20 }, { 100000, 300000 }, { data.size() - 1, 1 }, { data.size(), 0 } } };
+            for (auto [offset, size] : ranges)
+            {
+                std::vector<uint8_t> part(size);
+                Assert::IsTrue(ff::compression::uncompress_chunked(compress_data, offset, part.data(), part.size()));
+                Assert::IsTrue(!std::memcmp(data.data() + offset, part.data(), size));
+            }
+
+            // Through saved data
+            auto saved_data = std::make_shared<ff::saved_data_static>(std::make_shared<ff::data_vector>(compress_vector), data.size(), ff::saved_data_type::zlib_chunked);
+            std::shared_ptr<ff::data_base> loaded_data = saved_data->loaded_data();
+            Assert::IsNotNull(loaded_data.get());
+            Assert::AreEqual(data.size(), loaded_data->size());
+            Assert::IsTrue(!std::memcmp(data.data(), loaded_data->data(), data.size()));
+        }
+
+        TEST_METHOD(codecs)
+        {
+            for (size_t size : { 0, 1, 12, 13, 1000, 300000 })
+            {
+                std::vector<uint8_t> data = ff::test::data::compression_tests::create_test_data(size);
+                std::shared_ptr<ff::data_base> data_source = std::make_shared<ff::data_static>(data.data(), data.size());
+
+                for (std::string_view name : { "zlib", "zlib_chunked", "lz4" })
+                {
+                    const ff::compression::codec_base* codec = ff::compression::get_codec(name);
+                    Assert::IsNotNull(codec);
+                    Assert::IsTrue(ff::compression::get_codec(codec->type()) == codec);
+                    Assert::IsTrue(ff::flags::has(ff::compression::codec_types(), codec->type()));
+
+                    // Saving data as a value compresses it, loading it back uncompresses it
+                    ff::value_ptr data_value = ff::value::create<ff::data_base>(data_source, ff::flags::combine(codec->type(), ff::saved_data_type::dict));
+                    std::shared_ptr<ff::saved_data_base> saved_data = data_value->try_convert<ff::saved_data_base>()->get<ff::saved_data_base>();
+                    Assert::IsTrue(saved_data->type() == (size ? ff::flags::combine(codec->type(), ff::saved_data_type::dict) : ff::saved_data_type::dict));
+                    Assert::AreEqual(size, saved_data->loaded_size());
+
+                    std::shared_ptr<ff::data_base> loaded_data = saved_data->loaded_data();
+                    Assert::IsNotNull(loaded_data.get());
+                    Assert::AreEqual(size, loaded_data->size());
+                    Assert::IsTrue(!size || !std::memcmp(data.data(), loaded_data->data(), size));
+                }
+            }
+
+            Assert::IsNull(ff::compression::get_codec("none"));
+            Assert::IsNull(ff::compression::get_codec(ff::saved_data_type::dict));
+        }
+
+        TEST_METHOD(lz4_reference_blocks)
+        {
+            // Blocks written by the reference LZ4_compress_default (liblz4 1.9.4) for each input
+            const std::string sentence = "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog!";
+            std::string counting;
+            for (size_t i = 0; i < 120; i++)
+            {
+                counting.push_back(static_cast<char>(i % 40));
+            }
+
+            const std::array<std::pair<std::string, std::vector<uint8_t>>, 5> tests
+            { {
+                { "", { 0x00 } },
+                { "hello", { 0x50, 0x68, 0x65, 0x6C, 0x6C, 0x6F } },
+                { std::string(64, 'a'), { 0x1F, 0x61, 0x01, 0x00, 0x27, 0x50, 0x61, 0x61, 0x61, 0x61, 0x61 } },
+                { sentence,
+                    {
+                        0xFF, 0x1E, 0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6B, 0x20, 0x62, 0x72, 0x6F, 0x77,
+                        0x6E, 0x20, 0x66, 0x6F, 0x78, 0x20, 0x6A, 0x75, 0x6D, 0x70, 0x73, 0x20, 0x6F, 0x76, 0x65, 0x72,
+                        0x20, 0x74, 0x68, 0x65, 0x20, 0x6C, 0x61, 0x7A, 0x79, 0x20, 0x64, 0x6F, 0x67, 0x2E, 0x20, 0x2D,
+                        0x00, 0x14, 0x50, 0x20, 0x64, 0x6F, 0x67, 0x21,
+                    } },
+                { counting,
+                    {
+                        0xFF, 0x19, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D,
+                        0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D,
+                        0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x00, 0x38, 0x50, 0x23, 0x24,
+                        0x25, 0x26, 0x27,
+                    } },
+            } };
+
+            for (const auto& [input, block] : tests)
+            {
+                // Only the block is reference data, the header in front of it comes from compress_lz4
+                auto compress_vector = std::make_shared<std::vector<uint8_t>>();
+                {
+                    ff::data_writer writer(compress_vector);
+                    Assert::IsTrue(ff::compression::compress_lz4(ff::data_static(reinterpret_cast<const uint8_t*>(input.data()), input.size()), writer));
+                }
+
+                const size_t header_size = 2 * sizeof(uint64_t);
+                Assert::IsTrue(compress_vector->size() >= header_size);
+                compress_vector->resize(header_size);
+                compress_vector->insert(compress_vector->end(), block.begin(), block.end());
+
+                std::vector<uint8_t> uncompress_vector(input.size());
+                Assert::IsTrue(ff::compression::uncompress_lz4(ff::data_vector(compress_vector), uncompress_vector.data(), uncompress_vector.size()));
+                Assert::IsTrue(std::equal(input.begin(), input.end(), uncompress_vector.begin(), uncompress_vector.end(),
+                    [](char c, uint8_t b) { return static_cast<uint8_t>(c) == b; }));
+            }
+        }
+
+        TEST_METHOD(compress_benchmark)
+        {
+            std::vector<uint8_t> data = ff::test::data::compression_tests::create_test_data(32 * 1024 * 1024);
+            ff::data_static data_source(data.data(), data.size());
+            const double mb = data.size() / (1024.0 * 1024.0);
+            ff::timer timer;
+
+            auto compress_vector = std::make_shared<std::vector<uint8_t>>();
+            {
+                ff::data_reader reader(std::make_shared<ff::data_static>(data.data(), data.size()));
+                ff::data_writer writer(compress_vector);
+                Assert::IsTrue(ff::compression::compress(reader, data.size(), writer));
+            }
+
+            const double compress_seconds = timer.tick();
+
+            auto uncompress_vector = std::make_shared<std::vector<uint8_t>>();
+            {
+                ff::data_reader reader(std::make_shared<ff::data_vector>(compress_vector));
+                ff::data_writer writer(uncompress_vector);
+                Assert::IsTrue(ff::compression::uncompress(reader, compress_vector->size(), writer));
+                Assert::IsTrue(*uncompress_vector == data);
+            }
+
+            const double uncompress_seconds = timer.tick();
+
+            auto chunked_vector = std::make_shared<std::vector<uint8_t>>();
+            {
+                ff::data_writer writer(chunked_vector);
+                Assert::IsTrue(ff::compression::compress_chunked(data_source, writer));
+            }
+
+            const double compress_chunked_seconds = timer.tick();
+
+            {
+                std::vector<uint8_t> buffer(data.size());
+                Assert::IsTrue(ff::compression::uncompress_chunked(ff::data_vector(chunked_vector), 0, buffer.data(), buffer.size()));
+                Assert::IsTrue(buffer == data);
+            }
+
+            const double uncompress_chunked_seconds = timer.tick();
+
+            auto lz4_vector = std::make_shared<std::vector<uint8_t>>();
+            {
+                ff::data_writer writer(lz4_vector);
+                Assert::IsTrue(ff::compression::compress_lz4(data_source, writer));
+            }
+
+            const double compress_lz4_seconds = timer.tick();
+
+            {
+                std::vector<uint8_t> buffer(data.size());
+                Assert::IsTrue(ff::compression::uncompress_lz4(ff::data_vector(lz4_vector), buffer.data(), buffer.size()));
+                Assert::IsTrue(buffer == data);
+            }
+
+            const double uncompress_lz4_seconds = timer.tick();
+
+            ff::log::write(ff::log::type::test, "Compress ", mb, "MB, threads: ", ff::thread_pool::job_system()->thread_count());
+            ff::log::write(ff::log::type::test, "  zlib: ", compress_vector->size(), " bytes, compress: ", mb / compress_seconds, "MB/s, uncompress: ", mb / uncompress_seconds, "MB/s");
+            ff::log::write(ff::log::type::test, "  chunked: ", chunked_vector->size(), " bytes, compress: ", mb / compress_chunked_seconds, "MB/s, uncompress: ", mb / uncompress_chunked_seconds, "MB/s");
+            ff::log::write(ff::log::type::test, "  lz4: ", lz4_vector->size(), " bytes, compress: ", mb / compress_lz4_seconds, "MB/s, uncompress: ", mb / uncompress_lz4_seconds, "MB/s");
+        }
+
+    private:
+        // Repeating words with some noise, so that it compresses about as well as typical resource data
+        static std::vector<uint8_t> create_test_data(size_t size)
+        {
+            static const std::array<std::string_view, 8> words{ "texture", "sprite", "palette", "animation", "value", "\r\n", "  ", "0123" };
+            std::mt19937 random(42);
+            std::vector<uint8_t> data;
+            data.reserve(size + 16);
+
+            while (data.size() < size)
+            {
+                std::string_view word = words[random() % words.size()];
+                data.insert(data.end(), word.begin(), word.end());
+                data.push_back(static_cast<uint8_t>(random()));
+            }
+
+            data.resize(size);
+            return data;
+        }
     };
 }
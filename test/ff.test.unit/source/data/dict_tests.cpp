@@ -32,5 +32,111 @@ namespace ff::test::data
             Assert::AreEqual<size_t>(1, dict1.size());
             Assert::IsTrue(dict1 == dict2);
         }
+
+        TEST_METHOD(loaded_flat)
+        {
+            ff::dict dict1;
+            dict1.set<int>("zoo"sv, 3);
+            dict1.set<int>("bar"sv, 2);
+            dict1.set<std::string>("foo"sv, "Hello!");
+            dict1.set<int>(""sv, 1);
+
+            auto buffer = std::make_shared<std::vector<uint8_t>>();
+            {
+                ff::data_writer writer(buffer);
+                Assert::IsTrue(dict1.save(writer));
+            }
+
+            ff::dict dict2;
+            {
+                ff::data_reader reader(std::make_shared<ff::data_vector>(buffer));
+                Assert::IsTrue(ff::dict::load(reader, dict2));
+            }
+
+            Assert::IsTrue(dict1 == dict2);
+            Assert::AreEqual(3, dict2.get<int>("zoo"sv));
+            Assert::AreEqual(3, dict2.get<int>(ff::atom("zoo"sv)));
+            Assert::AreEqual(1, dict2.get<int>(""sv));
+            Assert::AreEqual(std::string("Hello!"), dict2.get<std::string>(ff::atom("foo"sv)));
+            Assert::AreEqual(5, dict2.get<int>(ff::atom("missing"sv), 5));
+            Assert::IsFalse(dict2.get("missing"sv));
+
+            std::vector<std::string_view> names;
+            for (const auto& i : std::as_const(dict2))
+            {
+                names.push_back(i.first);
+            }
+
+            std::vector<std::string_view> expect_names{ ""sv, "bar"sv, "foo"sv, "zoo"sv };
+            Assert::IsTrue(expect_names == names);
+            Assert::IsTrue(expect_names == dict2.child_names(true));
+
+            // Changing a copy doesn't change the original
+            ff::dict dict3 = dict2;
+            dict3.set<int>("bar"sv, 20);
+            Assert::AreEqual(20, dict3.get<int>(ff::atom("bar"sv)));
+            Assert::AreEqual(2, dict2.get<int>("bar"sv));
+            Assert::AreEqual<size_t>(4, dict3.size());
+
+            // Values can be changed while iterating
+            ff::dict dict4 = dict2;
+            for (auto& i : dict4)
+            {
+                i.second = ff::value::create<int>(0);
+            }
+
+            Assert::AreEqual(0, dict4.get<int>("zoo"sv));
+            Assert::AreEqual(3, dict2.get<int>("zoo"sv));
+        }
+
+        TEST_METHOD(loaded_indexed)
+        {
+            const std::array<uint8_t, 4> bytes{ 1, 2, 3, 4 };
+            ff::dict child;
+            child.set<int>("child"sv, 4);
+
+            ff::dict dict1;
+            dict1.set<int>("zoo"sv, 3);
+            dict1.set<std::string>("foo"sv, "Hello!");
+            dict1.set<ff::dict>("dict"sv, std::move(child));
+            dict1.set_bytes("bytes"sv, bytes.data(), bytes.size());
+
+            auto buffer = std::make_shared<std::vector<uint8_t>>();
+            {
+                ff::data_writer writer(buffer);
+                Assert::IsTrue(dict1.save_indexed(writer));
+            }
+
+            auto data = std::make_shared<ff::data_vector>(buffer);
+            ff::dict dict2;
+            Assert::IsTrue(ff::dict::load_indexed(data, dict2));
+            Assert::AreEqual<size_t>(4, dict2.size());
+
+            std::vector<std::string_view> expect_names{ "bytes"sv, "dict"sv, "foo"sv, "zoo"sv };
+            Assert::IsTrue(expect_names == dict2.child_names());
+            Assert::AreEqual(3, dict2.get<int>(ff::atom("zoo"sv)));
+            Assert::AreEqual(4, dict2.get<ff::dict>("dict"sv).get<int>("child"sv));
+            Assert::AreEqual(4, dict2.get<int>("/dict/child"sv));
+            Assert::IsFalse(dict2.get("missing"sv));
+
+            // Data values point into the saved buffer
+            std::shared_ptr<ff::data_base> bytes_data = dict2.get<ff::data_base>("bytes"sv);
+            Assert::AreEqual(bytes.size(), bytes_data->size());
+            Assert::IsTrue(bytes_data->data() >= buffer->data() && bytes_data->data() < buffer->data() + buffer->size());
+            Assert::IsTrue(std::memcmp(bytes.data(), bytes_data->data(), bytes.size()) == 0);
+
+            Assert::IsTrue(dict1 == dict2);
+
+            // Converting to data uses the indexed format
+            ff::value_ptr data_value = ff::value::create<ff::dict>(std::move(dict1))->try_convert<ff::data_base>();
+            Assert::IsTrue(ff::flags::has(static_cast<const ff::type::data_v*>(data_value.get())->saved_data_type(), ff::saved_data_type::dict_indexed));
+            Assert::IsTrue(dict2 == data_value->try_convert<ff::dict>()->get<ff::dict>());
+
+            // Corrupt data doesn't load
+            auto bad_buffer = std::make_shared<std::vector<uint8_t>>(*buffer);
+            bad_buffer->resize(bad_buffer->size() / 2);
+            ff::dict dict3;
+            Assert::IsFalse(ff::dict::load_indexed(std::make_shared<ff::data_vector>(bad_buffer), dict3));
+        }
     };
 }
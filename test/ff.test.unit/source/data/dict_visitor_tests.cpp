@@ -91,5 +91,105 @@ namespace ff::test::data
             ff::json_write(new_dict, new_json);
             Assert::AreEqual(expect_json, new_json.str());
         }
+
+        TEST_METHOD(async_paths)
+        {
+            ff::dict dict = ff::test::data::dict_visitor_tests::create_resources_dict(64);
+            ff::test::data::dict_visitor_tests::path_visitor visitor(true);
+            std::vector<std::string> errors;
+
+            Assert::IsNull(visitor.visit_dict(dict, errors).get());
+            Assert::AreEqual<size_t>(64, errors.size());
+
+            // Every task reports its own path, never one from a task on another thread
+            std::sort(errors.begin(), errors.end(), [](const std::string& a, const std::string& b)
+                {
+                    return a.substr(a.find('>')) < b.substr(b.find('>'));
+                });
+
+            for (size_t i = 0; i < errors.size(); i++)
+            {
+                std::ostringstream str;
+                str << "> res" << std::setw(6) << std::setfill('0') << i << "/sprites[2]/pos : bad";
+                Assert::IsTrue(errors[i].ends_with(str.str()));
+            }
+        }
+
+        TEST_METHOD(benchmark)
+        {
+            ff::dict dict = ff::test::data::dict_visitor_tests::create_resources_dict(8192);
+
+            for (bool async : { false, true })
+            {
+                ff::test::data::dict_visitor_tests::path_visitor visitor(async, false);
+                std::vector<std::string> errors;
+                ff::timer timer;
+
+                for (int repeat = 0; repeat < 4; repeat++)
+                {
+                    Assert::IsNotNull(visitor.visit_dict(dict, errors).get());
+                }
+
+                ff::log::write(ff::log::type::test, "dict_visitor async: ", async,
+                    ", roots: ", dict.size(),
+                    ", time: ", timer.tick() * 1000.0, "ms");
+            }
+        }
+
+    private:
+        // Looks like a resource JSON file: each root has nested dicts and vectors of values
+        static ff::dict create_resources_dict(size_t count)
+        {
+            std::ostringstream json;
+            json << "{\n";
+
+            for (size_t i = 0; i < count; i++)
+            {
+                json << "  'res" << std::setw(6) << std::setfill('0') << i << "': { 'res:type': 'sprites', 'texture': 'file:tex" << i << ".png', 'sprites': [ "
+                    << "{ 'name': 'a', 'pos': [ 0, 0 ], 'size': [ 16, 16 ] }, "
+                    << "{ 'name': 'b', 'pos': [ 16, 0 ], 'size': [ 16, 16 ] }, "
+                    << "{ 'name': 'c', 'pos': 'bad', 'size': [ 16, 16 ] } ] },\n";
+            }
+
+            json << "}\n";
+
+            std::string json_text = json.str();
+            std::replace(json_text.begin(), json_text.end(), '\'', '\"');
+
+            ff::dict dict;
+            Assert::IsTrue(ff::json_parse(json_text, dict));
+            return dict;
+        }
+
+        // Uses the path for every value, and reports an error for each 'pos' that isn't a vector
+        class path_visitor : public ff::dict_visitor_base
+        {
+        public:
+            path_visitor(bool async, bool report_errors = true)
+                : async(async)
+                , report_errors(report_errors)
+            {}
+
+        protected:
+            virtual bool async_allowed(const ff::dict& dict) override
+            {
+                return this->async && this->is_root();
+            }
+
+            virtual ff::value_ptr transform_value(ff::value_ptr value) override
+            {
+                const std::string path = this->path();
+                if (this->report_errors && path.ends_with("/pos") && value->is_type<std::string>())
+                {
+                    this->add_error("bad");
+                }
+
+                return ff::dict_visitor_base::transform_value(value);
+            }
+
+        private:
+            bool async;
+            bool report_errors;
+        };
     };
 }
@@ -49,5 +49,95 @@ namespace ff::test::data
 
             std::filesystem::remove(path);
         }
+
+        TEST_METHOD(read_async)
+        {
+            std::filesystem::path path = ff::filesystem::temp_directory_path();
+            path /= "temp_test_async.bin";
+
+            std::vector<uint32_t> values(256 * 1024);
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                values[i] = static_cast<uint32_t>(i);
+            }
+
+            {
+                ff::file_write fw(path);
+                Assert::AreEqual(values.size() * sizeof(uint32_t), fw.write(values.data(), values.size() * sizeof(uint32_t)));
+            }
+
+            {
+                ff::file_read fr(path);
+                Assert::IsTrue(fr);
+
+                // Several reads in flight at once
+                std::array<uint32_t, 16> first{}, middle{}, last{};
+                ff::co_task<size_t> first_task = fr.read_async(first.data(), sizeof(first));
+                ff::co_task<size_t> middle_task = fr.read_async(values.size() / 2 * sizeof(uint32_t), middle.data(), sizeof(middle));
+                ff::co_task<size_t> last_task = fr.read_async((values.size() - 8) * sizeof(uint32_t), last.data(), sizeof(last));
+
+                Assert::AreEqual(sizeof(first), fr.pos());
+                Assert::IsTrue(first_task.wait() && middle_task.wait() && last_task.wait());
+                Assert::AreEqual(sizeof(first), first_task.result());
+                Assert::AreEqual(sizeof(middle), middle_task.result());
+                Assert::AreEqual(8 * sizeof(uint32_t), last_task.result());
+                Assert::AreEqual<uint32_t>(15, first[15]);
+                Assert::AreEqual(static_cast<uint32_t>(values.size() / 2 + 15), middle[15]);
+                Assert::AreEqual(static_cast<uint32_t>(values.size() - 1), last[7]);
+
+                // Scatter read
+                std::array<uint32_t, 4> scatter1{}, scatter2{};
+                const std::array<ff::file_read_buffer, 2> buffers{ ff::file_read_buffer{ scatter1.data(), sizeof(scatter1) }, ff::file_read_buffer{ scatter2.data(), sizeof(scatter2) } };
+                ff::co_task<size_t> scatter_task = fr.read_async(100 * sizeof(uint32_t), buffers.data(), buffers.size());
+                Assert::IsTrue(scatter_task.wait());
+                Assert::AreEqual(sizeof(scatter1) + sizeof(scatter2), scatter_task.result());
+                Assert::AreEqual<uint32_t>(100, scatter1[0]);
+                Assert::AreEqual<uint32_t>(107, scatter2[3]);
+
+                // Past the end
+                ff::co_task<size_t> end_task = fr.read_async(values.size() * sizeof(uint32_t), first.data(), sizeof(first));
+                Assert::IsTrue(end_task.wait());
+                Assert::AreEqual<size_t>(0, end_task.result());
+            }
+
+            // Read ahead reader, with reads across chunks and a seek
+            {
+                ff::file_reader_async reader(ff::file_read(path), 4096);
+                Assert::AreEqual(values.size() * sizeof(uint32_t), reader.size());
+
+                std::vector<uint32_t> read_values(values.size());
+                uint8_t* data = reinterpret_cast<uint8_t*>(read_values.data());
+                for (size_t size = 1; reader.pos() < reader.size(); size = size * 3 % 10007)
+                {
+                    const size_t read_size = std::min(size, reader.size() - reader.pos());
+                    Assert::AreEqual(read_size, reader.read(data + reader.pos(), read_size));
+                }
+
+                Assert::IsTrue(values == read_values);
+                Assert::AreEqual<size_t>(0, reader.read(data, 1));
+
+                uint32_t value = 0;
+                reader.pos(1000 * sizeof(uint32_t));
+                ff::co_task<size_t> task = reader.read_async(&value, sizeof(value));
+                Assert::IsTrue(task.wait());
+                Assert::AreEqual(sizeof(value), task.result());
+                Assert::AreEqual<uint32_t>(1000, value);
+            }
+
+            // Saved data uses the async reader
+            {
+                ff::saved_data_file saved_data(path, 40, 4096, 4096, ff::saved_data_type::none);
+                std::shared_ptr<ff::reader_base> reader = saved_data.saved_reader();
+                uint32_t value = 0;
+                Assert::AreEqual(sizeof(value), reader->read(&value, sizeof(value)));
+                Assert::AreEqual<uint32_t>(10, value);
+
+                std::shared_ptr<ff::data_base> data = saved_data.saved_data();
+                Assert::AreEqual<size_t>(4096, data->size());
+                Assert::AreEqual<uint32_t>(11, reinterpret_cast<const uint32_t*>(data->data())[1]);
+            }
+
+            std::filesystem::remove(path);
+        }
     };
 }
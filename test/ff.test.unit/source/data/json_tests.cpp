@@ -58,6 +58,104 @@ namespace ff::test::data
             }
         }
 
+        TEST_METHOD(json_tokenizer_index_test)
+        {
+            std::vector<std::string> jsons
+            {
+                "{ 'foo': 'bar', 'numbers': [ -1, 0, 8.5, -98.76e54, 1E-8 ], 'identifiers': [ true, false, null ] }",
+                "{\n  // Comment with a 'quote\n  /* Comment with a 'quote */ 'a': 1 /**/,/* no space */'b'//\n:2 }",
+                "{ 'long': '" + std::string(100, 'x') + "', 'spaces':" + std::string(100, ' ') + "1 }",
+                "{ 'escapes': [ '\\\\', '\\'', '" + std::string(61, '\\') + "\\'', 'a\\'\\r\\u0020z' ] }",
+                "{ 'bad_escape': '\\x' }",
+                "{ 'control': 'a\tb' }",
+                "{ 'unterminated': 'abc",
+                "{ 'unterminated_comment': 1 /* abc",
+                "{ 'bad': tru }",
+                "{ 'bad': 12abc }",
+                "{ 'bad': 1/2 }",
+            };
+
+            for (std::string& json : jsons)
+            {
+                std::replace(json.begin(), json.end(), '\'', '\"');
+                ff::internal::json_tokenizer tokenizer(json, false);
+                ff::internal::json_tokenizer index_tokenizer(json, true);
+
+                while (true)
+                {
+                    ff::internal::json_token token = tokenizer.next();
+                    ff::internal::json_token index_token = index_tokenizer.next();
+
+                    Assert::IsTrue(token.type == index_token.type);
+                    Assert::IsTrue(token.begin() == index_token.begin());
+
+                    if (token.type == ff::internal::json_token_type::none || token.type == ff::internal::json_token_type::error)
+                    {
+                        break;
+                    }
+
+                    Assert::IsTrue(token.text == index_token.text);
+                }
+            }
+
+            // Error positions still point at the bad token
+            std::string bad_json = "{ 'a': 1, // 'b': 2\n 'c': tru }";
+            std::replace(bad_json.begin(), bad_json.end(), '\'', '\"');
+
+            const char* error_pos = nullptr;
+            ff::dict dict;
+            Assert::IsFalse(ff::json_parse(bad_json, dict, &error_pos));
+            Assert::IsTrue(error_pos == bad_json.data() + bad_json.find("tru"));
+        }
+
+        TEST_METHOD(json_tokenizer_benchmark)
+        {
+            std::ostringstream json_stream;
+            json_stream << "{\n";
+
+            for (int i = 0; i < 50000; i++)
+            {
+                json_stream <<
+                    "    // Resource " << i << "\n"
+                    "    \"texture_" << i << "\":\n"
+                    "    {\n"
+                    "        \"res:type\": \"texture\",\n"
+                    "        \"file\": \"file:assets/textures/texture_" << i << ".png\",\n"
+                    "        \"size\": [ 256, 128 ],\n"
+                    "        \"scale\": 0.5\n"
+                    "    },\n";
+            }
+
+            json_stream << "    \"end\": true\n}\n";
+            const std::string json = json_stream.str();
+
+            auto count_tokens = [&json](bool use_index)
+            {
+                size_t count = 0;
+                ff::internal::json_tokenizer tokenizer(json, use_index);
+
+                for (ff::internal::json_token token = tokenizer.next(); token.type != ff::internal::json_token_type::none; token = tokenizer.next())
+                {
+                    Assert::IsTrue(token.type != ff::internal::json_token_type::error);
+                    count++;
+                }
+
+                return count;
+            };
+
+            ff::timer timer;
+            const size_t char_tokens = count_tokens(false);
+            const double char_seconds = timer.tick();
+            const size_t index_tokens = count_tokens(true);
+            const double index_seconds = timer.tick();
+
+            Assert::AreEqual(char_tokens, index_tokens);
+
+            ff::log::write(ff::log::type::test, "JSON size: ", json.size(), ", tokens: ", index_tokens,
+                ", per char: ", char_seconds * 1000.0, "ms",
+                ", with index: ", index_seconds * 1000.0, "ms");
+        }
+
         TEST_METHOD(json_parser_test)
         {
             std::string json(
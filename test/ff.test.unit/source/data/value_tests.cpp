@@ -20,6 +20,27 @@ namespace ff::test::data
             Assert::AreEqual(12, val2->get<int32_t>());
         }
 
+        TEST_METHOD(allocator_size_classes)
+        {
+            std::vector<std::pair<uint8_t*, size_t>> allocations;
+
+            for (size_t size = 1; size <= 5000; size += 13)
+            {
+                uint8_t* data = reinterpret_cast<uint8_t*>(ff::internal::value_allocator::new_bytes(size));
+                Assert::IsNotNull(data);
+                Assert::AreEqual<size_t>(0, reinterpret_cast<size_t>(data) % alignof(std::max_align_t));
+
+                std::memset(data, static_cast<int>(size), size);
+                allocations.emplace_back(data, size);
+            }
+
+            for (auto& [data, size] : allocations)
+            {
+                Assert::AreEqual(static_cast<uint8_t>(size), data[size - 1]);
+                ff::internal::value_allocator::delete_bytes(data, size);
+            }
+        }
+
         TEST_METHOD(int32_convert_to_string)
         {
             ff::value_ptr val1 = ff::value::create<int32_t>(1024);
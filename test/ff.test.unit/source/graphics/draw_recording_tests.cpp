@@ -0,0 +1,547 @@
+﻿#include "pch.h"
+
+namespace
+{
+    struct sprite_workload
+    {
+        std::vector<std::shared_ptr<ff::dxgi::recording_texture>> textures;
+        std::vector<ff::dxgi::sprite_data> sprites;
+        std::vector<size_t> sprite_indexes;
+        std::vector<const ff::dxgi::sprite_data*> sprite_pointers;
+        std::vector<ff::transform> transforms;
+    };
+}
+
+static const ff::rect_float world_rect(0, 0, 1920, 1080);
+
+// Like the sprite perf test app: a quarter of the sprites use a palette, the rest have random colors,
+// and half of those colored sprites have transparent pixels or a transparent color.
+static ::sprite_workload create_sprite_workload(size_t count, size_t color_texture_count = 4, size_t palette_texture_count = 2)
+{
+    ::sprite_workload workload;
+    std::mt19937 random(1234);
+
+    for (size_t i = 0; i < color_texture_count + palette_texture_count; i++)
+    {
+        const bool palette = (i >= color_texture_count);
+        auto texture = std::make_shared<ff::dxgi::recording_texture>(ff::point_size(256, 256), palette ? DXGI_FORMAT_R8_UINT : DXGI_FORMAT_R8G8B8A8_UNORM);
+        const ff::rect_float rect(0, 0, 32, 32);
+        const ff::point_float handle(16, 16);
+        const ff::point_float scale(1, 1);
+
+        workload.textures.push_back(texture);
+        workload.sprites.emplace_back(texture.get(), rect, handle, scale, palette ? ff::dxgi::sprite_type::opaque_palette : ff::dxgi::sprite_type::opaque);
+        workload.sprites.emplace_back(texture.get(), rect, handle, scale, palette ? ff::dxgi::sprite_type::opaque_palette : ff::dxgi::sprite_type::transparent);
+    }
+
+    workload.sprite_indexes.reserve(count);
+    workload.transforms.reserve(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const bool palette = (random() % 4) == 0;
+        const size_t texture = palette ? color_texture_count + random() % palette_texture_count : random() % color_texture_count;
+        const bool alpha = !palette && (random() % 2) == 0;
+        const ff::point_float pos(static_cast<float>(random() % 1920), static_cast<float>(random() % 1080));
+
+        const DirectX::XMFLOAT4 color = palette
+            ? ff::color_white()
+            : DirectX::XMFLOAT4((random() % 65) / 64.0f, (random() % 65) / 64.0f, (random() % 65) / 64.0f, (alpha && (random() % 2)) ? 0.5f : 1.0f);
+
+        workload.sprite_indexes.push_back(texture * 2 + (alpha ? 1 : 0));
+        workload.transforms.emplace_back(pos, palette ? ff::point_float(2, 2) : ff::point_float(1, 1), static_cast<float>(random() % 360), color);
+    }
+
+    for (size_t i : workload.sprite_indexes)
+    {
+        workload.sprite_pointers.push_back(&workload.sprites[i]);
+    }
+
+    return workload;
+}
+
+static void draw_sprite_workload(ff::dxgi::draw_base& draw, const ::sprite_workload& workload, bool batch = false)
+{
+    if (batch)
+    {
+        draw.draw_sprites(workload.sprite_pointers.data(), workload.transforms.data(), workload.transforms.size());
+        return;
+    }
+
+    for (size_t i = 0; i < workload.transforms.size(); i++)
+    {
+        draw.draw_sprite(workload.sprites[workload.sprite_indexes[i]], workload.transforms[i]);
+    }
+}
+
+static std::vector<ff::dxgi::draw_util::geometry_bucket_type> recorded_draws(const ff::dxgi::recording_draw_device& device)
+{
+    std::vector<ff::dxgi::draw_util::geometry_bucket_type> draws;
+
+    for (const ff::dxgi::recorded_command& command : device.commands())
+    {
+        if (command.type == ff::dxgi::recorded_command_type::draw)
+        {
+            draws.push_back(command.bucket_type);
+        }
+    }
+
+    return draws;
+}
+
+namespace ff::test::graphics
+{
+    TEST_CLASS(draw_recording_tests)
+    {
+    public:
+        TEST_METHOD(opaque_sprites)
+        {
+            ff::dxgi::recording_command_context context;
+            ff::dxgi::recording_target target(ff::point_size(1920, 1080));
+            ff::dxgi::recording_texture texture(ff::point_size(256, 256));
+            ff::dxgi::sprite_data sprite(&texture, ff::rect_float(0, 0, 32, 32), ff::point_float(16, 16), ff::point_float(1, 1), ff::dxgi::sprite_type::opaque);
+            ff::dxgi::recording_draw_device device;
+            Assert::IsTrue(device.valid());
+
+            {
+                ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect);
+                Assert::IsNotNull(draw.get());
+
+                for (size_t i = 0; i < 1000; i++)
+                {
+                    draw->draw_sprite(sprite, ff::transform(ff::point_float(static_cast<float>(i), 0)));
+                }
+            }
+
+            const ff::dxgi::recording_stats& stats = device.stats();
+            Assert::AreEqual<size_t>(1, stats.begin_draw_count);
+            Assert::AreEqual<size_t>(1, stats.flush_count);
+            Assert::AreEqual<size_t>(1, stats.draw_count);
+            Assert::AreEqual<size_t>(1000, stats.drawn_item_count);
+            Assert::AreEqual<size_t>(1000 * sizeof(ff::vertex::sprite_geometry), stats.geometry_bytes);
+            Assert::AreEqual<size_t>(1000 * sizeof(ff::vertex::sprite_geometry), device.recorded_geometry_buffer().data().size());
+
+            const std::vector<ff::dxgi::recorded_command> expect
+            {
+                { ff::dxgi::recorded_command_type::setup },
+                { ff::dxgi::recorded_command_type::flush_begin },
+                { ff::dxgi::recorded_command_type::shader_input, {}, 1, 0 },
+                { ff::dxgi::recorded_command_type::opaque_state },
+                { ff::dxgi::recorded_command_type::geometry_state, ff::dxgi::draw_util::geometry_bucket_type::sprites },
+                { ff::dxgi::recorded_command_type::draw, ff::dxgi::draw_util::geometry_bucket_type::sprites, 1000, 0 },
+                { ff::dxgi::recorded_command_type::flush_end },
+                { ff::dxgi::recorded_command_type::end_draw },
+            };
+
+            Assert::IsTrue(device.commands() == expect);
+        }
+
+        TEST_METHOD(alpha_sprites)
+        {
+            ff::dxgi::recording_command_context context;
+            ff::dxgi::recording_target target(ff::point_size(1920, 1080));
+            ff::dxgi::recording_texture texture(ff::point_size(256, 256));
+            ff::dxgi::sprite_data sprite(&texture, ff::rect_float(0, 0, 32, 32), ff::point_float(16, 16), ff::point_float(1, 1), ff::dxgi::sprite_type::transparent);
+            ff::dxgi::recording_draw_device device;
+
+            // Every alpha sprite gets its own depth, so they can't be drawn together
+            {
+                ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect);
+                for (size_t i = 0; i < 10; i++)
+                {
+                    draw->draw_sprite(sprite, ff::transform(ff::point_float(static_cast<float>(i), 0)));
+                }
+            }
+
+            Assert::AreEqual<size_t>(1, device.stats().flush_count);
+            Assert::AreEqual<size_t>(10, device.stats().draw_count);
+            device.clear_recording();
+
+            // Unless they don't overlap
+            {
+                ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect);
+                draw->push_no_overlap();
+
+                for (size_t i = 0; i < 10; i++)
+                {
+                    draw->draw_sprite(sprite, ff::transform(ff::point_float(static_cast<float>(i), 0)));
+                }
+
+                draw->pop_no_overlap();
+            }
+
+            Assert::AreEqual<size_t>(1, device.stats().flush_count);
+            Assert::AreEqual<size_t>(1, device.stats().draw_count);
+            Assert::AreEqual<size_t>(10, device.stats().drawn_item_count);
+        }
+
+        TEST_METHOD(sort_alpha)
+        {
+            ff::dxgi::recording_command_context context;
+            ff::dxgi::recording_target target(ff::point_size(1920, 1080));
+            ff::dxgi::recording_texture texture(ff::point_size(256, 256));
+            ff::dxgi::sprite_data sprite(&texture, ff::rect_float(0, 0, 32, 32), ff::point_float(16, 16), ff::point_float(1, 1), ff::dxgi::sprite_type::transparent);
+            const DirectX::XMFLOAT4 alpha_color(1, 1, 1, 0.5f);
+            ff::dxgi::recording_draw_device device;
+
+            // Sprites along the top and circles along the bottom, none of them overlap
+            for (ff::dxgi::draw_options options : { ff::dxgi::draw_options::none, ff::dxgi::draw_options::sort_alpha })
+            {
+                device.clear_recording();
+                {
+                    ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect, options);
+                    for (size_t i = 0; i < 10; i++)
+                    {
+                        const float x = static_cast<float>(i * 190 + 50);
+                        draw->draw_sprite(sprite, ff::transform(ff::point_float(x, 100)));
+                        draw->draw_filled_circle(ff::point_float(x, 800), 16, alpha_color);
+                    }
+                }
+
+                Assert::AreEqual<size_t>(20, device.stats().drawn_item_count);
+                Assert::AreEqual<size_t>(options == ff::dxgi::draw_options::sort_alpha ? 2 : 20, device.stats().draw_count);
+            }
+
+            // Everything overlaps, so the draw order can't change
+            device.clear_recording();
+            {
+                ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect, ff::dxgi::draw_options::sort_alpha);
+                draw->draw_sprite(sprite, ff::transform(ff::point_float(500, 500)));
+                draw->draw_sprite(sprite, ff::transform(ff::point_float(504, 500)));
+                draw->draw_filled_circle(ff::point_float(500, 500), 16, alpha_color);
+                draw->draw_sprite(sprite, ff::transform(ff::point_float(508, 500)));
+            }
+
+            const std::vector<ff::dxgi::draw_util::geometry_bucket_type> expect
+            {
+                ff::dxgi::draw_util::geometry_bucket_type::sprites_alpha,
+                ff::dxgi::draw_util::geometry_bucket_type::circles_alpha,
+                ff::dxgi::draw_util::geometry_bucket_type::sprites_alpha,
+            };
+
+            // Only the first two sprites can be drawn together
+            Assert::IsTrue(::recorded_draws(device) == expect);
+            Assert::AreEqual<size_t>(4, device.stats().drawn_item_count);
+        }
+
+        TEST_METHOD(retained_matrixes)
+        {
+            ff::dxgi::recording_command_context context;
+            ff::dxgi::recording_target target(ff::point_size(1920, 1080));
+            ff::dxgi::recording_texture texture(ff::point_size(256, 256));
+            ff::dxgi::sprite_data sprite(&texture, ff::rect_float(0, 0, 32, 32), ff::point_float(16, 16), ff::point_float(1, 1), ff::dxgi::sprite_type::opaque);
+            ff::dxgi::recording_draw_device device(false);
+
+            auto draw_frame = [&](size_t matrix_count)
+            {
+                device.clear_recording();
+                ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect);
+
+                for (size_t i = 0; i < matrix_count; i++)
+                {
+                    DirectX::XMFLOAT4X4 matrix;
+                    DirectX::XMStoreFloat4x4(&matrix, DirectX::XMMatrixTranslation(static_cast<float>(i * 40), 0, 0));
+
+                    draw->world_matrix_stack().push();
+                    draw->world_matrix_stack().transform(matrix);
+                    draw->draw_sprite(sprite, ff::transform::identity());
+                    draw->world_matrix_stack().pop();
+                }
+            };
+
+            const size_t constants_0_size = sizeof(ff::dxgi::draw_util::geometry_shader_constants_0);
+            const size_t matrix_size = sizeof(DirectX::XMFLOAT4X4);
+
+            // Matrixes are only uploaded when one is added
+            draw_frame(10);
+            Assert::AreEqual(constants_0_size + 10 * matrix_size, device.stats().constant_bytes);
+            draw_frame(10);
+            Assert::AreEqual(constants_0_size, device.stats().constant_bytes);
+            draw_frame(11);
+            Assert::AreEqual(constants_0_size + 11 * matrix_size, device.stats().constant_bytes);
+            draw_frame(5);
+            Assert::AreEqual(constants_0_size, device.stats().constant_bytes);
+
+            // Matrixes that aren't used for a while are forgotten
+            for (size_t i = 0; i < ff::dxgi::draw_util::RETAIN_TRANSFORM_MATRIX_DRAWS; i++)
+            {
+                draw_frame(0);
+            }
+
+            draw_frame(10);
+            Assert::AreEqual(constants_0_size + 10 * matrix_size, device.stats().constant_bytes);
+            Assert::AreEqual<size_t>(10, device.stats().drawn_item_count);
+        }
+
+        TEST_METHOD(texture_limit)
+        {
+            ff::dxgi::recording_command_context context;
+            ff::dxgi::recording_target target(ff::point_size(1920, 1080));
+            ff::dxgi::recording_draw_device device(false);
+            ::sprite_workload workload = ::create_sprite_workload(1000, ff::dxgi::draw_util::MAX_TEXTURES + 1, 1);
+
+            {
+                ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect);
+                ::draw_sprite_workload(*draw, workload);
+            }
+
+            Assert::IsTrue(device.commands().empty());
+            Assert::IsTrue(device.stats().flush_count > 1);
+            Assert::AreEqual<size_t>(1000, device.stats().drawn_item_count);
+        }
+
+        TEST_METHOD(texture_slots_per_flush)
+        {
+            ff::dxgi::recording_command_context context;
+            ff::dxgi::recording_target target(ff::point_size(1920, 1080));
+            ff::dxgi::recording_draw_device device;
+            std::vector<std::unique_ptr<ff::dxgi::recording_texture>> textures;
+
+            {
+                ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect);
+                for (size_t i = 0; i < ff::dxgi::draw_util::MAX_TEXTURES + 1; i++)
+                {
+                    auto& texture = textures.emplace_back(std::make_unique<ff::dxgi::recording_texture>(ff::point_size(32, 32)));
+                    ff::dxgi::sprite_data sprite(texture.get(), ff::rect_float(0, 0, 32, 32), ff::point_float(0, 0), ff::point_float(1, 1), ff::dxgi::sprite_type::opaque);
+                    draw->draw_sprite(sprite, ff::transform::identity());
+                }
+            }
+
+            // Each flush only binds the textures that it uses
+            std::vector<size_t> texture_counts;
+            for (const ff::dxgi::recorded_command& command : device.commands())
+            {
+                if (command.type == ff::dxgi::recorded_command_type::shader_input)
+                {
+                    texture_counts.push_back(command.count);
+                }
+            }
+
+            const std::vector<size_t> expect{ ff::dxgi::draw_util::MAX_TEXTURES, 1 };
+            Assert::IsTrue(texture_counts == expect);
+        }
+
+        TEST_METHOD(draw_sprites)
+        {
+            ff::dxgi::recording_command_context context;
+            ff::dxgi::recording_target target(ff::point_size(1920, 1080));
+            ::sprite_workload workload = ::create_sprite_workload(1001, ff::dxgi::draw_util::MAX_TEXTURES + 1, 2);
+
+            // Some sprites that can't be seen
+            const ff::dxgi::sprite_data empty_sprite;
+            workload.transforms[10].color.w = 0;
+            workload.transforms[11].color.w = 0;
+            workload.sprite_pointers[12] = &empty_sprite;
+
+            ff::dxgi::recording_draw_device device_1;
+            ff::dxgi::recording_draw_device device_2;
+
+            for (ff::dxgi::draw_options options : { ff::dxgi::draw_options::none, ff::dxgi::draw_options::sort_alpha })
+            {
+                device_1.clear_recording();
+                device_2.clear_recording();
+
+                {
+                    ff::dxgi::draw_ptr draw = device_1.begin_draw(context, target, nullptr, ::world_rect, ::world_rect, options);
+                    for (size_t i = 0; i < workload.transforms.size(); i++)
+                    {
+                        draw->draw_sprite(*workload.sprite_pointers[i], workload.transforms[i]);
+                    }
+                }
+
+                {
+                    ff::dxgi::draw_ptr draw = device_2.begin_draw(context, target, nullptr, ::world_rect, ::world_rect, options);
+                    ::draw_sprite_workload(*draw, workload, true);
+                }
+
+                // Batches must be exactly the same as drawing one sprite at a time
+                Assert::IsTrue(device_1.stats().flush_count > 1);
+                Assert::AreEqual<size_t>(998, device_2.stats().drawn_item_count);
+                Assert::IsTrue(device_1.commands() == device_2.commands());
+                Assert::IsTrue(device_1.recorded_geometry_buffer().data() == device_2.recorded_geometry_buffer().data());
+                Assert::AreEqual(device_1.stats().geometry_bytes, device_2.stats().geometry_bytes);
+                Assert::AreEqual(device_1.stats().constant_bytes, device_2.stats().constant_bytes);
+            }
+        }
+
+        TEST_METHOD(recorders)
+        {
+            const size_t chunk_count = 4;
+            const size_t chunk_size = 500;
+
+            ff::dxgi::recording_command_context context;
+            ff::dxgi::recording_target target(ff::point_size(1920, 1080));
+            ::sprite_workload workload = ::create_sprite_workload(chunk_count * chunk_size, ff::dxgi::draw_util::MAX_TEXTURES + 1, 2);
+            const DirectX::XMFLOAT4 alpha_color(1, 0, 0, 0.5f);
+
+            auto draw_chunk = [&](ff::dxgi::draw_base& draw, size_t chunk)
+            {
+                for (size_t i = chunk * chunk_size; i < (chunk + 1) * chunk_size; i++)
+                {
+                    const ff::point_float pos = workload.transforms[i].position;
+
+                    if (i % 50 == 0)
+                    {
+                        DirectX::XMFLOAT4X4 matrix;
+                        DirectX::XMStoreFloat4x4(&matrix, DirectX::XMMatrixTranslation(static_cast<float>(chunk * 10), static_cast<float>(i % 7), 0));
+                        draw.world_matrix_stack().push();
+                        draw.world_matrix_stack().transform(matrix);
+                    }
+
+                    if (i % 100 == 25)
+                    {
+                        draw.push_no_overlap();
+                        draw.draw_filled_circle(pos, 8, alpha_color);
+                        draw.draw_line(pos, pos + ff::point_float(20, 20), ff::color_white(), 2);
+                        draw.pop_no_overlap();
+
+                        // One color for each point, then a single color
+                        const ff::point_float points[3] = { pos, pos + ff::point_float(10, 0), pos + ff::point_float(10, 10) };
+                        const DirectX::XMFLOAT4 colors[3] = { ff::color_white(), alpha_color, ff::color_white() };
+                        draw.draw_line_strip(points, colors, 3, 1);
+                        draw.draw_line_strip(points, 3, alpha_color, 1);
+                    }
+
+                    draw.draw_sprite(workload.sprites[workload.sprite_indexes[i]], workload.transforms[i]);
+
+                    if (i % 50 == 49)
+                    {
+                        draw.world_matrix_stack().pop();
+                    }
+                }
+            };
+
+            // Everything on one thread, the main content comes before the chunks
+            ff::dxgi::recording_draw_device device_1;
+            {
+                ff::dxgi::draw_ptr draw = device_1.begin_draw(context, target, nullptr, ::world_rect, ::world_rect);
+                draw->draw_filled_rectangle(ff::rect_float(0, 0, 100, 100), alpha_color);
+
+                for (size_t i = 0; i < chunk_count; i++)
+                {
+                    draw_chunk(*draw, i);
+                }
+            }
+
+            // Chunks recorded on other threads get drawn in order after the main content
+            ff::dxgi::recording_draw_device device_2;
+            {
+                ff::dxgi::draw_ptr draw = device_2.begin_draw(context, target, nullptr, ::world_rect, ::world_rect);
+                std::vector<ff::dxgi::draw_ptr> recorders;
+
+                for (size_t i = 0; i < chunk_count; i++)
+                {
+                    recorders.push_back(draw->begin_recording());
+                    Assert::IsNotNull(recorders.back().get());
+                }
+
+                ff::parallel_for(0, chunk_count, 1, [&](size_t i)
+                    {
+                        draw_chunk(*recorders[i], i);
+                        recorders[i].reset();
+                    }).wait();
+
+                draw->draw_filled_rectangle(ff::rect_float(0, 0, 100, 100), alpha_color);
+            }
+
+            const ff::dxgi::recording_stats& stats_1 = device_1.stats();
+            const ff::dxgi::recording_stats& stats_2 = device_2.stats();
+
+            Assert::IsTrue(stats_1.flush_count > 1);
+            Assert::IsTrue(device_1.commands() == device_2.commands());
+            Assert::IsTrue(device_1.recorded_geometry_buffer().data() == device_2.recorded_geometry_buffer().data());
+            Assert::AreEqual(stats_1.drawn_item_count, stats_2.drawn_item_count);
+            Assert::AreEqual(stats_1.geometry_bytes, stats_2.geometry_bytes);
+            Assert::AreEqual(stats_1.constant_bytes, stats_2.constant_bytes);
+            Assert::AreEqual(stats_1.texture_bytes, stats_2.texture_bytes);
+        }
+
+        TEST_METHOD(benchmark)
+        {
+            const size_t sprite_count = 100000;
+            const size_t frame_count = 10;
+
+            ff::dxgi::recording_command_context context;
+            ff::dxgi::recording_target target(ff::point_size(1920, 1080));
+            ff::dxgi::recording_draw_device device(false);
+            ::sprite_workload workload = ::create_sprite_workload(sprite_count);
+
+            const std::pair<ff::dxgi::draw_options, bool> runs[] =
+            {
+                { ff::dxgi::draw_options::none, false },
+                { ff::dxgi::draw_options::sort_alpha, false },
+                { ff::dxgi::draw_options::none, true },
+            };
+
+            double direct_seconds = 0;
+
+            for (auto [options, batch] : runs)
+            {
+                device.clear_recording();
+
+                ff::timer timer;
+                for (size_t i = 0; i < frame_count; i++)
+                {
+                    ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect, options);
+                    ::draw_sprite_workload(*draw, workload, batch);
+                }
+
+                const double seconds = timer.tick();
+                const ff::dxgi::recording_stats& stats = device.stats();
+                const size_t total_sprites = sprite_count * frame_count;
+                const size_t total_bytes = stats.geometry_bytes + stats.constant_bytes + stats.texture_bytes;
+
+                Assert::AreEqual(frame_count, stats.begin_draw_count);
+                Assert::AreEqual(total_sprites, stats.drawn_item_count);
+
+                ff::log::write(ff::log::type::test, "Recorded ", sprite_count, " sprites x ", frame_count, " frames",
+                    (options == ff::dxgi::draw_options::sort_alpha) ? " (sort alpha)" : "",
+                    batch ? " (draw_sprites)" : "",
+                    ", time: ", seconds * 1000000000.0 / total_sprites, "ns/sprite",
+                    ", flushes/frame: ", static_cast<double>(stats.flush_count) / frame_count,
+                    ", draws/flush: ", stats.draws_per_flush(),
+                    ", bytes/sprite: ", static_cast<double>(total_bytes) / total_sprites,
+                    ", state changes/frame: ", static_cast<double>(stats.state_change_count) / frame_count);
+
+                direct_seconds = seconds;
+            }
+
+            // Same as the last run, but recorders fill the draw on other threads and get replayed in end_draw,
+            // the whole frame must not take longer than drawing everything directly
+            const size_t chunk_count = 8;
+            const size_t chunk_size = sprite_count / chunk_count;
+            device.clear_recording();
+
+            ff::timer timer;
+            for (size_t i = 0; i < frame_count; i++)
+            {
+                ff::dxgi::draw_ptr draw = device.begin_draw(context, target, nullptr, ::world_rect, ::world_rect);
+                std::vector<ff::dxgi::draw_ptr> recorders;
+
+                for (size_t j = 0; j < chunk_count; j++)
+                {
+                    recorders.push_back(draw->begin_recording());
+                }
+
+                ff::parallel_for(0, chunk_count, 1, [&](size_t j)
+                    {
+                        const size_t start = j * chunk_size;
+                        recorders[j]->draw_sprites(workload.sprite_pointers.data() + start, workload.transforms.data() + start, chunk_size);
+                        recorders[j].reset();
+                    }).wait();
+            }
+
+            const double recorded_seconds = timer.tick();
+            Assert::AreEqual(sprite_count * frame_count, device.stats().drawn_item_count);
+
+            ff::log::write(ff::log::type::test, "Recorded ", sprite_count, " sprites x ", frame_count, " frames (", chunk_count, " recorders)",
+                ", time: ", recorded_seconds * 1000000000.0 / (sprite_count * frame_count), "ns/sprite",
+                ", compared to direct: ", recorded_seconds / direct_seconds);
+
+            if (std::thread::hardware_concurrency() >= 4)
+            {
+                Assert::IsTrue(recorded_seconds <= direct_seconds * 1.1);
+            }
+        }
+    };
+}
@@ -0,0 +1,57 @@
+﻿#include "pch.h"
+
+namespace ff::test::resource
+{
+    TEST_CLASS(resource_objects_tests)
+    {
+    public:
+        TEST_METHOD(load_group)
+        {
+            std::string json_source =
+                "{\n"
+                "  'values': { 'res:type': 'resource_values', 'global': { 'name': 'foobar' } },\n"
+                "  'level': { 'values': 'ref:values', 'more': [ 'ref:sub', 'ref:values' ] },\n"
+                "  'sub': { 'values': 'ref:values' },\n"
+                "  'other': { 'value': 1 }\n"
+                "}\n";
+            std::replace(json_source.begin(), json_source.end(), '\'', '\"');
+
+            ff::load_resources_result result = ff::load_resources_from_json(json_source, "", false);
+            Assert::IsNotNull(result.resources.get());
+            Assert::IsTrue(result.errors.empty());
+
+            // Dependencies come from the saved metadata
+            ff::dict cache_dict;
+            Assert::IsTrue(ff::resource_object_base::save_to_cache_typed(*result.resources, cache_dict));
+
+            const ff::resource_object_factory_base* factory = ff::resource_objects::get_factory("resource_objects");
+            auto res = std::dynamic_pointer_cast<ff::resource_objects>(factory->load_from_cache(cache_dict));
+            Assert::IsNotNull(res.get());
+
+            ff::co_task<std::vector<std::shared_ptr<ff::resource>>> task = res->load_group_async({ "level", "missing" });
+            Assert::IsTrue(task.wait(10000));
+
+            std::vector<std::shared_ptr<ff::resource>> resources = task.result();
+            Assert::AreEqual<size_t>(2, resources.size());
+            Assert::IsTrue(resources[0]->value()->is_type<ff::dict>());
+            Assert::IsTrue(resources[1]->value()->is_type<nullptr_t>());
+
+            const ff::dict& level_dict = resources[0]->value()->get<ff::dict>();
+            std::shared_ptr<ff::resource> values = level_dict.get("values")->get<ff::resource>();
+            Assert::IsFalse(values->is_loading());
+            Assert::IsTrue(values->value()->is_type<ff::resource_object_base>());
+
+            std::vector<ff::value_ptr> more = level_dict.get("more")->get<std::vector<ff::value_ptr>>();
+            Assert::AreEqual<size_t>(2, more.size());
+            Assert::IsFalse(more[0]->get<ff::resource>()->is_loading());
+            Assert::IsTrue(more[0]->get<ff::resource>()->value()->is_type<ff::dict>());
+            Assert::IsTrue(values == more[1]->get<ff::resource>());
+
+            // Already loaded resources are reused
+            ff::co_task<std::vector<std::shared_ptr<ff::resource>>> task2 = res->load_group_async({ "sub", "other" });
+            Assert::IsTrue(task2.wait(10000));
+            Assert::IsTrue(task2.result()[0] == more[0]->get<ff::resource>());
+            Assert::IsTrue(task2.result()[1]->value()->is_type<ff::dict>());
+        }
+    };
+}
@@ -64,5 +64,133 @@ namespace ff::test::resource
             Assert::IsTrue(data1->size() == test_string1.size() + 3 && !std::memcmp(data1->data() + 3, test_string1.data(), test_string1.size()));
             Assert::IsTrue(data2->size() == test_string2.size() + 3 && !std::memcmp(data2->data() + 3, test_string2.data(), test_string2.size()));
         }
+
+        TEST_METHOD(grouped_pack)
+        {
+            std::filesystem::path temp_path = ff::filesystem::temp_directory_path() / "resource_persist_group_test";
+            ff::scope_exit cleanup([&temp_path]()
+                {
+                    ff::filesystem::remove_all(temp_path);
+                });
+
+            std::filesystem::path source_path = temp_path / "res.json";
+            std::filesystem::path pack_path = temp_path / "res.pack";
+            std::array<std::string, 3> test_strings = { "Test string 1", "Test string 2", "Test string 3" };
+            std::string json_source =
+                "{\n"
+                "    'test_file1': { 'res:type': 'file', 'file': 'file:test1.txt', 'res:group': 'level1' },\n"
+                "    'test_file2': { 'res:type': 'file', 'file': 'file:test2.txt', 'res:group': 'level1' },\n"
+                "    'test_file3': { 'res:type': 'file', 'file': 'file:test3.txt' }\n"
+                "}\n";
+            std::replace(json_source.begin(), json_source.end(), '\'', '\"');
+
+            for (size_t i = 0; i < test_strings.size(); i++)
+            {
+                ff::filesystem::write_text_file(temp_path / ("test" + std::to_string(i + 1) + ".txt"), test_strings[i]);
+            }
+
+            ff::filesystem::write_text_file(source_path, json_source);
+
+            ff::load_resources_result result = ff::load_resources_from_file(source_path, ff::resource_cache_t::none, true);
+            Assert::IsNotNull(result.resources.get());
+            Assert::IsTrue(result.errors.empty());
+            {
+                ff::file_writer writer(pack_path);
+                Assert::IsTrue(result.resources->save(writer));
+            }
+
+            // Lookups work before the whole table of contents gets loaded
+            ff::file_reader reader(pack_path);
+            ff::resource_objects loaded_resources(reader);
+
+            for (size_t i = test_strings.size(); i > 0; i--)
+            {
+                ff::auto_resource<ff::resource_file> res_file = loaded_resources.get_resource_object("test_file" + std::to_string(i));
+                Assert::IsNotNull(res_file.object().get());
+
+                std::shared_ptr<ff::data_base> data = res_file->saved_data()->loaded_data();
+                const std::string& test_string = test_strings[i - 1];
+                Assert::IsTrue(data->size() == test_string.size() + 3 && !std::memcmp(data->data() + 3, test_string.data(), test_string.size()));
+            }
+
+            Assert::IsFalse(loaded_resources.get_resource_object("test_file4")->value()->is_type<ff::resource_object_base>());
+            Assert::AreEqual<size_t>(3, loaded_resources.resource_object_names().size());
+
+            // Groups are kept when saving again
+            ff::dict saved_dict;
+            Assert::IsTrue(loaded_resources.save(saved_dict));
+            const ff::dict& groups_dict = saved_dict.get<ff::dict>(ff::internal::RES_GROUPS);
+            Assert::AreEqual<size_t>(2, groups_dict.size());
+            Assert::AreEqual(std::string("level1"), groups_dict.get<std::string>("test_file2"));
+        }
+
+        TEST_METHOD(build_cache)
+        {
+            std::filesystem::path temp_path = ff::filesystem::temp_directory_path() / "resource_build_cache_test";
+            ff::scope_exit cleanup([&temp_path]()
+                {
+                    ff::filesystem::remove_all(temp_path);
+                });
+
+            std::filesystem::path source_path = temp_path / "res.json";
+            std::filesystem::path test_path = temp_path / "test.txt";
+            std::string json_source =
+                "{\n"
+                "    'test_file': { 'res:type': 'file', 'file': 'file:test.txt' }\n"
+                "}\n";
+            std::replace(json_source.begin(), json_source.end(), '\'', '\"');
+
+            ff::filesystem::write_text_file(source_path, json_source);
+            ff::filesystem::write_text_file(test_path, "Test string 1");
+
+            auto load_test_file = [&source_path](ff::resource_build_cache& build_cache)
+                {
+                    ff::load_resources_result result = ff::load_resources_from_file(source_path, ff::resource_cache_t::none, false, &build_cache);
+                    Assert::IsNotNull(result.resources.get());
+                    Assert::IsTrue(result.errors.empty());
+
+                    ff::auto_resource<ff::resource_file> res_file = result.resources->get_resource_object("test_file");
+                    Assert::IsNotNull(res_file.object().get());
+
+                    std::shared_ptr<ff::data_base> data = res_file->saved_data()->loaded_data();
+                    return std::string(reinterpret_cast<const char*>(data->data() + 3), data->size() - 3);
+                };
+
+            {
+                // The first build fills the cache and the second one uses it
+                ff::resource_build_cache build_cache(temp_path / "cache");
+                Assert::AreEqual(std::string("Test string 1"), load_test_file(build_cache));
+                Assert::AreEqual<size_t>(0, build_cache.hit_count());
+                Assert::AreEqual<size_t>(1, build_cache.miss_count());
+            }
+
+            {
+                ff::resource_build_cache build_cache(temp_path / "cache");
+                Assert::AreEqual(std::string("Test string 1"), load_test_file(build_cache));
+                Assert::AreEqual<size_t>(1, build_cache.hit_count());
+                Assert::AreEqual<size_t>(0, build_cache.miss_count());
+            }
+
+            {
+                // Changing an input file's bytes is a different key
+                ff::filesystem::write_text_file(test_path, "Test string 2");
+                ff::resource_build_cache build_cache(temp_path / "cache");
+                Assert::AreEqual(std::string("Test string 2"), load_test_file(build_cache));
+                Assert::AreEqual<size_t>(0, build_cache.hit_count());
+                Assert::AreEqual<size_t>(1, build_cache.miss_count());
+            }
+
+            {
+                // The same sources in another directory use the same key
+                source_path = temp_path / "moved" / "res.json";
+                ff::filesystem::write_text_file(source_path, json_source);
+                ff::filesystem::write_text_file(temp_path / "moved" / "test.txt", "Test string 2");
+
+                ff::resource_build_cache build_cache(temp_path / "cache");
+                Assert::AreEqual(std::string("Test string 2"), load_test_file(build_cache));
+                Assert::AreEqual<size_t>(1, build_cache.hit_count());
+                Assert::AreEqual<size_t>(0, build_cache.miss_count());
+            }
+        }
     };
 }